@@ -166,13 +166,17 @@ namespace remix {
     Result< remixapi_MaterialHandle > CreateMaterial(const remixapi_MaterialInfo& info);
     Result< void >                    DestroyMaterial(remixapi_MaterialHandle handle);
     Result< remixapi_MeshHandle >     CreateMesh(const remixapi_MeshInfo& info);
+    Result< void >                    CreateMeshes(const remixapi_MeshInfo* infos, uint32_t count,
+                                                   remixapi_MeshHandle* outHandles);
     Result< void >                    DestroyMesh(remixapi_MeshHandle handle);
     Result< void >                    SetupCamera(const remixapi_CameraInfo& info);
     Result< void >                    DrawInstance(const remixapi_InstanceInfo& info);
+    Result< void >                    DrawInstances(const remixapi_InstanceInfo* infos, uint32_t count);
     Result< void >                    DrawUIInstance(const remixapi_UIInstanceInfo& info);
     Result< remixapi_LightHandle >    CreateLight(const remixapi_LightInfo& info);
     Result< void >                    DestroyLight(remixapi_LightHandle handle);
     Result< void >                    DrawLightInstance(remixapi_LightHandle handle);
+    Result< void >                    DrawLightInstances(const remixapi_LightHandle* handles, uint32_t count);
     Result< void >                    SetConfigVariable(const char* key, const char* value);
 
     // DXVK interoperability
@@ -209,7 +213,7 @@ namespace remix {
         return status;
       }
 
-      static_assert(sizeof(remixapi_Interface) == 192,
+      static_assert(sizeof(remixapi_Interface) == 216,
                     "Change version, update C++ wrapper when adding new functions");
 
       remix::Interface interfaceInCpp = {};
@@ -631,6 +635,11 @@ namespace remix {
     return handle;
   }
 
+  inline Result< void > Interface::CreateMeshes(const remixapi_MeshInfo* infos, uint32_t count,
+                                                remixapi_MeshHandle* outHandles) {
+    return m_CInterface.CreateMeshes(infos, count, outHandles);
+  }
+
   inline Result< void > Interface::DestroyMesh(remixapi_MeshHandle handle) {
     return m_CInterface.DestroyMesh(handle);
   }
@@ -734,6 +743,10 @@ namespace remix {
     return m_CInterface.DrawInstance(&info);
   }
 
+  inline Result< void > Interface::DrawInstances(const remixapi_InstanceInfo* infos, uint32_t count) {
+    return m_CInterface.DrawInstances(infos, count);
+  }
+
   inline Result<void> Interface::DrawUIInstance(const remixapi_UIInstanceInfo& info) {
     return m_CInterface.DrawUIInstance(&info);
   }
@@ -912,6 +925,10 @@ namespace remix {
     return m_CInterface.DrawLightInstance(handle);
   }
 
+  inline Result< void > Interface::DrawLightInstances(const remixapi_LightHandle* handles, uint32_t count) {
+    return m_CInterface.DrawLightInstances(handles, count);
+  }
+
   namespace detail {
     struct dxvk_ExternalSwapchain {
       uint64_t vkImage;
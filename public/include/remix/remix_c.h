@@ -51,8 +51,8 @@
 #define REMIXAPI_VERSION_GET_PATCH(version) (((uint64_t)(version)      ) & (uint64_t)0xFFFF)
 
 #define REMIXAPI_VERSION_MAJOR 0
-#define REMIXAPI_VERSION_MINOR 5
-#define REMIXAPI_VERSION_PATCH 1
+#define REMIXAPI_VERSION_MINOR 6
+#define REMIXAPI_VERSION_PATCH 0
 
 
 // External
@@ -325,6 +325,14 @@ extern "C" {
     const remixapi_MeshInfo*  info,
     remixapi_MeshHandle*      out_handle);
 
+  // Creates 'infos_count' meshes at once, writing a handle per mesh into 'out_handles'.
+  // Surfaces of all meshes share a single allocation, which is released
+  // only after every mesh of the batch has been destroyed.
+  typedef remixapi_ErrorCode(REMIXAPI_PTR* PFN_remixapi_CreateMeshes)(
+    const remixapi_MeshInfo*  infos_values,
+    uint32_t                  infos_count,
+    remixapi_MeshHandle*      out_handles);
+
   typedef remixapi_ErrorCode(REMIXAPI_PTR* PFN_remixapi_DestroyMesh)(
     remixapi_MeshHandle       handle);
 
@@ -438,6 +446,11 @@ extern "C" {
   typedef remixapi_ErrorCode(REMIXAPI_PTR* PFN_remixapi_DrawInstance)(
     const remixapi_InstanceInfo* info);
 
+  // Same as DrawInstance, but submits all instances with a single command
+  typedef remixapi_ErrorCode(REMIXAPI_PTR* PFN_remixapi_DrawInstances)(
+    const remixapi_InstanceInfo* infos_values,
+    uint32_t                     infos_count);
+
 
 
   typedef struct remixapi_Viewport {
@@ -686,6 +699,11 @@ typedef enum remixapi_Format {
   typedef remixapi_ErrorCode(REMIXAPI_PTR* PFN_remixapi_DrawLightInstance)(
     remixapi_LightHandle      lightHandle);
 
+  // Same as DrawLightInstance, but submits all lights with a single command
+  typedef remixapi_ErrorCode(REMIXAPI_PTR* PFN_remixapi_DrawLightInstances)(
+    const remixapi_LightHandle* lightHandles_values,
+    uint32_t                    lightHandles_count);
+
 
   typedef remixapi_ErrorCode(REMIXAPI_PTR* PFN_remixapi_SetConfigVariable)(
     const char*               key,
@@ -789,6 +807,11 @@ typedef enum remixapi_Format {
     PFN_remixapi_DrawUIInstance     DrawUIInstance;
     PFN_remixapi_CreateImage        CreateImage;
     PFN_remixapi_DestroyImage       DestroyImage;
+
+    // Batched submission
+    PFN_remixapi_CreateMeshes       CreateMeshes;
+    PFN_remixapi_DrawInstances      DrawInstances;
+    PFN_remixapi_DrawLightInstances DrawLightInstances;
   } remixapi_Interface;
 
   REMIXAPI remixapi_ErrorCode REMIXAPI_CALL remixapi_InitializeLibrary(
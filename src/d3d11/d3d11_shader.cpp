@@ -30,6 +30,18 @@ namespace dxvk {
       reader.store(std::ofstream(str::tows(str::format(dumpPath, "/", name, ".dxbc").c_str()).c_str(),
         std::ios_base::binary | std::ios_base::trunc));
     }
+
+    // NV-DXVK start: shader corpus capture
+    // Raw bytecode only, to build corpora for the offline compile benchmark
+    const std::string bytecodeDumpPath = env::getEnvVar("DXVK_SHADER_BYTECODE_DUMP_PATH");
+
+    if (bytecodeDumpPath.size() != 0) {
+      env::createDirectory(bytecodeDumpPath);
+
+      reader.store(std::ofstream(str::tows(str::format(bytecodeDumpPath, "/", name, ".dxbc").c_str()).c_str(),
+        std::ios_base::binary | std::ios_base::trunc));
+    }
+    // NV-DXVK end
     
     // Decide whether we need to create a pass-through
     // geometry shader for vertex shader stream output
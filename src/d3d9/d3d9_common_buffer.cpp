@@ -39,6 +39,10 @@ namespace dxvk {
 
     if (m_desc.Pool != D3DPOOL_DEFAULT)
       m_dirtyRange = D3D9Range(0, m_desc.Size);
+
+    // Creation counts as a write to the whole buffer, so anything keyed on a
+    // recycled DxvkBuffer address can never validate against this buffer.
+    MarkWritten(D3D9Range(0, m_desc.Size));
   }
 
 
@@ -63,6 +67,41 @@ namespace dxvk {
   }
 
 
+  static std::atomic<uint64_t> s_writeGeneration = { 0ull };
+
+
+  void D3D9CommonBuffer::MarkWritten(D3D9Range range) {
+    WriteRecord& record = m_writeHistory[m_writeCount % WriteHistorySize];
+    record.generation = ++s_writeGeneration;
+    record.range = range;
+    ++m_writeCount;
+  }
+
+
+  bool D3D9CommonBuffer::WasWrittenSince(uint64_t generation, D3D9Range range) const {
+    const uint32_t numRecords = std::min(m_writeCount, WriteHistorySize);
+
+    for (uint32_t i = 1; i <= numRecords; i++) {
+      const WriteRecord& record = m_writeHistory[(m_writeCount - i) % WriteHistorySize];
+
+      if (record.generation <= generation)
+        return false;
+
+      if (record.range.max > range.min && record.range.min < range.max)
+        return true;
+    }
+
+    // Every recorded write is newer than the generation, and older ones may
+    // have been dropped from the history.
+    return true;
+  }
+
+
+  uint64_t D3D9CommonBuffer::GetCurrentWriteGeneration() {
+    return s_writeGeneration.load();
+  }
+
+
   HRESULT D3D9CommonBuffer::ValidateBufferProperties(const D3D9_BUFFER_DESC* pDesc) {
     if (pDesc->Size == 0)
       return D3DERR_INVALIDCALL;
@@ -151,6 +151,11 @@ namespace dxvk {
      */
     inline D3D9Range& GPUReadingRange() { return m_gpuReadingRange; }
 
+    /**
+     * \brief The range of the buffer written through Lock calls since it was last fully unlocked
+     */
+    inline D3D9Range& LockedWriteRange() { return m_lockedWriteRange; }
+
     /**
     * \brief Whether or not the buffer was written to by the GPU (in IDirect3DDevice9::ProcessVertices)
     */
@@ -161,6 +166,31 @@ namespace dxvk {
     */
     inline void SetWrittenByGPU(bool state) { m_wasWrittenByGPU = state; }
 
+    /**
+     * \brief Records a CPU or GPU write to the given range of the buffer
+     *
+     * Every write is stamped with a device-wide, monotonically increasing
+     * generation, so data derived from the buffer contents (e.g. RTX geometry
+     * hashes) can later be validated with \ref WasWrittenSince.
+     * \param [in] range Range of the buffer that was written
+     */
+    void MarkWritten(D3D9Range range);
+
+    /**
+     * \brief Checks whether a range was written after a given generation
+     *
+     * Conservative: returns true if the write history no longer reaches back
+     * far enough to prove the range was untouched.
+     * \param [in] generation Generation the caller's data was derived at
+     * \param [in] range Range of the buffer the caller's data covers
+     */
+    bool WasWrittenSince(uint64_t generation, D3D9Range range) const;
+
+    /**
+     * \brief Current device-wide write generation
+     */
+    static uint64_t GetCurrentWriteGeneration();
+
     inline uint32_t IncrementLockCount() { return ++m_lockCount; }
     inline uint32_t DecrementLockCount() {
       if (m_lockCount == 0)
@@ -238,9 +268,20 @@ namespace dxvk {
 
     D3D9Range                   m_dirtyRange;
     D3D9Range                   m_gpuReadingRange;
+    D3D9Range                   m_lockedWriteRange;
 
     uint32_t                    m_lockCount = 0;
 
+    struct WriteRecord {
+      uint64_t  generation = 0;
+      D3D9Range range;
+    };
+
+    static constexpr uint32_t   WriteHistorySize = 8;
+
+    std::array<WriteRecord, WriteHistorySize> m_writeHistory;
+    uint32_t                    m_writeCount = 0;
+
     uint64_t                    m_seq = 0ull;
 
   };
@@ -94,6 +94,9 @@ namespace dxvk {
     , m_state          ( Direct3DState9 { D3D9CapturableState{ static_cast<uint32_t>(std::max(m_d3d9Options.maxEnabledLights, 0)) } } )
 // NV-DXVK end
     , m_rtx            ( this, WithDrawCallConversion)
+// NV-DXVK start: user pointer ring
+    , m_upRing         ( dxvkDevice )
+// NV-DXVK end
 // NV-DXVK start: external API
     , m_withExternalSwapchain { WithExternalSwapchain } {
 // NV-DXVK end
@@ -124,6 +127,14 @@ namespace dxvk {
 
     m_dxsoOptions = DxsoOptions(this, m_d3d9Options);
 
+    // NV-DXVK start: persistent DXSO shader cache, fixed-function shader precompilation
+    if (m_d3d9Options.enableShaderCache)
+      m_shaderModules->InitDiskCache();
+
+    if (m_d3d9Options.enableFixedFunctionShaderCache)
+      m_ffModules.InitPrecompile(this);
+    // NV-DXVK end
+
     const bool supportsRobustness2 = m_dxvkDevice->features().extRobustness2.robustBufferAccess2;
     bool useRobustConstantAccess = supportsRobustness2;
     if (useRobustConstantAccess) {
@@ -2662,7 +2673,7 @@ namespace dxvk {
     const uint32_t dataSize = GetUPDataSize(drawInfo.vertexCount, VertexStreamZeroStride);
     const uint32_t bufferSize = GetUPBufferSize(drawInfo.vertexCount, VertexStreamZeroStride);
 
-    auto upSlice = AllocTempBuffer<false, true>(bufferSize);
+    auto upSlice = AllocUPBuffer(bufferSize);
     FillUPVertexBuffer(upSlice.mapPtr, pVertexStreamZeroData, dataSize, bufferSize);
 
     // NV-DXVK start: geometry processing
@@ -2736,7 +2747,7 @@ namespace dxvk {
 
     const uint32_t upSize = vertexBufferSize + indicesSize;
 
-    auto upSlice = AllocTempBuffer<false, true>(upSize);
+    auto upSlice = AllocUPBuffer(upSize);
     uint8_t* data = reinterpret_cast<uint8_t*>(upSlice.mapPtr);
     FillUPVertexBuffer(data, pVertexStreamZeroData, vertexDataSize, vertexBufferSize);
     std::memcpy(data + vertexBufferSize, pIndexData, indicesSize);
@@ -2925,6 +2936,9 @@ namespace dxvk {
     }
 
     dst->SetWrittenByGPU(true);
+    // NV-DXVK start: track GPU writes for the RTX geometry hash cache
+    dst->MarkWritten(D3D9Range(0, dst->Desc()->Size));
+    // NV-DXVK end
     TrackBufferMappingBufferSequenceNumber(dst);
 
     return D3D_OK;
@@ -4401,6 +4415,15 @@ namespace dxvk {
     }
   }
 
+// NV-DXVK start: user pointer ring
+  D3D9BufferSlice D3D9DeviceEx::AllocUPBuffer(VkDeviceSize size) {
+    D3D9BufferSlice result;
+    result.slice  = m_upRing.Alloc(size);
+    result.mapPtr = result.slice.mapPtr(0);
+    return result;
+  }
+// NV-DXVK end
+
   bool D3D9DeviceEx::ShouldRecord() {
     return m_recorder != nullptr && !m_recorder->IsApplying();
   }
@@ -4976,6 +4999,15 @@ namespace dxvk {
     if ((desc.Pool == D3DPOOL_DEFAULT || !(Flags & D3DLOCK_NO_DIRTY_UPDATE)) && !(Flags & D3DLOCK_READONLY))
       pResource->DirtyRange().Conjoin(lockRange);
 
+    // NV-DXVK start: track CPU writes for the RTX geometry hash cache
+    // Note: NO_DIRTY_UPDATE only skips the upload tracking, the data still changes.
+    // The range is stamped again in UnlockBuffer once the application is done writing.
+    if (!(Flags & D3DLOCK_READONLY)) {
+      pResource->MarkWritten(lockRange);
+      pResource->LockedWriteRange().Conjoin(lockRange);
+    }
+    // NV-DXVK end
+
     Rc<DxvkBuffer> mappingBuffer = pResource->GetBuffer<D3D9_COMMON_BUFFER_TYPE_MAPPING>();
 
     DxvkBufferSliceHandle physSlice;
@@ -5095,6 +5127,14 @@ namespace dxvk {
     if (pResource->DecrementLockCount() != 0)
       return D3D_OK;
 
+    // NV-DXVK start: track CPU writes for the RTX geometry hash cache
+    // Note: Anything derived from the buffer while it was locked may have seen partially written data.
+    if (!pResource->LockedWriteRange().IsDegenerate()) {
+      pResource->MarkWritten(pResource->LockedWriteRange());
+      pResource->LockedWriteRange().Clear();
+    }
+    // NV-DXVK end
+
     if (pResource->GetMapMode() != D3D9_COMMON_BUFFER_MAP_MODE_BUFFER)
       return D3D_OK;
 
@@ -6864,6 +6904,12 @@ namespace dxvk {
       Count,
       m_d3d9Options.d3d9FloatEmulation == D3D9FloatEmulation::Enabled);
 
+    // NV-DXVK start: incremental vertex shader constant hashing
+    if constexpr (ProgramType == DxsoProgramType::VertexShader) {
+      m_rtx.SetVertexShaderConstantsDirty<ConstantType>(StartRegister, Count);
+    }
+    // NV-DXVK end
+
     return D3D_OK;
   }
 
@@ -30,6 +30,9 @@
 #include <type_traits>
 #include <unordered_map>
 #include "d3d9_rtx.h"
+// NV-DXVK start: user pointer ring
+#include "d3d9_up_ring.h"
+// NV-DXVK end
 
 #include "../util/util_flush.h"
 #include "../util/util_lru.h"
@@ -1000,6 +1003,10 @@ namespace dxvk {
     template<bool UpBuffer, bool ShaderBuffer = false>
     D3D9BufferSlice AllocTempBuffer(VkDeviceSize size);
 
+// NV-DXVK start: user pointer ring
+    D3D9BufferSlice AllocUPBuffer(VkDeviceSize size);
+// NV-DXVK end
+
     bool ShouldRecord();
 
     HRESULT               CreateShaderModule(
@@ -1305,6 +1312,10 @@ namespace dxvk {
 
     D3D9Rtx                         m_rtx;
 
+// NV-DXVK start: user pointer ring
+    D3D9UPRing                      m_upRing;
+// NV-DXVK end
+
 // NV-DXVK start: external API
     bool                            m_withExternalSwapchain;
 // NV-DXVK end
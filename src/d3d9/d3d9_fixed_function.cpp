@@ -12,7 +12,9 @@
 
 #include "../spirv/spirv_module.h"
 
+#include <algorithm>
 #include <cfloat>
+#include <fstream>
 
 namespace dxvk {
 
@@ -2685,18 +2687,18 @@ namespace dxvk {
   }
 
 
+  // NV-DXVK start: fixed-function shader precompilation
   D3D9FFShader::D3D9FFShader(
-          D3D9DeviceEx*         pDevice,
-    const D3D9FFShaderKeyVS&    Key) {
+    const D3D9FixedFunctionOptions& Options,
+    const D3D9FFShaderKeyVS&        Key) {
     Sha1Hash hash = Sha1Hash::compute(&Key, sizeof(Key));
     DxvkShaderKey shaderKey = { VK_SHADER_STAGE_VERTEX_BIT, hash };
 
     std::string name = str::format("FF_", shaderKey.toString());
 
+    // The compiler does not use the device
     D3D9FFShaderCompiler compiler(
-      pDevice->GetDXVKDevice(),
-      Key, name,
-      pDevice->GetOptions());
+      nullptr, Key, name, Options);
 
     m_shader = compiler.compile();
     m_isgn   = compiler.isgn();
@@ -2704,22 +2706,19 @@ namespace dxvk {
     Dump(Key, name);
 
     m_shader->setShaderKey(shaderKey);
-    pDevice->GetDXVKDevice()->registerShader(m_shader);
   }
 
 
   D3D9FFShader::D3D9FFShader(
-          D3D9DeviceEx*         pDevice,
-    const D3D9FFShaderKeyFS&    Key) {
+    const D3D9FixedFunctionOptions& Options,
+    const D3D9FFShaderKeyFS&        Key) {
     Sha1Hash hash = Sha1Hash::compute(&Key, sizeof(Key));
     DxvkShaderKey shaderKey = { VK_SHADER_STAGE_FRAGMENT_BIT, hash };
 
     std::string name = str::format("FF_", shaderKey.toString());
 
     D3D9FFShaderCompiler compiler(
-      pDevice->GetDXVKDevice(),
-      Key, name,
-      pDevice->GetOptions());
+      nullptr, Key, name, Options);
 
     m_shader = compiler.compile();
     m_isgn   = compiler.isgn();
@@ -2727,8 +2726,8 @@ namespace dxvk {
     Dump(Key, name);
 
     m_shader->setShaderKey(shaderKey);
-    pDevice->GetDXVKDevice()->registerShader(m_shader);
   }
+  // NV-DXVK end
 
   template <typename T>
   void D3D9FFShader::Dump(const T& Key, const std::string& Name) {
@@ -2744,6 +2743,263 @@ namespace dxvk {
   }
 
 
+  // NV-DXVK start: fixed-function shader precompilation
+  /**
+   * \brief Fixed-function shader key file of the process
+   *
+   * Opened once and shared by all devices, so a device
+   * created later does not discard what earlier ones
+   * recorded. Keys not in the file yet are appended.
+   */
+  class D3D9FFShaderKeyFile {
+
+  public:
+
+    static D3D9FFShaderKeyFile& Get() {
+      static D3D9FFShaderKeyFile s_instance;
+      return s_instance;
+    }
+
+    void GetKeys(
+            std::vector<D3D9FFShaderKeyVS>& VsKeys,
+            std::vector<D3D9FFShaderKeyFS>& FsKeys) {
+      std::lock_guard<dxvk::mutex> lock(m_mutex);
+      VsKeys = m_vsKeys;
+      FsKeys = m_fsKeys;
+    }
+
+    void Record(const D3D9FFShaderKeyVS& ShaderKey) {
+      Record(D3D9FFShaderKeyType::Vertex, ShaderKey, m_vsKeySet, m_vsKeys);
+    }
+
+    void Record(const D3D9FFShaderKeyFS& ShaderKey) {
+      Record(D3D9FFShaderKeyType::Fragment, ShaderKey, m_fsKeySet, m_fsKeys);
+    }
+
+  private:
+
+    template<typename Key>
+    using KeySet = std::unordered_set<Key, D3D9FFShaderKeyHash, D3D9FFShaderKeyEq>;
+
+    dxvk::mutex                         m_mutex;
+    std::ofstream                       m_file;
+
+    std::vector<D3D9FFShaderKeyVS>      m_vsKeys;
+    std::vector<D3D9FFShaderKeyFS>      m_fsKeys;
+    KeySet<D3D9FFShaderKeyVS>           m_vsKeySet;
+    KeySet<D3D9FFShaderKeyFS>           m_fsKeySet;
+
+    D3D9FFShaderKeyFile() {
+      const std::string fileName = D3D9FFShaderModuleSet::GetKeyFileName();
+
+      std::vector<D3D9FFShaderKeyVS> vsKeys;
+      std::vector<D3D9FFShaderKeyFS> fsKeys;
+      const bool isValid = ReadFFShaderKeyFile(fileName, vsKeys, fsKeys);
+
+      for (const auto& key : vsKeys) {
+        if (m_vsKeySet.insert(key).second)
+          m_vsKeys.push_back(key);
+      }
+
+      for (const auto& key : fsKeys) {
+        if (m_fsKeySet.insert(key).second)
+          m_fsKeys.push_back(key);
+      }
+
+      // Reading stops at the first incomplete record, anything
+      // past the records it returned would corrupt appended keys
+      const std::streamoff completeSize = std::streamoff(sizeof(D3D9FFShaderKeyFileHeader)
+        + vsKeys.size() * (sizeof(D3D9FFShaderKeyType) + sizeof(D3D9FFShaderKeyVS))
+        + fsKeys.size() * (sizeof(D3D9FFShaderKeyType) + sizeof(D3D9FFShaderKeyFS)));
+
+      const bool canAppend = isValid && std::ifstream(str::tows(fileName.c_str()).c_str(),
+        std::ios_base::binary | std::ios_base::ate).tellg() == completeSize;
+
+      std::string directory = fileName.substr(0, fileName.find_last_of('/') + 1);
+
+      if (!directory.empty())
+        env::createDirectory(directory);
+
+      if (canAppend) {
+        m_file = std::ofstream(str::tows(fileName.c_str()).c_str(),
+          std::ios_base::binary | std::ios_base::app);
+      } else {
+        // Start over with only the complete, unique records
+        m_file = std::ofstream(str::tows(fileName.c_str()).c_str(),
+          std::ios_base::binary | std::ios_base::trunc);
+
+        if (m_file) {
+          D3D9FFShaderKeyFileHeader header;
+          m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+          for (const auto& key : m_vsKeys)
+            Write(D3D9FFShaderKeyType::Vertex, key);
+
+          for (const auto& key : m_fsKeys)
+            Write(D3D9FFShaderKeyType::Fragment, key);
+        }
+      }
+
+      if (!m_file)
+        Logger::warn(str::format("D3D9: Failed to open fixed-function shader key file ", fileName));
+    }
+
+    template<typename Key>
+    void Record(
+            D3D9FFShaderKeyType   Type,
+      const Key&                  ShaderKey,
+            KeySet<Key>&          Set,
+            std::vector<Key>&     Keys) {
+      std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+      // Another device may have recorded it already
+      if (!Set.insert(ShaderKey).second)
+        return;
+
+      Keys.push_back(ShaderKey);
+      Write(Type, ShaderKey);
+    }
+
+    template<typename Key>
+    void Write(
+            D3D9FFShaderKeyType   Type,
+      const Key&                  ShaderKey) {
+      if (!m_file)
+        return;
+
+      // Flush every key, so that a crash later on does not lose it
+      m_file.write(reinterpret_cast<const char*>(&Type), sizeof(Type));
+      m_file.write(reinterpret_cast<const char*>(&ShaderKey), sizeof(ShaderKey));
+      m_file.flush();
+    }
+
+  };
+
+
+  D3D9FFShaderModuleSet::~D3D9FFShaderModuleSet() {
+    m_stopPrecompile.store(true);
+
+    for (auto& thread : m_precompileThreads)
+      thread.join();
+  }
+
+
+  void D3D9FFShaderModuleSet::InitPrecompile(
+          D3D9DeviceEx*         pDevice) {
+    m_options = D3D9FixedFunctionOptions(pDevice->GetOptions());
+
+    // Keys of earlier runs, and of devices created before this one
+    D3D9FFShaderKeyFile::Get().GetKeys(m_recordedVsKeys, m_recordedFsKeys);
+
+    m_precompileVs.queued.insert(m_recordedVsKeys.begin(), m_recordedVsKeys.end());
+    m_precompileFs.queued.insert(m_recordedFsKeys.begin(), m_recordedFsKeys.end());
+
+    const uint32_t keyCount = uint32_t(m_recordedVsKeys.size() + m_recordedFsKeys.size());
+
+    if (keyCount == 0)
+      return;
+
+    uint32_t numWorkers = dxvk::thread::hardware_concurrency() / 2;
+    numWorkers = std::clamp(numWorkers, 1u, std::min(keyCount, 8u));
+
+    Logger::info(str::format("D3D9: Precompiling ", keyCount, " fixed-function shaders on ", numWorkers, " threads"));
+
+    m_precompileStart = dxvk::high_resolution_clock::now();
+
+    for (uint32_t i = 0; i < numWorkers; i++)
+      m_precompileThreads.emplace_back([this] () { PrecompileFunc(); });
+  }
+
+
+  std::string D3D9FFShaderModuleSet::GetKeyFileName() {
+    std::string path = env::getEnvVar("DXVK_SHADER_CACHE_PATH");
+
+    if (!path.empty() && *path.rbegin() != '/')
+      path += '/';
+
+    return path + env::getExeBaseName() + ".ff-keys";
+  }
+
+
+  void D3D9FFShaderModuleSet::PrecompileFunc() {
+    env::setThreadName("dxvk-ff-shader");
+
+    const uint32_t vsKeyCount = uint32_t(m_recordedVsKeys.size());
+    const uint32_t keyCount   = uint32_t(m_recordedFsKeys.size()) + vsKeyCount;
+
+    for (uint32_t i = m_nextRecordedKey++; i < keyCount; i = m_nextRecordedKey++) {
+      if (m_stopPrecompile.load())
+        return;
+
+      if (i < vsKeyCount)
+        Precompile(m_precompileVs, m_recordedVsKeys[i]);
+      else
+        Precompile(m_precompileFs, m_recordedFsKeys[i - vsKeyCount]);
+
+      if (++m_numPrecompiled == keyCount) {
+        using ms = std::chrono::duration<double, std::milli>;
+
+        Logger::info(str::format("D3D9: Precompiled ", keyCount, " fixed-function shaders in ",
+          ms(dxvk::high_resolution_clock::now() - m_precompileStart).count(), " ms"));
+      }
+    }
+  }
+
+
+  template<typename Key>
+  void D3D9FFShaderModuleSet::Precompile(
+          PrecompileSet<Key>&   Set,
+    const Key&                  ShaderKey) {
+    { std::lock_guard<dxvk::mutex> lock(m_precompileMutex);
+
+      // The device already compiled this one itself
+      if (!Set.queued.erase(ShaderKey))
+        return;
+
+      Set.compiling.insert(ShaderKey);
+    }
+
+    D3D9FFShader shader(m_options, ShaderKey);
+
+    { std::lock_guard<dxvk::mutex> lock(m_precompileMutex);
+      Set.compiling.erase(ShaderKey);
+      Set.compiled.insert({ ShaderKey, shader });
+    }
+
+    m_precompileCond.notify_all();
+  }
+
+
+  template<typename Key>
+  std::optional<D3D9FFShader> D3D9FFShaderModuleSet::TakePrecompiled(
+          PrecompileSet<Key>&   Set,
+    const Key&                  ShaderKey,
+          bool&                 IsRecorded) {
+    std::unique_lock<dxvk::mutex> lock(m_precompileMutex);
+
+    // Compiling it again would not be any faster than waiting
+    m_precompileCond.wait(lock, [&] {
+      return Set.compiling.find(ShaderKey) == Set.compiling.end();
+    });
+
+    auto entry = Set.compiled.find(ShaderKey);
+
+    if (entry != Set.compiled.end()) {
+      std::optional<D3D9FFShader> shader = entry->second;
+      Set.compiled.erase(entry);
+      IsRecorded = true;
+      return shader;
+    }
+
+    // No worker got to it yet, the caller compiles it instead
+    IsRecorded = Set.queued.erase(ShaderKey) != 0;
+    return std::nullopt;
+  }
+
+
+  // NV-DXVK end
+
+
   D3D9FFShader D3D9FFShaderModuleSet::GetShaderModule(
           D3D9DeviceEx*         pDevice,
     const D3D9FFShaderKeyVS&    ShaderKey) {
@@ -2751,13 +3007,24 @@ namespace dxvk {
     auto entry = m_vsModules.find(ShaderKey);
     if (entry != m_vsModules.end())
       return entry->second;
-    
-    D3D9FFShader shader(
-      pDevice, ShaderKey);
 
-    m_vsModules.insert({ShaderKey, shader});
+    // NV-DXVK start: fixed-function shader precompilation
+    bool isRecorded = false;
+
+    std::optional<D3D9FFShader> shader = TakePrecompiled(m_precompileVs, ShaderKey, isRecorded);
+
+    if (!shader)
+      shader.emplace(D3D9FixedFunctionOptions(pDevice->GetOptions()), ShaderKey);
 
-    return shader;
+    if (!isRecorded && pDevice->GetOptions()->enableFixedFunctionShaderCache)
+      D3D9FFShaderKeyFile::Get().Record(ShaderKey);
+
+    pDevice->GetDXVKDevice()->registerShader(shader->GetShader());
+
+    m_vsModules.insert({ShaderKey, *shader});
+
+    return *shader;
+    // NV-DXVK end
   }
 
 
@@ -2768,14 +3035,105 @@ namespace dxvk {
     auto entry = m_fsModules.find(ShaderKey);
     if (entry != m_fsModules.end())
       return entry->second;
-    
-    D3D9FFShader shader(
-      pDevice, ShaderKey);
 
-    m_fsModules.insert({ShaderKey, shader});
+    // NV-DXVK start: fixed-function shader precompilation
+    bool isRecorded = false;
+
+    std::optional<D3D9FFShader> shader = TakePrecompiled(m_precompileFs, ShaderKey, isRecorded);
+
+    if (!shader)
+      shader.emplace(D3D9FixedFunctionOptions(pDevice->GetOptions()), ShaderKey);
+
+    if (!isRecorded && pDevice->GetOptions()->enableFixedFunctionShaderCache)
+      D3D9FFShaderKeyFile::Get().Record(ShaderKey);
+
+    pDevice->GetDXVKDevice()->registerShader(shader->GetShader());
+
+    m_fsModules.insert({ShaderKey, *shader});
+
+    return *shader;
+    // NV-DXVK end
+  }
+
+
+  // NV-DXVK start: fixed-function shader precompilation
+  bool ReadFFShaderKeyFile(
+    const std::string&                    FileName,
+          std::vector<D3D9FFShaderKeyVS>& VsKeys,
+          std::vector<D3D9FFShaderKeyFS>& FsKeys) {
+    std::ifstream file(str::tows(FileName.c_str()).c_str(), std::ios_base::binary);
+
+    if (!file)
+      return false;
+
+    const D3D9FFShaderKeyFileHeader expected;
+    D3D9FFShaderKeyFileHeader header;
+
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+     || std::memcmp(&header, &expected, sizeof(header))) {
+      Logger::warn("D3D9: Fixed-function shader key file is out of date");
+      return false;
+    }
+
+    D3D9FFShaderKeyType type;
+
+    while (file.read(reinterpret_cast<char*>(&type), sizeof(type))) {
+      if (type == D3D9FFShaderKeyType::Vertex) {
+        D3D9FFShaderKeyVS key;
+
+        if (!file.read(reinterpret_cast<char*>(&key), sizeof(key)))
+          break;
+
+        VsKeys.push_back(key);
+      } else if (type == D3D9FFShaderKeyType::Fragment) {
+        D3D9FFShaderKeyFS key;
+
+        if (!file.read(reinterpret_cast<char*>(&key), sizeof(key)))
+          break;
+
+        FsKeys.push_back(key);
+      } else {
+        break;
+      }
+    }
+
+    return true;
+  }
+
+
+  uint32_t compileFixedFunctionShaderKeys(
+    const char*               keyFilePath,
+    pfnFFShaderCompileReport  report) {
+    std::vector<D3D9FFShaderKeyVS> vsKeys;
+    std::vector<D3D9FFShaderKeyFS> fsKeys;
+
+    if (!ReadFFShaderKeyFile(keyFilePath, vsKeys, fsKeys))
+      return 0;
+
+    // Default options, a device is not needed to compile
+    const D3D9FixedFunctionOptions options;
+
+    auto compile = [&] (const auto& key) {
+      const auto t0 = dxvk::high_resolution_clock::now();
+      D3D9FFShader shader(options, key);
+      const auto t1 = dxvk::high_resolution_clock::now();
+
+      if (report) {
+        report(shader.GetShader()->debugName().c_str(),
+          uint32_t(shader.GetShader()->getCode().size()),
+          std::chrono::duration<double, std::milli>(t1 - t0).count());
+      }
+    };
+
+    for (const auto& key : vsKeys)
+      compile(key);
+
+    for (const auto& key : fsKeys)
+      compile(key);
 
-    return shader;
+    return uint32_t(vsKeys.size() + fsKeys.size());
   }
+  // NV-DXVK end
 
 
   size_t D3D9FFShaderKeyHash::operator () (const D3D9FFShaderKeyVS& key) const {
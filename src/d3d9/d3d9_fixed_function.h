@@ -8,8 +8,13 @@
 
 #include "../dxso/dxso_isgn.h"
 
+#include "../util/thread.h"
+#include "../util/util_time.h"
+
 #include <unordered_map>
+#include <unordered_set>
 #include <bitset>
+#include <optional>
 
 namespace dxvk {
 
@@ -37,9 +42,12 @@ namespace dxvk {
   };
 
   struct D3D9FixedFunctionOptions {
+    // NV-DXVK start: fixed-function shader precompilation
+    D3D9FixedFunctionOptions() = default;
+    // NV-DXVK end
     D3D9FixedFunctionOptions(const D3D9Options* options);
 
-    bool invariantPosition;
+    bool invariantPosition = false;
   };
 
   // Returns new oFog if VS
@@ -194,17 +202,68 @@ namespace dxvk {
     bool operator () (const D3D9FFShaderKeyFS& a, const D3D9FFShaderKeyFS& b) const;
   };
 
+  // NV-DXVK start: fixed-function shader precompilation
+  /**
+   * \brief Fixed-function shader key file header
+   *
+   * The file is followed by records of one \c uint32_t key
+   * type and the raw key. Files with a different version
+   * or key sizes are discarded, so the version needs to be
+   * bumped whenever the meaning of key bits changes.
+   */
+  struct D3D9FFShaderKeyFileHeader {
+    char     magic[4]  = { 'D', '9', 'F', 'F' };
+    uint32_t version   = 1;
+    uint32_t vsKeySize = sizeof(D3D9FFShaderKeyVS);
+    uint32_t fsKeySize = sizeof(D3D9FFShaderKeyFS);
+  };
+
+  static_assert(sizeof(D3D9FFShaderKeyFileHeader) == 16);
+
+  enum class D3D9FFShaderKeyType : uint32_t {
+    Vertex,
+    Fragment,
+  };
+
+  /**
+   * \brief Reads a fixed-function shader key file
+   *
+   * A partially written record at the end of the
+   * file, e.g. after a crash, is ignored.
+   * \param [in] FileName Key file path
+   * \param [out] VsKeys Recorded vertex shader keys
+   * \param [out] FsKeys Recorded fragment shader keys
+   * \returns \c false if the file is missing or incompatible
+   */
+  bool ReadFFShaderKeyFile(
+    const std::string&                    FileName,
+          std::vector<D3D9FFShaderKeyVS>& VsKeys,
+          std::vector<D3D9FFShaderKeyFS>& FsKeys);
+
+  // Compiles every key in a key file without a device, reporting each
+  // compile time. Exported for the standalone precompilation harness.
+  using pfnFFShaderCompileReport = void (*)(const char* name, uint32_t codeSize, double milliseconds);
+
+  extern "C" __declspec(dllexport) uint32_t compileFixedFunctionShaderKeys(
+    const char*               keyFilePath,
+    pfnFFShaderCompileReport  report);
+  // NV-DXVK end
+
   class D3D9FFShader {
 
   public:
 
+    // NV-DXVK start: fixed-function shader precompilation
+    // Compiles the shader without registering it with a device,
+    // so that this can run on the precompilation threads.
     D3D9FFShader(
-            D3D9DeviceEx*         pDevice,
-      const D3D9FFShaderKeyVS&    Key);
+      const D3D9FixedFunctionOptions& Options,
+      const D3D9FFShaderKeyVS&        Key);
 
     D3D9FFShader(
-            D3D9DeviceEx*         pDevice,
-      const D3D9FFShaderKeyFS&    Key);
+      const D3D9FixedFunctionOptions& Options,
+      const D3D9FFShaderKeyFS&        Key);
+    // NV-DXVK end
 
     template <typename T>
     void Dump(const T& Key, const std::string& Name);
@@ -226,6 +285,29 @@ namespace dxvk {
 
   public:
 
+    // NV-DXVK start: fixed-function shader precompilation
+    ~D3D9FFShaderModuleSet();
+
+    /**
+     * \brief Starts precompiling recorded shaders
+     *
+     * Compiles all shader keys recorded by earlier runs on
+     * worker threads, and records every key compiled on
+     * demand from now on, so that the next run has them.
+     * \param [in] pDevice The device
+     */
+    void InitPrecompile(
+            D3D9DeviceEx*         pDevice);
+
+    /**
+     * \brief Default key file name for this process
+     *
+     * Stored next to the DXSO shader cache, i.e. in
+     * \c DXVK_SHADER_CACHE_PATH if set.
+     */
+    static std::string GetKeyFileName();
+    // NV-DXVK end
+
     D3D9FFShader GetShaderModule(
             D3D9DeviceEx*         pDevice,
       const D3D9FFShaderKeyVS&    ShaderKey);
@@ -246,6 +328,51 @@ namespace dxvk {
       D3D9FFShader,
       D3D9FFShaderKeyHash, D3D9FFShaderKeyEq> m_fsModules;
 
+    // NV-DXVK start: fixed-function shader precompilation
+    template<typename Key>
+    struct PrecompileSet {
+      // Recorded keys no thread has started on yet
+      std::unordered_set<Key,
+        D3D9FFShaderKeyHash, D3D9FFShaderKeyEq> queued;
+      // Keys a worker is compiling right now
+      std::unordered_set<Key,
+        D3D9FFShaderKeyHash, D3D9FFShaderKeyEq> compiling;
+      // Finished shaders the device has not asked for yet
+      std::unordered_map<Key, D3D9FFShader,
+        D3D9FFShaderKeyHash, D3D9FFShaderKeyEq> compiled;
+    };
+
+    D3D9FixedFunctionOptions          m_options;
+
+    std::vector<D3D9FFShaderKeyVS>    m_recordedVsKeys;
+    std::vector<D3D9FFShaderKeyFS>    m_recordedFsKeys;
+    std::atomic<uint32_t>             m_nextRecordedKey   = { 0u };
+    std::atomic<uint32_t>             m_numPrecompiled    = { 0u };
+    dxvk::high_resolution_clock::time_point m_precompileStart;
+
+    // Guarded by the mutex, workers and device both use them
+    dxvk::mutex                       m_precompileMutex;
+    dxvk::condition_variable          m_precompileCond;
+    PrecompileSet<D3D9FFShaderKeyVS>  m_precompileVs;
+    PrecompileSet<D3D9FFShaderKeyFS>  m_precompileFs;
+
+    std::atomic<bool>                 m_stopPrecompile    = { false };
+    std::vector<dxvk::thread>         m_precompileThreads;
+
+    void PrecompileFunc();
+
+    template<typename Key>
+    void Precompile(
+            PrecompileSet<Key>&   Set,
+      const Key&                  ShaderKey);
+
+    template<typename Key>
+    std::optional<D3D9FFShader> TakePrecompiled(
+            PrecompileSet<Key>&   Set,
+      const Key&                  ShaderKey,
+            bool&                 IsRecorded);
+    // NV-DXVK end
+
   };
 
 
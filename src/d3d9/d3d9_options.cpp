@@ -106,6 +106,12 @@ namespace dxvk {
     // NV-DXVK start: adapter override conf
     this->adapterOverride = config.getOption<int32_t>("d3d9.adapterOverride", -1);
     // NV-DXVK end
+    // NV-DXVK start: persistent DXSO shader cache
+    this->enableShaderCache             = config.getOption<bool>        ("d3d9.enableShaderCache",             true, "DXVK_SHADER_CACHE");
+    // NV-DXVK end
+    // NV-DXVK start: fixed-function shader precompilation
+    this->enableFixedFunctionShaderCache = config.getOption<bool>       ("d3d9.enableFixedFunctionShaderCache", this->enableShaderCache);
+    // NV-DXVK end
 
     // If we are not Nvidia, enable general hazards.
     this->generalHazards = adapter != nullptr
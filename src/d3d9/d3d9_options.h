@@ -197,6 +197,19 @@ namespace dxvk {
     /// Override the adapter/GPU used for D3D9 (-1 = use application defined)
     int adapterOverride;
     // NV-DXVK end
+
+    // NV-DXVK start: persistent DXSO shader cache
+    /// Keep translated shaders in a file across runs,
+    /// see DxsoShaderCache for where the file is stored
+    bool enableShaderCache;
+    // NV-DXVK end
+
+    // NV-DXVK start: fixed-function shader precompilation
+    /// Record fixed-function shader keys in a file, next to
+    /// the shader cache, and precompile them on startup of
+    /// the next run. Follows enableShaderCache unless set.
+    bool enableFixedFunctionShaderCache;
+    // NV-DXVK end
   };
 
 }
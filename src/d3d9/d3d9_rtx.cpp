@@ -103,6 +103,7 @@ namespace dxvk {
     T* pIndices = (T*) pBaseIndex;
     T* pIndicesDst = (T*) stagingSlice.mapPtr(0);
     copyIndices<T>(indexCount, pIndicesDst, pIndices, minIndex, maxIndex);
+    m_geometryCopyBytes += numIndexBytes;
 
     return stagingSlice;
   }
@@ -187,57 +188,74 @@ namespace dxvk {
 
   void D3D9Rtx::processVertices(const VertexContext vertexContext[caps::MaxStreams], int vertexIndexOffset, RasterGeometry& geoData) {
     DxvkBufferSlice streamCopies[caps::MaxStreams] {};
-
-    // Process vertex buffers from CPU
-    for (const auto& element : d3d9State().vertexDecl->GetElements()) {
-      // Get vertex context
-      const VertexContext& ctx = vertexContext[element.Stream];
-
-      if (ctx.mappedSlice.handle == VK_NULL_HANDLE)
-        continue;
-
-      ScopedCpuProfileZoneN("Process Vertices");
-      const int32_t vertexOffset = ctx.offset + ctx.stride * vertexIndexOffset;
-      const uint32_t numVertexBytes = ctx.stride * geoData.vertexCount;
-
-      // Validating index data here, vertexCount and vertexIndexOffset accounts for the min/max indices
-      if (RtxOptions::Get()->getValidateCPUIndexData()) {
-        if (ctx.mappedSlice.length < vertexOffset + numVertexBytes) {
-          throw DxvkError("Invalid draw call");
-        }
-      }
-
-      // TODO: Simplify this by refactoring RasterGeometry to contain an array of RasterBuffer's
-      RasterBuffer* targetBuffer = nullptr;
+    GeometryHashSource streamSources[caps::MaxStreams] {};
+    uint32_t packedStreams = 0;
+
+    // Packing moves position data to a new stride and drops the bytes around it, which legacy and vertex layout hashes depend on
+    const HashRule& generationHashRule = RtxOptions::Get()->GeometryHashGenerationRule;
+    const bool packStagedStreams = compactStagedVertexStreams() &&
+      !generationHashRule.test(HashComponents::LegacyPositions0) &&
+      !generationHashRule.test(HashComponents::LegacyPositions1) &&
+      !RtxOptions::Get()->GeometryAssetHashRule.test(HashComponents::VertexLayout);
+
+    // TODO: Simplify this by refactoring RasterGeometry to contain an array of RasterBuffer's
+    const auto getTargetBuffer = [&] (const D3DVERTEXELEMENT9& element) -> RasterBuffer* {
       switch (element.Usage) {
       case D3DDECLUSAGE_POSITIONT:
       case D3DDECLUSAGE_POSITION:
         if (element.UsageIndex == 0)
-          targetBuffer = &geoData.positionBuffer;
+          return &geoData.positionBuffer;
         break;
       case D3DDECLUSAGE_BLENDWEIGHT:
         if (element.UsageIndex == 0)
-          targetBuffer = &geoData.blendWeightBuffer;
+          return &geoData.blendWeightBuffer;
         break;
       case D3DDECLUSAGE_BLENDINDICES:
         if (element.UsageIndex == 0)
-          targetBuffer = &geoData.blendIndicesBuffer;
+          return &geoData.blendIndicesBuffer;
         break;
       case D3DDECLUSAGE_NORMAL:
         if (element.UsageIndex == 0)
-          targetBuffer = &geoData.normalBuffer;
+          return &geoData.normalBuffer;
         break;
       case D3DDECLUSAGE_TEXCOORD:
         if (m_texcoordIndex <= MAXD3DDECLUSAGEINDEX && element.UsageIndex == m_texcoordIndex)
-          targetBuffer = &geoData.texcoordBuffer;
+          return &geoData.texcoordBuffer;
         break;
       case D3DDECLUSAGE_COLOR:
         if (element.UsageIndex == 0 &&
             !lookupHash(RtxOptions::ignoreBakedLightingTextures(), m_activeDrawCallState.materialData.colorTextures[0].getImageHash())) {
-          targetBuffer = &geoData.color0Buffer;
+          return &geoData.color0Buffer;
         }
         break;
       }
+      return nullptr;
+    };
+
+    // Process vertex buffers from CPU
+    for (const auto& element : d3d9State().vertexDecl->GetElements()) {
+      // Get vertex context
+      const VertexContext& ctx = vertexContext[element.Stream];
+
+      if (ctx.mappedSlice.handle == VK_NULL_HANDLE)
+        continue;
+
+      ScopedCpuProfileZoneN("Process Vertices");
+      const int32_t vertexOffset = ctx.offset + ctx.stride * vertexIndexOffset;
+      const uint32_t numVertexBytes = ctx.stride * geoData.vertexCount;
+
+      // Validating index data here, vertexCount and vertexIndexOffset accounts for the min/max indices
+      if (RtxOptions::Get()->getValidateCPUIndexData()) {
+        if (ctx.mappedSlice.length < vertexOffset + numVertexBytes) {
+          throw DxvkError("Invalid draw call");
+        }
+      }
+
+      // Every element consumed from a packed stream already has its target buffer
+      if (packedStreams & (1u << element.Stream))
+        continue;
+
+      RasterBuffer* targetBuffer = getTargetBuffer(element);
 
       if (targetBuffer != nullptr) {
         assert(!targetBuffer->defined());
@@ -249,7 +267,7 @@ namespace dxvk {
 
           // Check if buffer is actualy a d3d9 orphan
           const bool isOrphan = !(ctx.buffer.getSliceHandle() == ctx.mappedSlice);
-          const bool canUseBuffer = ctx.canUseBuffer && m_forceGeometryCopy == false;
+          const bool canUseBuffer = ctx.canUseBuffer && (ctx.isImmutable || m_forceGeometryCopy == false);
 
           if (canUseBuffer && !isOrphan) {
             // Use the buffer directly if it is not an orphan
@@ -257,27 +275,151 @@ namespace dxvk {
               m_parent->FlushBuffer(ctx.pVBO);
 
             streamCopies[element.Stream] = ctx.buffer.subSlice(vertexOffset, numVertexBytes);
+
+            if (ctx.pVBO != nullptr && vertexOffset >= 0) {
+              streamSources[element.Stream].pBuffer = ctx.pVBO;
+              streamSources[element.Stream].range = D3D9Range(vertexOffset, vertexOffset + numVertexBytes);
+            }
           } else if (canUseBuffer && numVertexBytes > kMinSizeToClone) {
             // Create a clone for the orphaned physical slice
             auto clone = ctx.buffer.buffer()->clone();
             clone->rename(ctx.mappedSlice);
             streamCopies[element.Stream] = DxvkBufferSlice(clone, ctx.buffer.offset() + vertexOffset, numVertexBytes);
           } else {
+            if (packStagedStreams) {
+              // Copy only the elements consumed from this stream, rather than the whole vertex
+              VertexElementTarget targets[MAXD3DDECLLENGTH];
+              uint32_t targetCount = 0;
+
+              for (const auto& other : d3d9State().vertexDecl->GetElements()) {
+                RasterBuffer* otherTarget = other.Stream == element.Stream ? getTargetBuffer(other) : nullptr;
+
+                if (otherTarget != nullptr && targetCount < MAXD3DDECLLENGTH)
+                  targets[targetCount++] = { &other, otherTarget };
+              }
+
+              if (packVertexStream(ctx, vertexOffset, targets, targetCount, geoData)) {
+                packedStreams |= 1u << element.Stream;
+                continue;
+              }
+            }
+
             streamCopies[element.Stream] = m_rtStagingData.alloc(CACHE_LINE_SIZE, numVertexBytes);
 
             // Acquire prevents the staging allocator from re-using this memory
             streamCopies[element.Stream].buffer()->acquire(DxvkAccess::Read);
 
             memcpy(streamCopies[element.Stream].mapPtr(0), (uint8_t*) ctx.mappedSlice.mapPtr + vertexOffset, numVertexBytes);
+            m_geometryCopyBytes += numVertexBytes;
           }
         }
 
         *targetBuffer = RasterBuffer(streamCopies[element.Stream], element.Offset, ctx.stride, DecodeDecltype(D3DDECLTYPE(element.Type)));
         assert(targetBuffer->offset() % 4 == 0);
+
+        if (targetBuffer == &geoData.positionBuffer)
+          m_geometryHashSources.position = streamSources[element.Stream];
+        else if (targetBuffer == &geoData.texcoordBuffer)
+          m_geometryHashSources.texcoord = streamSources[element.Stream];
       }
     }
   }
 
+  bool D3D9Rtx::packVertexStream(const VertexContext& ctx, const int32_t vertexOffset, const VertexElementTarget* targets, const uint32_t targetCount, RasterGeometry& geoData) {
+    ScopedCpuProfileZone();
+
+    // Elements read by the raytracing geometry go first, in the order the geometry interleaver writes them, so that a stream
+    // providing all of them can be used without interleaving on the GPU.  Blend data only feeds skinning and gets its own stream.
+    constexpr uint32_t kMaxGroupElements = 4;
+    RasterBuffer* const groups[][kMaxGroupElements] = {
+      { &geoData.positionBuffer, &geoData.normalBuffer, &geoData.texcoordBuffer, &geoData.color0Buffer },
+      { &geoData.blendWeightBuffer, &geoData.blendIndicesBuffer, nullptr, nullptr },
+    };
+    constexpr uint32_t kGroupCount = sizeof(groups) / sizeof(groups[0]);
+
+    fast::PackedVertexElement packed[kGroupCount][kMaxGroupElements];
+    RasterBuffer* buffers[kGroupCount][kMaxGroupElements];
+    VkFormat formats[kGroupCount][kMaxGroupElements];
+    uint32_t counts[kGroupCount] = {};
+    uint32_t strides[kGroupCount] = {};
+
+    for (uint32_t g = 0; g < kGroupCount; g++) {
+      for (RasterBuffer* buffer : groups[g]) {
+        const VertexElementTarget* target = nullptr;
+        for (uint32_t i = 0; i < targetCount && buffer != nullptr; i++) {
+          if (targets[i].buffer == buffer) {
+            target = &targets[i];
+            break;
+          }
+        }
+
+        if (target == nullptr)
+          continue;
+
+        const D3DDECLTYPE type = D3DDECLTYPE(target->element->Type);
+        const uint32_t size = GetDecltypeSize(type);
+
+        // Leave anything unusual to the plain copy
+        if (size == 0 || target->element->Offset + size > ctx.stride)
+          return false;
+
+        fast::PackedVertexElement& element = packed[g][counts[g]];
+        element.srcOffset = target->element->Offset;
+        element.dstOffset = strides[g];
+        element.size = size;
+        element.conversion = fast::VertexElementConversion::Copy;
+
+        VkFormat format = DecodeDecltype(type);
+
+        // Positions and texcoords are hashed and must keep their exact bytes, normals and colors
+        // are converted to what the geometry interleaver would otherwise produce on the GPU
+        if (buffer == &geoData.normalBuffer) {
+          switch (type) {
+          case D3DDECLTYPE_FLOAT4:    element.size = sizeof(float) * 3; break;
+          case D3DDECLTYPE_FLOAT16_4: element.conversion = fast::VertexElementConversion::Half4ToFloat3; break;
+          case D3DDECLTYPE_SHORT4N:   element.conversion = fast::VertexElementConversion::Short4NToFloat3; break;
+          case D3DDECLTYPE_DEC3N:     element.conversion = fast::VertexElementConversion::Dec3NToFloat3; break;
+          case D3DDECLTYPE_UBYTE4N:   element.conversion = fast::VertexElementConversion::Ubyte4NToFloat3; break;
+          default: break;
+          }
+
+          if (type == D3DDECLTYPE_FLOAT4 || element.conversion != fast::VertexElementConversion::Copy)
+            format = VK_FORMAT_R32G32B32_SFLOAT;
+        } else if (buffer == &geoData.color0Buffer && type == D3DDECLTYPE_UBYTE4N) {
+          element.conversion = fast::VertexElementConversion::Rgba8ToBgra8;
+          format = VK_FORMAT_B8G8R8A8_UNORM;
+        }
+
+        buffers[g][counts[g]] = buffer;
+        formats[g][counts[g]] = format;
+        strides[g] += fast::packedVertexElementSize(element);
+        counts[g]++;
+      }
+    }
+
+    const uint8_t* pSrc = (const uint8_t*) ctx.mappedSlice.mapPtr + vertexOffset;
+
+    for (uint32_t g = 0; g < kGroupCount; g++) {
+      if (counts[g] == 0)
+        continue;
+
+      DxvkBufferSlice slice = m_rtStagingData.alloc(CACHE_LINE_SIZE, strides[g] * geoData.vertexCount);
+
+      // Acquire prevents the staging allocator from re-using this memory
+      slice.buffer()->acquire(DxvkAccess::Read);
+
+      fast::packVertexStream(slice.mapPtr(0), strides[g], pSrc, ctx.stride, geoData.vertexCount, packed[g], counts[g]);
+      m_geometryCopyBytes += strides[g] * geoData.vertexCount;
+
+      for (uint32_t i = 0; i < counts[g]; i++) {
+        *buffers[g][i] = RasterBuffer(slice, packed[g][i].dstOffset, strides[g], formats[g][i]);
+        assert(buffers[g][i]->offset() % 4 == 0);
+      }
+    }
+
+    return true;
+  }
+
   bool D3D9Rtx::processRenderState() {
     DrawCallTransforms& transformData = m_activeDrawCallState.transformData;
 
@@ -528,6 +670,7 @@ namespace dxvk {
     // The packet we'll send to RtxContext with information about geometry
     RasterGeometry& geoData = m_activeDrawCallState.geometryData;
     geoData = {};
+    m_geometryHashSources = {};
     geoData.cullMode = DecodeCullMode(D3DCULL(d3d9State().renderStates[D3DRS_CULLMODE]));
     geoData.frontFace = VK_FRONT_FACE_CLOCKWISE;
     geoData.topology = DecodeInputAssemblyState(drawContext.PrimitiveType).primitiveTopology;
@@ -553,6 +696,12 @@ namespace dxvk {
 
       geoData.vertexCount = maxIndex - minIndex + 1;
       vertexIndexOffset += minIndex;
+
+      if (indexContext.pIBO != nullptr) {
+        const uint32_t indexStride = geoData.indexBuffer.stride();
+        m_geometryHashSources.index.pBuffer = indexContext.pIBO;
+        m_geometryHashSources.index.range = D3D9Range(drawContext.StartIndex * indexStride, (drawContext.StartIndex + geoData.indexCount) * indexStride);
+      }
     } else {
       geoData.vertexCount = GetVertexCount(drawContext.PrimitiveType, drawContext.PrimitiveCount);
     }
@@ -755,7 +904,9 @@ namespace dxvk {
     memcpy(boneMatrices, d3d9State().transforms.data() + startBoneTransform, sizeof(Matrix4)*(maxBone + 1));
     m_stagedBonesCount += maxBone + 1;
 
-    return m_pGeometryWorkers->Schedule([boneMatrices, blendIndices, numBonesPerVertex, vertexCount]()->SkinningData {
+    BonePaletteArena* pBonePalettes = &m_bonePalettes;
+
+    return m_pGeometryWorkers->Schedule([boneMatrices, pBonePalettes, blendIndices, numBonesPerVertex, vertexCount]()->SkinningData {
       ScopedCpuProfileZone();
       uint32_t numBones = numBonesPerVertex;
 
@@ -779,16 +930,20 @@ namespace dxvk {
       // Pass bone data to RT back-end
 
       SkinningData skinningData;
-      skinningData.pBoneMatrices.reserve(numBones);
-
-      for (uint32_t n = 0; n < numBones; n++) {
-        skinningData.pBoneMatrices.push_back(boneMatrices[n]);
-      }
-
       skinningData.minBoneIndex = minBoneIndex;
       skinningData.numBones = numBones;
       skinningData.numBonesPerVertex = numBonesPerVertex;
-      skinningData.computeHash(); // Computes the hash and stores it in the skinningData itself
+
+      // Same as SkinningData::computeHash, which only covers the bones referenced by the vertices
+      const Matrix4* firstBone = boneMatrices + minBoneIndex;
+      skinningData.boneHash = XXH3_64bits(firstBone, (numBones - minBoneIndex) * sizeof(Matrix4));
+
+      // The palette key covers all the bones stored, extend the bone hash by the unreferenced ones
+      const XXH64_hash_t paletteKey = minBoneIndex == 0
+        ? skinningData.boneHash
+        : XXH3_64bits_withSeed(boneMatrices, minBoneIndex * sizeof(Matrix4), skinningData.boneHash);
+
+      skinningData.bonePalette = pBonePalettes->acquire(paletteKey, boneMatrices, numBones);
 
       return skinningData;
     });
@@ -996,6 +1151,7 @@ namespace dxvk {
 
       indices.indexBuffer = ibo->GetMappedSlice();
       indices.indexType = DecodeIndexType(ibo->Desc()->Format);
+      indices.pIBO = ibo;
     }
 
     // Copy over the vertex buffers that are actually required
@@ -1051,6 +1207,8 @@ namespace dxvk {
     vertices[0].buffer = buffer.slice.subSlice(0, vertexSize);
     vertices[0].mappedSlice = buffer.slice.getSliceHandle(0, vertexSize);
     vertices[0].canUseBuffer = true;
+    // UP data lives in the user pointer ring, which never writes to a slice again
+    vertices[0].isImmutable = true;
 
     return internalPrepareDraw(indices, vertices, drawContext);
   }
@@ -1106,6 +1264,16 @@ namespace dxvk {
     m_seenCameraPositionsPrev = std::move(m_seenCameraPositions);
 
     m_stagedBonesCount = 0;
+    m_bonePalettes.reset();
+
+    m_parent->m_upRing.EndFrame();
+
+    DxvkStatCounters& counters = m_parent->GetDXVKDevice()->statCounters();
+    counters.setCtr(DxvkStatCounter::RtxUserPointerBytes, m_parent->m_upRing.ResetBytesAllocated());
+    counters.setCtr(DxvkStatCounter::RtxGeometryCopyBytes, m_geometryCopyBytes);
+    m_geometryCopyBytes = 0;
+
+    evictGeometryHashCache();
   }
 
   void D3D9Rtx::OnPresent(const Rc<DxvkImage>& targetImage) {
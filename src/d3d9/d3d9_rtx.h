@@ -1,6 +1,7 @@
 #pragma once
 
 #include "d3d9_state.h"
+#include "d3d9_rtx_constant_hash.h"
 #include "../dxvk/dxvk_buffer.h"
 #include "../util/util_threadpool.h"
 
@@ -39,6 +40,8 @@ namespace dxvk {
     RTX_OPTION("rtx", bool, allowCubemaps, false, "When enabled, cubemaps from the game are processed through Remix, but they may not render correctly.");
     RTX_OPTION("rtx", bool, useVertexCapture, true, "When enabled, injects code into the original vertex shader to capture final shaded vertex positions.  Is useful for games using simple vertex shaders, that still also set the fixed function transform matrices.");
     RTX_OPTION("rtx", bool, useVertexCapturedNormals, true, "When enabled, vertex normals are read from the input assembler and used in raytracing.  This doesn't always work as normals can be in any coordinate space, but can help sometimes.");
+    RTX_OPTION("rtx", bool, enableGeometryHashCache, true, "When enabled, geometry hashes of draw calls sourced directly from unmodified D3D9 vertex and index buffers are reused across frames instead of rehashing the vertex data.");
+    RTX_OPTION("rtx", bool, compactStagedVertexStreams, false, "When enabled, vertex streams that have to be copied for raytracing only keep the elements Remix consumes (position, normal, texcoord, color and blend data) instead of every element of the game's vertex.  Normals and colors are converted to the formats used for raytracing on the way, positions and texcoords are kept as is.  Ignored while legacy or vertex layout asset hashes are in use, as they depend on the original vertex stride.");
     RTX_OPTION("rtx", bool, useWorldMatricesForShaders, true, "When enabled, Remix will utilize the world matrices being passed from the game via D3D9 fixed function API, even when running with shaders.  Sometimes games pass these matrices and they are useful, however for some games they are very unreliable, and should be filtered out.  If you're seeing precision related issues with shader vertex capture, try disabling this setting.");
 
     // Copy of the parameters issued to D3D9 on DrawXXX
@@ -93,6 +96,22 @@ namespace dxvk {
       }
     }
 
+    /**
+      * \brief: Signal that vertex shader constants have been written
+      *
+      * \param [in] startRegister: first register written
+      * \param [in] count: number of registers written
+      */
+    template<D3D9ConstantType ConstantType>
+    void SetVertexShaderConstantsDirty(const uint32_t startRegister, const uint32_t count) {
+      if constexpr (ConstantType == D3D9ConstantType::Float) {
+        m_vsFloatConstHasher.markDirty(startRegister, count);
+      } else if constexpr (ConstantType == D3D9ConstantType::Int) {
+        m_vsIntConstHasher.markDirty(startRegister, count);
+      }
+      // Bool constants are a few dwords at most, they are hashed directly
+    }
+
     /**
       * \brief: This function is responsible for preparing the geometry for rendering in Direct3D 9.
       *
@@ -183,6 +202,59 @@ namespace dxvk {
       kAllThreads = (kHashingThreads | kSkinningThread)
     };
 
+    // Data hashes of draws that read straight from D3D9 buffers, keyed on the buffer regions
+    // they cover.  Entries are filled in by the geometry workers once hashing completes.
+    struct GeometryHashCacheKey {
+      const DxvkBuffer* indexBuffer;
+      uint32_t indexOffset;
+      uint32_t indexCount;
+      uint32_t indexStride;
+      uint32_t vertexCount;
+      const DxvkBuffer* positionBuffer;
+      uint32_t positionOffset;
+      uint32_t positionStride;
+      VkFormat positionFormat;
+      const DxvkBuffer* texcoordBuffer;
+      uint32_t texcoordOffset;
+      uint32_t texcoordStride;
+      VkFormat texcoordFormat;
+      uint32_t hashRule;
+    };
+
+    struct GeometryHashCacheEntry : public RcObject {
+      GeometryHashCacheKey key;
+      uint64_t generation = 0;
+      std::atomic<bool> ready = { false };
+      GeometryHashes hashes;
+    };
+
+    struct GeometryHashCacheSlot {
+      Rc<GeometryHashCacheEntry> entry;
+      uint32_t lastUsedFrame = 0;
+    };
+
+    // Region of a D3D9 buffer that a hashed stream was read from directly, null when it was copied
+    struct GeometryHashSource {
+      const D3D9CommonBuffer* pBuffer = nullptr;
+      D3D9Range range;
+    };
+
+    struct GeometryHashSources {
+      GeometryHashSource index;
+      GeometryHashSource position;
+      GeometryHashSource texcoord;
+    };
+
+    inline static const uint32_t kGeometryHashCacheMaxUnusedFrames = 60;
+
+    fast_flat_cache<GeometryHashCacheSlot> m_geometryHashCache;
+    GeometryHashSources m_geometryHashSources;
+    uint32_t m_geometryHashCacheFrame = 0;
+    uint32_t m_geometryHashCacheHits = 0;
+    uint32_t m_geometryHashCacheMisses = 0;
+
+    uint64_t m_geometryCopyBytes = 0;
+
     inline static const uint32_t kMaxConcurrentDraws = 6 * 1024; // some games issuing >3000 draw calls per frame...  account for some consumer thread lag with x2
     using GeometryProcessor = WorkerThreadPool<kMaxConcurrentDraws>;
     const std::unique_ptr<GeometryProcessor> m_pGeometryWorkers;
@@ -204,8 +276,14 @@ namespace dxvk {
     // in DXVK depend on say when the submit thread's present happens which is unpredictable).
     uint64_t m_reflexFrameId = 0;
 
+    // Vertex shader constant hashes for vertex capture, kept up to date by SetVertexShaderConstantsDirty
+    D3D9ConstantBlockHasher<Vector4, caps::MaxFloatConstantsSoftware> m_vsFloatConstHasher;
+    D3D9ConstantBlockHasher<Vector4i, caps::MaxOtherConstantsSoftware> m_vsIntConstHasher;
+
+    // Bones captured at draw time, the geometry workers move the ones in use into m_bonePalettes
     std::vector<Matrix4> m_stagedBones;
     uint32_t m_stagedBonesCount = 0;
+    BonePaletteArena m_bonePalettes;
     uint32_t m_maxBone = 0;
 
     const bool m_enableDrawCallConversion;
@@ -228,6 +306,7 @@ namespace dxvk {
     struct IndexContext {
       VkIndexType indexType = VK_INDEX_TYPE_NONE_KHR;
       DxvkBufferSliceHandle indexBuffer;
+      D3D9CommonBuffer* pIBO = nullptr;
     };
 
     struct VertexContext {
@@ -237,6 +316,8 @@ namespace dxvk {
       DxvkBufferSliceHandle mappedSlice;
       D3D9CommonBuffer* pVBO = nullptr;
       bool canUseBuffer;
+      // Contents never change while referenced, so they need no copy even when copies are forced
+      bool isImmutable = false;
     };
 
     static bool isPrimitiveSupported(const D3DPRIMITIVETYPE PrimitiveType) {
@@ -255,6 +336,13 @@ namespace dxvk {
 
     void processVertices(const VertexContext vertexContext[caps::MaxStreams], int vertexIndexOffset, RasterGeometry& geoData);
 
+    struct VertexElementTarget {
+      const D3DVERTEXELEMENT9* element;
+      RasterBuffer* buffer;
+    };
+
+    bool packVertexStream(const VertexContext& ctx, const int32_t vertexOffset, const VertexElementTarget* targets, const uint32_t targetCount, RasterGeometry& geoData);
+
     bool processRenderState();
 
     template<bool FixedFunction>
@@ -279,7 +367,11 @@ namespace dxvk {
 
     Future<AxisAlignedBoundingBox> computeAxisAlignedBoundingBox(const RasterGeometry& geoData);
 
-    Future<GeometryHashes> computeHash(const RasterGeometry& geoData, const uint32_t maxIndexValue);
+    Future<GeometryHashes> computeHash(RasterGeometry& geoData, const uint32_t maxIndexValue);
+
+    bool lookupGeometryHashCache(const RasterGeometry& geoData, GeometryHashes& hashesOut, Rc<GeometryHashCacheEntry>& entryOut);
+
+    void evictGeometryHashCache();
 
     void submitActiveDrawCallState();
   };
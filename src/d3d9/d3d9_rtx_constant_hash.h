@@ -0,0 +1,114 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <algorithm>
+#include <array>
+
+#include "../util/util_bit.h"
+#include "../util/xxHash/xxhash.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Hashes a shader constant register file in fixed size blocks
+   *
+   * Constant writes mark the blocks they touch, hashing a register range
+   * only rehashes the marked blocks within it and then combines the cached
+   * block hashes. The per draw cost scales with the number of registers
+   * changed since the last draw rather than with the number of registers.
+   *
+   * Hashes are stable for the same register contents and range, but are
+   * not the same as a single hash over the range.
+   */
+  template<typename T, uint32_t RegisterCount>
+  class D3D9ConstantBlockHasher {
+    static constexpr uint32_t kBlockSize = 16;
+    static constexpr uint32_t kBlockCount = (RegisterCount + kBlockSize - 1) / kBlockSize;
+
+  public:
+
+    D3D9ConstantBlockHasher() {
+      m_dirty.setAll();
+    }
+
+    /**
+     * \brief Marks registers as written
+     *
+     * \param [in] startRegister First register written
+     * \param [in] count Number of registers written
+     */
+    void markDirty(const uint32_t startRegister, const uint32_t count) {
+      if (count == 0) {
+        return;
+      }
+
+      const uint32_t lastBlock = std::min((startRegister + count - 1) / kBlockSize, kBlockCount - 1);
+
+      for (uint32_t block = startRegister / kBlockSize; block <= lastBlock; block++) {
+        m_dirty.set(block, true);
+      }
+    }
+
+    /**
+     * \brief Hashes the first registers of the register file
+     *
+     * \param [in] registers The register file, must be the one writes are tracked for
+     * \param [in] count Number of registers to hash
+     * \param [in] seed Hash to continue from
+     */
+    XXH64_hash_t hash(const T* registers, const uint32_t count, const XXH64_hash_t seed) {
+      const uint32_t fullBlocks = std::min(count, RegisterCount) / kBlockSize;
+
+      // Rehash the dirty blocks in range, 32 blocks per bitmask dword
+      for (uint32_t dword = 0; dword * 32 < fullBlocks; dword++) {
+        const uint32_t inRange = fullBlocks - dword * 32 >= 32 ? ~0u : (1u << (fullBlocks - dword * 32)) - 1;
+        const uint32_t dirty = m_dirty.dword(dword) & inRange;
+
+        for (uint32_t bit : bit::BitMask(dirty)) {
+          const uint32_t block = dword * 32 + bit;
+          m_hashes[block] = XXH3_64bits(registers + block * kBlockSize, kBlockSize * sizeof(T));
+        }
+
+        m_dirty.dword(dword) &= ~dirty;
+      }
+
+      XXH64_hash_t result = XXH3_64bits_withSeed(m_hashes.data(), fullBlocks * sizeof(XXH64_hash_t), seed);
+
+      // Registers past the last full block are few, hash them directly
+      const uint32_t tail = std::min(count, RegisterCount) - fullBlocks * kBlockSize;
+
+      if (tail != 0) {
+        result = XXH3_64bits_withSeed(registers + fullBlocks * kBlockSize, tail * sizeof(T), result);
+      }
+
+      return result;
+    }
+
+  private:
+
+    std::array<XXH64_hash_t, kBlockCount> m_hashes = { };
+    bit::bitset<kBlockCount>              m_dirty;
+
+  };
+
+}
@@ -41,32 +41,36 @@ namespace dxvk {
     return true;
   }
 
-  // Sorts and deduplicates a set of integers, storing the result in a vector
-  template<typename T>
-  void deduplicateSortIndices(const void* pIndexData, const size_t indexCount, const uint32_t maxIndexValue, std::vector<T>& uniqueIndicesOut) {
-    // TODO (REMIX-657): Implement optimized variant of this function
-    // We know there will be at most, this many unique indices
-    const uint32_t indexRange = maxIndexValue + 1;
-
-    // Initialize all to 0
-    uniqueIndicesOut.resize(indexRange, (T)0);
-
-    // Use memory as a bin table for index data
-    for (uint32_t i = 0; i < indexCount; i++) {
-      const T& index = ((T*) pIndexData)[i];
-      assert(index <= maxIndexValue);
-      uniqueIndicesOut[index] = 1;
+  // Scratch memory owned by each geometry worker thread, grows to the largest draw seen and is then reused
+  struct GeometryHashScratch {
+    std::vector<uint8_t> indexFlags;
+    std::vector<uint32_t> uniqueIndices;
+
+    template<typename T>
+    T* getUniqueIndices(const uint32_t maxIndexValue) {
+      const size_t numElements = ((size_t) maxIndexValue + 1) * sizeof(T) / sizeof(uint32_t) + 1;
+      if (uniqueIndices.size() < numElements) {
+        uniqueIndices.resize(numElements);
+      }
+      return reinterpret_cast<T*>(uniqueIndices.data());
     }
 
-    // Repopulate the bins with contiguous index values
-    uint32_t uniqueIndexCount = 0;
-    for (uint32_t i = 0; i < indexRange; i++) {
-      if (uniqueIndicesOut[i])
-        uniqueIndicesOut[uniqueIndexCount++] = i;
+    uint8_t* getIndexFlags(const uint32_t maxIndexValue) {
+      const size_t size = fast::deduplicateSortIndicesScratchSize(maxIndexValue);
+      if (indexFlags.size() < size) {
+        indexFlags.resize(size);
+      }
+      return indexFlags.data();
     }
+  };
 
-    // Remove any unused entries
-    uniqueIndicesOut.resize(uniqueIndexCount);
+  static thread_local GeometryHashScratch s_hashScratch;
+
+  // Sorts and deduplicates a set of integers into the calling thread's scratch memory, returns the unique count
+  template<typename T>
+  uint32_t deduplicateSortIndices(const void* pIndexData, const size_t indexCount, const uint32_t maxIndexValue, T*& uniqueIndicesOut) {
+    uniqueIndicesOut = s_hashScratch.getUniqueIndices<T>(maxIndexValue);
+    return fast::deduplicateSortIndices<T>(indexCount, (const T*) pIndexData, maxIndexValue, s_hashScratch.getIndexFlags(maxIndexValue), uniqueIndicesOut);
   }
 
   template<typename T>
@@ -76,11 +80,13 @@ namespace dxvk {
 
     const HashRule& globalHashRule = RtxOptions::Get()->GeometryHashGenerationRule;
 
-    // TODO (REMIX-658): Improve this by reducing allocation overhead of vector
-    std::vector<T> uniqueIndices(0);
+    const T* uniqueIndices = nullptr;
+    uint32_t uniqueIndexCount = 0;
     if constexpr (!std::is_same<T, NoIndices>::value) {
       assert((indexCount > 0 && indexBufferRef));
-      deduplicateSortIndices(pIndexData, indexCount, maxIndexValue, uniqueIndices);
+      T* pUniqueIndices;
+      uniqueIndexCount = deduplicateSortIndices(pIndexData, indexCount, maxIndexValue, pUniqueIndices);
+      uniqueIndices = pUniqueIndices;
 
       if (globalHashRule.test(HashComponents::Indices)) {
         hashesOut[HashComponents::Indices] = hashContiguousMemory(pIndexData, indexCount * sizeof(T));
@@ -102,7 +108,7 @@ namespace dxvk {
 
       if (globalHashRule.test(component) && componentToRegionMap.count(component) > 0) {
         const VertexRegions::Type region = componentToRegionMap.at(component);
-        hashesOut[component] = hashVertexRegionIndexed(vertexRegions[(uint32_t)region], uniqueIndices);
+        hashesOut[component] = hashVertexRegionIndexed(vertexRegions[(uint32_t)region], uniqueIndices, uniqueIndexCount);
       }
     }
 
@@ -124,46 +130,104 @@ namespace dxvk {
     }
   }
 
-  Future<GeometryHashes> D3D9Rtx::computeHash(const RasterGeometry& geoData, const uint32_t maxIndexValue) {
+  bool D3D9Rtx::lookupGeometryHashCache(const RasterGeometry& geoData, GeometryHashes& hashesOut, Rc<GeometryHashCacheEntry>& entryOut) {
     ScopedCpuProfileZone();
 
-    const uint32_t indexCount = geoData.indexCount;
-    const uint32_t vertexCount = geoData.vertexCount;
+    const GeometryHashSources& sources = m_geometryHashSources;
 
-    HashQuery vertexRegions[VertexRegions::Count];
-    memset(&vertexRegions[0], 0, sizeof(vertexRegions));
+    // Only draws whose hashed streams all come straight from D3D9 buffers can be tracked
+    if (!enableGeometryHashCache() ||
+        sources.position.pBuffer == nullptr ||
+        (geoData.texcoordBuffer.defined() && sources.texcoord.pBuffer == nullptr) ||
+        (geoData.indexBuffer.defined() && sources.index.pBuffer == nullptr)) {
+      return false;
+    }
 
-    if (!getVertexRegion(geoData.positionBuffer, vertexCount, vertexRegions[VertexRegions::Position]))
-      return Future<GeometryHashes>(); //invalid
+    GeometryHashCacheKey key;
+    memset(&key, 0, sizeof(key));
+    key.vertexCount = geoData.vertexCount;
+    key.positionBuffer = geoData.positionBuffer.buffer().ptr();
+    key.positionOffset = (uint32_t) geoData.positionBuffer.offsetFromSlice();
+    key.positionStride = geoData.positionBuffer.stride();
+    key.positionFormat = geoData.positionBuffer.vertexFormat();
+    if (geoData.texcoordBuffer.defined()) {
+      key.texcoordBuffer = geoData.texcoordBuffer.buffer().ptr();
+      key.texcoordOffset = (uint32_t) geoData.texcoordBuffer.offsetFromSlice();
+      key.texcoordStride = geoData.texcoordBuffer.stride();
+      key.texcoordFormat = geoData.texcoordBuffer.vertexFormat();
+    }
+    if (geoData.indexBuffer.defined()) {
+      key.indexBuffer = sources.index.pBuffer->GetBuffer<D3D9_COMMON_BUFFER_TYPE_MAPPING>().ptr();
+      key.indexOffset = sources.index.range.min;
+      key.indexCount = geoData.indexCount;
+      key.indexStride = geoData.indexBuffer.stride();
+    }
+    key.hashRule = RtxOptions::Get()->GeometryHashGenerationRule.raw();
+
+    GeometryHashCacheSlot& slot = m_geometryHashCache[XXH3_64bits(&key, sizeof(key))];
+    slot.lastUsedFrame = m_geometryHashCacheFrame;
+
+    if (slot.entry != nullptr &&
+        memcmp(&slot.entry->key, &key, sizeof(key)) == 0 &&
+        slot.entry->ready.load(std::memory_order_acquire)) {
+      const uint64_t generation = slot.entry->generation;
+      const bool dirty = sources.position.pBuffer->WasWrittenSince(generation, sources.position.range) ||
+                         (sources.texcoord.pBuffer != nullptr && sources.texcoord.pBuffer->WasWrittenSince(generation, sources.texcoord.range)) ||
+                         (sources.index.pBuffer != nullptr && sources.index.pBuffer->WasWrittenSince(generation, sources.index.range));
+      if (!dirty) {
+        ++m_geometryHashCacheHits;
+        hashesOut = slot.entry->hashes;
+        return true;
+      }
+    }
 
-    // Acquire prevents the staging allocator from re-using this memory
-    vertexRegions[VertexRegions::Position].ref->acquire(DxvkAccess::Read);
-    vertexRegions[VertexRegions::Position].ref->incRef();
+    // Start a new entry for the hashing task to fill in.  A still pending entry
+    // in this slot is simply orphaned, its task holds its own reference.
+    ++m_geometryHashCacheMisses;
+    slot.entry = new GeometryHashCacheEntry();
+    slot.entry->key = key;
+    slot.entry->generation = D3D9CommonBuffer::GetCurrentWriteGeneration();
+    entryOut = slot.entry;
+    return false;
+  }
 
-    if (getVertexRegion(geoData.texcoordBuffer, vertexCount, vertexRegions[VertexRegions::Texcoord])) {
-      vertexRegions[VertexRegions::Texcoord].ref->acquire(DxvkAccess::Read);
-      vertexRegions[VertexRegions::Texcoord].ref->incRef();
-    }
+  void D3D9Rtx::evictGeometryHashCache() {
+    ScopedCpuProfileZone();
 
-    // Make sure we hold a ref to the index buffer while hashing.
-    const Rc<DxvkBuffer> indexBufferRef = geoData.indexBuffer.buffer();
-    if (indexBufferRef.ptr()) {
-      indexBufferRef->acquire(DxvkAccess::Read);
-      indexBufferRef->incRef();
+    const uint32_t frame = m_geometryHashCacheFrame++;
+
+    for (auto it = m_geometryHashCache.begin(); it != m_geometryHashCache.end();) {
+      if (frame - it->second.lastUsedFrame > kGeometryHashCacheMaxUnusedFrames)
+        it = m_geometryHashCache.erase(it);
+      else
+        ++it;
     }
-    const void* pIndexData = geoData.indexBuffer.defined() ? geoData.indexBuffer.mapPtr(0) : nullptr;
-    const size_t indexStride = geoData.indexBuffer.stride();
-    const size_t indexDataSize = indexCount * indexStride;
+
+    DxvkStatCounters& counters = m_parent->GetDXVKDevice()->statCounters();
+    counters.setCtr(DxvkStatCounter::RtxGeometryHashCacheHits, m_geometryHashCacheHits);
+    counters.setCtr(DxvkStatCounter::RtxGeometryHashCacheMisses, m_geometryHashCacheMisses);
+    m_geometryHashCacheHits = 0;
+    m_geometryHashCacheMisses = 0;
+  }
+
+  Future<GeometryHashes> D3D9Rtx::computeHash(RasterGeometry& geoData, const uint32_t maxIndexValue) {
+    ScopedCpuProfileZone();
+
+    const uint32_t indexCount = geoData.indexCount;
+    const uint32_t vertexCount = geoData.vertexCount;
+
+    if (!geoData.positionBuffer.defined())
+      return Future<GeometryHashes>(); //invalid
 
     // Assume the GPU changed the data via shaders, include the constant buffer data in hash
     XXH64_hash_t vertexShaderHash = kEmptyHash;
     if (m_parent->UseProgrammableVS() && useVertexCapture()) {
       if (RtxOptions::Get()->GeometryHashGenerationRule.test(HashComponents::GeometryDescriptor)) {
         const D3D9ConstantSets& cb = m_parent->m_consts[DxsoProgramTypes::VertexShader];
-        auto& shaderByteCode = d3d9State().vertexShader->GetCommonShader()->GetBytecode();
-        vertexShaderHash = XXH3_64bits(shaderByteCode.data(), shaderByteCode.size());
-        vertexShaderHash = XXH3_64bits_withSeed(&d3d9State().vsConsts.fConsts[0], cb.meta.maxConstIndexF * sizeof(float) * 4, vertexShaderHash);
-        vertexShaderHash = XXH3_64bits_withSeed(&d3d9State().vsConsts.iConsts[0], cb.meta.maxConstIndexI * sizeof(int) * 4, vertexShaderHash);
+        // Bytecode is hashed once per shader, and only constant blocks written since the last draw are rehashed
+        vertexShaderHash = d3d9State().vertexShader->GetCommonShader()->GetBytecodeHash();
+        vertexShaderHash = m_vsFloatConstHasher.hash(&d3d9State().vsConsts.fConsts[0], cb.meta.maxConstIndexF, vertexShaderHash);
+        vertexShaderHash = m_vsIntConstHasher.hash(&d3d9State().vsConsts.iConsts[0], cb.meta.maxConstIndexI, vertexShaderHash);
         vertexShaderHash = XXH3_64bits_withSeed(&d3d9State().vsConsts.bConsts[0], cb.meta.maxConstIndexB * sizeof(uint32_t)/32, vertexShaderHash);
       }
     }
@@ -183,10 +247,48 @@ namespace dxvk {
       vertexLayoutHash = hashVertexLayout(geoData);
     }
 
+    // Buffer contents unchanged since the last time this region was hashed, reuse the data hashes.
+    // A hit is handed over in geoData.hashes right away, there is nothing to wait for.
+    GeometryHashes cachedHashes;
+    Rc<GeometryHashCacheEntry> cacheEntry;
+    if (lookupGeometryHashCache(geoData, cachedHashes, cacheEntry)) {
+      cachedHashes[HashComponents::GeometryDescriptor] = geometryDescriptorHash;
+      cachedHashes[HashComponents::VertexLayout] = vertexLayoutHash;
+      cachedHashes[HashComponents::VertexShader] = vertexShaderHash;
+      cachedHashes.precombine();
+
+      geoData.hashes = cachedHashes;
+      return Future<GeometryHashes>();
+    }
+
+    HashQuery vertexRegions[VertexRegions::Count];
+    memset(&vertexRegions[0], 0, sizeof(vertexRegions));
+
+    getVertexRegion(geoData.positionBuffer, vertexCount, vertexRegions[VertexRegions::Position]);
+
+    // Acquire prevents the staging allocator from re-using this memory
+    vertexRegions[VertexRegions::Position].ref->acquire(DxvkAccess::Read);
+    vertexRegions[VertexRegions::Position].ref->incRef();
+
+    if (getVertexRegion(geoData.texcoordBuffer, vertexCount, vertexRegions[VertexRegions::Texcoord])) {
+      vertexRegions[VertexRegions::Texcoord].ref->acquire(DxvkAccess::Read);
+      vertexRegions[VertexRegions::Texcoord].ref->incRef();
+    }
+
+    // Make sure we hold a ref to the index buffer while hashing.
+    const Rc<DxvkBuffer> indexBufferRef = geoData.indexBuffer.buffer();
+    if (indexBufferRef.ptr()) {
+      indexBufferRef->acquire(DxvkAccess::Read);
+      indexBufferRef->incRef();
+    }
+    const void* pIndexData = geoData.indexBuffer.defined() ? geoData.indexBuffer.mapPtr(0) : nullptr;
+    const size_t indexStride = geoData.indexBuffer.stride();
+    const size_t indexDataSize = indexCount * indexStride;
+
     return m_pGeometryWorkers->Schedule([vertexRegions, indexBufferRef = indexBufferRef.ptr(),
                                  pIndexData, indexStride, indexDataSize, indexCount,
                                  maxIndexValue, vertexShaderHash, geometryDescriptorHash,
-                                 vertexLayoutHash]() -> GeometryHashes {
+                                 vertexLayoutHash, cacheEntry = std::move(cacheEntry)]() -> GeometryHashes {
       ScopedCpuProfileZone();
 
       GeometryHashes hashes;
@@ -213,6 +315,11 @@ namespace dxvk {
 
       hashes.precombine();
 
+      if (cacheEntry != nullptr) {
+        cacheEntry->hashes = hashes;
+        cacheEntry->ready.store(true, std::memory_order_release);
+      }
+
       return hashes;
     });
   }
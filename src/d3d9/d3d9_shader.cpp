@@ -5,6 +5,14 @@
 #include "d3d9_util.h"
 #include "../dxvk/dxvk_scoped_annotation.h"
 
+// NV-DXVK start: persistent DXSO shader cache
+#include <version.h>
+// NV-DXVK end
+
+// NV-DXVK start: offline shader compile benchmark
+#include "../dxso/dxso_tables.h"
+// NV-DXVK end
+
 
 namespace dxvk {
 
@@ -17,10 +25,16 @@ namespace dxvk {
       const DxsoModuleInfo*       pDxsoModuleInfo,
       const void*                 pShaderBytecode,
       const DxsoAnalysisInfo&     AnalysisInfo,
-            DxsoModule*           pModule) {
+            DxsoModule*           pModule,
+    // NV-DXVK start: persistent DXSO shader cache
+            DxsoShaderCache*      pDiskCache) {
+    // NV-DXVK end
     const uint32_t bytecodeLength = AnalysisInfo.bytecodeByteLength;
     m_bytecode.resize(bytecodeLength);
     std::memcpy(m_bytecode.data(), pShaderBytecode, bytecodeLength);
+    // NV-DXVK start: hashed once, used to hash vertex shader state for vertex capture
+    m_bytecodeHash = XXH3_64bits(m_bytecode.data(), m_bytecode.size());
+    // NV-DXVK end
 
     const std::string name = Key.toString();
     Logger::debug(str::format("Compiling shader ", name));
@@ -51,6 +65,21 @@ namespace dxvk {
           blob->GetBufferSize());
       }
     }
+
+    // NV-DXVK start: shader corpus capture
+    // Raw bytecode only, to build corpora for the offline compile benchmark
+    const std::string bytecodeDumpPath = env::getEnvVar("DXVK_SHADER_BYTECODE_DUMP_PATH");
+
+    if (bytecodeDumpPath.size() != 0) {
+      env::createDirectory(bytecodeDumpPath);
+
+      DxsoReader reader(
+        reinterpret_cast<const char*>(pShaderBytecode));
+
+      reader.store(std::ofstream(str::tows(str::format(bytecodeDumpPath, "/", name, ".dxso").c_str()).c_str(),
+        std::ios_base::binary | std::ios_base::trunc), bytecodeLength);
+    }
+    // NV-DXVK end
     
     // Decide whether we need to create a pass-through
     // geometry shader for vertex shader stream output
@@ -58,12 +87,34 @@ namespace dxvk {
     const D3D9ConstantLayout& constantLayout = ShaderStage == VK_SHADER_STAGE_VERTEX_BIT
       ? pDevice->GetVertexConstantLayout()
       : pDevice->GetPixelConstantLayout();
-    m_shaders      = pModule->compile(*pDxsoModuleInfo, name, AnalysisInfo, constantLayout);
-    m_isgn         = pModule->isgn();
-    // NV-DXVK start: expose shader outputs for vertex capture
-    m_osgn = pModule->osgn();
+    // NV-DXVK start: persistent DXSO shader cache
+    // Skip the translation if a previous run already did it
+    DxsoCompiledShader compiled;
+    const Sha1Hash cacheKey = DxsoShaderCache::computeKey(Key, *pDxsoModuleInfo, constantLayout);
+
+    if (pDiskCache == nullptr || !pDiskCache->lookup(cacheKey, ShaderStage, compiled)) {
+      const auto t0 = dxvk::high_resolution_clock::now();
+
+      compiled.shaders         = pModule->compile(*pDxsoModuleInfo, name, AnalysisInfo, constantLayout);
+      compiled.isgn            = pModule->isgn();
+      compiled.osgn            = pModule->osgn();
+      compiled.usedSamplers    = pModule->usedSamplers();
+      compiled.usedRTs         = pModule->usedRTs();
+      compiled.meta            = pModule->meta();
+      compiled.constants       = pModule->constants();
+      compiled.maxDefinedConst = pModule->maxDefinedConstant();
+
+      if (pDiskCache != nullptr) {
+        pDiskCache->recordTranslation(dxvk::high_resolution_clock::now() - t0);
+        pDiskCache->store(cacheKey, compiled);
+      }
+    }
+
+    m_shaders      = compiled.shaders;
+    m_isgn         = compiled.isgn;
+    m_osgn         = compiled.osgn;
+    m_usedSamplers = compiled.usedSamplers;
     // NV-DXVK end
-    m_usedSamplers = pModule->usedSamplers();
 
     // Shift up these sampler bits so we can just
     // do an or per-draw in the device.
@@ -71,12 +122,14 @@ namespace dxvk {
     if (ShaderStage == VK_SHADER_STAGE_VERTEX_BIT)
       m_usedSamplers <<= caps::MaxTexturesPS + 1;
 
-    m_usedRTs      = pModule->usedRTs();
+    // NV-DXVK start: persistent DXSO shader cache
+    m_usedRTs      = compiled.usedRTs;
 
     m_info      = pModule->info();
-    m_meta      = pModule->meta();
-    m_constants = pModule->constants();
-    m_maxDefinedConst = pModule->maxDefinedConstant();
+    m_meta      = compiled.meta;
+    m_constants = compiled.constants;
+    m_maxDefinedConst = compiled.maxDefinedConst;
+    // NV-DXVK end
 
     m_shaders[0]->setShaderKey(Key);
 
@@ -100,6 +153,15 @@ namespace dxvk {
   }
 
 
+  // NV-DXVK start: persistent DXSO shader cache
+  void D3D9ShaderModuleSet::InitDiskCache() {
+    // Translations from other builds are discarded when loading
+    m_diskCache = new DxsoShaderCache(
+      DxsoShaderCache::getDefaultFileName(), DXVK_VERSION);
+  }
+  // NV-DXVK end
+
+
   void D3D9ShaderModuleSet::GetShaderModule(
             D3D9DeviceEx*         pDevice,
             D3D9CommonShader*     pShaderModule,
@@ -139,7 +201,10 @@ namespace dxvk {
     *pShaderModule = D3D9CommonShader(
       pDevice, ShaderStage, lookupKey,
       pDxbcModuleInfo, pShaderBytecode,
-      info, &module);
+      info, &module,
+      // NV-DXVK start: persistent DXSO shader cache
+      m_diskCache.ptr());
+      // NV-DXVK end
     
     // Insert the new module into the lookup table. If another thread
     // has compiled the same shader in the meantime, we should return
@@ -154,4 +219,139 @@ namespace dxvk {
     }
   }
 
+
+  // NV-DXVK start: offline shader compile benchmark
+  // Walks the instruction tokens like DxsoDecodeContext does, without reading
+  // past the blob. Returns the size of the shader up to and including its end
+  // token, or 0 if the end token is not within the first Length bytes.
+  static size_t getDxsoBytecodeLength(
+    const void*                   pShaderBytecode,
+          size_t                  Length) {
+    const uint32_t* tokens     = reinterpret_cast<const uint32_t*>(pShaderBytecode);
+    const size_t    tokenCount = Length / sizeof(uint32_t);
+
+    if (tokenCount == 0)
+      return 0;
+
+    const uint32_t majorVersion = (tokens[0] >> 8) & 0xff;
+    const uint32_t minorVersion = tokens[0] & 0xff;
+
+    for (size_t i = 1; i < tokenCount; ) {
+      const uint32_t   token  = tokens[i++];
+      const DxsoOpcode opcode = static_cast<DxsoOpcode>(token & 0x0000ffff);
+
+      if (opcode == DxsoOpcode::End)
+        return i * sizeof(uint32_t);
+
+      uint32_t length = 0;
+
+      if (opcode == DxsoOpcode::Comment) {
+        length = (token & 0x7fff0000) >> 16;
+      } else if (opcode != DxsoOpcode::Phase) {
+        length = majorVersion >= 2
+          ? (token & 0x0f000000) >> 24
+          : DxsoGetDefaultOpcodeLength(opcode);
+
+        if (length == InvalidOpcodeLength)
+          length = 0;
+
+        if (majorVersion == 1 && minorVersion == 4
+         && (opcode == DxsoOpcode::Tex || opcode == DxsoOpcode::TexCoord))
+          length += 1;
+      }
+
+      i += length;
+    }
+
+    return 0;
+  }
+
+
+  bool benchmarkDxsoShader(
+    const void*                   pShaderBytecode,
+          size_t                  BytecodeLength,
+          D3D9ShaderCompileStats* pStats) {
+    if (pShaderBytecode == nullptr || pStats == nullptr)
+      return false;
+
+    // The reader does not know the blob size, so only
+    // a shader that ends within the blob is parsed
+    const size_t bytecodeLength = getDxsoBytecodeLength(pShaderBytecode, BytecodeLength);
+
+    if (bytecodeLength == 0)
+      return false;
+
+    // Options of a typical desktop device, the
+    // compiler itself does not need a device
+    DxsoModuleInfo moduleInfo;
+    moduleInfo.options.useDemoteToHelperInvocation     = true;
+    moduleInfo.options.useSubgroupOpsForEarlyDiscard   = false;
+    moduleInfo.options.strictConstantCopies            = false;
+    moduleInfo.options.d3d9FloatEmulation              = D3D9FloatEmulation::Enabled;
+    moduleInfo.options.strictPow                       = true;
+    moduleInfo.options.shaderModel                     = 3;
+    moduleInfo.options.invariantPosition               = true;
+    moduleInfo.options.forceSamplerTypeSpecConstants   = false;
+    moduleInfo.options.vertexFloatConstantBufferAsSSBO = false;
+    moduleInfo.options.longMad                         = false;
+    moduleInfo.options.alphaTestWiggleRoom             = false;
+    moduleInfo.options.robustness2Supported            = true;
+
+    try {
+      const auto t0 = dxvk::high_resolution_clock::now();
+
+      DxsoReader reader(
+        reinterpret_cast<const char*>(pShaderBytecode));
+
+      DxsoModule module(reader);
+
+      const auto t1 = dxvk::high_resolution_clock::now();
+
+      DxsoAnalysisInfo analysis = module.analyze();
+
+      const auto t2 = dxvk::high_resolution_clock::now();
+
+      const VkShaderStageFlagBits stage = module.info().shaderStage();
+
+      D3D9ConstantLayout layout;
+
+      if (stage == VK_SHADER_STAGE_VERTEX_BIT) {
+        layout.floatCount = caps::MaxFloatConstantsVS;
+        layout.intCount   = caps::MaxOtherConstants;
+        layout.boolCount  = caps::MaxOtherConstants;
+      } else {
+        layout.floatCount = caps::MaxFloatConstantsPS;
+        layout.intCount   = caps::MaxOtherConstants;
+        layout.boolCount  = caps::MaxOtherConstants;
+      }
+
+      layout.bitmaskCount = align(layout.boolCount, 32) / 32;
+
+      const std::string name = DxvkShaderKey(stage,
+        Sha1Hash::compute(pShaderBytecode, bytecodeLength)).toString();
+
+      const DxsoPermutations shaders = module.compile(moduleInfo, name, analysis, layout);
+
+      const auto t3 = dxvk::high_resolution_clock::now();
+
+      pStats->stage          = stage;
+      pStats->bytecodeLength = uint32_t(bytecodeLength);
+      pStats->readMs         = std::chrono::duration<double, std::milli>(t1 - t0).count();
+      pStats->analyzeMs      = std::chrono::duration<double, std::milli>(t2 - t1).count();
+      pStats->compileMs      = std::chrono::duration<double, std::milli>(t3 - t2).count();
+      pStats->spirvDwords    = 0;
+
+      for (const auto& shader : shaders) {
+        if (shader != nullptr)
+          pStats->spirvDwords += shader->getCode().dwords();
+      }
+
+      return true;
+    } catch (const DxvkError& e) {
+      Logger::err(e.message());
+      return false;
+    }
+  }
+  // NV-DXVK end
+
 }
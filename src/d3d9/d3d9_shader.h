@@ -2,8 +2,14 @@
 
 #include "d3d9_resource.h"
 #include "../dxso/dxso_module.h"
+// NV-DXVK start: persistent DXSO shader cache
+#include "../dxso/dxso_cache.h"
+// NV-DXVK end
 #include "d3d9_shader_permutations.h"
 #include "d3d9_util.h"
+// NV-DXVK start: bytecode hash for vertex capture
+#include "../util/xxHash/xxhash.h"
+// NV-DXVK end
 
 #include <array>
 
@@ -30,7 +36,10 @@ namespace dxvk {
       const DxsoModuleInfo*       pDxbcModuleInfo,
       const void*                 pShaderBytecode,
       const DxsoAnalysisInfo&     AnalysisInfo,
-            DxsoModule*           pModule);
+            DxsoModule*           pModule,
+    // NV-DXVK start: persistent DXSO shader cache
+            DxsoShaderCache*      pDiskCache);
+    // NV-DXVK end
 
 
     Rc<DxvkShader> GetShader(D3D9ShaderPermutation Permutation) const {
@@ -45,6 +54,12 @@ namespace dxvk {
       return m_bytecode;
     }
 
+    // NV-DXVK start: hashed once, used to hash vertex shader state for vertex capture
+    XXH64_hash_t GetBytecodeHash() const {
+      return m_bytecodeHash;
+    }
+    // NV-DXVK end
+
     const DxsoIsgn& GetIsgn() const {
       return m_isgn;
     }
@@ -81,6 +96,9 @@ namespace dxvk {
     DxsoPermutations      m_shaders;
 
     std::vector<uint8_t>  m_bytecode;
+    // NV-DXVK start: hashed once, used to hash vertex shader state for vertex capture
+    XXH64_hash_t          m_bytecodeHash = 0;
+    // NV-DXVK end
 
   };
 
@@ -182,6 +200,16 @@ namespace dxvk {
     
   public:
     
+    // NV-DXVK start: persistent DXSO shader cache
+    /**
+     * \brief Loads the on-disk shader cache
+     *
+     * Shaders found in the cache skip DXSO translation,
+     * newly translated ones are added to it.
+     */
+    void InitDiskCache();
+    // NV-DXVK end
+
     void GetShaderModule(
             D3D9DeviceEx*         pDevice,
             D3D9CommonShader*     pShaderModule,
@@ -197,6 +225,10 @@ namespace dxvk {
       DxvkShaderKey,
       D3D9CommonShader,
       DxvkHash, DxvkEq> m_modules;
+
+    // NV-DXVK start: persistent DXSO shader cache
+    Rc<DxsoShaderCache> m_diskCache;
+    // NV-DXVK end
     
   };
 
@@ -205,4 +237,25 @@ namespace dxvk {
     return pShader != nullptr ? pShader->GetCommonShader() : nullptr;
   }
 
+  // NV-DXVK start: offline shader compile benchmark
+  /**
+   * \brief Timings of one DXSO to SPIR-V translation
+   */
+  struct D3D9ShaderCompileStats {
+    VkShaderStageFlagBits stage;
+    uint32_t              bytecodeLength;
+    double                readMs;
+    double                analyzeMs;
+    double                compileMs;
+    uint32_t              spirvDwords;
+  };
+
+  // Translates a DXSO blob without a device and reports the time spent
+  // in each front-end phase. Exported for the shader corpus benchmark.
+  extern "C" __declspec(dllexport) bool benchmarkDxsoShader(
+    const void*                   pShaderBytecode,
+          size_t                  BytecodeLength,
+          D3D9ShaderCompileStats* pStats);
+  // NV-DXVK end
+
 }
\ No newline at end of file
@@ -0,0 +1,111 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include "d3d9_up_ring.h"
+
+namespace dxvk {
+
+  namespace {
+    // True if no draw and no geometry references the buffer anymore. Command
+    // lists hold a reference to the resources they use until their fence signals.
+    bool IsExclusive(const Rc<DxvkBuffer>& buffer) {
+      const uint32_t refs = buffer->incRef();
+      buffer->decRef();
+      return refs == 2;
+    }
+  }
+
+  D3D9UPRing::D3D9UPRing(const Rc<DxvkDevice>& device)
+    : m_device(device) { }
+
+
+  DxvkBufferSlice D3D9UPRing::Alloc(VkDeviceSize size) {
+    m_bytesAllocated += size;
+
+    // Too large to share a chunk, give it its own buffer
+    if (unlikely(size > ChunkSize))
+      return DxvkBufferSlice(CreateBuffer(size));
+
+    if (m_chunk == nullptr || m_offset + size > ChunkSize) {
+      m_chunk = NextChunk();
+      m_offset = 0;
+    }
+
+    DxvkBufferSlice slice(m_chunk, m_offset, size);
+    m_offset = align(m_offset + size, CACHE_LINE_SIZE);
+    return slice;
+  }
+
+
+  void D3D9UPRing::EndFrame() {
+    m_chunk = nullptr;
+    m_offset = 0;
+
+    for (auto& chunk : m_frameChunks)
+      m_retiredChunks.push_back(std::move(chunk));
+
+    m_frameChunks.clear();
+
+    // Let chunks the geometry holds on to for a long time go, they
+    // are destroyed once the last reference to them is released
+    if (m_retiredChunks.size() > MaxRetiredChunks) {
+      const size_t excess = m_retiredChunks.size() - MaxRetiredChunks;
+      m_retiredChunks.erase(m_retiredChunks.begin(), m_retiredChunks.begin() + excess);
+    }
+  }
+
+
+  Rc<DxvkBuffer> D3D9UPRing::CreateBuffer(VkDeviceSize size) const {
+    // Same usage as a shader buffer, the raytracing geometry reads from it
+    DxvkBufferCreateInfo info;
+    info.size   = size;
+    info.usage  = VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    info.access = VK_ACCESS_TRANSFER_READ_BIT;
+    info.stages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+    const VkMemoryPropertyFlags memoryFlags
+      = VK_MEMORY_PROPERTY_HOST_CACHED_BIT
+      | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+
+    return m_device->createBuffer(info, memoryFlags, DxvkMemoryStats::Category::AppBuffer);
+  }
+
+
+  Rc<DxvkBuffer> D3D9UPRing::NextChunk() {
+    Rc<DxvkBuffer> chunk;
+
+    // Oldest first, those are the most likely to be idle
+    for (auto it = m_retiredChunks.begin(); it != m_retiredChunks.end(); ++it) {
+      if (IsExclusive(*it) && !(*it)->isInUse()) {
+        chunk = std::move(*it);
+        m_retiredChunks.erase(it);
+        break;
+      }
+    }
+
+    if (chunk == nullptr)
+      chunk = CreateBuffer(ChunkSize);
+
+    m_frameChunks.push_back(chunk);
+    return chunk;
+  }
+
+}
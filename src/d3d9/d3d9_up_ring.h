@@ -0,0 +1,91 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "../dxvk/dxvk_device.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Frame paced ring for DrawPrimitiveUP data
+   *
+   * User pointer vertex and index data is copied once into chunks of
+   * host visible memory. The slices are bound for rasterization and
+   * referenced by the raytracing geometry directly, because nothing
+   * writes to a slice again while it is referenced.
+   *
+   * Allocation within a frame is a bump of the offset. At the end of the
+   * frame all chunks in use are retired. A retired chunk is only reused
+   * once the ring holds the last reference to it. Raster draws reference
+   * the chunk until the command lists that read it have signalled their
+   * fence, and raytracing geometry references it for as long as it is kept.
+   */
+  class D3D9UPRing {
+    constexpr static VkDeviceSize ChunkSize = 4 << 20;
+    constexpr static size_t       MaxRetiredChunks = 16;
+
+  public:
+
+    D3D9UPRing(const Rc<DxvkDevice>& device);
+
+    /**
+     * \brief Allocates a slice for user pointer data
+     *
+     * Valid and unchanged for as long as it is referenced.
+     * \param [in] size Size of the allocation in bytes
+     */
+    DxvkBufferSlice Alloc(VkDeviceSize size);
+
+    /**
+     * \brief Retires the chunks used in this frame
+     */
+    void EndFrame();
+
+    /**
+     * \brief Bytes allocated since the last call, i.e. user data copied
+     */
+    uint64_t ResetBytesAllocated() {
+      return std::exchange(m_bytesAllocated, 0);
+    }
+
+  private:
+
+    Rc<DxvkDevice>              m_device;
+
+    Rc<DxvkBuffer>              m_chunk;
+    VkDeviceSize                m_offset = 0;
+
+    std::vector<Rc<DxvkBuffer>> m_frameChunks;
+    std::vector<Rc<DxvkBuffer>> m_retiredChunks;
+
+    uint64_t                    m_bytesAllocated = 0;
+
+    Rc<DxvkBuffer> CreateBuffer(VkDeviceSize size) const;
+
+    Rc<DxvkBuffer> NextChunk();
+
+  };
+
+}
@@ -43,8 +43,15 @@ namespace dxvk {
   Rc<DxvkShader> DxbcModule::compile(
     const DxbcModuleInfo& moduleInfo,
     const std::string&    fileName) const {
+    // NV-DXVK start: separate analysis pass
+    return this->compile(moduleInfo, fileName, this->analyze(moduleInfo));
+  }
+  
+  
+  DxbcAnalysisInfo DxbcModule::analyze(
+    const DxbcModuleInfo& moduleInfo) const {
     if (m_shexChunk == nullptr)
-      throw DxvkError("DxbcModule::compile: No SHDR/SHEX chunk");
+      throw DxvkError("DxbcModule::analyze: No SHDR/SHEX chunk");
     
     DxbcAnalysisInfo analysisInfo;
     
@@ -54,6 +61,17 @@ namespace dxvk {
       m_psgnChunk, analysisInfo);
     
     this->runAnalyzer(analyzer, m_shexChunk->slice());
+    return analysisInfo;
+  }
+  
+  
+  Rc<DxvkShader> DxbcModule::compile(
+    const DxbcModuleInfo&   moduleInfo,
+    const std::string&      fileName,
+    const DxbcAnalysisInfo& analysisInfo) const {
+    if (m_shexChunk == nullptr)
+      throw DxvkError("DxbcModule::compile: No SHDR/SHEX chunk");
+    // NV-DXVK end
     
     DxbcCompiler compiler(
       fileName, moduleInfo,
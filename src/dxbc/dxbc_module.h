@@ -2,6 +2,9 @@
 
 #include "../dxvk/dxvk_shader.h"
 
+// NV-DXVK start: separate analysis pass
+#include "dxbc_analysis.h"
+// NV-DXVK end
 #include "dxbc_chunk_isgn.h"
 #include "dxbc_chunk_shex.h"
 #include "dxbc_header.h"
@@ -60,6 +63,32 @@ namespace dxvk {
       const DxbcModuleInfo& moduleInfo,
       const std::string&    fileName) const;
     
+    // NV-DXVK start: separate analysis pass
+    /**
+     * \brief Runs the analysis pass
+     * 
+     * \param [in] moduleInfo DXBC module info
+     * \returns Analysis info for \c compile
+     */
+    DxbcAnalysisInfo analyze(
+      const DxbcModuleInfo& moduleInfo) const;
+    
+    /**
+     * \brief Compiles analyzed DXBC shader to SPIR-V
+     * 
+     * Same as the other \c compile overload, but
+     * takes the result of a previous \c analyze.
+     * \param [in] moduleInfo DXBC module info
+     * \param [in] fileName SPIR-V shader name
+     * \param [in] analysisInfo Analysis info
+     * \returns The compiled shader object
+     */
+    Rc<DxvkShader> compile(
+      const DxbcModuleInfo&   moduleInfo,
+      const std::string&      fileName,
+      const DxbcAnalysisInfo& analysisInfo) const;
+    // NV-DXVK end
+    
     /**
      * \brief Compiles a pass-through geometry shader
      *
@@ -0,0 +1,500 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include "dxso_cache.h"
+
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+#include "../util/util_env.h"
+#include "../util/util_string.h"
+
+namespace dxvk {
+
+  namespace {
+
+    class DxsoCacheWriter {
+
+    public:
+
+      DxsoCacheWriter(std::vector<char>& data)
+      : m_data(data) { }
+
+      template<typename T>
+      void write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        writeBytes(&value, sizeof(T));
+      }
+
+      template<typename T>
+      void writeArray(const T* values, uint32_t count) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write(count);
+        writeBytes(values, sizeof(T) * count);
+      }
+
+    private:
+
+      std::vector<char>& m_data;
+
+      void writeBytes(const void* data, size_t size) {
+        const char* bytes = reinterpret_cast<const char*>(data);
+        m_data.insert(m_data.end(), bytes, bytes + size);
+      }
+
+    };
+
+
+    class DxsoCacheReader {
+
+    public:
+
+      DxsoCacheReader(const char* data, size_t size)
+      : m_data(data), m_size(size) { }
+
+      template<typename T>
+      bool read(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        return readBytes(&value, sizeof(T));
+      }
+
+      template<typename T>
+      bool readVector(std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        uint32_t count = 0;
+
+        if (!read(count) || count > (m_size - m_offset) / sizeof(T))
+          return false;
+
+        values.resize(count);
+        return readBytes(values.data(), sizeof(T) * count);
+      }
+
+      bool isAtEnd() const {
+        return m_offset == m_size;
+      }
+
+    private:
+
+      const char* m_data;
+      size_t      m_size;
+      size_t      m_offset = 0;
+
+      bool readBytes(void* data, size_t size) {
+        if (m_size - m_offset < size)
+          return false;
+
+        std::memcpy(data, m_data + m_offset, size);
+        m_offset += size;
+        return true;
+      }
+
+    };
+
+  }
+
+
+  DxsoShaderCache::DxsoShaderCache(
+    const std::string&          fileName,
+    const std::string&          compilerVersion)
+  : m_fileName(str::tows(fileName.c_str())),
+    m_compilerVersion(Sha1Hash::compute(compilerVersion.data(), compilerVersion.size())) {
+    const auto t0 = dxvk::high_resolution_clock::now();
+
+    if (!readCacheFile())
+      writeNewCacheFile();
+
+    m_loadTime = dxvk::high_resolution_clock::now() - t0;
+
+    m_writerThread = dxvk::thread([this] () { writerFunc(); });
+  }
+
+
+  DxsoShaderCache::~DxsoShaderCache() {
+    { std::unique_lock<dxvk::mutex> lock(m_writerLock);
+      m_stopWriter = true;
+      m_writerCond.notify_one();
+    }
+
+    if (m_writerThread.joinable())
+      m_writerThread.join();
+
+    using ms = std::chrono::duration<double, std::milli>;
+
+    Logger::info(str::format("DXSO: Shader cache loaded in ", ms(m_loadTime).count(), " ms, ",
+      m_numHits.load(), " hits took ", ms(std::chrono::nanoseconds(m_hitTimeNs.load())).count(), " ms, ",
+      m_numTranslations.load(), " translations took ", ms(std::chrono::nanoseconds(m_translationTimeNs.load())).count(), " ms"));
+  }
+
+
+  Sha1Hash DxsoShaderCache::computeKey(
+    const DxvkShaderKey&        shaderKey,
+    const DxsoModuleInfo&       moduleInfo,
+    const D3D9ConstantLayout&   layout) {
+    const DxsoOptions& options = moduleInfo.options;
+
+    // Everything that can change the generated code besides the bytecode
+    // itself, this needs to be kept in sync with the fields of DxsoOptions
+    const uint32_t state[] = {
+      uint32_t(shaderKey.type()),
+      uint32_t(options.useDemoteToHelperInvocation),
+      uint32_t(options.useSubgroupOpsForEarlyDiscard),
+      uint32_t(options.strictConstantCopies),
+      uint32_t(options.d3d9FloatEmulation),
+      uint32_t(options.strictPow),
+      uint32_t(options.shaderModel),
+      uint32_t(options.invariantPosition),
+      uint32_t(options.forceSamplerTypeSpecConstants),
+      uint32_t(options.vertexFloatConstantBufferAsSSBO),
+      uint32_t(options.longMad),
+      uint32_t(options.alphaTestWiggleRoom),
+      uint32_t(options.robustness2Supported),
+      layout.floatCount,
+      layout.intCount,
+      layout.boolCount,
+      layout.bitmaskCount,
+    };
+
+    const Sha1Hash bytecodeHash = shaderKey.sha1();
+
+    const Sha1Data chunks[] = {
+      { &bytecodeHash, sizeof(bytecodeHash) },
+      { state,         sizeof(state)        },
+    };
+
+    return Sha1Hash::compute(2, chunks);
+  }
+
+
+  bool DxsoShaderCache::lookup(
+    const Sha1Hash&             key,
+          VkShaderStageFlagBits stage,
+          DxsoCompiledShader&   shader) const {
+    const auto t0 = dxvk::high_resolution_clock::now();
+
+    auto entry = m_entries.find(key);
+
+    if (entry == m_entries.end())
+      return false;
+
+    if (!deserializeEntry(
+        m_fileData.data() + entry->second.offset,
+        entry->second.size, stage, shader))
+      return false;
+
+    m_numHits += 1;
+    m_hitTimeNs += (dxvk::high_resolution_clock::now() - t0).count();
+    return true;
+  }
+
+
+  void DxsoShaderCache::store(
+    const Sha1Hash&             key,
+    const DxsoCompiledShader&   shader) {
+    std::vector<char> entry = serializeEntry(key, shader);
+
+    std::unique_lock<dxvk::mutex> lock(m_writerLock);
+    m_writerQueue.push(std::move(entry));
+    m_writerCond.notify_one();
+  }
+
+
+  void DxsoShaderCache::flush() {
+    std::unique_lock<dxvk::mutex> lock(m_writerLock);
+
+    m_writerIdleCond.wait(lock, [this] () {
+      return m_writerQueue.empty() && !m_writerBusy;
+    });
+  }
+
+
+  void DxsoShaderCache::recordTranslation(
+          std::chrono::nanoseconds time) {
+    m_numTranslations += 1;
+    m_translationTimeNs += time.count();
+  }
+
+
+  std::string DxsoShaderCache::getDefaultFileName() {
+    std::string path = env::getEnvVar("DXVK_SHADER_CACHE_PATH");
+
+    if (!path.empty() && *path.rbegin() != '/')
+      path += '/';
+
+    return path + env::getExeBaseName() + ".dxso-cache";
+  }
+
+
+  bool DxsoShaderCache::readCacheFile() {
+    // Read the whole file in one go, entries are
+    // deserialized straight from memory on lookup
+    std::ifstream file(m_fileName.c_str(), std::ios_base::binary | std::ios_base::ate);
+
+    if (!file) {
+      Logger::info("DXSO: No shader cache file found");
+      return false;
+    }
+
+    const std::streamoff fileSize = file.tellg();
+    file.seekg(0, std::ios_base::beg);
+
+    DxsoShaderCacheHeader header;
+
+    if (fileSize < std::streamoff(sizeof(header))) {
+      Logger::warn("DXSO: Failed to read shader cache header");
+      return false;
+    }
+
+    m_fileData.resize(size_t(fileSize));
+
+    if (!file.read(m_fileData.data(), fileSize)) {
+      Logger::warn("DXSO: Failed to read shader cache file");
+      m_fileData.clear();
+      return false;
+    }
+
+    // Discard the file if it was written by a different build
+    DxsoShaderCacheHeader expected;
+    std::memcpy(&header, m_fileData.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, expected.magic, sizeof(expected.magic))
+     || header.version != expected.version
+     || header.compilerVersion != m_compilerVersion) {
+      Logger::warn("DXSO: Shader cache is out of date");
+      m_fileData.clear();
+      return false;
+    }
+
+    // Scan entries, a crash while appending leaves a
+    // truncated entry or one with a bad checksum behind
+    size_t offset = sizeof(header);
+    uint32_t numInvalidEntries = 0;
+
+    while (offset < m_fileData.size()) {
+      DxsoShaderCacheEntryHeader entryHeader;
+
+      if (m_fileData.size() - offset < sizeof(entryHeader)) {
+        numInvalidEntries += 1;
+        break;
+      }
+
+      std::memcpy(&entryHeader, m_fileData.data() + offset, sizeof(entryHeader));
+      offset += sizeof(entryHeader);
+
+      if (m_fileData.size() - offset < entryHeader.size) {
+        numInvalidEntries += 1;
+        break;
+      }
+
+      if (Sha1Hash::compute(m_fileData.data() + offset, entryHeader.size) == entryHeader.checksum)
+        m_entries.insert({ entryHeader.key, Entry { offset, entryHeader.size } });
+      else
+        numInvalidEntries += 1;
+
+      offset += entryHeader.size;
+    }
+
+    Logger::info(str::format("DXSO: Read ", m_entries.size(), " shader cache entries"));
+
+    if (numInvalidEntries) {
+      Logger::warn(str::format("DXSO: Skipped ", numInvalidEntries, " invalid shader cache entries"));
+      return false;
+    }
+
+    return true;
+  }
+
+
+  void DxsoShaderCache::writeNewCacheFile() {
+    std::ofstream file(m_fileName.c_str(),
+      std::ios_base::binary |
+      std::ios_base::trunc);
+
+    if (!file) {
+      const std::string fileName = str::fromws(m_fileName.c_str());
+      const size_t dirEnd = fileName.find_last_of("/\\");
+
+      if (dirEnd != std::string::npos && env::createDirectory(fileName.substr(0, dirEnd))) {
+        file = std::ofstream(m_fileName.c_str(),
+          std::ios_base::binary |
+          std::ios_base::trunc);
+      }
+    }
+
+    if (!file) {
+      Logger::warn("DXSO: Failed to create shader cache file");
+      return;
+    }
+
+    DxsoShaderCacheHeader header;
+    header.compilerVersion = m_compilerVersion;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Keep the valid entries if we're recovering a damaged file
+    for (const auto& entry : m_entries) {
+      DxsoShaderCacheEntryHeader entryHeader;
+      entryHeader.key = entry.first;
+      entryHeader.checksum = Sha1Hash::compute(m_fileData.data() + entry.second.offset, entry.second.size);
+      entryHeader.size = entry.second.size;
+
+      file.write(reinterpret_cast<const char*>(&entryHeader), sizeof(entryHeader));
+      file.write(m_fileData.data() + entry.second.offset, entry.second.size);
+    }
+  }
+
+
+  void DxsoShaderCache::writerFunc() {
+    env::setThreadName("dxso-cache-writer");
+
+    std::ofstream file;
+
+    while (true) {
+      std::vector<char> entry;
+
+      { std::unique_lock<dxvk::mutex> lock(m_writerLock);
+
+        m_writerBusy = false;
+        m_writerIdleCond.notify_all();
+
+        m_writerCond.wait(lock, [this] () {
+          return m_writerQueue.size()
+              || m_stopWriter;
+        });
+
+        // Write out everything that was queued before stopping
+        if (m_writerQueue.size() == 0)
+          break;
+
+        entry = std::move(m_writerQueue.front());
+        m_writerQueue.pop();
+        m_writerBusy = true;
+      }
+
+      if (!file.is_open()) {
+        file = std::ofstream(m_fileName.c_str(),
+          std::ios_base::binary |
+          std::ios_base::app);
+      }
+
+      // Flush every entry so that a crash loses at most the one being written
+      file.write(entry.data(), entry.size());
+      file.flush();
+    }
+  }
+
+
+  std::vector<char> DxsoShaderCache::serializeEntry(
+    const Sha1Hash&             key,
+    const DxsoCompiledShader&   shader) {
+    std::vector<char> data(sizeof(DxsoShaderCacheEntryHeader));
+    DxsoCacheWriter writer(data);
+
+    uint32_t permutationMask = 0;
+
+    for (uint32_t i = 0; i < D3D9ShaderPermutations::Count; i++) {
+      if (shader.shaders[i] != nullptr)
+        permutationMask |= 1u << i;
+    }
+
+    writer.write(permutationMask);
+
+    for (uint32_t i = 0; i < D3D9ShaderPermutations::Count; i++) {
+      if (shader.shaders[i] == nullptr)
+        continue;
+
+      const std::vector<DxvkResourceSlot>& slots = shader.shaders[i]->getResourceSlots();
+      const SpirvCodeBuffer code = shader.shaders[i]->getCode();
+
+      writer.writeArray(slots.data(), uint32_t(slots.size()));
+      writer.write(shader.shaders[i]->interfaceSlots());
+      writer.writeArray(code.data(), code.dwords());
+    }
+
+    writer.write(shader.isgn);
+    writer.write(shader.osgn);
+    writer.write(shader.usedSamplers);
+    writer.write(shader.usedRTs);
+    writer.write(shader.meta);
+    writer.writeArray(shader.constants.data(), uint32_t(shader.constants.size()));
+    writer.write(shader.maxDefinedConst);
+
+    // Fill in the header now that the size is known
+    DxsoShaderCacheEntryHeader header;
+    header.key = key;
+    header.size = uint32_t(data.size() - sizeof(header));
+    header.checksum = Sha1Hash::compute(data.data() + sizeof(header), header.size);
+
+    std::memcpy(data.data(), &header, sizeof(header));
+    return data;
+  }
+
+
+  bool DxsoShaderCache::deserializeEntry(
+    const char*                 data,
+          size_t                size,
+          VkShaderStageFlagBits stage,
+          DxsoCompiledShader&   shader) {
+    DxsoCacheReader reader(data, size);
+    DxsoCompiledShader result;
+
+    uint32_t permutationMask = 0;
+
+    if (!reader.read(permutationMask) || !(permutationMask & 1u))
+      return false;
+
+    for (uint32_t i = 0; i < D3D9ShaderPermutations::Count; i++) {
+      if (!(permutationMask & (1u << i)))
+        continue;
+
+      std::vector<DxvkResourceSlot> slots;
+      DxvkInterfaceSlots iface;
+      std::vector<uint32_t> code;
+
+      if (!reader.readVector(slots)
+       || !reader.read(iface)
+       || !reader.readVector(code))
+        return false;
+
+      DxvkShaderOptions shaderOptions = { };
+      DxvkShaderConstData constData = { };
+
+      result.shaders[i] = new DxvkShader(stage,
+        slots.size(), slots.data(), iface,
+        SpirvCodeBuffer(code.size(), code.data()),
+        shaderOptions, std::move(constData));
+    }
+
+    if (!reader.read(result.isgn)
+     || !reader.read(result.osgn)
+     || !reader.read(result.usedSamplers)
+     || !reader.read(result.usedRTs)
+     || !reader.read(result.meta)
+     || !reader.readVector(result.constants)
+     || !reader.read(result.maxDefinedConst)
+     || !reader.isAtEnd())
+      return false;
+
+    shader = std::move(result);
+    return true;
+  }
+
+}
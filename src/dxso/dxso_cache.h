@@ -0,0 +1,229 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dxso_isgn.h"
+#include "dxso_modinfo.h"
+
+#include "../d3d9/d3d9_constant_layout.h"
+#include "../d3d9/d3d9_shader_permutations.h"
+
+#include "../dxvk/dxvk_shader.h"
+
+#include "../util/thread.h"
+#include "../util/util_time.h"
+#include "../util/sha1/sha1_util.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Result of a DXSO to SPIR-V translation
+   *
+   * Everything \c DxsoModule::compile produces for a
+   * shader, which is what the disk cache stores.
+   */
+  struct DxsoCompiledShader {
+    DxsoPermutations      shaders;
+    DxsoIsgn              isgn;
+    DxsoIsgn              osgn;
+    uint32_t              usedSamplers    = 0;
+    uint32_t              usedRTs         = 0;
+    DxsoShaderMetaInfo    meta;
+    DxsoDefinedConstants  constants;
+    uint32_t              maxDefinedConst = 0;
+  };
+
+  /**
+   * \brief Shader cache file header
+   *
+   * The compiler version is a hash of the build version,
+   * files written by any other build are discarded.
+   */
+  struct DxsoShaderCacheHeader {
+    char     magic[4] = { 'D', 'X', 'S', 'O' };
+    uint32_t version  = 1;
+    Sha1Hash compilerVersion;
+  };
+
+  /**
+   * \brief Shader cache entry header
+   *
+   * Precedes \c size bytes of serialized shader data.
+   * The checksum covers that data, so entries that were
+   * only partially written are detected on load.
+   */
+  struct DxsoShaderCacheEntryHeader {
+    Sha1Hash key;
+    Sha1Hash checksum;
+    uint32_t size;
+  };
+
+  /**
+   * \brief Persistent DXSO to SPIR-V translation cache
+   *
+   * Reads the whole cache file with one sequential read
+   * on creation and looks up entries by a key derived from
+   * the bytecode hash, the module options and the constant
+   * layout. New entries are appended to the file by a
+   * background writer thread. A file with invalid entries,
+   * e.g. from a crash while writing, is rewritten with only
+   * the valid ones. Lookups are thread-safe.
+   */
+  class DxsoShaderCache : public RcObject {
+
+  public:
+
+    DxsoShaderCache(
+      const std::string&          fileName,
+      const std::string&          compilerVersion);
+
+    ~DxsoShaderCache();
+
+    /**
+     * \brief Computes the cache key of a shader
+     *
+     * \param [in] shaderKey Stage and bytecode hash
+     * \param [in] moduleInfo Compiler options
+     * \param [in] layout Constant buffer layout
+     * \returns Key for \c lookup and \c store
+     */
+    static Sha1Hash computeKey(
+      const DxvkShaderKey&        shaderKey,
+      const DxsoModuleInfo&       moduleInfo,
+      const D3D9ConstantLayout&   layout);
+
+    /**
+     * \brief Looks up a translated shader
+     *
+     * \param [in] key Cache key
+     * \param [in] stage Shader stage
+     * \param [out] shader The translated shader
+     * \returns \c true if the shader was found
+     */
+    bool lookup(
+      const Sha1Hash&             key,
+            VkShaderStageFlagBits stage,
+            DxsoCompiledShader&   shader) const;
+
+    /**
+     * \brief Queues a translated shader for writing
+     *
+     * \param [in] key Cache key
+     * \param [in] shader The translated shader
+     */
+    void store(
+      const Sha1Hash&             key,
+      const DxsoCompiledShader&   shader);
+
+    /**
+     * \brief Waits until all stored shaders are written
+     */
+    void flush();
+
+    /**
+     * \brief Records time spent translating a shader
+     *
+     * Used to compare cold translations against cache
+     * hits, both totals are logged on destruction.
+     * \param [in] time Translation time of one shader
+     */
+    void recordTranslation(
+            std::chrono::nanoseconds time);
+
+    /**
+     * \brief Number of shaders read from the file
+     */
+    size_t loadedEntryCount() const {
+      return m_entries.size();
+    }
+
+    /**
+     * \brief Default cache file name for this process
+     *
+     * Stored in \c DXVK_SHADER_CACHE_PATH, or the working
+     * directory if unset, and named after the executable.
+     */
+    static std::string getDefaultFileName();
+
+  private:
+
+    struct Entry {
+      size_t   offset;
+      uint32_t size;
+    };
+
+    struct KeyHash {
+      size_t operator () (const Sha1Hash& key) const {
+        return key.dword(0);
+      }
+    };
+
+    std::wstring                      m_fileName;
+    Sha1Hash                          m_compilerVersion;
+
+    // Contents of the cache file at startup, never modified
+    // after loading, so lookups do not need to take a lock
+    std::vector<char>                 m_fileData;
+
+    std::unordered_map<
+      Sha1Hash, Entry, KeyHash>       m_entries;
+
+    std::chrono::nanoseconds          m_loadTime = { };
+    mutable std::atomic<uint32_t>     m_numHits         = { 0u };
+    mutable std::atomic<int64_t>      m_hitTimeNs       = { 0 };
+    std::atomic<uint32_t>             m_numTranslations = { 0u };
+    std::atomic<int64_t>              m_translationTimeNs = { 0 };
+
+    dxvk::mutex                       m_writerLock;
+    dxvk::condition_variable          m_writerCond;
+    dxvk::condition_variable          m_writerIdleCond;
+    std::queue<std::vector<char>>     m_writerQueue;
+    bool                              m_writerBusy = false;
+    bool                              m_stopWriter = false;
+    dxvk::thread                      m_writerThread;
+
+    bool readCacheFile();
+
+    void writeNewCacheFile();
+
+    void writerFunc();
+
+    static std::vector<char> serializeEntry(
+      const Sha1Hash&             key,
+      const DxsoCompiledShader&   shader);
+
+    static bool deserializeEntry(
+      const char*                 data,
+            size_t                size,
+            VkShaderStageFlagBits stage,
+            DxsoCompiledShader&   shader);
+
+  };
+
+}
@@ -59,12 +59,29 @@ namespace dxvk {
     const DxvkComputePipelineStateInfo& state) {
     DxvkComputePipelineInstance* instance = nullptr;
 
-    { std::lock_guard<sync::Spinlock> lock(m_mutex);
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    { std::unique_lock<sync::Spinlock> lock(m_mutex);
+    // NV-DXVK end
 
       instance = this->findInstance(state);
 
-      if (instance)
+      if (instance) {
+        // NV-DXVK start: frequency ordered pipeline warm-up
+        if (unlikely(instance->isPrecompiled())) {
+          instance->setPrecompiled(false);
+
+          // Recording the use takes the state cache writer lock, so
+          // release the spinlock first. The instance may move once
+          // the lock is released, keep its handle.
+          VkPipeline pipeline = instance->pipeline();
+          lock.unlock();
+
+          this->writePipelineUseToCache(state);
+          return pipeline;
+        }
+        // NV-DXVK end
         return instance->pipeline();
+      }
     
       // If no pipeline instance exists with the given state
       // vector, create a new one and add it to the list.
@@ -83,8 +100,10 @@ namespace dxvk {
     const DxvkComputePipelineStateInfo& state) {
     std::lock_guard<sync::Spinlock> lock(m_mutex);
 
+    // NV-DXVK start: frequency ordered pipeline warm-up
     if (!this->findInstance(state))
-      this->createInstance(state);
+      this->createInstance(state)->setPrecompiled(true);
+    // NV-DXVK end
   }
   
   
@@ -174,12 +193,28 @@ namespace dxvk {
     if (m_pipeMgr->m_stateCache == nullptr)
       return;
     
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    m_pipeMgr->m_stateCache->addComputePipeline(getStateCacheKey(), state);
+  }
+
+
+  void DxvkComputePipeline::writePipelineUseToCache(
+    const DxvkComputePipelineStateInfo& state) const {
+    if (m_pipeMgr->m_stateCache == nullptr)
+      return;
+
+    m_pipeMgr->m_stateCache->markComputePipelineUsed(getStateCacheKey(), state);
+  }
+
+
+  DxvkStateCacheKey DxvkComputePipeline::getStateCacheKey() const {
     DxvkStateCacheKey key;
 
     if (m_shaders.cs != nullptr)
       key.cs = m_shaders.cs->getShaderKey();
 
-    m_pipeMgr->m_stateCache->addComputePipeline(key, state);
+    return key;
   }
+  // NV-DXVK end
   
 }
@@ -15,6 +15,9 @@ namespace dxvk {
   
   class DxvkDevice;
   class DxvkPipelineManager;
+  // NV-DXVK start: frequency ordered pipeline warm-up
+  struct DxvkStateCacheKey;
+  // NV-DXVK end
   
   /**
    * \brief Shaders used in compute pipelines
@@ -67,10 +70,29 @@ namespace dxvk {
       return m_pipeline;
     }
 
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    /**
+     * \brief Checks whether the state cache compiled this instance
+     *
+     * Cleared once a dispatch uses the instance for the first time.
+     * \returns \c true if precompiled and not used yet
+     */
+    bool isPrecompiled() const {
+      return m_precompiled;
+    }
+
+    void setPrecompiled(bool precompiled) {
+      m_precompiled = precompiled;
+    }
+    // NV-DXVK end
+
   private:
 
     DxvkComputePipelineStateInfo m_stateVector;
     VkPipeline                   m_pipeline;
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    bool                         m_precompiled = false;
+    // NV-DXVK end
 
   };
   
@@ -159,6 +181,13 @@ namespace dxvk {
 
     void writePipelineStateToCache(
       const DxvkComputePipelineStateInfo& state) const;
+
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    void writePipelineUseToCache(
+      const DxvkComputePipelineStateInfo& state) const;
+
+    DxvkStateCacheKey getStateCacheKey() const;
+    // NV-DXVK end
     
   };
   
@@ -64,30 +64,77 @@ namespace dxvk {
   }
   
   
+  // NV-DXVK start: lock-free CS chunk recycling
+  DxvkCsChunkPool::ThreadCache::~ThreadCache() {
+    while (head != nullptr) {
+      DxvkCsChunk* chunk = head;
+      head = chunk->m_nextFree;
+      delete chunk;
+    }
+  }
+
+
+  thread_local DxvkCsChunkPool::ThreadCache DxvkCsChunkPool::s_threadCache;
+  // NV-DXVK end
+
+
   DxvkCsChunkPool::DxvkCsChunkPool() {
     
   }
   
   
   DxvkCsChunkPool::~DxvkCsChunkPool() {
-    for (DxvkCsChunk* chunk : m_chunks)
+    // NV-DXVK start: lock-free CS chunk recycling
+    DxvkCsChunk* chunk = m_freeList.exchange(nullptr, std::memory_order_acquire);
+
+    while (chunk != nullptr) {
+      DxvkCsChunk* next = chunk->m_nextFree;
       delete chunk;
+      chunk = next;
+    }
+    // NV-DXVK end
   }
   
   
   DxvkCsChunk* DxvkCsChunkPool::allocChunk(DxvkCsChunkFlags flags) {
-    DxvkCsChunk* chunk = nullptr;
+    // NV-DXVK start: lock-free CS chunk recycling
+    ThreadCache& cache = s_threadCache;
 
-    { std::lock_guard<sync::Spinlock> lock(m_mutex);
-      
-      if (m_chunks.size() != 0) {
-        chunk = m_chunks.back();
-        m_chunks.pop_back();
+    if (cache.head == nullptr) {
+      // Take everything released so far in one go. Removing the
+      // whole list cannot race with concurrent pushes, unlike
+      // popping single entries which would be prone to ABA.
+      DxvkCsChunk* list = m_freeList.exchange(nullptr, std::memory_order_acquire);
+
+      while (list != nullptr && cache.size < ThreadCache::MaxSize) {
+        DxvkCsChunk* next = list->m_nextFree;
+        list->m_nextFree = cache.head;
+        cache.head = list;
+        cache.size++;
+        list = next;
+      }
+
+      if (unlikely(list != nullptr)) {
+        DxvkCsChunk* last = list;
+
+        while (last->m_nextFree != nullptr)
+          last = last->m_nextFree;
+
+        pushFreeList(list, last);
       }
     }
-    
-    if (!chunk)
+
+    DxvkCsChunk* chunk = cache.head;
+
+    if (chunk != nullptr) {
+      cache.head = chunk->m_nextFree;
+      cache.size--;
+
+      chunk->m_nextFree = nullptr;
+    } else {
       chunk = new DxvkCsChunk();
+    }
+    // NV-DXVK end
     
     chunk->init(flags);
     return chunk;
@@ -97,11 +144,162 @@ namespace dxvk {
   void DxvkCsChunkPool::freeChunk(DxvkCsChunk* chunk) {
     chunk->reset();
     
-    std::lock_guard<sync::Spinlock> lock(m_mutex);
-    m_chunks.push_back(chunk);
+    // NV-DXVK start: lock-free CS chunk recycling
+    pushFreeList(chunk, chunk);
+    // NV-DXVK end
+  }
+  
+  
+  // NV-DXVK start: lock-free CS chunk recycling
+  void DxvkCsChunkPool::pushFreeList(
+          DxvkCsChunk*      first,
+          DxvkCsChunk*      last) {
+    DxvkCsChunk* head = m_freeList.load(std::memory_order_relaxed);
+
+    do {
+      last->m_nextFree = head;
+    } while (!m_freeList.compare_exchange_weak(head, first,
+      std::memory_order_release, std::memory_order_relaxed));
   }
+  // NV-DXVK end
   
   
+  // NV-DXVK start: lock-free CS chunk submission
+  DxvkCsChunkQueue::DxvkCsChunkQueue() {
+
+  }
+
+
+  DxvkCsChunkQueue::~DxvkCsChunkQueue() {
+
+  }
+
+
+  uint64_t DxvkCsChunkQueue::push(
+          DxvkCsChunkRef&&            chunk,
+          std::chrono::microseconds&  stallTime) {
+    // Count the chunk before it becomes visible so that
+    // the executed count never overtakes this one
+    const uint64_t seq = m_chunksDispatched.fetch_add(1, std::memory_order_release) + 1;
+
+    stallTime = std::chrono::microseconds(0);
+
+    if (unlikely(!m_ring.push(std::move(chunk)))) {
+      auto t0 = dxvk::high_resolution_clock::now();
+      waitForProducer([this, &chunk] { return m_ring.push(std::move(chunk)); });
+      auto t1 = dxvk::high_resolution_clock::now();
+
+      stallTime = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0);
+    }
+
+    // Pairs with the fence in pop, either the consumer sees
+    // the new chunk or we see that it is about to park
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (m_consumerParked.load(std::memory_order_relaxed)) {
+      { std::lock_guard<dxvk::mutex> lock(m_mutex); }
+      m_condOnAdd.notify_one();
+    }
+
+    return seq;
+  }
+
+
+  bool DxvkCsChunkQueue::pop(DxvkCsChunkRef& chunk) {
+    auto ready = [this, &chunk] {
+      return m_stopped.load(std::memory_order_acquire) || m_ring.pop(chunk);
+    };
+
+    if (!ready() && !spinWait(m_consumerSpinCount, ready)) {
+      std::unique_lock<dxvk::mutex> lock(m_mutex);
+      m_consumerParked.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      m_condOnAdd.wait(lock, ready);
+      m_consumerParked.store(false, std::memory_order_relaxed);
+    }
+
+    return bool(chunk);
+  }
+
+
+  void DxvkCsChunkQueue::completeChunk() {
+    m_chunksExecuted.fetch_add(1, std::memory_order_release);
+
+    // Pairs with the fence in waitForProducer
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (m_producersParked.load(std::memory_order_relaxed)) {
+      { std::lock_guard<dxvk::mutex> lock(m_mutex); }
+      m_condOnSync.notify_all();
+    }
+  }
+
+
+  void DxvkCsChunkQueue::synchronize(uint64_t seq) {
+    waitForProducer([this, seq] {
+      return m_chunksExecuted.load(std::memory_order_acquire) >= seq;
+    });
+  }
+
+
+  void DxvkCsChunkQueue::stop() {
+    { std::lock_guard<dxvk::mutex> lock(m_mutex);
+      m_stopped.store(true, std::memory_order_release);
+    }
+
+    m_condOnAdd.notify_one();
+    m_condOnSync.notify_all();
+  }
+
+
+  template<typename Fn>
+  void DxvkCsChunkQueue::waitForProducer(
+    const Fn&                 condition) {
+    if (condition())
+      return;
+
+    // Several threads may synchronize at once, so the
+    // shared spin budget is only updated approximately
+    uint32_t spinCount = m_producerSpinCount.load(std::memory_order_relaxed);
+    bool success = spinWait(spinCount, condition);
+    m_producerSpinCount.store(spinCount, std::memory_order_relaxed);
+
+    if (success)
+      return;
+
+    std::unique_lock<dxvk::mutex> lock(m_mutex);
+    m_producersParked.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    m_condOnSync.wait(lock, [this, &condition] {
+      return condition() || m_stopped.load(std::memory_order_acquire);
+    });
+
+    m_producersParked.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+
+  template<typename Fn>
+  bool DxvkCsChunkQueue::spinWait(
+          uint32_t&           spinCount,
+    const Fn&                 condition) {
+    for (uint32_t i = 0; i < spinCount; i++) {
+      _mm_pause();
+
+      if (condition()) {
+        // Spinning paid off, allow spinning for longer
+        spinCount = std::min(spinCount * 2, MaxSpinCount);
+        return true;
+      }
+    }
+
+    spinCount = std::max(spinCount / 2, MinSpinCount);
+    return false;
+  }
+  // NV-DXVK end
+
+
   DxvkCsThread::DxvkCsThread(
     const Rc<DxvkDevice>&   device,
     const Rc<DxvkContext>&  context)
@@ -112,11 +310,9 @@ namespace dxvk {
   
   
   DxvkCsThread::~DxvkCsThread() {
-    { std::unique_lock<dxvk::mutex> lock(m_mutex);
-      m_stopped.store(true);
-    }
-    
-    m_condOnAdd.notify_one();
+    // NV-DXVK start: lock-free CS chunk submission
+    m_queue.stop();
+    // NV-DXVK end
     m_thread.join();
   }
   
@@ -124,14 +320,16 @@ namespace dxvk {
   uint64_t DxvkCsThread::dispatchChunk(DxvkCsChunkRef&& chunk) {
     ScopedCpuProfileZone();
 
-    uint64_t seq;
+    // NV-DXVK start: lock-free CS chunk submission
+    std::chrono::microseconds stallTime;
+    uint64_t seq = m_queue.push(std::move(chunk), stallTime);
 
-    { std::unique_lock<dxvk::mutex> lock(m_mutex);
-      seq = ++m_chunksDispatched;
-      m_chunksQueued.push(std::move(chunk));
+    if (unlikely(stallTime.count())) {
+      m_device->addStatCtr(DxvkStatCounter::CsStallCount, 1);
+      m_device->addStatCtr(DxvkStatCounter::CsStallTicks, stallTime.count());
     }
-    
-    m_condOnAdd.notify_one();
+    // NV-DXVK end
+
     return seq;
   }
   
@@ -141,22 +339,20 @@ namespace dxvk {
 
     // Avoid locking if we know the sync is a no-op, may
     // reduce overhead if this is being called frequently
-    if (seq > m_chunksExecuted.load(std::memory_order_acquire)) {
-      std::unique_lock<dxvk::mutex> lock(m_mutex);
-
+    // NV-DXVK start: lock-free CS chunk submission
+    if (seq > m_queue.executedCount()) {
       if (seq == SynchronizeAll)
-        seq = m_chunksDispatched.load();
+        seq = m_queue.dispatchedCount();
 
       auto t0 = dxvk::high_resolution_clock::now();
-      m_condOnSync.wait(lock, [this, seq] {
-        return m_chunksExecuted.load() >= seq;
-      });
+      m_queue.synchronize(seq);
       auto t1 = dxvk::high_resolution_clock::now();
       auto ticks = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0);
 
       m_device->addStatCtr(DxvkStatCounter::CsSyncCount, 1);
       m_device->addStatCtr(DxvkStatCounter::CsSyncTicks, ticks.count());
     }
+    // NV-DXVK end
   }
   
   
@@ -168,33 +364,24 @@ namespace dxvk {
     DxvkCsChunkRef chunk;
 
     try {
-      while (!m_stopped.load()) {
-        { std::unique_lock<dxvk::mutex> lock(m_mutex);
-          if (chunk) {
-            m_chunksExecuted++;
-            m_condOnSync.notify_one();
-            
-            chunk = DxvkCsChunkRef();
-          }
-          
-          if (m_chunksQueued.size() == 0) {
-            m_condOnAdd.wait(lock, [this] {
-              return (m_chunksQueued.size() != 0)
-                  || (m_stopped.load());
-            });
-          }
-          
-          if (m_chunksQueued.size() != 0) {
-            chunk = std::move(m_chunksQueued.front());
-            m_chunksQueued.pop();
-          }
-        }
-        
-        if (chunk) {
-          m_context->addStatCtr(DxvkStatCounter::CsChunkCount, 1);
-          chunk->executeAll(m_context.ptr());
-        }
+      // NV-DXVK start: lock-free CS chunk submission
+      while (!m_queue.stopped()) {
+        if (!m_queue.pop(chunk))
+          continue;
+
+        // Chunks submitted but not yet executed, including this one
+        const uint64_t depth = m_queue.dispatchedCount() - m_queue.executedCount();
+
+        m_context->addStatCtr(DxvkStatCounter::CsChunkCount, 1);
+        m_context->addStatCtr(DxvkStatCounter::CsQueueDepth, depth);
+        chunk->executeAll(m_context.ptr());
+
+        // Release the chunk before waking up waiters, so that
+        // it is back in the pool when the producer continues
+        chunk = DxvkCsChunkRef();
+        m_queue.completeChunk();
       }
+      // NV-DXVK end
     } catch (const DxvkError& e) {
       Logger::err("Exception on CS thread!");
       Logger::err(e.message());
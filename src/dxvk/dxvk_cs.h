@@ -6,6 +6,9 @@
 #include <queue>
 
 #include "../util/thread.h"
+// NV-DXVK start: lock-free CS chunk submission
+#include "../util/util_atomic_queue.h"
+// NV-DXVK end
 
 #include "dxvk_device.h"
 #include "dxvk_context.h"
@@ -236,6 +239,12 @@ namespace dxvk {
     
   private:
     
+    // NV-DXVK start: lock-free CS chunk recycling
+    friend class DxvkCsChunkPool;
+
+    DxvkCsChunk* m_nextFree = nullptr;
+    // NV-DXVK end
+
     size_t m_commandOffset = 0;
     
     DxvkCsCmd* m_head = nullptr;
@@ -255,6 +264,14 @@ namespace dxvk {
    * Implements a pool of CS chunks which can be
    * recycled. The goal is to reduce the number
    * of dynamic memory allocations.
+   *
+   * Chunks are usually released on the CS thread and
+   * allocated on the submitting thread. Released chunks
+   * go to a lock-free list, and allocating threads take
+   * that whole list at once into a small thread-local
+   * cache that they then allocate from without atomics.
+   * Chunks do not belong to a pool, so a thread's cache
+   * may serve any pool.
    */
   class DxvkCsChunkPool {
     
@@ -286,8 +303,30 @@ namespace dxvk {
     
   private:
     
-    sync::Spinlock            m_mutex;
-    std::vector<DxvkCsChunk*> m_chunks;
+    // NV-DXVK start: lock-free CS chunk recycling
+    /**
+     * \brief Per-thread chunk cache
+     * 
+     * Bounded so that threads do not hold on
+     * to many chunks after a device is gone.
+     */
+    struct ThreadCache {
+      constexpr static uint32_t MaxSize = 64;
+
+      DxvkCsChunk* head = nullptr;
+      uint32_t     size = 0;
+
+      ~ThreadCache();
+    };
+
+    static thread_local ThreadCache s_threadCache;
+
+    std::atomic<DxvkCsChunk*> m_freeList = { nullptr };
+
+    void pushFreeList(
+            DxvkCsChunk*      first,
+            DxvkCsChunk*      last);
+    // NV-DXVK end
     
   };
   
@@ -372,6 +411,134 @@ namespace dxvk {
   };
 
 
+  // NV-DXVK start: lock-free CS chunk submission
+  /**
+   * \brief Command stream chunk queue
+   * 
+   * Lock-free ring of chunks between the submitting thread
+   * and the CS thread. Waiting on either side spins for a
+   * while before parking on a condition variable, and the
+   * spin budget adapts to how often spinning succeeds, so
+   * a busy CS thread never touches the mutex.
+   * 
+   * Only one thread may push at a time. This is already
+   * the case for all users since chunks are recorded into
+   * a single chunk owned by the device or context first.
+   */
+  class DxvkCsChunkQueue {
+    
+  public:
+    
+    constexpr static uint32_t Capacity     = 4096;
+    constexpr static uint32_t MinSpinCount = 64;
+    constexpr static uint32_t MaxSpinCount = 2048;
+    
+    DxvkCsChunkQueue();
+    ~DxvkCsChunkQueue();
+    
+    DxvkCsChunkQueue             (const DxvkCsChunkQueue&) = delete;
+    DxvkCsChunkQueue& operator = (const DxvkCsChunkQueue&) = delete;
+    
+    /**
+     * \brief Adds a chunk to the queue
+     * 
+     * Waits for the consumer if the ring is full.
+     * \param [in] chunk The chunk to add
+     * \param [out] stallTime Time spent waiting for space
+     * \returns Sequence number of the chunk
+     */
+    uint64_t push(
+            DxvkCsChunkRef&&            chunk,
+            std::chrono::microseconds&  stallTime);
+    
+    /**
+     * \brief Takes the next chunk from the queue
+     * 
+     * Called by the consumer. Waits until a chunk
+     * is available or the queue has been stopped.
+     * \param [out] chunk The chunk
+     * \returns \c false if stopped with no chunk
+     */
+    bool pop(DxvkCsChunkRef& chunk);
+    
+    /**
+     * \brief Marks the last popped chunk as executed
+     * 
+     * Called by the consumer, wakes up threads
+     * waiting in \c synchronize or \c push.
+     */
+    void completeChunk();
+    
+    /**
+     * \brief Waits for a chunk to be executed
+     * 
+     * \param [in] seq Sequence number to wait for
+     */
+    void synchronize(uint64_t seq);
+    
+    /**
+     * \brief Stops the queue
+     * 
+     * Wakes up the consumer, which will then
+     * not receive any more chunks.
+     */
+    void stop();
+    
+    /**
+     * \brief Checks whether the queue was stopped
+     */
+    bool stopped() const {
+      return m_stopped.load(std::memory_order_acquire);
+    }
+    
+    /**
+     * \brief Sequence number of the last pushed chunk
+     */
+    uint64_t dispatchedCount() const {
+      return m_chunksDispatched.load(std::memory_order_acquire);
+    }
+    
+    /**
+     * \brief Sequence number of the last executed chunk
+     */
+    uint64_t executedCount() const {
+      return m_chunksExecuted.load(std::memory_order_acquire);
+    }
+    
+  private:
+    
+    AtomicQueue<DxvkCsChunkRef, Capacity> m_ring;
+    
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<uint64_t>       m_chunksDispatched = { 0ull };
+    std::atomic<uint32_t>       m_producerSpinCount = { MinSpinCount };
+    
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<uint64_t>       m_chunksExecuted   = { 0ull };
+    uint32_t                    m_consumerSpinCount = MinSpinCount;
+    
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<bool>           m_stopped          = { false };
+    std::atomic<bool>           m_consumerParked   = { false };
+    std::atomic<uint32_t>       m_producersParked  = { 0u };
+    
+    dxvk::mutex                 m_mutex;
+    dxvk::condition_variable    m_condOnAdd;
+    dxvk::condition_variable    m_condOnSync;
+    
+    template<typename Fn>
+    void waitForProducer(
+      const Fn&                 condition);
+    
+    template<typename Fn>
+    static bool spinWait(
+            uint32_t&           spinCount,
+      const Fn&                 condition);
+    
+  };
+  // NV-DXVK end
+
+
   /**
    * \brief Command stream thread
    * 
@@ -417,7 +584,9 @@ namespace dxvk {
      * \returns Sequence number of last executed chunk
      */
     uint64_t lastSequenceNumber() const {
-      return m_chunksExecuted.load();
+      // NV-DXVK start: lock-free CS chunk submission
+      return m_queue.executedCount();
+      // NV-DXVK end
     }
 
   private:
@@ -425,14 +594,9 @@ namespace dxvk {
     Rc<DxvkDevice>              m_device;
     Rc<DxvkContext>             m_context;
 
-    std::atomic<uint64_t>       m_chunksDispatched = { 0ull };
-    std::atomic<uint64_t>       m_chunksExecuted   = { 0ull };
-    
-    std::atomic<bool>           m_stopped = { false };
-    dxvk::mutex                 m_mutex;
-    dxvk::condition_variable    m_condOnAdd;
-    dxvk::condition_variable    m_condOnSync;
-    std::queue<DxvkCsChunkRef>  m_chunksQueued;
+    // NV-DXVK start: lock-free CS chunk submission
+    DxvkCsChunkQueue            m_queue;
+    // NV-DXVK end
     dxvk::thread                m_thread;
     
     void threadFunc();
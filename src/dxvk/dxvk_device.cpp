@@ -307,6 +307,10 @@ namespace dxvk {
     result.setCtr(DxvkStatCounter::PipeCountGraphics, pipe.numGraphicsPipelines);
     result.setCtr(DxvkStatCounter::PipeCountCompute,  pipe.numComputePipelines);
     result.setCtr(DxvkStatCounter::PipeCompilerBusy,  m_objects.pipelineManager().isCompilingShaders());
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    result.setCtr(DxvkStatCounter::PipeCacheEntries,  pipe.numCachedPipelines);
+    result.setCtr(DxvkStatCounter::PipeCacheCompiled, pipe.numCachedPipelinesCompiled);
+    // NV-DXVK end
     result.setCtr(DxvkStatCounter::GpuIdleTicks,      m_submissionQueue.gpuIdleTicks());
 
     std::lock_guard<sync::Spinlock> lock(m_statLock);
@@ -320,6 +324,13 @@ namespace dxvk {
   }
 
 
+  // NV-DXVK start: chunk fragmentation stats
+  VkDeviceSize DxvkDevice::refreshLargestChunkFreeBlock(uint32_t heap) {
+    return m_objects.memoryManager().refreshLargestChunkFreeBlock(heap);
+  }
+  // NV-DXVK end
+
+
   uint32_t DxvkDevice::getCurrentFrameId() const {
     // NV-DXVK start
     // ToDo: avoid returning kInvalidFrameIndex
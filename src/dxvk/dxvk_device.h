@@ -451,6 +451,17 @@ namespace dxvk {
      */
     DxvkMemoryStats getMemoryStats(uint32_t heap);
 
+    // NV-DXVK start: chunk fragmentation stats
+    /**
+     * \brief Refreshes the largest free chunk block of a heap
+     *
+     * Walks every chunk of the heap, only meant for diagnostics.
+     * \param [in] heap Memory heap index
+     * \returns Size of the largest free chunk block
+     */
+    VkDeviceSize refreshLargestChunkFreeBlock(uint32_t heap);
+    // NV-DXVK end
+
     /**
      * \brief Retreves current frame ID
      * \returns Current frame ID
@@ -65,12 +65,29 @@ namespace dxvk {
     const DxvkRenderPass*                renderPass) {
     DxvkGraphicsPipelineInstance* instance = nullptr;
 
-    { std::lock_guard<sync::Spinlock> lock(m_mutex);
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    { std::unique_lock<sync::Spinlock> lock(m_mutex);
+    // NV-DXVK end
     
       instance = this->findInstance(state, renderPass);
       
-      if (instance)
+      if (instance) {
+        // NV-DXVK start: frequency ordered pipeline warm-up
+        if (unlikely(instance->isPrecompiled())) {
+          instance->setPrecompiled(false);
+
+          // Recording the use takes the state cache writer lock, so
+          // release the spinlock first. The instance may move once
+          // the lock is released, keep its handle.
+          VkPipeline pipeline = instance->pipeline();
+          lock.unlock();
+
+          this->writePipelineUseToCache(state, renderPass->format());
+          return pipeline;
+        }
+        // NV-DXVK end
         return instance->pipeline();
+      }
       
       instance = this->createInstance(state, renderPass);
     }
@@ -88,8 +105,14 @@ namespace dxvk {
     const DxvkRenderPass*                renderPass) {
     std::lock_guard<sync::Spinlock> lock(m_mutex);
 
-    if (!this->findInstance(state, renderPass))
-      this->createInstance(state, renderPass);
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    if (!this->findInstance(state, renderPass)) {
+      DxvkGraphicsPipelineInstance* instance = this->createInstance(state, renderPass);
+
+      if (instance)
+        instance->setPrecompiled(true);
+    }
+    // NV-DXVK end
   }
 
 
@@ -526,15 +549,31 @@ namespace dxvk {
     if (m_pipeMgr->m_stateCache == nullptr)
       return;
     
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    m_pipeMgr->m_stateCache->addGraphicsPipeline(getStateCacheKey(), state, format);
+  }
+
+
+  void DxvkGraphicsPipeline::writePipelineUseToCache(
+    const DxvkGraphicsPipelineStateInfo& state,
+    const DxvkRenderPassFormat&          format) const {
+    if (m_pipeMgr->m_stateCache == nullptr)
+      return;
+
+    m_pipeMgr->m_stateCache->markGraphicsPipelineUsed(getStateCacheKey(), state, format);
+  }
+
+
+  DxvkStateCacheKey DxvkGraphicsPipeline::getStateCacheKey() const {
     DxvkStateCacheKey key;
     if (m_shaders.vs  != nullptr) key.vs = m_shaders.vs->getShaderKey();
     if (m_shaders.tcs != nullptr) key.tcs = m_shaders.tcs->getShaderKey();
     if (m_shaders.tes != nullptr) key.tes = m_shaders.tes->getShaderKey();
     if (m_shaders.gs  != nullptr) key.gs = m_shaders.gs->getShaderKey();
     if (m_shaders.fs  != nullptr) key.fs = m_shaders.fs->getShaderKey();
-
-    m_pipeMgr->m_stateCache->addGraphicsPipeline(key, state, format);
+    return key;
   }
+  // NV-DXVK end
   
   
   void DxvkGraphicsPipeline::logPipelineState(
@@ -16,6 +16,9 @@ namespace dxvk {
   
   class DxvkDevice;
   class DxvkPipelineManager;
+  // NV-DXVK start: frequency ordered pipeline warm-up
+  struct DxvkStateCacheKey;
+  // NV-DXVK end
 
   /**
    * \brief Flags that describe pipeline properties
@@ -113,11 +116,30 @@ namespace dxvk {
       return m_pipeline;
     }
 
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    /**
+     * \brief Checks whether the state cache compiled this instance
+     *
+     * Cleared once a draw uses the instance for the first time.
+     * \returns \c true if precompiled and not used yet
+     */
+    bool isPrecompiled() const {
+      return m_precompiled;
+    }
+
+    void setPrecompiled(bool precompiled) {
+      m_precompiled = precompiled;
+    }
+    // NV-DXVK end
+
   private:
 
     DxvkGraphicsPipelineStateInfo m_stateVector;
     const DxvkRenderPass*         m_renderPass;
     VkPipeline                    m_pipeline;
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    bool                          m_precompiled = false;
+    // NV-DXVK end
 
   };
 
@@ -251,6 +273,14 @@ namespace dxvk {
     void writePipelineStateToCache(
       const DxvkGraphicsPipelineStateInfo& state,
       const DxvkRenderPassFormat&          format) const;
+
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    void writePipelineUseToCache(
+      const DxvkGraphicsPipelineStateInfo& state,
+      const DxvkRenderPassFormat&          format) const;
+
+    DxvkStateCacheKey getStateCacheKey() const;
+    // NV-DXVK end
     
     void logPipelineState(
             LogLevel                       level,
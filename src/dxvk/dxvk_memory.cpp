@@ -38,6 +38,11 @@ DxvkMemoryStats& DxvkMemoryStats::operator=(const DxvkMemoryStats& other)
   rtxOpacityMicromaps = other.rtxOpacityMicromaps.load();
   rtxMaterialTextures = other.rtxMaterialTextures.load();
   rtxRenderTargets = other.rtxRenderTargets.load();
+  // NV-DXVK start: chunk fragmentation stats
+  chunkMemoryFree = other.chunkMemoryFree.load();
+  chunkFreeBlockCount = other.chunkFreeBlockCount.load();
+  largestChunkFreeBlockSize = other.largestChunkFreeBlockSize.load();
+  // NV-DXVK end
 
   return *this;
 }
@@ -151,6 +156,43 @@ VkDeviceSize DxvkMemoryStats::usedByCategory(Category category) const
   }
 }
 
+// NV-DXVK start: chunk fragmentation stats
+void DxvkMemoryStats::trackChunkFreeSpace(int64_t sizeDelta, int32_t blockDelta)
+{
+  chunkMemoryFree += VkDeviceSize(sizeDelta);
+  chunkFreeBlockCount += uint32_t(blockDelta);
+}
+
+void DxvkMemoryStats::setLargestChunkFreeBlock(VkDeviceSize size)
+{
+  largestChunkFreeBlockSize = size;
+}
+
+VkDeviceSize DxvkMemoryStats::chunkFreeMemory() const
+{
+  return chunkMemoryFree;
+}
+
+uint32_t DxvkMemoryStats::chunkFreeBlocks() const
+{
+  return chunkFreeBlockCount;
+}
+
+VkDeviceSize DxvkMemoryStats::largestChunkFreeBlock() const
+{
+  return largestChunkFreeBlockSize;
+}
+
+float DxvkMemoryStats::chunkFragmentation() const
+{
+  const VkDeviceSize freeMemory = chunkMemoryFree;
+  if (freeMemory == 0) {
+    return 0.0f;
+  }
+  return 1.0f - float(std::min<VkDeviceSize>(largestChunkFreeBlockSize, freeMemory)) / float(freeMemory);
+}
+// NV-DXVK end
+
 static const std::map<DxvkMemoryStats::Category, const char *> categoryStringMap = {
   { DxvkMemoryStats::Category::AppBuffer, "AppBuffer" },
   { DxvkMemoryStats::Category::AppTexture, "AppTexture" },
@@ -174,7 +216,8 @@ DxvkMemory::DxvkMemory() { }
           VkDeviceSize          offset,
           VkDeviceSize          length,
           void*                 mapPtr,
-          DxvkMemoryStats::Category category)
+          DxvkMemoryStats::Category category,
+          TlsfAllocator::Node   chunkNode)
   : m_alloc   (alloc),
     m_chunk   (chunk),
     m_type    (type),
@@ -182,7 +225,8 @@ DxvkMemory::DxvkMemory() { }
     m_offset  (offset),
     m_length  (length),
     m_mapPtr  (mapPtr),
-    m_category (category) { }
+    m_category (category),
+    m_chunkNode (chunkNode) { }
   
   
   DxvkMemory::DxvkMemory(DxvkMemory&& other)
@@ -193,7 +237,8 @@ DxvkMemory::DxvkMemory() { }
     m_offset  (std::exchange(other.m_offset, 0)),
     m_length  (std::exchange(other.m_length, 0)),
     m_mapPtr  (std::exchange(other.m_mapPtr, nullptr)),
-    m_category (std::exchange(other.m_category, DxvkMemoryStats::Category::Invalid)) { }
+    m_category (std::exchange(other.m_category, DxvkMemoryStats::Category::Invalid)),
+    m_chunkNode (std::exchange(other.m_chunkNode, TlsfAllocator::kInvalidNode)) { }
   
   
   DxvkMemory& DxvkMemory::operator = (DxvkMemory&& other) {
@@ -206,6 +251,7 @@ DxvkMemory::DxvkMemory() { }
     m_length  = std::exchange(other.m_length, 0);
     m_mapPtr  = std::exchange(other.m_mapPtr, nullptr);
     m_category = std::exchange(other.m_category, DxvkMemoryStats::Category::Invalid);
+    m_chunkNode = std::exchange(other.m_chunkNode, TlsfAllocator::kInvalidNode);
     return *this;
   }
   
@@ -226,13 +272,20 @@ DxvkMemory::DxvkMemory() { }
           DxvkMemoryType*       type,
           DxvkDeviceMemory      memory,
           DxvkMemoryFlags       hints)
-  : m_alloc(alloc), m_type(type), m_memory(memory), m_hints(hints) {
-    // Mark the entire chunk as free
-    m_freeList.push_back(FreeSlice { 0, memory.memSize });
+  : m_alloc(alloc), m_type(type), m_memory(memory), m_hints(hints)
+  // NV-DXVK start: TLSF chunk sub-allocator
+  , m_allocator(memory.memSize) {
+    // The entire chunk starts out as one free block
+    m_type->heap->stats.trackChunkFreeSpace(int64_t(m_allocator.freeBytes()), int32_t(m_allocator.freeBlockCount()));
+    // NV-DXVK end
   }
   
   
   DxvkMemoryChunk::~DxvkMemoryChunk() {
+    // NV-DXVK start: chunk fragmentation stats
+    m_type->heap->stats.trackChunkFreeSpace(-int64_t(m_allocator.freeBytes()), -int32_t(m_allocator.freeBlockCount()));
+    // NV-DXVK end
+
     // This call is technically not thread-safe, but it
     // doesn't need to be since we don't free chunks
     m_alloc->freeDeviceMemory(m_type, m_memory);
@@ -250,84 +303,53 @@ DxvkMemory::DxvkMemory() { }
     if (m_memory.memFlags != flags || !checkHints(hints))
       return DxvkMemory();
     
-    // If the chunk is full, return
-    if (m_freeList.size() == 0)
-      return DxvkMemory();
-    
-    // Select the slice to allocate from in a worst-fit
-    // manner. This may help keep fragmentation low.
-    auto bestSlice = m_freeList.begin();
-    
-    for (auto slice = m_freeList.begin(); slice != m_freeList.end(); slice++) {
-      if (slice->length == size) {
-        bestSlice = slice;
-        break;
-      } else if (slice->length > bestSlice->length) {
-        bestSlice = slice;
-      }
-    }
-    
-    // We need to align the allocation to the requested alignment
-    const VkDeviceSize sliceStart = bestSlice->offset;
-    const VkDeviceSize sliceEnd   = bestSlice->offset + bestSlice->length;
-    
-    const VkDeviceSize allocStart = dxvk::align(sliceStart,        align);
-    const VkDeviceSize allocEnd   = dxvk::align(allocStart + size, align);
-    
-    if (allocEnd > sliceEnd)
+    // NV-DXVK start: TLSF chunk sub-allocator
+    // Finds a free block in O(1), the size is rounded up to the alignment
+    // as before, and adjacent free blocks are merged on free
+    const uint64_t freeBytesBefore = m_allocator.freeBytes();
+    const uint32_t freeBlocksBefore = m_allocator.freeBlockCount();
+
+    const TlsfAllocator::Allocation allocation = m_allocator.alloc(size, align);
+
+    if (!allocation)
       return DxvkMemory();
-    
-    // We can use this slice, but we'll have to add
-    // the unused parts of it back to the free list.
-    m_freeList.erase(bestSlice);
-    
-    if (allocStart != sliceStart)
-      m_freeList.push_back({ sliceStart, allocStart - sliceStart });
-    
-    if (allocEnd != sliceEnd)
-      m_freeList.push_back({ allocEnd, sliceEnd - allocEnd });
 
-    // NV-DXVK start:
+    trackFreeSpace(freeBytesBefore, freeBlocksBefore);
+
     // Calculate the pointer to the mapped data, if any
-    void* mapPtr = (m_memory.memPointer != nullptr) ? reinterpret_cast<char*>(m_memory.memPointer) + allocStart : nullptr;
+    void* mapPtr = (m_memory.memPointer != nullptr) ? reinterpret_cast<char*>(m_memory.memPointer) + allocation.offset : nullptr;
 
     // Create the memory object with the aligned slice
     return DxvkMemory(m_alloc, this, m_type,
-      m_memory.memHandle, allocStart, allocEnd - allocStart,
-      mapPtr, category);
+      m_memory.memHandle, allocation.offset, allocation.size,
+      mapPtr, category, allocation.node);
     // NV-DXVK end
   }
   
   
+  // NV-DXVK start: TLSF chunk sub-allocator
   void DxvkMemoryChunk::free(
-          VkDeviceSize  offset,
-          VkDeviceSize  length) {
-    // Remove adjacent entries from the free list and then add
-    // a new slice that covers all those entries. Without doing
-    // so, the slice could not be reused for larger allocations.
-    auto curr = m_freeList.begin();
-    
-    while (curr != m_freeList.end()) {
-      if (curr->offset == offset + length) {
-        length += curr->length;
-        curr = m_freeList.erase(curr);
-      } else if (curr->offset + curr->length == offset) {
-        offset -= curr->length;
-        length += curr->length;
-        curr = m_freeList.erase(curr);
-      } else {
-        curr++;
-      }
-    }
-    
-    m_freeList.push_back({ offset, length });
+          TlsfAllocator::Node node) {
+    const uint64_t freeBytesBefore = m_allocator.freeBytes();
+    const uint32_t freeBlocksBefore = m_allocator.freeBlockCount();
+
+    m_allocator.free(node);
+
+    trackFreeSpace(freeBytesBefore, freeBlocksBefore);
   }
   
   
   bool DxvkMemoryChunk::isEmpty() const {
-    return m_freeList.size() == 1
-        && m_freeList[0].length == m_memory.memSize;
+    return m_allocator.isEmpty();
+  }
+
+
+  void DxvkMemoryChunk::trackFreeSpace(uint64_t freeBytesBefore, uint32_t freeBlocksBefore) {
+    m_type->heap->stats.trackChunkFreeSpace(
+      int64_t(m_allocator.freeBytes()) - int64_t(freeBytesBefore),
+      int32_t(m_allocator.freeBlockCount()) - int32_t(freeBlocksBefore));
   }
+  // NV-DXVK end
 
 
   bool DxvkMemoryChunk::isCompatible(const Rc<DxvkMemoryChunk>& other) const {
@@ -474,9 +496,17 @@ DxvkMemory::DxvkMemory() { }
         "\n  Mem types: ", "0x", std::hex, req->memoryTypeBits));
 
       for (uint32_t i = 0; i < m_memProps.memoryHeapCount; i++) {
+        // NV-DXVK start: chunk fragmentation stats
+        refreshLargestChunkFreeBlock(i);
+        const DxvkMemoryStats& stats = getMemoryStats(i);
+        // NV-DXVK end
         Logger::err(str::format("Heap ", i, ": ",
-          (m_memHeaps[i].stats.totalAllocated() >> 20), " MB allocated, ",
-          (m_memHeaps[i].stats.totalUsed() >> 20), " MB used, ",
+          (stats.totalAllocated() >> 20), " MB allocated, ",
+          (stats.totalUsed() >> 20), " MB used, ",
+          // NV-DXVK start: chunk fragmentation stats
+          (stats.chunkFreeMemory() >> 20), " MB free in ", stats.chunkFreeBlocks(), " chunk blocks (largest ",
+          (stats.largestChunkFreeBlock() >> 20), " MB), ",
+          // NV-DXVK end
           m_device->extensions().extMemoryBudget
             ? str::format(
                 (memHeapInfo.heaps[i].memoryAllocated >> 20), " MB allocated (driver), ",
@@ -492,6 +522,29 @@ DxvkMemory::DxvkMemory() { }
     return result;
   }
   
+  // NV-DXVK start: chunk fragmentation stats
+  VkDeviceSize DxvkMemoryAllocator::refreshLargestChunkFreeBlock(uint32_t heap) {
+    DxvkMemoryHeap& memHeap = m_memHeaps[heap];
+
+    VkDeviceSize largestFreeBlock = 0;
+
+    for (uint32_t i = 0; i < m_memProps.memoryTypeCount; i++) {
+      DxvkMemoryType* type = &m_memTypes[i];
+
+      if (type->heap != &memHeap)
+        continue;
+
+      std::lock_guard<dxvk::mutex> lock(type->mutex);
+
+      for (const Rc<DxvkMemoryChunk>& chunk : type->chunks)
+        largestFreeBlock = std::max(largestFreeBlock, chunk->largestFreeBlock());
+    }
+
+    memHeap.stats.setLargestChunkFreeBlock(largestFreeBlock);
+    return largestFreeBlock;
+  }
+  // NV-DXVK end
+
   //// NV-DXVK start: Free unused memory
   void DxvkMemoryAllocator::freeUnusedChunks() {
     for (auto& heap : m_memHeaps) {
@@ -664,11 +717,12 @@ DxvkMemory::DxvkMemory() { }
     memory.m_type->heap->stats.trackMemoryReleased(memory.m_category, memory.m_length);
 
     if (memory.m_chunk != nullptr) {
+      // NV-DXVK start: TLSF chunk sub-allocator
       this->freeChunkMemory(
         memory.m_type,
         memory.m_chunk,
-        memory.m_offset,
-        memory.m_length);
+        memory.m_chunkNode);
+      // NV-DXVK end
     } else {
       DxvkDeviceMemory devMem;
       devMem.memHandle  = memory.m_memory;
@@ -679,12 +733,13 @@ DxvkMemory::DxvkMemory() { }
   }
 
   
+  // NV-DXVK start: TLSF chunk sub-allocator
   void DxvkMemoryAllocator::freeChunkMemory(
           DxvkMemoryType*       type,
           DxvkMemoryChunk*      chunk,
-          VkDeviceSize          offset,
-          VkDeviceSize          length) {
-    chunk->free(offset, length);
+          TlsfAllocator::Node   node) {
+    chunk->free(node);
+    // NV-DXVK end
 
     if (chunk->isEmpty()) {
       Rc<DxvkMemoryChunk> chunkRef = chunk;
@@ -22,6 +22,9 @@
 #pragma once
 
 #include "dxvk_adapter.h"
+// NV-DXVK start: TLSF chunk sub-allocator
+#include "../util/util_tlsf_allocator.h"
+// NV-DXVK end
 
 namespace dxvk {
   
@@ -73,6 +76,19 @@ namespace dxvk {
     VkDeviceSize totalUsed() const;
     VkDeviceSize usedByCategory(Category category) const;
 
+    // NV-DXVK start: chunk fragmentation stats
+    // tracks free space left inside sub-allocated chunks
+    void trackChunkFreeSpace(int64_t sizeDelta, int32_t blockDelta);
+    void setLargestChunkFreeBlock(VkDeviceSize size);
+
+    VkDeviceSize chunkFreeMemory() const;
+    uint32_t chunkFreeBlocks() const;
+    // Only refreshed by DxvkMemoryAllocator::refreshLargestChunkFreeBlock
+    VkDeviceSize largestChunkFreeBlock() const;
+    // 0 when all free chunk memory is one block, approaching 1 as it is split into many small ones
+    float chunkFragmentation() const;
+    // NV-DXVK end
+
     static const char* categoryToString(Category category);
     
   private:
@@ -86,6 +102,12 @@ namespace dxvk {
     std::atomic<VkDeviceSize> rtxOpacityMicromaps = 0;
     std::atomic<VkDeviceSize> rtxMaterialTextures = 0;
     std::atomic<VkDeviceSize> rtxRenderTargets = 0;
+
+    // NV-DXVK start: chunk fragmentation stats
+    std::atomic<VkDeviceSize> chunkMemoryFree = 0;
+    std::atomic<uint32_t> chunkFreeBlockCount = 0;
+    std::atomic<VkDeviceSize> largestChunkFreeBlockSize = 0;
+    // NV-DXVK end
   };
 
 
@@ -184,7 +206,10 @@ namespace dxvk {
       VkDeviceSize          offset,
       VkDeviceSize          length,
       void*                 mapPtr,
-      DxvkMemoryStats::Category category);
+      DxvkMemoryStats::Category category,
+      // NV-DXVK start: TLSF chunk sub-allocator
+      TlsfAllocator::Node   chunkNode = TlsfAllocator::kInvalidNode);
+      // NV-DXVK end
     DxvkMemory             (DxvkMemory&& other);
     DxvkMemory& operator = (DxvkMemory&& other);
     ~DxvkMemory();
@@ -252,6 +277,9 @@ namespace dxvk {
     VkDeviceSize          m_length = 0;
     void*                 m_mapPtr = nullptr;
     DxvkMemoryStats::Category m_category = DxvkMemoryStats::Category::Invalid;
+    // NV-DXVK start: TLSF chunk sub-allocator
+    TlsfAllocator::Node   m_chunkNode = TlsfAllocator::kInvalidNode;
+    // NV-DXVK end
     
     void free();
     
@@ -311,18 +339,25 @@ namespace dxvk {
             DxvkMemoryFlags       hints,
             DxvkMemoryStats::Category category);
     
+    // NV-DXVK start: TLSF chunk sub-allocator
     /**
      * \brief Frees memory
      * 
      * Returns a slice back to the chunk.
      * Called automatically when a memory
      * slice runs out of scope.
-     * \param [in] offset Slice offset
-     * \param [in] length Slice length
+     * \param [in] node Sub-allocator node of the slice
      */
     void free(
-            VkDeviceSize  offset,
-            VkDeviceSize  length);
+            TlsfAllocator::Node node);
+
+    /**
+     * \brief Size of the largest free block
+     */
+    VkDeviceSize largestFreeBlock() const {
+      return m_allocator.largestFreeBlock();
+    }
+    // NV-DXVK end
 
     /**
      * \brief Checks whether the chunk is being used
@@ -338,17 +373,18 @@ namespace dxvk {
 
   private:
     
-    struct FreeSlice {
-      VkDeviceSize offset;
-      VkDeviceSize length;
-    };
-    
     DxvkMemoryAllocator*  m_alloc;
     DxvkMemoryType*       m_type;
     DxvkDeviceMemory      m_memory;
     DxvkMemoryFlags       m_hints;
     
-    std::vector<FreeSlice> m_freeList;
+    // NV-DXVK start: TLSF chunk sub-allocator
+    // O(1) alloc and free no matter how many slices are live, the previous
+    // worst-fit scan over a free list degraded with fragmentation
+    TlsfAllocator         m_allocator;
+
+    void trackFreeSpace(uint64_t freeBytesBefore, uint32_t freeBlocksBefore);
+    // NV-DXVK end
 
     bool checkHints(DxvkMemoryFlags hints) const;
     
@@ -413,6 +449,18 @@ namespace dxvk {
       return m_memHeaps[heap].stats;
     }
 
+    // NV-DXVK start: chunk fragmentation stats
+    /**
+     * \brief Refreshes the largest free chunk block
+     *
+     * Locks every memory type of the heap and visits each of
+     * its chunks, so this is meant for diagnostics only.
+     * \param [in] heap Heap index
+     * \returns Size of the largest free block in any chunk
+     */
+    VkDeviceSize refreshLargestChunkFreeBlock(uint32_t heap);
+    // NV-DXVK end
+
     // NV-DXVK start
     /**
      * \brief Queries memory properties
@@ -480,11 +528,12 @@ namespace dxvk {
     void free(
       const DxvkMemory&           memory);
     
+    // NV-DXVK start: TLSF chunk sub-allocator
     void freeChunkMemory(
             DxvkMemoryType*       type,
             DxvkMemoryChunk*      chunk,
-            VkDeviceSize          offset,
-            VkDeviceSize          length);
+            TlsfAllocator::Node   node);
+    // NV-DXVK end
     
     void freeDeviceMemory(
             DxvkMemoryType*       type,
@@ -128,6 +128,10 @@ namespace dxvk {
     DxvkPipelineCount result;
     result.numComputePipelines  = m_numComputePipelines.load();
     result.numGraphicsPipelines = m_numGraphicsPipelines.load();
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    result.numCachedPipelines         = m_stateCache != nullptr ? m_stateCache->getEntryCount() : 0;
+    result.numCachedPipelinesCompiled = m_stateCache != nullptr ? m_stateCache->getCompiledEntryCount() : 0;
+    // NV-DXVK end
     return result;
   }
 
@@ -40,6 +40,10 @@ namespace dxvk {
   struct DxvkPipelineCount {
     uint32_t numGraphicsPipelines;
     uint32_t numComputePipelines;
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    uint32_t numCachedPipelines;          ///< Pipelines read from the state cache
+    uint32_t numCachedPipelinesCompiled;  ///< Cached pipelines compiled ahead of time so far
+    // NV-DXVK end
   };
   
   
@@ -228,7 +228,28 @@ namespace dxvk {
     const DxvkShaderConstData& shaderConstants() const {
       return m_constData;
     }
-    
+
+    // NV-DXVK start: persistent DXSO shader cache
+    /**
+     * \brief Resource slots used by the shader
+     * \returns Resource slot infos
+     */
+    const std::vector<DxvkResourceSlot>& getResourceSlots() const {
+      return m_slots;
+    }
+
+    /**
+     * \brief Uncompressed SPIR-V code
+     *
+     * The code as passed to the constructor,
+     * without any binding remapping applied.
+     * \returns SPIR-V code
+     */
+    SpirvCodeBuffer getCode() const {
+      return m_code.decompress();
+    }
+    // NV-DXVK end
+
     /**
      * \brief Dumps SPIR-V shader
      * 
@@ -23,6 +23,10 @@
 #include "dxvk_pipemanager.h"
 #include "dxvk_state_cache.h"
 
+// NV-DXVK start: frequency ordered pipeline warm-up
+#include "../util/util_mapped_file.h"
+// NV-DXVK end
+
 namespace dxvk {
 
   static const Sha1Hash       g_nullHash      = Sha1Hash::compute(nullptr, 0);
@@ -37,6 +41,25 @@ namespace dxvk {
     uint32_t entrySize : 24;
   };
 
+  // NV-DXVK start: frequency ordered pipeline warm-up
+  /**
+   * \brief Usage record
+   *
+   * Stored like an entry with an empty stage mask. Adds
+   * to the usage of the entry with the given check sum.
+   */
+  struct DxvkStateCacheUsageRecord {
+    Sha1Hash            entryHash;
+    DxvkStateCacheUsage usage;
+  };
+
+  struct DxvkStateCacheHashFn {
+    size_t operator () (const Sha1Hash& hash) const {
+      return hash.dword(0);
+    }
+  };
+  // NV-DXVK end
+
   
   /**
    * \brief State cache entry data
@@ -115,6 +138,19 @@ namespace dxvk {
       return true;
     }
 
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    bool readFromMemory(const char* data, size_t size) {
+      if (size > MaxSize)
+        return false;
+
+      std::memcpy(m_data, data, size);
+
+      m_size = size;
+      m_read = 0;
+      return true;
+    }
+    // NV-DXVK end
+
   private:
 
     size_t m_size = 0;
@@ -174,7 +210,8 @@ namespace dxvk {
     const DxvkDevice*           device,
           DxvkPipelineManager*  pipeManager,
           DxvkRenderPassPool*   passManager)
-  : m_pipeManager(pipeManager),
+  : m_device(device),
+    m_pipeManager(pipeManager),
     m_passManager(passManager) {
     bool newFile = !readCacheFile();
 
@@ -202,8 +239,15 @@ namespace dxvk {
 
       // Write all valid entries to the cache file in
       // case we're recovering a corrupted cache file
-      for (auto& e : m_entries)
-        writeCacheEntry(file, e);
+      // NV-DXVK start: frequency ordered pipeline warm-up
+      for (size_t i = 0; i < m_entries.size(); i++) {
+        writeCacheEntry(file, m_entries[i]);
+
+        // Accumulated usage replaces the per-session records
+        if (m_entryUsage[i].useCount)
+          writeUsageRecord(file, m_entries[i].hash, m_entryUsage[i]);
+      }
+      // NV-DXVK end
     }
 
     // Use half the available CPU cores for pipeline compilation
@@ -248,16 +292,28 @@ namespace dxvk {
     for (auto e = entries.first; e != entries.second; e++) {
       const DxvkStateCacheEntry& entry = m_entries[e->second];
 
-      if (entry.format.eq(format) && entry.gpState == state)
+      if (entry.format.eq(format) && entry.gpState == state) {
+        // NV-DXVK start: frequency ordered pipeline warm-up
+        // Needed before the cache got to compile it
+        markPipelineUsed(e->second);
+        // NV-DXVK end
         return;
+      }
     }
 
     // Queue a job to write this pipeline to the cache
     std::unique_lock<dxvk::mutex> lock(m_writerLock);
 
-    m_writerQueue.push({ shaders, state,
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    WriterItem item;
+    item.entry = { shaders, state,
       DxvkComputePipelineStateInfo(),
-      format, g_nullHash });
+      format, g_nullHash };
+    item.hasUse = m_usedKeys.insert(shaders).second;
+    item.frameId = m_device->getCurrentFrameId();
+
+    m_writerQueue.push(item);
+    // NV-DXVK end
     m_writerCond.notify_one();
   }
 
@@ -272,20 +328,64 @@ namespace dxvk {
     auto entries = m_entryMap.equal_range(shaders);
 
     for (auto e = entries.first; e != entries.second; e++) {
-      if (m_entries[e->second].cpState == state)
+      if (m_entries[e->second].cpState == state) {
+        // NV-DXVK start: frequency ordered pipeline warm-up
+        markPipelineUsed(e->second);
+        // NV-DXVK end
         return;
+      }
     }
 
     // Queue a job to write this pipeline to the cache
     std::unique_lock<dxvk::mutex> lock(m_writerLock);
 
-    m_writerQueue.push({ shaders,
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    WriterItem item;
+    item.entry = { shaders,
       DxvkGraphicsPipelineStateInfo(), state,
-      DxvkRenderPassFormat(), g_nullHash });
+      DxvkRenderPassFormat(), g_nullHash };
+    item.hasUse = m_usedKeys.insert(shaders).second;
+    item.frameId = m_device->getCurrentFrameId();
+
+    m_writerQueue.push(item);
+    // NV-DXVK end
     m_writerCond.notify_one();
   }
 
 
+  // NV-DXVK start: frequency ordered pipeline warm-up
+  void DxvkStateCache::markGraphicsPipelineUsed(
+    const DxvkStateCacheKey&              shaders,
+    const DxvkGraphicsPipelineStateInfo&  state,
+    const DxvkRenderPassFormat&           format) {
+    auto entries = m_entryMap.equal_range(shaders);
+
+    for (auto e = entries.first; e != entries.second; e++) {
+      const DxvkStateCacheEntry& entry = m_entries[e->second];
+
+      if (entry.format.eq(format) && entry.gpState == state) {
+        markPipelineUsed(e->second);
+        return;
+      }
+    }
+  }
+
+
+  void DxvkStateCache::markComputePipelineUsed(
+    const DxvkStateCacheKey&              shaders,
+    const DxvkComputePipelineStateInfo&   state) {
+    auto entries = m_entryMap.equal_range(shaders);
+
+    for (auto e = entries.first; e != entries.second; e++) {
+      if (m_entries[e->second].cpState == state) {
+        markPipelineUsed(e->second);
+        return;
+      }
+    }
+  }
+  // NV-DXVK end
+
+
   void DxvkStateCache::registerShader(const Rc<DxvkShader>& shader) {
     DxvkShaderKey key = shader->getShaderKey();
 
@@ -318,11 +418,16 @@ namespace dxvk {
        || !getShaderByKey(p->second.cs,  item.cp.cs))
         continue;
       
+      // NV-DXVK start: frequency ordered pipeline warm-up
+      item.usage = getPipelineUsage(p->second);
+      // NV-DXVK end
+
       if (!workerLock)
         workerLock = std::unique_lock<dxvk::mutex>(m_workerLock);
       
       // NV-DXVK start: do not compile same shader multiple times
       if (m_workerItemsInFlight.count(item.hash()) == 0) {
+        item.seq = m_workerSeq++;
         m_workerQueue.push(item);
         m_workerItemsInFlight.insert(item.hash());
       }
@@ -346,6 +451,7 @@ namespace dxvk {
 
     // Do not compile same shader multiple times
     if (m_workerItemsInFlight.count(item.hash()) == 0) {
+      item.seq = m_workerSeq++;
       m_workerQueue.push(item);
       m_workerItemsInFlight.insert(item.hash());
 
@@ -407,6 +513,41 @@ namespace dxvk {
   }
 
 
+  // NV-DXVK start: frequency ordered pipeline warm-up
+  void DxvkStateCache::markPipelineUsed(
+          size_t                    entryId) {
+    std::unique_lock<dxvk::mutex> lock(m_writerLock);
+
+    // Usage is ranked per key, so only the first
+    // variant of a key used this session counts
+    if (!m_usedKeys.insert(m_entries[entryId].shaders).second)
+      return;
+
+    WriterItem item;
+    item.entry.hash = m_entries[entryId].hash;
+    item.frameId = m_device->getCurrentFrameId();
+    item.isUse = true;
+    item.hasUse = true;
+
+    m_writerQueue.push(item);
+    m_writerCond.notify_one();
+  }
+
+
+  DxvkStateCacheUsage DxvkStateCache::getPipelineUsage(
+    const DxvkStateCacheKey&        key) const {
+    DxvkStateCacheUsage usage;
+
+    auto entries = m_entryMap.equal_range(key);
+
+    for (auto e = entries.first; e != entries.second; e++)
+      usage.merge(m_entryUsage[e->second]);
+
+    return usage;
+  }
+  // NV-DXVK end
+
+
   void DxvkStateCache::compilePipelines(const WorkerItem& item) {
     DxvkStateCacheKey key;
     key.vs  = getShaderKey(item.gp.vs);
@@ -431,6 +572,9 @@ namespace dxvk {
 
         auto rp = m_passManager->getRenderPass(entry.format);
         pipeline->compilePipeline(entry.gpState, rp);
+        // NV-DXVK start: frequency ordered pipeline warm-up
+        m_entriesCompiled += 1;
+        // NV-DXVK end
       }
     } else {
       auto pipeline = m_pipeManager->createComputePipeline(item.cp);
@@ -439,6 +583,9 @@ namespace dxvk {
       for (auto e = entries.first; e != entries.second; e++) {
         const auto& entry = m_entries[e->second];
         pipeline->compilePipeline(entry.cpState);
+        // NV-DXVK start: frequency ordered pipeline warm-up
+        m_entriesCompiled += 1;
+        // NV-DXVK end
       }
     }
   }
@@ -495,30 +642,93 @@ namespace dxvk {
     // regenerate the entire state cache file.
     uint32_t numInvalidEntries = 0;
 
-    while (ifile) {
-      DxvkStateCacheEntry entry;
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    uint32_t numUsageRecords = 0;
+
+    if (curHeader.version < 8) {
+      while (ifile) {
+        DxvkStateCacheEntry entry;
+
+        if (readCacheEntry(curHeader.version, ifile, entry)) {
+          m_entries.push_back(entry);
+          m_entryUsage.emplace_back();
+        } else if (ifile) {
+          numInvalidEntries += 1;
+        }
+      }
+    } else {
+      // Packed entries are parsed straight from a mapping of the file,
+      // and validated in parallel since hashing them is the slow part
+      ifile.close();
+
+      MappedFile mappedFile;
+      std::vector<char> fileData;
 
-      if (readCacheEntry(curHeader.version, ifile, entry)) {
-        size_t entryId = m_entries.size();
-        m_entries.push_back(entry);
+      const char* data;
+      size_t size;
 
-        mapPipelineToEntry(entry.shaders, entryId);
+      if (mappedFile.open(str::fromws(getCacheFileName().c_str()))) {
+        data = reinterpret_cast<const char*>(mappedFile.data());
+        size = mappedFile.size();
+      } else {
+        std::ifstream file(getCacheFileName().c_str(), std::ios_base::binary | std::ios_base::ate);
+        fileData.resize(size_t(file.tellg()));
+        file.seekg(0);
+
+        if (!file.read(fileData.data(), fileData.size())) {
+          Logger::warn("DXVK: Failed to read state cache file");
+          return false;
+        }
 
-        mapShaderToPipeline(entry.shaders.vs,  entry.shaders);
-        mapShaderToPipeline(entry.shaders.tcs, entry.shaders);
-        mapShaderToPipeline(entry.shaders.tes, entry.shaders);
-        mapShaderToPipeline(entry.shaders.gs,  entry.shaders);
-        mapShaderToPipeline(entry.shaders.fs,  entry.shaders);
-        mapShaderToPipeline(entry.shaders.cs,  entry.shaders);
-      } else if (ifile) {
-        numInvalidEntries += 1;
+        data = fileData.data();
+        size = fileData.size();
       }
+
+      const uint32_t numThreads = std::min(std::max(dxvk::thread::hardware_concurrency(), 1u), 16u);
+
+      const auto t0 = dxvk::high_resolution_clock::now();
+
+      DxvkStateCacheContents contents;
+      parseCacheEntries(curHeader.version, data + sizeof(curHeader), size - sizeof(curHeader), numThreads, contents);
+
+      const auto t1 = dxvk::high_resolution_clock::now();
+
+      m_entries = std::move(contents.entries);
+      m_entryUsage = std::move(contents.usage);
+      numInvalidEntries = contents.numInvalidEntries;
+      numUsageRecords = contents.numUsageRecords;
+
+      Logger::info(str::format("DXVK: Parsed state cache in ",
+        std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count(), " ms"));
+    }
+
+    for (size_t entryId = 0; entryId < m_entries.size(); entryId++) {
+      const DxvkStateCacheEntry& entry = m_entries[entryId];
+
+      mapPipelineToEntry(entry.shaders, entryId);
+
+      mapShaderToPipeline(entry.shaders.vs,  entry.shaders);
+      mapShaderToPipeline(entry.shaders.tcs, entry.shaders);
+      mapShaderToPipeline(entry.shaders.tes, entry.shaders);
+      mapShaderToPipeline(entry.shaders.gs,  entry.shaders);
+      mapShaderToPipeline(entry.shaders.fs,  entry.shaders);
+      mapShaderToPipeline(entry.shaders.cs,  entry.shaders);
     }
 
     Logger::info(str::format(
       "DXVK: Read ", m_entries.size(),
       " valid state cache entries"));
 
+    // Every session appends a record per pipeline it used, fold
+    // them into one record per entry once they start to pile up
+    if (numUsageRecords > 4 * m_entries.size() + 1024) {
+      Logger::info(str::format(
+        "DXVK: Compacting ", numUsageRecords,
+        " state cache usage records"));
+      return false;
+    }
+    // NV-DXVK end
+
     if (numInvalidEntries) {
       Logger::warn(str::format(
         "DXVK: Skipped ", numInvalidEntries,
@@ -610,8 +820,19 @@ namespace dxvk {
     if (hash != data.computeHash())
       return false;
 
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    entry.hash = hash;
+    return decodeCacheEntry(version, VkShaderStageFlags(header.stageMask), data, entry);
+  }
+
+
+  bool DxvkStateCache::decodeCacheEntry(
+          uint32_t                  version,
+          VkShaderStageFlags        stageMask,
+          DxvkStateCacheEntryData&  data,
+          DxvkStateCacheEntry&      entry) {
+    // NV-DXVK end
     // Read shader hashes
-    VkShaderStageFlags stageMask = VkShaderStageFlags(header.stageMask);
     auto keys = &entry.shaders.vs;
 
     for (uint32_t i = 0; i < 6; i++) {
@@ -715,7 +936,7 @@ namespace dxvk {
 
   void DxvkStateCache::writeCacheEntry(
           std::ostream&             stream, 
-          DxvkStateCacheEntry&      entry) const {
+          DxvkStateCacheEntry&      entry) {
     DxvkStateCacheEntryData data;
     VkShaderStageFlags stageMask = 0;
 
@@ -797,9 +1018,159 @@ namespace dxvk {
     stream.write(reinterpret_cast<char*>(&hash), sizeof(hash));
     stream.write(data.data(), data.size());
     stream.flush();
+
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    entry.hash = hash;
+    // NV-DXVK end
+  }
+
+
+  // NV-DXVK start: frequency ordered pipeline warm-up
+  void DxvkStateCache::writeUsageRecord(
+          std::ostream&             stream,
+    const Sha1Hash&                 entryHash,
+    const DxvkStateCacheUsage&      usage) {
+    DxvkStateCacheEntryData data;
+    data.write(DxvkStateCacheUsageRecord { entryHash, usage });
+
+    DxvkStateCacheEntryHeader header;
+    header.stageMask = 0;
+    header.entrySize = data.size();
+
+    Sha1Hash hash = data.computeHash();
+
+    stream.write(reinterpret_cast<char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<char*>(&hash), sizeof(hash));
+    stream.write(data.data(), data.size());
+    stream.flush();
   }
 
 
+  void DxvkStateCache::parseCacheEntries(
+          uint32_t                  version,
+    const char*                     data,
+          size_t                    size,
+          uint32_t                  numThreads,
+          DxvkStateCacheContents&   contents) {
+    constexpr size_t RecordHeaderSize = sizeof(DxvkStateCacheEntryHeader) + sizeof(Sha1Hash);
+
+    enum class RecordType : uint8_t {
+      Invalid,
+      Entry,
+      Usage,
+    };
+
+    struct Record {
+      const char*               data;
+      DxvkStateCacheEntryHeader header;
+      RecordType                type;
+    };
+
+    // Records are variable in size, so finding them is sequential.
+    // This only touches the headers. A truncated record at the
+    // end is dropped like a failed read from a stream would.
+    std::vector<Record> records;
+    size_t offset = 0;
+
+    while (offset + RecordHeaderSize <= size) {
+      Record record;
+      std::memcpy(&record.header, data + offset, sizeof(record.header));
+      record.data = data + offset + sizeof(record.header);
+      record.type = RecordType::Invalid;
+
+      offset += RecordHeaderSize + record.header.entrySize;
+
+      if (offset > size)
+        break;
+
+      records.push_back(record);
+    }
+
+    std::vector<DxvkStateCacheEntry>       entries(records.size());
+    std::vector<DxvkStateCacheUsageRecord> usage(records.size());
+
+    auto validateRecords = [&] (size_t first, size_t last) {
+      DxvkStateCacheEntryData entryData;
+
+      for (size_t i = first; i < last; i++) {
+        Record& record = records[i];
+
+        Sha1Hash hash;
+        std::memcpy(&hash, record.data, sizeof(hash));
+
+        if (!entryData.readFromMemory(record.data + sizeof(hash), record.header.entrySize)
+         || hash != entryData.computeHash())
+          continue;
+
+        if (record.header.stageMask == 0 && version >= 12) {
+          if (entryData.size() == sizeof(DxvkStateCacheUsageRecord)
+           && entryData.read(usage[i], version))
+            record.type = RecordType::Usage;
+        } else {
+          entries[i].hash = hash;
+
+          if (decodeCacheEntry(version, VkShaderStageFlags(record.header.stageMask), entryData, entries[i]))
+            record.type = RecordType::Entry;
+        }
+      }
+    };
+
+    // Not worth spinning up threads for small caches
+    constexpr size_t MinRecordsPerThread = 1024;
+
+    const size_t threadCount = std::max<size_t>(1,
+      std::min<size_t>(numThreads, records.size() / MinRecordsPerThread));
+    const size_t recordsPerThread = (records.size() + threadCount - 1) / threadCount;
+
+    std::vector<dxvk::thread> threads;
+
+    for (size_t t = 1; t < threadCount; t++) {
+      const size_t first = t * recordsPerThread;
+      const size_t last = std::min(first + recordsPerThread, records.size());
+
+      threads.emplace_back([&validateRecords, first, last] () {
+        validateRecords(first, last);
+      });
+    }
+
+    validateRecords(0, std::min(recordsPerThread, records.size()));
+
+    for (auto& thread : threads)
+      thread.join();
+
+    // Gather valid entries in file order. Usage records always
+    // follow the entry they refer to, which makes this one pass.
+    std::unordered_map<Sha1Hash, size_t, DxvkStateCacheHashFn> entryIds;
+
+    contents.entries.reserve(records.size());
+    contents.usage.reserve(records.size());
+
+    for (size_t i = 0; i < records.size(); i++) {
+      switch (records[i].type) {
+        case RecordType::Entry: {
+          entryIds.insert({ entries[i].hash, contents.entries.size() });
+          contents.entries.push_back(std::move(entries[i]));
+          contents.usage.emplace_back();
+        } break;
+
+        case RecordType::Usage: {
+          auto entry = entryIds.find(usage[i].entryHash);
+
+          if (entry != entryIds.end())
+            contents.usage[entry->second].merge(usage[i].usage);
+
+          contents.numUsageRecords += 1;
+        } break;
+
+        case RecordType::Invalid:
+          contents.numInvalidEntries += 1;
+          break;
+      }
+    }
+  }
+  // NV-DXVK end
+
+
   bool DxvkStateCache::convertEntryV2(
           DxvkStateCacheEntryV4&    entry) const {
     // Semantics changed:
@@ -1001,7 +1372,9 @@ namespace dxvk {
         if (m_workerQueue.empty())
           break;
         
-        item = m_workerQueue.front();
+        // NV-DXVK start: frequency ordered pipeline warm-up
+        item = m_workerQueue.top();
+        // NV-DXVK end
         m_workerQueue.pop();
       }
 
@@ -1023,7 +1396,9 @@ namespace dxvk {
     std::ofstream file;
 
     while (!m_stopThreads.load()) {
-      DxvkStateCacheEntry entry;
+      // NV-DXVK start: frequency ordered pipeline warm-up
+      WriterItem item;
+      // NV-DXVK end
 
       { std::unique_lock<dxvk::mutex> lock(m_writerLock);
 
@@ -1035,7 +1410,7 @@ namespace dxvk {
         if (m_writerQueue.size() == 0)
           break;
 
-        entry = m_writerQueue.front();
+        item = m_writerQueue.front();
         m_writerQueue.pop();
       }
 
@@ -1045,7 +1420,13 @@ namespace dxvk {
           std::ios_base::app);
       }
 
-      writeCacheEntry(file, entry);
+      // NV-DXVK start: frequency ordered pipeline warm-up
+      if (!item.isUse)
+        writeCacheEntry(file, item.entry);
+
+      if (item.hasUse)
+        writeUsageRecord(file, item.entry.hash, DxvkStateCacheUsage { 1u, item.frameId });
+      // NV-DXVK end
     }
   }
 
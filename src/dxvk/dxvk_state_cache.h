@@ -37,6 +37,19 @@
 namespace dxvk {
 
   class DxvkDevice;
+  // NV-DXVK start: frequency ordered pipeline warm-up
+  class DxvkStateCacheEntryData;
+
+  /**
+   * \brief Parsed state cache entries
+   */
+  struct DxvkStateCacheContents {
+    std::vector<DxvkStateCacheEntry>  entries;
+    std::vector<DxvkStateCacheUsage>  usage;              ///< Usage of each entry
+    uint32_t                          numInvalidEntries = 0;
+    uint32_t                          numUsageRecords   = 0;
+  };
+  // NV-DXVK end
 
   /**
    * \brief State cache
@@ -121,9 +134,99 @@ namespace dxvk {
       return m_workerBusy.load() > 0;
     }
 
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    /**
+     * \brief Records that a cached graphics pipeline was used
+     *
+     * Called the first time a draw needs a pipeline
+     * that was compiled ahead of time from the cache.
+     * Usage is counted once per shader key and session.
+     * \param [in] shaders Shader keys
+     * \param [in] state Graphics pipeline state
+     * \param [in] format Render pass format
+     */
+    void markGraphicsPipelineUsed(
+      const DxvkStateCacheKey&              shaders,
+      const DxvkGraphicsPipelineStateInfo&  state,
+      const DxvkRenderPassFormat&           format);
+
+    /**
+     * \brief Records that a cached compute pipeline was used
+     *
+     * \param [in] shaders Shader keys
+     * \param [in] state Compute pipeline state
+     */
+    void markComputePipelineUsed(
+      const DxvkStateCacheKey&              shaders,
+      const DxvkComputePipelineStateInfo&   state);
+
+    /**
+     * \brief Number of pipelines read from the cache file
+     */
+    uint32_t getEntryCount() const {
+      return uint32_t(m_entries.size());
+    }
+
+    /**
+     * \brief Number of cached pipelines compiled so far
+     */
+    uint32_t getCompiledEntryCount() const {
+      return m_entriesCompiled.load();
+    }
+
+    /**
+     * \brief Parses packed state cache entries
+     *
+     * Splits the data into records, then validates and decodes
+     * them on up to \c numThreads threads. Usage records are
+     * merged into the usage of the entry they refer to.
+     * \param [in] version State cache version, at least 8
+     * \param [in] data Records following the file header
+     * \param [in] size Size of the records in bytes
+     * \param [in] numThreads Maximum number of threads
+     * \param [out] contents Valid entries and their usage
+     */
+    static void parseCacheEntries(
+            uint32_t                  version,
+      const char*                     data,
+            size_t                    size,
+            uint32_t                  numThreads,
+            DxvkStateCacheContents&   contents);
+
+    /**
+     * \brief Writes a packed entry
+     *
+     * Also stores the check sum of the entry in \c entry.hash.
+     * \param [in] stream Output stream
+     * \param [in] entry Entry to write
+     */
+    static void writeCacheEntry(
+            std::ostream&             stream,
+            DxvkStateCacheEntry&      entry);
+
+    /**
+     * \brief Writes a usage record
+     *
+     * \param [in] stream Output stream
+     * \param [in] entryHash Check sum of the entry
+     * \param [in] usage Usage to add to the entry
+     */
+    static void writeUsageRecord(
+            std::ostream&             stream,
+      const Sha1Hash&                 entryHash,
+      const DxvkStateCacheUsage&      usage);
+    // NV-DXVK end
+
   private:
 
-    using WriterItem = DxvkStateCacheEntry;
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    struct WriterItem {
+      DxvkStateCacheEntry entry;
+      uint32_t            frameId = 0;
+      bool                isUse   = false;  ///< Only records the use of a cached entry
+      bool                hasUse  = false;  ///< Writes a usage record for the entry
+    };
+    // NV-DXVK end
 
     struct WorkerItem {
       DxvkGraphicsPipelineShaders gp;
@@ -133,6 +236,11 @@ namespace dxvk {
       DxvkRaytracingPipelineShaders rt;
       // NV-DXVK end
 
+      // NV-DXVK start: frequency ordered pipeline warm-up
+      DxvkStateCacheUsage usage;
+      uint64_t            seq = 0;
+      // NV-DXVK end
+
       // NV-DXVK start: do not compile same shader multiple times
       size_t hash() const {
         // raytracing shader group hash is NOT guaranteed to be zero
@@ -145,10 +253,43 @@ namespace dxvk {
       // NV-DXVK end
     };
 
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    /**
+     * \brief Orders worker items by urgency
+     *
+     * Raytracing pipelines go first since rendering waits for them.
+     * Cached pipelines follow by the number of sessions that used
+     * them, then by how early they were first needed.
+     */
+    struct WorkerItemOrder {
+      bool operator () (const WorkerItem& a, const WorkerItem& b) const {
+        const bool aIsRt = !a.rt.groups.empty();
+        const bool bIsRt = !b.rt.groups.empty();
+
+        if (aIsRt != bIsRt)
+          return bIsRt;
+
+        if (a.usage.useCount != b.usage.useCount)
+          return a.usage.useCount < b.usage.useCount;
+
+        if (a.usage.firstUseFrame != b.usage.firstUseFrame)
+          return a.usage.firstUseFrame > b.usage.firstUseFrame;
+
+        return a.seq > b.seq;
+      }
+    };
+
+    const DxvkDevice*                 m_device;
+    // NV-DXVK end
+
     DxvkPipelineManager*              m_pipeManager;
     DxvkRenderPassPool*               m_passManager;
 
     std::vector<DxvkStateCacheEntry>  m_entries;
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    std::vector<DxvkStateCacheUsage>  m_entryUsage;
+    std::atomic<uint32_t>             m_entriesCompiled = { 0u };
+    // NV-DXVK end
     std::atomic<bool>                 m_stopThreads = { false };
 
     dxvk::mutex                       m_entryLock;
@@ -167,7 +308,12 @@ namespace dxvk {
 
     dxvk::mutex                       m_workerLock;
     dxvk::condition_variable          m_workerCond;
-    std::queue<WorkerItem>            m_workerQueue;
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    std::priority_queue<
+      WorkerItem, std::vector<WorkerItem>,
+      WorkerItemOrder>                m_workerQueue;
+    uint64_t                          m_workerSeq = 0;
+    // NV-DXVK end
     // NV-DXVK start: do not compile same shader multiple times
     std::unordered_set<size_t>        m_workerItemsInFlight;  // stores hashes for work items in the queue
     // NV-DXVK end
@@ -177,6 +323,11 @@ namespace dxvk {
     dxvk::mutex                       m_writerLock;
     dxvk::condition_variable          m_writerCond;
     std::queue<WriterItem>            m_writerQueue;
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    std::unordered_set<
+      DxvkStateCacheKey,
+      DxvkHash, DxvkEq>               m_usedKeys;  ///< Keys with a usage record this session
+    // NV-DXVK end
     dxvk::thread                      m_writerThread;
 
     DxvkShaderKey getShaderKey(
@@ -212,10 +363,20 @@ namespace dxvk {
             uint32_t                  version,
             std::istream&             stream, 
             DxvkStateCacheEntry&      entry) const;
-    
-    void writeCacheEntry(
-            std::ostream&             stream, 
-            DxvkStateCacheEntry&      entry) const;
+
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    static bool decodeCacheEntry(
+            uint32_t                  version,
+            VkShaderStageFlags        stageMask,
+            DxvkStateCacheEntryData&  data,
+            DxvkStateCacheEntry&      entry);
+
+    void markPipelineUsed(
+            size_t                    entryId);
+
+    DxvkStateCacheUsage getPipelineUsage(
+      const DxvkStateCacheKey&        key) const;
+    // NV-DXVK end
     
     bool convertEntryV2(
             DxvkStateCacheEntryV4&    entry) const;
@@ -43,6 +43,26 @@ namespace dxvk {
   };
 
 
+  // NV-DXVK start: frequency ordered pipeline warm-up
+  /**
+   * \brief State entry usage
+   *
+   * Accumulated over all sessions that used the pipeline.
+   * Stored in usage records next to the entries, which
+   * reference the entry by its check sum.
+   */
+  struct DxvkStateCacheUsage {
+    uint32_t useCount      = 0;    ///< Number of sessions that used the pipeline
+    uint32_t firstUseFrame = ~0u;  ///< Earliest frame the pipeline was first needed in
+
+    void merge(const DxvkStateCacheUsage& other) {
+      useCount     += other.useCount;
+      firstUseFrame = std::min(firstUseFrame, other.firstUseFrame);
+    }
+  };
+  // NV-DXVK end
+
+
   /**
    * \brief State cache header
    * 
@@ -52,7 +72,9 @@ namespace dxvk {
    */
   struct DxvkStateCacheHeader {
     char     magic[4]   = { 'D', 'X', 'V', 'K' };
-    uint32_t version    = 11;
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    uint32_t version    = 12;
+    // NV-DXVK end
     uint32_t entrySize  = 0; /* no longer meaningful */
   };
 
@@ -18,6 +18,10 @@ namespace dxvk {
     PipeCountGraphics,        ///< Number of graphics pipelines
     PipeCountCompute,         ///< Number of compute pipelines
     PipeCompilerBusy,         ///< Boolean indicating compiler activity
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    PipeCacheEntries,         ///< Number of pipelines in the state cache
+    PipeCacheCompiled,        ///< Number of cached pipelines compiled ahead of time
+    // NV-DXVK end
     QueueSubmitCount,         ///< Number of command buffer submissions
     QueuePresentCount,        ///< Number of present calls / frames
     GpuSyncCount,             ///< Number of GPU synchronizations
@@ -26,6 +30,11 @@ namespace dxvk {
     CsSyncCount,              ///< CS thread synchronizations
     CsSyncTicks,              ///< Time spent waiting on CS
     CsChunkCount,             ///< Submitted CS chunks
+    // NV-DXVK start: lock-free CS chunk submission
+    CsQueueDepth,             ///< Sum of CS queue depths seen per executed chunk
+    CsStallCount,             ///< Submissions that waited for a full CS queue
+    CsStallTicks,             ///< Time spent waiting for a full CS queue
+    // NV-DXVK end
 
     // NV-DXVK begin: RTX Remix counters
     CmdTraceRaysCalls,                 ///< Number of traceRays calls
@@ -40,6 +49,14 @@ namespace dxvk {
     RtxSamplers,                       ///< Number of samplers currently present in the scene
     RtxTexturesInFlight,               ///< Number of texture currently being loaded
     RtxLastTextureBatchDuration,       ///< Duration in ms of the last processed texture batch
+    RtxTextureBytesInFlight,           ///< Estimated bytes of texture uploads queued or being loaded
+    RtxTextureLatencyP50,              ///< Median time in ms from queueing a texture upload to its completion
+    RtxTextureLatencyP95,              ///< 95th percentile time in ms from queueing a texture upload to its completion
+    RtxGeometryHashCacheHits,          ///< Number of draw calls in the last frame that reused cached geometry hashes
+    RtxGeometryHashCacheMisses,        ///< Number of cacheable draw calls in the last frame that had to be rehashed
+    RtxUserPointerBytes,               ///< Bytes of DrawPrimitiveUP data copied in the last frame
+    RtxGeometryCopyBytes,              ///< Bytes of vertex and index data copied for raytracing in the last frame
+    RtxSurfaceUploadBytes,             ///< Bytes of surface, surface mapping and primitive ID prefix sum data uploaded in the last frame
     // NV-DXVK end
 
     NumCounters,              ///< Number of counters available
@@ -526,6 +526,10 @@ namespace dxvk::hud {
 
     m_graphicsPipelines = counters.getCtr(DxvkStatCounter::PipeCountGraphics);
     m_computePipelines  = counters.getCtr(DxvkStatCounter::PipeCountCompute);
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    m_cachedPipelines         = counters.getCtr(DxvkStatCounter::PipeCacheEntries);
+    m_cachedPipelinesCompiled = counters.getCtr(DxvkStatCounter::PipeCacheCompiled);
+    // NV-DXVK end
   }
 
 
@@ -554,6 +558,21 @@ namespace dxvk::hud {
       { 1.0f, 1.0f, 1.0f, 1.0f },
       str::format(m_computePipelines));
 
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    if (m_cachedPipelines) {
+      position.y += 20.0f;
+      renderer.drawText(16.0f,
+        { position.x, position.y },
+        { 1.0f, 0.25f, 1.0f, 1.0f },
+        "State cache:");
+
+      renderer.drawText(16.0f,
+        { position.x + 240.0f, position.y },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        str::format(m_cachedPipelinesCompiled, " / ", m_cachedPipelines));
+    }
+    // NV-DXVK end
+
     position.y += 8.0f;
     return position;
   }
@@ -571,8 +590,12 @@ namespace dxvk::hud {
 
 
   void HudMemoryStatsItem::update(dxvk::high_resolution_clock::time_point time) {
-    for (uint32_t i = 0; i < m_memory.memoryHeapCount; i++)
+    for (uint32_t i = 0; i < m_memory.memoryHeapCount; i++) {
+      // NV-DXVK start: chunk fragmentation stats
+      m_device->refreshLargestChunkFreeBlock(i);
+      // NV-DXVK end
       m_heaps[i] = m_device->getMemoryStats(i);
+    }
   }
 
 
@@ -602,6 +625,19 @@ namespace dxvk::hud {
         text);
       position.y += 4.0f;
 
+      // NV-DXVK start: chunk fragmentation stats
+      if (m_heaps[i].chunkFreeMemory() != 0) {
+        std::string chunkText = str::format(std::setfill(' '), std::setw(5), m_heaps[i].chunkFreeMemory() >> 20, " MB free in ",
+          m_heaps[i].chunkFreeBlocks(), " blocks, largest ", m_heaps[i].largestChunkFreeBlock() >> 20, " MB");
+        position.y += 16.0f;
+        renderer.drawText(16.0f,
+                          { position.x + 16.0f, position.y },
+                          { 1.0f, 1.0f, 1.0f, 1.0f },
+                          chunkText);
+        position.y += 4.0f;
+      }
+      // NV-DXVK end
+
       if (isDeviceLocal) {
         for (uint32_t cat = DxvkMemoryStats::Category::First; cat <= DxvkMemoryStats::Category::Last; cat++) {
           VkDeviceSize memSizeMib = m_heaps[i].usedByCategory(DxvkMemoryStats::Category(cat)) >> 20;
@@ -658,8 +694,29 @@ namespace dxvk::hud {
     if (ticks >= UpdateInterval) {
       uint64_t currCsChunks = counters.getCtr(DxvkStatCounter::CsChunkCount);
       uint64_t diffCsChunks = (currCsChunks - m_prevCsChunks) / m_updateCount;
+      // NV-DXVK start: lock-free CS chunk submission
+      uint64_t totalCsChunks = currCsChunks - m_prevCsChunks;
+      // NV-DXVK end
       m_prevCsChunks = currCsChunks;
 
+      // NV-DXVK start: lock-free CS chunk submission
+      uint64_t currCsQueueDepth = counters.getCtr(DxvkStatCounter::CsQueueDepth);
+      uint64_t currCsStallCount = counters.getCtr(DxvkStatCounter::CsStallCount);
+      uint64_t currCsStallTicks = counters.getCtr(DxvkStatCounter::CsStallTicks);
+
+      // Average number of chunks queued behind each executed one, in tenths
+      uint64_t depth = totalCsChunks ? (10 * (currCsQueueDepth - m_prevCsQueueDepth)) / totalCsChunks : 0;
+      uint64_t stallTicks = (currCsStallTicks - m_prevCsStallTicks) / 100;
+
+      m_csDepthString = str::format(depth / 10, ".", depth % 10);
+      m_csStallString = str::format(currCsStallCount - m_prevCsStallCount,
+        " (", (stallTicks / 10), ".", (stallTicks % 10), " ms)");
+
+      m_prevCsQueueDepth = currCsQueueDepth;
+      m_prevCsStallCount = currCsStallCount;
+      m_prevCsStallTicks = currCsStallTicks;
+      // NV-DXVK end
+
       uint64_t syncTicks = m_maxCsSyncTicks / 100;
 
       m_csChunkString = str::format(diffCsChunks);
@@ -701,6 +758,30 @@ namespace dxvk::hud {
       { 1.0f, 1.0f, 1.0f, 1.0f },
       m_csSyncString);
 
+    // NV-DXVK start: lock-free CS chunk submission
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.25f, 1.0f, 0.25f, 1.0f },
+      "CS depth:");
+
+    renderer.drawText(16.0f,
+      { position.x + 132.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_csDepthString);
+
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.25f, 1.0f, 0.25f, 1.0f },
+      "CS stalls:");
+
+    renderer.drawText(16.0f,
+      { position.x + 132.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_csStallString);
+    // NV-DXVK end
+
     position.y += 8.0f;
     return position;
   }
@@ -824,7 +905,18 @@ namespace dxvk::hud {
                                    "# Lights:",
                                    "# Samplers:",
                                    "# Textures in-flight:",
-                                   "# Last tex. batch (ms):"}; 
+                                   "# Last tex. batch (ms):",
+                                   "# Tex. bytes in-flight (MB):",
+                                   "# Tex. latency p50 (ms):",
+                                   "# Tex. latency p95 (ms):",
+                                   "# Geom. hash cache hits:",
+                                   "# Geom. hash cache hit rate (%):",
+                                   "# UP data (KB):",
+                                   "# Geom. copies (KB):",
+                                   "# Surface uploads (KB):"}; 
+    const uint64_t hashCacheHits = counters.getCtr(DxvkStatCounter::RtxGeometryHashCacheHits);
+    const uint64_t hashCacheLookups = hashCacheHits + counters.getCtr(DxvkStatCounter::RtxGeometryHashCacheMisses);
+
     const uint64_t values[] = { counters.getCtr(DxvkStatCounter::QueuePresentCount),
                                 counters.getCtr(DxvkStatCounter::RtxBlasCount),
                                 counters.getCtr(DxvkStatCounter::RtxBufferCount),
@@ -836,7 +928,15 @@ namespace dxvk::hud {
                                 counters.getCtr(DxvkStatCounter::RtxLightCount),
                                 counters.getCtr(DxvkStatCounter::RtxSamplers),
                                 counters.getCtr(DxvkStatCounter::RtxTexturesInFlight),
-                                counters.getCtr(DxvkStatCounter::RtxLastTextureBatchDuration)};
+                                counters.getCtr(DxvkStatCounter::RtxLastTextureBatchDuration),
+                                counters.getCtr(DxvkStatCounter::RtxTextureBytesInFlight) >> 20,
+                                counters.getCtr(DxvkStatCounter::RtxTextureLatencyP50),
+                                counters.getCtr(DxvkStatCounter::RtxTextureLatencyP95),
+                                hashCacheHits,
+                                hashCacheLookups > 0 ? hashCacheHits * 100 / hashCacheLookups : 0,
+                                counters.getCtr(DxvkStatCounter::RtxUserPointerBytes) >> 10,
+                                counters.getCtr(DxvkStatCounter::RtxGeometryCopyBytes) >> 10,
+                                counters.getCtr(DxvkStatCounter::RtxSurfaceUploadBytes) >> 10};
 
     const uint32_t kNumLabels = sizeof(labels) / sizeof(labels[0]);
     static_assert(kNumLabels == sizeof(values) / sizeof(values[0]));
@@ -354,6 +354,10 @@ namespace dxvk::hud {
 
     uint64_t m_graphicsPipelines = 0;
     uint64_t m_computePipelines = 0;
+    // NV-DXVK start: frequency ordered pipeline warm-up
+    uint64_t m_cachedPipelines = 0;
+    uint64_t m_cachedPipelinesCompiled = 0;
+    // NV-DXVK end
 
   };
 
@@ -408,6 +412,11 @@ namespace dxvk::hud {
     uint64_t m_prevCsSyncCount  = 0;
     uint64_t m_prevCsSyncTicks  = 0;
     uint64_t m_prevCsChunks     = 0;
+    // NV-DXVK start: lock-free CS chunk submission
+    uint64_t m_prevCsQueueDepth = 0;
+    uint64_t m_prevCsStallCount = 0;
+    uint64_t m_prevCsStallTicks = 0;
+    // NV-DXVK end
 
     uint64_t m_maxCsSyncCount   = 0;
     uint64_t m_maxCsSyncTicks   = 0;
@@ -416,6 +425,10 @@ namespace dxvk::hud {
 
     std::string m_csSyncString;
     std::string m_csChunkString;
+    // NV-DXVK start: lock-free CS chunk submission
+    std::string m_csDepthString;
+    std::string m_csStallString;
+    // NV-DXVK end
 
     dxvk::high_resolution_clock::time_point m_lastUpdate
       = dxvk::high_resolution_clock::now();
@@ -19,6 +19,8 @@
 * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 * DEALINGS IN THE SOFTWARE.
 */
+#include <array>
+#include <cstring>
 #include <mutex>
 #include <vector>
 #include <assert.h>
@@ -61,6 +63,12 @@ namespace dxvk {
         // only allocated with a 64 byte alignment.
         // Note: This could use the value of m_scratchAlignment, but this is duplicated to avoid potential future initialization order issues.
         device->properties().khrDeviceAccelerationStructureProperties.minAccelerationStructureScratchOffsetAlignment);
+
+    // Leave most cores to the game and the other render workers, record generation is short and once per frame
+    const uint32_t numRecordWorkers = std::min(dxvk::thread::hardware_concurrency() / 4, 4u);
+    if (numRecordWorkers > 0) {
+      m_recordWorkers = std::make_unique<AccelRecordWorkers>(uint8_t(numRecordWorkers), "rtx-accel-records");
+    }
   }
 
   void AccelManager::clear() {
@@ -383,6 +391,8 @@ namespace dxvk {
     std::vector<std::unique_ptr<BlasBucket>> blasBuckets;
     blasBuckets.reserve(instances.size());
 
+    std::vector<StaticBlasInstanceSource> staticBlasInstances[Tlas::Count];
+
     for (RtInstance* instance : instances) {
       // If the instance has zero mask, do not build BLAS for it: no ray can intersect this instance.
       if (instance->getVkInstance().mask == 0) {
@@ -515,22 +525,13 @@ namespace dxvk {
       }
 
       if (blasEntry->staticBlas.ptr()) {
-        // Create an instance for this static BLAS
-        VkAccelerationStructureInstanceKHR blasInstance = instance->getVkInstance();
-        blasInstance.accelerationStructureReference = blasEntry->staticBlas->accelerationStructureReference;
-        blasInstance.instanceCustomIndex =
-          (blasInstance.instanceCustomIndex & ~uint32_t(CUSTOM_INDEX_SURFACE_MASK)) |
-          uint32_t(m_reorderedSurfaces.size()) & uint32_t(CUSTOM_INDEX_SURFACE_MASK);
-
-        // Get the instance's flags and apply the objectToWorldMirrored flag.
-        // This flag should only be applied to static BLAS.
-        if (instance->isObjectToWorldMirrored())
-          blasInstance.flags ^= VK_GEOMETRY_INSTANCE_TRIANGLE_FLIP_FACING_BIT_KHR;
+        // Queue an instance for this static BLAS, its TLAS record is written after the loop
+        const StaticBlasInstanceSource blasInstance { instance, blasEntry->staticBlas->accelerationStructureReference, uint32_t(m_reorderedSurfaces.size()) };
 
         if (instance->usesUnorderedApproximations() && RtxOptions::Get()->enableSeparateUnorderedApproximations())
-          m_mergedInstances[Tlas::Unordered].push_back(blasInstance);
+          staticBlasInstances[Tlas::Unordered].push_back(blasInstance);
         else
-          m_mergedInstances[Tlas::Opaque].push_back(blasInstance);
+          staticBlasInstances[Tlas::Opaque].push_back(blasInstance);
 
         // Append the instance to the reordered surface list
         // Note: this happens *after* the instance is appended, because the size of m_reorderedSurfaces is used above
@@ -573,6 +574,11 @@ namespace dxvk {
       }
     }
 
+    // Static BLAS records go first in each TLAS, the merged BLAS instances are appended by createBlasBuffersAndInstances
+    for (size_t tlas = 0; tlas < Tlas::Count; tlas++) {
+      appendStaticBlasInstanceRecords(m_recordWorkers.get(), staticBlasInstances[tlas], m_mergedInstances[tlas]);
+    }
+
     // Copy the instance transform data to the device
     if(instanceTransforms.size() > 0)
       ctx->writeToBuffer(m_transformBuffer, 0, instanceTransforms.size() * sizeof(VkTransformMatrixKHR), instanceTransforms.data());
@@ -737,65 +743,8 @@ namespace dxvk {
 
     // Check the enablement here - because the instance manager needs to run the billboard analysis all the time
     if (RtxOptions::Get()->enableBillboardOrientationCorrection()) {
-      memoryBillboards.resize(instanceManager.getBillboards().size());
-      uint32_t index = 0;
-
-      for (const auto& billboard : instanceManager.getBillboards()) {
-        if (billboard.instanceMask == 0 || !billboard.allowAsIntersectionPrimitive)
-          continue;
-
-        // Shader data
-        MemoryBillboard& memory = memoryBillboards[index];
-        memory.center = billboard.center;
-        memory.surfaceIndex = billboard.instance->getSurfaceIndex();
-        memory.inverseHalfWidth = 2.f / billboard.width;
-        memory.inverseHalfHeight = 2.f / billboard.height;
-        memory.xAxis = billboard.xAxis;
-        memory.yAxis = billboard.yAxis;
-        memory.xAxisUV = billboard.xAxisUV;
-        memory.yAxisUV = billboard.yAxisUV;
-        memory.centerUV = billboard.centerUV;
-        memory.vertexColor = billboard.vertexColor;
-        memory.flags = 0;
-        if (billboard.isBeam)
-          memory.flags |= billboardFlagIsBeam;
-        if (billboard.isCameraFacing)
-          memory.flags |= billboardFlagIsCameraFacing;
-
-        // TLAS instance
-        VkAccelerationStructureInstanceKHR instance {};
-        instance.accelerationStructureReference = m_intersectionBlas->accelerationStructureReference;
-        instance.flags = 0;
-        instance.instanceShaderBindingTableRecordOffset = 0;
-        instance.mask = billboard.instanceMask;
-        instance.instanceCustomIndex = index;
-
-        Matrix4 transform;
-        if (billboard.isBeam) {
-          // Scale and orient the primitive so that its local X and Y axes match the billboard's X and Y axes,
-          // and the Z axis is (obviously) orthogonal to those. Note that the beam is cylindrical, so its 'width'
-          // applies to both the X and Z axes.
-          transform[0] = Vector4(billboard.xAxis * billboard.width * 0.5f, 0.f);
-          transform[1] = Vector4(billboard.yAxis * billboard.height * 0.5f, 0.f);
-          transform[2] = Vector4(normalize(cross(billboard.xAxis, billboard.yAxis)) * billboard.width * 0.5f, 0.f);
-        }
-        else {
-          // Note: to be fully conservative, the size of the intersection primitive should be equal to the diagonal
-          // of the original particle, not its largest side. But the particle textures are usually round, so
-          // the reduced size works well in practice and results in fewer unnecessary ray interactions.
-          const float radius = std::max(billboard.width, billboard.height) * 0.5f;
-          transform[0][0] = transform[1][1] = transform[2][2] = radius;
-        }
-        transform[3] = Vector4(billboard.center, 1.f);
-        transform = transpose(transform);
-        memcpy(instance.transform.matrix, &transform, sizeof(VkTransformMatrixKHR));
-
-        m_mergedInstances[Tlas::Unordered].push_back(instance);
-
-        ++index;
-      }
-
-      numActiveBillboards = index;
+      numActiveBillboards = appendBillboardRecords(m_recordWorkers.get(), instanceManager.getBillboards(), m_intersectionBlas->accelerationStructureReference,
+                                                   memoryBillboards, m_mergedInstances[Tlas::Unordered]);
     }
 
     // Allocate the instance buffer and copy its contents from host to device memory
@@ -906,11 +855,64 @@ namespace dxvk {
     m_lastSurfaceInfoList = curSurfaceInfoList;
   }
 
+  // Byte ranges of a buffer's host copy that changed and need uploading. Ranges closer than
+  // kMergeGapBytes are merged, so scattered changes don't turn into hundreds of tiny writes.
+  class DirtyBufferRanges {
+  public:
+    // Ranges must be added in increasing order
+    void add(size_t begin, size_t end) {
+      if (!m_ranges.empty() && begin <= m_ranges.back().second + kMergeGapBytes) {
+        m_ranges.back().second = std::max(m_ranges.back().second, end);
+      } else {
+        m_ranges.emplace_back(begin, end);
+      }
+    }
+
+    // Writes the ranges from the host copy, returns the number of bytes uploaded
+    VkDeviceSize upload(Rc<DxvkContext>& ctx, const Rc<DxvkBuffer>& buffer, const void* hostCopy) {
+      VkDeviceSize uploadedBytes = 0;
+
+      for (const auto& [begin, end] : m_ranges) {
+        ctx->writeToBuffer(buffer, begin, end - begin, static_cast<const unsigned char*>(hostCopy) + begin);
+        uploadedBytes += end - begin;
+      }
+
+      m_ranges.clear();
+      return uploadedBytes;
+    }
+
+  private:
+    static constexpr size_t kMergeGapBytes = 1024;
+    std::vector<std::pair<size_t, size_t>> m_ranges;
+  };
+
+  // Uploads the words that differ from the buffer's host copy and updates the copy
+  static VkDeviceSize uploadChangedWords(Rc<DxvkContext>& ctx, const Rc<DxvkBuffer>& buffer,
+                                         const std::vector<uint32_t>& words, std::vector<uint32_t>& hostCopy) {
+    constexpr size_t kWordsPerChunk = 16;
+
+    const size_t numComparable = std::min(words.size(), hostCopy.size());
+    DirtyBufferRanges dirtyRanges;
+
+    for (size_t begin = 0; begin < words.size(); begin += kWordsPerChunk) {
+      const size_t end = std::min(begin + kWordsPerChunk, words.size());
+
+      if (end > numComparable || std::memcmp(&words[begin], &hostCopy[begin], (end - begin) * sizeof(uint32_t)) != 0) {
+        dirtyRanges.add(begin * sizeof(uint32_t), end * sizeof(uint32_t));
+      }
+    }
+
+    hostCopy = words;
+    return dirtyRanges.upload(ctx, buffer, hostCopy.data());
+  }
+
   void AccelManager::uploadSurfaceData(Rc<DxvkContext> ctx) {
     ScopedCpuProfileZone();
     if (m_reorderedSurfaces.empty())
       return;
 
+    VkDeviceSize uploadedBytes = 0;
+
     // Surface buffer
     const auto surfacesGPUSize = m_reorderedSurfaces.size() * kSurfaceGPUSize;
 
@@ -923,25 +925,42 @@ namespace dxvk {
     info.size = align(surfacesGPUSize, kBufferAlignment);
     if (m_surfaceBuffer == nullptr || info.size > m_surfaceBuffer->info().size) {
       m_surfaceBuffer = m_device->createBuffer(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, DxvkMemoryStats::Category::RTXAccelerationStructure);
+      // A new buffer holds nothing yet
+      m_surfacesGPUData.clear();
     }
 
-    // Write surface data
-    std::size_t dataOffset = 0;
-    std::vector<unsigned char> surfacesGPUData(surfacesGPUSize);
+    // Write surface data. Surfaces are serialized into the host copy of the buffer,
+    // and only the records that differ from what was uploaded before are written.
+    const std::size_t numUploadedBytes = m_surfacesGPUData.size();
+    m_surfacesGPUData.resize(surfacesGPUSize);
+
+    DirtyBufferRanges dirtyRanges;
+    std::array<unsigned char, kSurfaceGPUSize> surfaceGPUData;
 
     for (uint32_t i = 0; i < m_reorderedSurfaces.size(); ++i) {
       const auto& currentInstance = *m_reorderedSurfaces[i];
 
+      // Padding is not written, clear it so it doesn't make unchanged surfaces look different
+      surfaceGPUData.fill(0);
+      std::size_t dataOffset = 0;
+
       // Split instance geometry need to have their first index offset set in their corresponding surface instances
       m_reorderedSurfaces[i]->surface.firstIndex += m_reorderedSurfacesFirstIndexOffset[i];
-      currentInstance.surface.writeGPUData(surfacesGPUData.data(), dataOffset);
+      currentInstance.surface.writeGPUData(surfaceGPUData.data(), dataOffset);
       m_reorderedSurfaces[i]->surface.firstIndex -= m_reorderedSurfacesFirstIndexOffset[i];
-    }
 
-    assert(dataOffset == surfacesGPUSize);
-    assert(surfacesGPUData.size() == surfacesGPUSize);
+      assert(dataOffset == kSurfaceGPUSize);
 
-    ctx->writeToBuffer(m_surfaceBuffer, 0, surfacesGPUData.size(), surfacesGPUData.data());
+      const std::size_t surfaceOffset = i * kSurfaceGPUSize;
+      unsigned char* uploadedData = m_surfacesGPUData.data() + surfaceOffset;
+
+      if (surfaceOffset >= numUploadedBytes || std::memcmp(uploadedData, surfaceGPUData.data(), kSurfaceGPUSize) != 0) {
+        std::memcpy(uploadedData, surfaceGPUData.data(), kSurfaceGPUSize);
+        dirtyRanges.add(surfaceOffset, surfaceOffset + kSurfaceGPUSize);
+      }
+    }
+
+    uploadedBytes += dirtyRanges.upload(ctx, m_surfaceBuffer, m_surfacesGPUData.data());
 
     // Find the size of the surface mapping buffer
     uint32_t maxPreviousSurfaceIndex = 0;
@@ -977,30 +996,38 @@ namespace dxvk {
     }
 
     // Create and upload the primitive id prefix sum buffer
-    auto updatePrefixSumBuffer = [&info, this, ctx](std::vector<uint32_t>& prefixSumList, Rc<DxvkBuffer>& prefixSumBuffer) {
+    auto updatePrefixSumBuffer = [&info, &uploadedBytes, this, &ctx](std::vector<uint32_t>& prefixSumList, Rc<DxvkBuffer>& prefixSumBuffer,
+                                                                      std::vector<uint32_t>& uploadedPrefixSumList) {
       info.size = std::max(prefixSumList.size(), 1llu) * sizeof(prefixSumList[0]);
 
       if (prefixSumBuffer == nullptr || info.size > prefixSumBuffer->info().size) {
         prefixSumBuffer = m_device->createBuffer(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, DxvkMemoryStats::Category::RTXAccelerationStructure);
+        uploadedPrefixSumList.clear();
       }
 
-      if (prefixSumList.size() > 0) {
-        ctx->writeToBuffer(prefixSumBuffer, 0, prefixSumList.size() * sizeof(prefixSumList[0]), prefixSumList.data());
-      }
+      uploadedBytes += uploadChangedWords(ctx, prefixSumBuffer, prefixSumList, uploadedPrefixSumList);
     };
 
-    updatePrefixSumBuffer(m_reorderedSurfacesPrimitiveIDPrefixSum, m_primitiveIDPrefixSumBuffer);
-    updatePrefixSumBuffer(m_reorderedSurfacesPrimitiveIDPrefixSumLastFrame, m_primitiveIDPrefixSumBufferLastFrame);
+    // Last frame's prefix sum is what the current frame's buffer was given last frame, so the
+    // two buffers trade places and normally only the current frame's one has changes to upload.
+    std::swap(m_primitiveIDPrefixSumBuffer, m_primitiveIDPrefixSumBufferLastFrame);
+    std::swap(m_uploadedPrimitiveIDPrefixSum, m_uploadedPrimitiveIDPrefixSumLastFrame);
+
+    updatePrefixSumBuffer(m_reorderedSurfacesPrimitiveIDPrefixSum, m_primitiveIDPrefixSumBuffer, m_uploadedPrimitiveIDPrefixSum);
+    updatePrefixSumBuffer(m_reorderedSurfacesPrimitiveIDPrefixSumLastFrame, m_primitiveIDPrefixSumBufferLastFrame, m_uploadedPrimitiveIDPrefixSumLastFrame);
 
     // Create and upload the surface mapping buffer
     if (!surfaceIndexMapping.empty()) {
       info.size = align(surfaceIndexMapping.size() * sizeof(int), kBufferAlignment);
       if (m_surfaceMappingBuffer == nullptr || info.size > m_surfaceMappingBuffer->info().size) {
         m_surfaceMappingBuffer = m_device->createBuffer(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, DxvkMemoryStats::Category::RTXAccelerationStructure);
+        m_uploadedSurfaceIndexMapping.clear();
       }
 
-      ctx->writeToBuffer(m_surfaceMappingBuffer, 0, surfaceIndexMapping.size() * sizeof(surfaceIndexMapping[0]), surfaceIndexMapping.data());
+      uploadedBytes += uploadChangedWords(ctx, m_surfaceMappingBuffer, surfaceIndexMapping, m_uploadedSurfaceIndexMapping);
     }
+
+    m_device->statCounters().setCtr(DxvkStatCounter::RtxSurfaceUploadBytes, uploadedBytes);
   }
 
   void AccelManager::buildBlases(Rc<DxvkContext> ctx,
@@ -29,6 +29,7 @@
 #include "rtx_types.h"
 #include "rtx_common_object.h"
 #include "rtx_staging.h"
+#include "rtx_accel_records.h"
 #include "../util/util_vector.h"
 #include "../util/util_matrix.h"
 
@@ -153,6 +154,12 @@ private:
 
   std::vector<SurfaceInfo> m_lastSurfaceInfoList;
 
+  // Host copies of what the surface related buffers hold on the GPU, so only changes get uploaded
+  std::vector<unsigned char> m_surfacesGPUData;
+  std::vector<uint32_t> m_uploadedSurfaceIndexMapping;
+  std::vector<uint32_t> m_uploadedPrimitiveIDPrefixSum;
+  std::vector<uint32_t> m_uploadedPrimitiveIDPrefixSumLastFrame;
+
   int getCurrentFramePrimitiveIDPrefixSumBufferID() const;
 
   Rc<PooledBlas> m_intersectionBlas;
@@ -164,6 +171,9 @@ private:
 
   VkDeviceSize m_scratchAlignment;
   std::unique_ptr<RtxStagingDataAlloc> m_scratchAllocator;
+
+  // Splits TLAS instance and billboard record generation across threads, null on machines with few cores
+  std::unique_ptr<AccelRecordWorkers> m_recordWorkers;
 };
 
 }  // namespace dxvk
@@ -0,0 +1,172 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <cstring>
+#include <vector>
+
+#include "rtx_types.h"
+#include "rtx_instance_manager.h"
+#include "../../util/util_threadpool.h"
+#include "../../util/util_matrix.h"
+
+#include "rtx/pass/instance_definitions.h"
+#include "rtx/concept/billboard.h"
+
+namespace dxvk {
+  // Generation of the TLAS instance records and billboard records uploaded by the AccelManager each frame.
+  // Every record only depends on its own source, so the ranges are split into chunks processed on a worker
+  // pool.  Outputs are sized up front and written in place, which keeps the record order (and with it the
+  // surface and billboard indices the shaders see) identical to a serial pass.
+  using AccelRecordWorkers = WorkerThreadPool<4, true, false>;
+
+  // Below this many records the fork-join costs more than it saves
+  constexpr uint32_t kAccelRecordsPerChunk = 1024;
+
+  // A static BLAS instance gathered by mergeInstancesIntoBlas, expanded into its TLAS record afterwards
+  struct StaticBlasInstanceSource {
+    const RtInstance* instance;
+    uint64_t blasReference;
+    uint32_t surfaceIndex;
+  };
+
+  template<typename F>
+  inline void forEachAccelRecordChunk(AccelRecordWorkers* workers, uint32_t count, F&& func) {
+    if (workers == nullptr || count < 2 * kAccelRecordsPerChunk) {
+      func(0u, count);
+    } else {
+      workers->ParallelFor(0u, count, kAccelRecordsPerChunk, std::forward<F>(func));
+    }
+  }
+
+  inline void writeStaticBlasInstanceRecord(const StaticBlasInstanceSource& source, VkAccelerationStructureInstanceKHR& record) {
+    record = source.instance->getVkInstance();
+    record.accelerationStructureReference = source.blasReference;
+    record.instanceCustomIndex =
+      (record.instanceCustomIndex & ~uint32_t(CUSTOM_INDEX_SURFACE_MASK)) |
+      source.surfaceIndex & uint32_t(CUSTOM_INDEX_SURFACE_MASK);
+
+    // Get the instance's flags and apply the objectToWorldMirrored flag.
+    // This flag should only be applied to static BLAS.
+    if (source.instance->isObjectToWorldMirrored())
+      record.flags ^= VK_GEOMETRY_INSTANCE_TRIANGLE_FLIP_FACING_BIT_KHR;
+  }
+
+  // Appends a TLAS record for every source, in source order
+  inline void appendStaticBlasInstanceRecords(AccelRecordWorkers* workers,
+                                              const std::vector<StaticBlasInstanceSource>& sources,
+                                              std::vector<VkAccelerationStructureInstanceKHR>& records) {
+    const size_t base = records.size();
+    records.resize(base + sources.size());
+
+    VkAccelerationStructureInstanceKHR* out = records.data() + base;
+
+    forEachAccelRecordChunk(workers, uint32_t(sources.size()), [&sources, out](uint32_t begin, uint32_t end) {
+      for (uint32_t i = begin; i < end; i++) {
+        writeStaticBlasInstanceRecord(sources[i], out[i]);
+      }
+    });
+  }
+
+  inline void writeBillboardRecords(const IntersectionBillboard& billboard, uint32_t index, uint64_t intersectionBlasReference,
+                                    MemoryBillboard& memory, VkAccelerationStructureInstanceKHR& instance) {
+    // Shader data
+    memory.center = billboard.center;
+    memory.surfaceIndex = billboard.instance->getSurfaceIndex();
+    memory.inverseHalfWidth = 2.f / billboard.width;
+    memory.inverseHalfHeight = 2.f / billboard.height;
+    memory.xAxis = billboard.xAxis;
+    memory.yAxis = billboard.yAxis;
+    memory.xAxisUV = billboard.xAxisUV;
+    memory.yAxisUV = billboard.yAxisUV;
+    memory.centerUV = billboard.centerUV;
+    memory.vertexColor = billboard.vertexColor;
+    memory.flags = 0;
+    if (billboard.isBeam)
+      memory.flags |= billboardFlagIsBeam;
+    if (billboard.isCameraFacing)
+      memory.flags |= billboardFlagIsCameraFacing;
+
+    // TLAS instance
+    instance = VkAccelerationStructureInstanceKHR {};
+    instance.accelerationStructureReference = intersectionBlasReference;
+    instance.flags = 0;
+    instance.instanceShaderBindingTableRecordOffset = 0;
+    instance.mask = billboard.instanceMask;
+    instance.instanceCustomIndex = index;
+
+    Matrix4 transform;
+    if (billboard.isBeam) {
+      // Scale and orient the primitive so that its local X and Y axes match the billboard's X and Y axes,
+      // and the Z axis is (obviously) orthogonal to those. Note that the beam is cylindrical, so its 'width'
+      // applies to both the X and Z axes.
+      transform[0] = Vector4(billboard.xAxis * billboard.width * 0.5f, 0.f);
+      transform[1] = Vector4(billboard.yAxis * billboard.height * 0.5f, 0.f);
+      transform[2] = Vector4(normalize(cross(billboard.xAxis, billboard.yAxis)) * billboard.width * 0.5f, 0.f);
+    }
+    else {
+      // Note: to be fully conservative, the size of the intersection primitive should be equal to the diagonal
+      // of the original particle, not its largest side. But the particle textures are usually round, so
+      // the reduced size works well in practice and results in fewer unnecessary ray interactions.
+      const float radius = std::max(billboard.width, billboard.height) * 0.5f;
+      transform[0][0] = transform[1][1] = transform[2][2] = radius;
+    }
+    transform[3] = Vector4(billboard.center, 1.f);
+    transform = transpose(transform);
+    memcpy(instance.transform.matrix, &transform, sizeof(VkTransformMatrixKHR));
+  }
+
+  // Fills memoryBillboards with the billboards usable as intersection primitives and appends their TLAS
+  // records to instances.  Billboard indices are assigned in source order.  Returns the number written.
+  inline uint32_t appendBillboardRecords(AccelRecordWorkers* workers,
+                                         const std::vector<IntersectionBillboard>& billboards,
+                                         uint64_t intersectionBlasReference,
+                                         std::vector<MemoryBillboard>& memoryBillboards,
+                                         std::vector<VkAccelerationStructureInstanceKHR>& instances) {
+    // Compaction is the only serial dependency between billboards, resolve it first
+    std::vector<uint32_t> activeBillboards;
+    activeBillboards.reserve(billboards.size());
+
+    for (uint32_t i = 0; i < billboards.size(); i++) {
+      if (billboards[i].instanceMask != 0 && billboards[i].allowAsIntersectionPrimitive)
+        activeBillboards.push_back(i);
+    }
+
+    const uint32_t numActiveBillboards = uint32_t(activeBillboards.size());
+    const size_t base = instances.size();
+
+    memoryBillboards.resize(numActiveBillboards);
+    instances.resize(base + numActiveBillboards);
+
+    MemoryBillboard* memory = memoryBillboards.data();
+    VkAccelerationStructureInstanceKHR* out = instances.data() + base;
+
+    forEachAccelRecordChunk(workers, numActiveBillboards,
+      [&billboards, &activeBillboards, intersectionBlasReference, memory, out](uint32_t begin, uint32_t end) {
+        for (uint32_t index = begin; index < end; index++) {
+          writeBillboardRecords(billboards[activeBillboards[index]], index, intersectionBlasReference, memory[index], out[index]);
+        }
+      });
+
+    return numActiveBillboards;
+  }
+}
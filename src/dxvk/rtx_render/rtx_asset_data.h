@@ -138,6 +138,18 @@ namespace dxvk {
      */
     virtual void releaseSource() = 0;
 
+    /**
+     * \brief Load a range of image levels ahead of use
+     *
+     * Lets the asset load (and validate) several levels in one batch
+     * before data() is called for each of them. Assets that cannot
+     * batch their reads ignore the hint and load on data().
+     * \param [in] layer Image layer, ignored if asset is not an image
+     * \param [in] level First image level, ignored if asset is not an image
+     * \param [in] levelCount Number of image levels
+     */
+    virtual void prefetch(int layer, int level, int levelCount) { }
+
   protected:
     AssetData() = default;
 
@@ -173,6 +185,10 @@ namespace dxvk {
       return m_sourceAsset->evictCache(layer, level + m_minLevel);
     }
 
+    void prefetch(int layer, int level, int levelCount) override {
+      m_sourceAsset->prefetch(layer, level + m_minLevel, levelCount);
+    }
+
     void placement(
       int       layer,
       int       face,
@@ -183,6 +199,10 @@ namespace dxvk {
         offset, size);
     }
 
+    const AssetInfo& sourceInfo() const {
+      return m_sourceAsset->info();
+    }
+
     void setMinLevel(int minLevel) {
       const auto& srcInfo = m_sourceAsset->info();
 
@@ -27,6 +27,7 @@
 #include "rtx_io.h"
 #include "dxvk_scoped_annotation.h"
 #include <gli/gli.hpp>
+#include <unordered_set>
 
 namespace dxvk {
   
@@ -334,8 +335,10 @@ namespace dxvk {
   class PackagedAssetData : public AssetData {
   public:
     PackagedAssetData() = delete;
-    PackagedAssetData(const Rc<AssetPackage>& package, uint32_t assetIdx)
+    PackagedAssetData(const Rc<AssetPackage>& package, uint32_t assetIdx,
+                      AssetDataManager::BlobReaders* blobReaders)
     : m_package(package)
+    , m_blobReaders(blobReaders)
     , m_assetIdx(assetIdx) {
       m_assetDesc = package->getAssetDesc(assetIdx);
 
@@ -408,9 +411,21 @@ namespace dxvk {
           throw DxvkError("Compressed data blobs are not supported for CPU readback.");
         }
 
+        // Memory mapped packages are read in place
+        if (const void* blob = m_package->getDataBlobView(blobIdx)) {
+          if (m_verifiedBlobs.count(blobIdx) == 0 && !validateBlob(blobIdx, blob)) {
+            return nullptr;
+          }
+          return blob;
+        }
+
         std::vector<uint8_t> data(blobDesc->size);
         m_package->readDataBlob(blobIdx, data.data(), data.size());
 
+        if (!validateBlob(blobIdx, data.data())) {
+          return nullptr;
+        }
+
         const void* rawData = data.data();
         m_data[blobIdx] = std::move(data);
         return rawData;
@@ -424,6 +439,61 @@ namespace dxvk {
       releaseVectorMemory(m_data[blobIdx]);
     }
 
+    void prefetch(int layer, int level, int levelCount) override {
+      if (m_blobReaders == nullptr) {
+        return;
+      }
+
+      const bool validate = RtxOptions::Get()->validateAssetPackageBlobs();
+
+      // Mapped blobs are handed out in place, there is nothing to batch unless they need validation
+      if (m_package->isMapped() && !validate) {
+        return;
+      }
+
+      std::vector<AssetPackage::BlobRead> reads;
+      for (int n = level; n < level + levelCount; n++) {
+        const uint32_t blobIdx = getBlobIndex(layer, 0, n);
+        const auto blobDesc = m_package->getDataBlobDesc(blobIdx);
+
+        // Mip tail levels share a blob
+        if (!blobDesc || blobDesc->compression != 0 ||
+            (!reads.empty() && reads.back().blobIdx == blobIdx) ||
+            m_verifiedBlobs.count(blobIdx) != 0) {
+          continue;
+        }
+
+        void* out = nullptr;
+        if (!m_package->isMapped()) {
+          auto& data = m_data[blobIdx];
+          if (!data.empty()) {
+            continue;
+          }
+          data.resize(blobDesc->size);
+          out = data.data();
+        }
+
+        reads.push_back({ blobIdx, out, out ? blobDesc->size : 0, false });
+      }
+
+      if (reads.empty()) {
+        return;
+      }
+
+      m_package->readDataBlobs(*m_blobReaders, reads.data(), uint32_t(reads.size()), validate);
+
+      for (const auto& read : reads) {
+        if (!read.succeeded) {
+          // Leave failed blobs to data(), which rejects them
+          if (read.out) {
+            releaseVectorMemory(m_data[read.blobIdx]);
+          }
+        } else if (!read.out) {
+          m_verifiedBlobs.insert(read.blobIdx);
+        }
+      }
+    }
+
     void releaseSource() override {
     }
 
@@ -446,6 +516,14 @@ namespace dxvk {
     }
 
   private:
+    bool validateBlob(uint32_t blobIdx, const void* data) const {
+      if (RtxOptions::Get()->validateAssetPackageBlobs() && !m_package->verifyDataBlob(blobIdx, data)) {
+        Logger::err(str::format("Checksum mismatch in data blob ", blobIdx, " of package ", m_package->getFilename()));
+        return false;
+      }
+      return true;
+    }
+
     uint32_t getBlobIndex(int       layer,
                           int       face,
                           int       level) const {
@@ -467,10 +545,13 @@ namespace dxvk {
     }
 
     Rc<AssetPackage> m_package;
+    AssetDataManager::BlobReaders* m_blobReaders;
     const AssetPackage::AssetDesc* m_assetDesc = nullptr;
     uint32_t m_assetIdx;
 
     std::unordered_map<uint32_t, std::vector<uint8_t>> m_data;
+    // Mapped blobs which already passed validation in prefetch()
+    std::unordered_set<uint32_t> m_verifiedBlobs;
   };
 
   AssetDataManager::AssetDataManager() {
@@ -504,8 +585,11 @@ namespace dxvk {
 
     m_searchPaths[priority] = searchPath;
 
-    // Find the packages
-    if (RtxIo::enabled()) {
+    // Find the packages. Without RTX IO uncompressed packaged assets are
+    // loaded on the CPU, which is only worth it when packages are mapped.
+    const bool cpuPackageLoads = !RtxIo::enabled() && RtxOptions::Get()->useMemoryMappedAssetPackages();
+
+    if (RtxIo::enabled() || cpuPackageLoads) {
       PackageSet packageSet;
       for (const auto& entry : std::filesystem::directory_iterator(path)) {
         if (entry.path().extension() == ".pkg" || entry.path().extension() == ".rtxio") {
@@ -513,6 +597,15 @@ namespace dxvk {
           // Try to initialize the replacements packages
           Rc<AssetPackage> package = new AssetPackage(packagePath);
           if (package->initialize()) {
+            if (RtxOptions::Get()->useMemoryMappedAssetPackages()) {
+              package->mapFile();
+            }
+
+            if (cpuPackageLoads && m_blobReaders == nullptr) {
+              // Leave most cores to the game, the texture loader threads wait on these
+              const uint32_t numBlobReaders = std::clamp(dxvk::thread::hardware_concurrency() / 4, 1u, 4u);
+              m_blobReaders = std::make_unique<BlobReaders>(uint8_t(numBlobReaders), "rtx-blob-readers");
+            }
             packageSet.emplace(packagePath, std::move(package));
             Logger::info(str::format("Mounted a package at: ", entry.path()));
           } else {
@@ -550,7 +643,7 @@ namespace dxvk {
       }
     }
 
-    if (RtxIo::enabled() && !m_packageSets.empty()) {
+    if (!m_packageSets.empty()) {
       // Iterate package sets in search priority order
       for (auto itBase = m_packageSets.rbegin(); itBase != m_packageSets.rend(); ++itBase) {
         const auto& basePath = std::get<0>(itBase->second);
@@ -565,7 +658,12 @@ namespace dxvk {
           for (auto it = packages.rbegin(); it != packages.rend(); ++it) {
             uint32_t assetIdx = it->second->findAsset(relativePath);
             if (AssetPackage::kNoAssetIdx != assetIdx) {
-              return new PackagedAssetData(it->second, assetIdx);
+              Rc<PackagedAssetData> asset = new PackagedAssetData(it->second, assetIdx, m_blobReaders.get());
+
+              // Only RTX IO can decode compressed blobs
+              if (RtxIo::enabled() || asset->compression() == AssetCompression::None) {
+                return asset;
+              }
             }
           }
         }
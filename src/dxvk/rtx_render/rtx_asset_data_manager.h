@@ -23,7 +23,9 @@
 
 #include <filesystem>
 #include <map>
+#include <memory>
 #include "../util/util_singleton.h"
+#include "../../util/util_threadpool.h"
 #include "rtx_asset_data.h"
 #include "rtx_asset_package.h"
 
@@ -34,9 +36,15 @@ namespace dxvk {
   // wraps the asset in an AssetData implementation that help to abstract
   // the access to actual data.
   class AssetDataManager : public Singleton<AssetDataManager> {
+  public:
+    // Workers reading packaged blobs for the CPU texture load path
+    using BlobReaders = WorkerThreadPool<16, true, false>;
+
+  private:
     using PackageSet = std::map<std::string, Rc<AssetPackage>>;
     std::map<uint32_t, std::tuple<std::string, PackageSet>> m_packageSets;
     std::map<uint32_t, std::string> m_searchPaths;
+    std::unique_ptr<BlobReaders> m_blobReaders;
   public:
     AssetDataManager();
     ~AssetDataManager();
@@ -24,12 +24,19 @@
 #include <stddef.h>
 #include <stdio.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 #include "../../util/rc/util_rc.h"
 #include "../../util/log/log.h"
 #include "../../util/util_string.h"
+#include "../../util/util_crc32.h"
+#include "../../util/util_mapped_file.h"
+#include "../../util/thread.h"
 
 #ifdef WIN32
 #define fseek64 _fseeki64
@@ -48,6 +55,7 @@ namespace dxvk {
     static constexpr uint32_t kMagic = 0xbaadd00d;
     static constexpr uint32_t kVersion = 1;
     static constexpr uint32_t kNoAssetIdx = ~0;
+    static constexpr size_t kVerifyPieceSize = 256 * 1024;
 
     struct Header {
       uint32_t magic;
@@ -100,12 +108,23 @@ namespace dxvk {
 
     static_assert(sizeof(BlobDesc) == 16, "Blob description structure size overrun!");
 
+    // A request to read one data blob out of the package, see readDataBlobs()
+    struct BlobRead {
+      uint32_t blobIdx;
+      // Destination, or nullptr to only check a mapped blob in place
+      void* out;
+      size_t outSize;
+      // Set by readDataBlobs()
+      bool succeeded;
+    };
+
     AssetPackage() = default;
     explicit AssetPackage(const std::string& filename)
       : m_filename { filename } { }
 
     ~AssetPackage() {
       closeFileHandle();
+      unmapFile();
     }
 
     bool initialize(const char* filename = nullptr) {
@@ -113,6 +132,7 @@ namespace dxvk {
         return false;
 
       closeFileHandle();
+      unmapFile();
 
       if (m_filename.empty() && nullptr != filename)
         m_filename = filename;
@@ -226,11 +246,115 @@ namespace dxvk {
       return reinterpret_cast<const BlobDesc*>(m_metadata.get() + offs);
     }
 
+    /**
+     * \brief Memory maps the package
+     *
+     * Once mapped, blobs can be accessed in place through getDataBlobView()
+     * and readDataBlob() copies from the mapping instead of going through
+     * the shared file handle. Failing to map is not an error, the stream
+     * reader keeps working.
+     * \returns \c true if the package is mapped
+     */
+    bool mapFile() {
+      if (!m_mappedFile.isOpen()) {
+        if (!m_mappedFile.open(m_filename)) {
+          Logger::info(str::format("Unable to memory map package file ", m_filename));
+          return false;
+        }
+        closeFileHandle();
+      }
+
+      return true;
+    }
+
+    void unmapFile() {
+      m_mappedFile.close();
+    }
+
+    bool isMapped() const {
+      return m_mappedFile.isOpen();
+    }
+
+    /**
+     * \brief Zero-copy access to a data blob
+     *
+     * \param [in] idx Blob index
+     * \returns Pointer to the blob's stored (possibly compressed) bytes inside
+     *   the mapping, valid while the package stays mapped, or \c nullptr if the
+     *   package is not mapped or the blob lies outside of the file.
+     */
+    const void* getDataBlobView(uint32_t idx) const {
+      auto blobDesc = getDataBlobDesc(idx);
+      if (!blobDesc || !m_mappedFile.isOpen())
+        return nullptr;
+
+      if (blobDesc->offset > m_mappedFile.size() ||
+          blobDesc->size > m_mappedFile.size() - blobDesc->offset)
+        return nullptr;
+
+      return m_mappedFile.data() + blobDesc->offset;
+    }
+
+    /**
+     * \brief Checks blob bytes against the stored checksum
+     *
+     * The checksum covers the bytes as stored in the package. Blobs
+     * written without a checksum (zero) always pass.
+     */
+    bool verifyDataBlob(uint32_t idx, const void* data) const {
+      auto blobDesc = getDataBlobDesc(idx);
+      if (!blobDesc)
+        return false;
+
+      return blobDesc->crc32 == 0 || blobDesc->crc32 == crc32(data, blobDesc->size);
+    }
+
+    /**
+     * \brief Reads a batch of data blobs across worker threads
+     *
+     * Each blob is copied out of the mapping piece by piece and every piece
+     * is checksummed right after it is copied, while it is still in cache,
+     * so BlobDesc::crc32 is verified in the same pass. Reads with no
+     * destination check the blob in place. Packages that are not mapped
+     * are read through readDataBlob() and checksummed afterwards.
+     * Compressed blobs are read as stored, for the GPU decoder to consume.
+     * \param [in] pool Worker pool providing ParallelFor()
+     * \param [in,out] reads Blob read requests, \c succeeded is written back
+     * \param [in] count Number of requests
+     * \param [in] verify Whether to verify checksums
+     * \returns Number of requests that failed
+     */
+    template<typename ThreadPool>
+    uint32_t readDataBlobs(ThreadPool& pool, BlobRead* reads, uint32_t count, bool verify) {
+      std::atomic<uint32_t> numFailed = { 0u };
+
+      pool.ParallelFor(0u, count, 1u, [this, reads, verify, &numFailed](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+          BlobRead& read = reads[i];
+          read.succeeded = readAndVerifyDataBlob(read, verify);
+
+          if (!read.succeeded) {
+            ++numFailed;
+          }
+        }
+      });
+
+      return numFailed.load();
+    }
+
     size_t readDataBlob(uint32_t idx, void* out, size_t outSize) {
       if (auto blobDesc = getDataBlobDesc(idx)) {
         if (outSize < blobDesc->size)
           return 0;
 
+        if (auto blob = getDataBlobView(idx)) {
+          memcpy(out, blob, blobDesc->size);
+          return blobDesc->size;
+        }
+
+        // The file handle is shared, texture loader threads may read concurrently
+        std::lock_guard<dxvk::mutex> lock(m_readMutex);
+
         if (!openFileHandle())
           return 0;
 
@@ -271,8 +395,49 @@ namespace dxvk {
     }
 
   private:
+    bool readAndVerifyDataBlob(const BlobRead& read, bool verify) {
+      const auto blobDesc = getDataBlobDesc(read.blobIdx);
+      if (!blobDesc || (read.out && read.outSize < blobDesc->size)) {
+        return false;
+      }
+
+      uint32_t crc = 0;
+
+      if (const uint8_t* blob = static_cast<const uint8_t*>(getDataBlobView(read.blobIdx))) {
+        for (size_t offset = 0; offset < blobDesc->size; offset += kVerifyPieceSize) {
+          const size_t pieceSize = std::min<size_t>(kVerifyPieceSize, blobDesc->size - offset);
+
+          if (read.out) {
+            memcpy(static_cast<uint8_t*>(read.out) + offset, blob + offset, pieceSize);
+          }
+
+          if (verify) {
+            crc = crc32(blob + offset, pieceSize, crc);
+          }
+        }
+      } else {
+        // In place checks need the mapping
+        if (!read.out || readDataBlob(read.blobIdx, read.out, read.outSize) != blobDesc->size) {
+          return false;
+        }
+
+        if (verify) {
+          crc = crc32(read.out, blobDesc->size);
+        }
+      }
+
+      if (verify && blobDesc->crc32 != 0 && blobDesc->crc32 != crc) {
+        Logger::err(str::format("Checksum mismatch in data blob ", read.blobIdx, " of package ", m_filename));
+        return false;
+      }
+
+      return true;
+    }
+
     std::string m_filename;
     FILE* m_handle = nullptr;
+    MappedFile m_mappedFile;
+    dxvk::mutex m_readMutex;
 
     uint32_t m_assetCount = 0;
     uint32_t m_blobCount = 0;
@@ -60,6 +60,7 @@ namespace dxvk {
     assert(numDescriptors <= kMaxBindlessResources);
 
     std::vector<T> descriptorInfos(numDescriptors);
+    std::vector<DxvkResource*> resources(numDescriptors, nullptr);
     descriptorInfos[0] = dummyDescriptor; // we set the first descriptor to be a dummy (size is always at least 1) and overwrite it if there are valid engine objects
 
     uint32_t idx = 0;
@@ -72,17 +73,20 @@ namespace dxvk {
           descriptorInfos[idx].sampler = nullptr;
           descriptorInfos[idx].imageView = imageView->handle();
           descriptorInfos[idx].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+          resources[idx] = imageView;
           ctx->getCommandList()->trackResource<DxvkAccess::Read>(imageView);
         }
       } else if constexpr (Type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) {
         if (engineObject.defined()) {
           descriptorInfos[idx] = engineObject.getDescriptor().buffer;
+          resources[idx] = engineObject.buffer().ptr();
           ctx->getCommandList()->trackResource<DxvkAccess::Read>(engineObject.buffer());
         }
       } else if constexpr (Type == VK_DESCRIPTOR_TYPE_SAMPLER) {
         if (engineObject != nullptr) {
           descriptorInfos[idx].sampler = engineObject->handle();
           descriptorInfos[idx].imageView = nullptr;
+          resources[idx] = engineObject.ptr();
         }
       } else {
         static_assert(Type != VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE || Type != VK_DESCRIPTOR_TYPE_STORAGE_BUFFER || Type != VK_DESCRIPTOR_TYPE_SAMPLER, "Support for this descriptor type has not been implemented yet.");
@@ -92,27 +96,15 @@ namespace dxvk {
       ++idx;
     }
 
-    VkWriteDescriptorSet descWrites;
-    memset(&descWrites, 0, sizeof(descWrites));
-    descWrites.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descWrites.descriptorCount = numDescriptors;
-    descWrites.descriptorType = Type;
-
-    if constexpr (std::is_same_v<T, VkDescriptorImageInfo>) {
-      descWrites.pImageInfo = &descriptorInfos[0];
-    } else if constexpr (std::is_same_v<T, VkDescriptorBufferInfo>) {
-      descWrites.pBufferInfo = &descriptorInfos[0];
-    }
-
     switch (Type) {
     case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-      m_tables[Table::Textures][currentIdx()]->updateDescriptors(descWrites);
+      m_tables[Table::Textures][currentIdx()]->updateDescriptors(Type, descriptorInfos, resources);
       break;
     case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-      m_tables[Table::Buffers][currentIdx()]->updateDescriptors(descWrites);
+      m_tables[Table::Buffers][currentIdx()]->updateDescriptors(Type, descriptorInfos, resources);
       break;
     case VK_DESCRIPTOR_TYPE_SAMPLER:
-      m_tables[Table::Samplers][currentIdx()]->updateDescriptors(descWrites);
+      m_tables[Table::Samplers][currentIdx()]->updateDescriptors(Type, descriptorInfos, resources);
       break;
     }
   }
@@ -177,22 +169,82 @@ namespace dxvk {
       throw DxvkError("BindlessTable: Failed to create descriptor set layout");
   }
 
-  void BindlessResourceManager::BindlessTable::updateDescriptors(VkWriteDescriptorSet set) {
+  static bool isSameDescriptor(const VkDescriptorImageInfo& a, const VkDescriptorImageInfo& b) {
+    return a.sampler == b.sampler && a.imageView == b.imageView && a.imageLayout == b.imageLayout;
+  }
+
+  static bool isSameDescriptor(const VkDescriptorBufferInfo& a, const VkDescriptorBufferInfo& b) {
+    return a.buffer == b.buffer && a.offset == b.offset && a.range == b.range;
+  }
+
+  template<typename T>
+  void BindlessResourceManager::BindlessTable::updateDescriptors(const VkDescriptorType type, const std::vector<T>& descriptorInfos, const std::vector<DxvkResource*>& resources) {
     if (bindlessDescSet == nullptr) {
       // Allocate the descriptor set
       bindlessDescSet = m_pManager->m_globalBindlessPool[m_pManager->currentIdx()]->alloc(layout, "bindless descriptor set");
       if (bindlessDescSet == nullptr) {
-        Logger::err(str::format("BindlessTable: failed to allocate a descriptor set for ", set.descriptorCount, " ",
-                                (set.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) ? "buffers" : "textures"));
+        Logger::err(str::format("BindlessTable: failed to allocate a descriptor set for ", descriptorInfos.size(), " ",
+                                (type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) ? "buffers" : "textures"));
         return;
       }
     }
 
-    // Update the write descriptor with our set
-    set.dstSet = bindlessDescSet;
+    std::vector<T>* written;
+    if constexpr (std::is_same_v<T, VkDescriptorImageInfo>) {
+      written = &m_writtenImages;
+    } else {
+      written = &m_writtenBuffers;
+    }
 
-    // Do the write
-    vkd()->vkUpdateDescriptorSets(vkd()->device(), 1, &set, 0, nullptr);
+    const uint32_t numDescriptors = descriptorInfos.size();
+    auto isUnchanged = [&](uint32_t i) {
+      return i < written->size() &&
+             isSameDescriptor((*written)[i], descriptorInfos[i]) &&
+             m_writtenResources[i].ptr() == resources[i];
+    };
+
+    // Emit one write per run of changed descriptors
+    std::vector<VkWriteDescriptorSet> descWrites;
+    for (uint32_t i = 0; i < numDescriptors; ) {
+      if (isUnchanged(i)) {
+        ++i;
+        continue;
+      }
+
+      const uint32_t runBegin = i;
+      while (i < numDescriptors && !isUnchanged(i)) {
+        ++i;
+      }
+
+      VkWriteDescriptorSet& write = descWrites.emplace_back();
+      memset(&write, 0, sizeof(write));
+      write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      write.dstSet = bindlessDescSet;
+      write.dstArrayElement = runBegin;
+      write.descriptorCount = i - runBegin;
+      write.descriptorType = type;
+
+      if constexpr (std::is_same_v<T, VkDescriptorImageInfo>) {
+        write.pImageInfo = &descriptorInfos[runBegin];
+      } else if constexpr (std::is_same_v<T, VkDescriptorBufferInfo>) {
+        write.pBufferInfo = &descriptorInfos[runBegin];
+      }
+    }
+
+    // Do the writes
+    if (!descWrites.empty()) {
+      vkd()->vkUpdateDescriptorSets(vkd()->device(), descWrites.size(), descWrites.data(), 0, nullptr);
+    }
+
+    // Slots past the new count are left stale, which is fine for a partially bound table, but
+    // their objects don't need to be kept alive any longer
+    *written = descriptorInfos;
+    m_writtenResources.resize(numDescriptors);
+    for (uint32_t i = 0; i < numDescriptors; i++) {
+      if (m_writtenResources[i].ptr() != resources[i]) {
+        m_writtenResources[i] = resources[i];
+      }
+    }
   }
 
   void BindlessResourceManager::createGlobalBindlessDescPool() {
@@ -66,12 +66,22 @@ namespace dxvk {
       VkDescriptorSet bindlessDescSet = VK_NULL_HANDLE;
 
       void createLayout(const VkDescriptorType type);
-      void updateDescriptors(VkWriteDescriptorSet set);
+
+      // Writes only the descriptors that differ from what this set was last updated with
+      template<typename T>
+      void updateDescriptors(const VkDescriptorType type, const std::vector<T>& descriptorInfos, const std::vector<DxvkResource*>& resources);
 
     private:
       const Rc<vk::DeviceFn> vkd() const;
 
       BindlessResourceManager* m_pManager = nullptr;
+
+      // Shadow of the descriptors currently written in the set.  The referenced objects are kept
+      // alive until their slot is overwritten, so a handle value can't be recycled by a different
+      // object while still written here - which is what makes comparing handles safe.
+      std::vector<VkDescriptorImageInfo> m_writtenImages;
+      std::vector<VkDescriptorBufferInfo> m_writtenBuffers;
+      std::vector<Rc<DxvkResource>> m_writtenResources;
     };
 
     // Persistent desc pool, our sets can be updated after bind (should be no need to reset this pool)
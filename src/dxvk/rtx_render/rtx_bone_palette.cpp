@@ -0,0 +1,87 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include "rtx_bone_palette.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace dxvk {
+
+  BonePalette BonePalette::create(const Matrix4* matrices, uint32_t count) {
+    BonePalette palette;
+
+    if (count == 0) {
+      return palette;
+    }
+
+    palette.page = new BonePalettePage(count);
+    palette.page->used = count;
+    palette.count = count;
+    palette.key = XXH3_64bits(matrices, sizeof(Matrix4) * count);
+
+    memcpy(palette.page->matrices.data(), matrices, sizeof(Matrix4) * count);
+
+    return palette;
+  }
+
+  BonePalette BonePaletteArena::acquire(XXH64_hash_t key, const Matrix4* matrices, uint32_t count) {
+    if (count == 0) {
+      return BonePalette();
+    }
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    auto it = m_palettes.find(key);
+
+    if (it != m_palettes.end()) {
+      assert(it->second.count == count);
+      return it->second;
+    }
+
+    // Palettes never straddle pages, start a new one when the current one is full.
+    // The previous page lives on for as long as palettes in it are referenced.
+    if (m_page == nullptr || m_page->used + count > m_page->matrices.size()) {
+      m_page = new BonePalettePage(std::max(count, kPageMatrixCount));
+    }
+
+    BonePalette palette;
+    palette.page = m_page;
+    palette.offset = m_page->used;
+    palette.count = count;
+    palette.key = key;
+
+    memcpy(m_page->matrices.data() + palette.offset, matrices, sizeof(Matrix4) * count);
+    m_page->used += count;
+
+    m_palettes.emplace(key, palette);
+
+    return palette;
+  }
+
+  void BonePaletteArena::reset() {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    // Keep filling the current page, palettes handed out are never overwritten
+    m_palettes.clear();
+  }
+
+}
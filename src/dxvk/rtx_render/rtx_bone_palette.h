@@ -0,0 +1,121 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <vector>
+
+#include "../../util/rc/util_rc.h"
+#include "../../util/rc/util_rc_ptr.h"
+#include "../../util/thread.h"
+#include "../../util/util_fast_cache.h"
+#include "../../util/util_matrix.h"
+#include "../../util/xxHash/xxhash.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Backing storage for bone palettes
+   *
+   * Pages are only ever appended to, a palette written to
+   * a page stays valid for as long as the page is referenced.
+   */
+  struct BonePalettePage : public RcObject {
+    explicit BonePalettePage(uint32_t capacity)
+      : matrices(capacity) { }
+
+    std::vector<Matrix4> matrices;
+    uint32_t used = 0;
+  };
+
+  /**
+   * \brief Immutable bone palette
+   *
+   * A slice of a bone palette page. Copying a palette only
+   * copies the page reference, and palettes with the same key
+   * hold the same matrices.
+   */
+  struct BonePalette {
+    Rc<BonePalettePage> page;
+    uint32_t offset = 0;
+    uint32_t count = 0;
+    XXH64_hash_t key = 0;
+
+    bool empty() const {
+      return count == 0;
+    }
+
+    const Matrix4* data() const {
+      return page != nullptr ? page->matrices.data() + offset : nullptr;
+    }
+
+    const Matrix4& operator [] (uint32_t index) const {
+      assert(index < count);
+      return data()[index];
+    }
+
+    /**
+     * \brief Creates a palette with its own page
+     *
+     * For palettes that do not come from an arena, e.g. the ones
+     * passed in through the Remix API.
+     */
+    static BonePalette create(const Matrix4* matrices, uint32_t count);
+  };
+
+  /**
+   * \brief Frame scoped bone palette arena
+   *
+   * Packs the bone palettes of all skinned draws into shared pages and
+   * stores every distinct palette only once per frame, draws that submit
+   * the same matrices (e.g. a character drawn in several passes) get the
+   * same palette. Thread safe, palettes are acquired from geometry workers.
+   */
+  class BonePaletteArena {
+  public:
+    // 256 KiB, enough for 16 full 256 bone palettes
+    static constexpr uint32_t kPageMatrixCount = 4096;
+
+    /**
+     * \brief Returns the palette for the given key
+     *
+     * Copies the matrices into the arena if no palette with this
+     * key was acquired since the last reset.
+     * \param [in] key Hash identifying the contents of the palette
+     * \param [in] matrices First matrix of the palette
+     * \param [in] count Number of matrices
+     */
+    BonePalette acquire(XXH64_hash_t key, const Matrix4* matrices, uint32_t count);
+
+    /**
+     * \brief Ends the deduplication scope, called once per frame
+     *
+     * Palettes acquired before remain valid.
+     */
+    void reset();
+
+  private:
+    dxvk::mutex m_mutex;
+    fast_unordered_cache<BonePalette> m_palettes;
+    Rc<BonePalettePage> m_page;
+  };
+
+}
@@ -730,7 +730,7 @@ namespace dxvk {
     RasterGeometry& geoData = drawCallState.geometryData;
     DrawCallTransforms& transformData = drawCallState.transformData;
 
-    assert(geoData.futureGeometryHashes.valid());
+    assert(geoData.futureGeometryHashes.valid() || geoData.hashes[HashComponents::VertexPosition] != kEmptyHash);
     assert(geoData.positionBuffer.defined());
 
     const auto fusedMode = RtxOptions::Get()->fusedWorldViewMode();
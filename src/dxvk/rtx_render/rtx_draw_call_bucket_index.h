@@ -0,0 +1,252 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "../../util/util_fast_cache.h"
+#include "../../util/util_spatial_map.h"
+#include "../../util/util_vector.h"
+#include "../../util/xxHash/xxhash.h"
+
+namespace dxvk {
+  // What DrawCallCache matches on, taken from a draw call or from the draw call a BlasEntry was last updated with
+  struct DrawCallMatchKey {
+    XXH64_hash_t materialHash = 0;
+    XXH64_hash_t fullGeometryHash = 0;
+    XXH64_hash_t vertexPositionHash = 0;
+    XXH64_hash_t vertexTexcoordHash = 0;
+    XXH64_hash_t boneHash = 0;
+    Vector3 worldPosition;
+    bool isSky = false;
+  };
+
+  inline bool isExactDrawCallMatch(const DrawCallMatchKey& drawCall, const DrawCallMatchKey& entry) {
+    return drawCall.isSky == entry.isSky
+        && drawCall.materialHash == entry.materialHash
+        && drawCall.fullGeometryHash == entry.fullGeometryHash
+        && drawCall.boneHash == entry.boneHash;
+  }
+
+  // Similarity of an entry that isn't an exact match, only entries scoring above kMinDrawCallMatchScore are reused
+  inline float calcDrawCallMatchScore(const DrawCallMatchKey& drawCall, const DrawCallMatchKey& entry) {
+    // TODO these heuristics could use more refinement.
+    float score = 0;
+    if (entry.vertexPositionHash == drawCall.vertexPositionHash &&
+        entry.boneHash == drawCall.boneHash) {
+      score += 1000.f;
+    }
+    if (entry.vertexTexcoordHash == drawCall.vertexTexcoordHash) {
+      score += 1000.f;
+    }
+    if (entry.materialHash == drawCall.materialHash) {
+      score += 1000.f;
+    }
+    // TODO this is only checking the distance to the first instance that created the BlasEntry, not to
+    // each instance.  It also doesn't include the portal logic from InstanceManager.
+    score -= lengthSqr(drawCall.worldPosition - entry.worldPosition);
+    return score;
+  }
+
+  constexpr float kMinDrawCallMatchScore = std::numeric_limits<float>::min();
+
+  // The score is at most 3000 minus the squared distance, so nothing further than sqrt(3000) can pass
+  // kMinDrawCallMatchScore.  Rounded up so the spatial query never misses an entry right at the edge.
+  constexpr float kMaxDrawCallMatchDistance = 55.f;
+
+  // Indexes the entries of one DrawCallCache bucket, so draw calls of meshes instanced hundreds of times
+  // don't have to score every entry.  Exact matches are found by their exact match hashes, and since only
+  // entries within kMaxDrawCallMatchDistance can score high enough to be reused, similar entries are found
+  // through a spatial map.  Each entry also carries its position in the bucket's iteration order, so ties
+  // resolve to the same entry a linear pass over the bucket would pick.
+  //
+  // The index holds a copy of each entry's key, which has to be updated whenever the entry changes.
+  template<typename Entry>
+  class DrawCallBucketIndex {
+  public:
+    DrawCallBucketIndex()
+      : m_spatialMap(kMaxDrawCallMatchDistance) {
+    }
+
+    size_t size() const {
+      return m_records.size();
+    }
+
+    // Adds an entry between its neighbours in iteration order, null for the ends of the bucket
+    void insert(Entry* entry, const DrawCallMatchKey& key, const Entry* prev, const Entry* next) {
+      if (prev == nullptr && next == nullptr) {
+        addRecord(entry, key, 0);
+      } else if (next == nullptr) {
+        addRecord(entry, key, m_records.at(prev).order + kOrderSpacing);
+      } else if (prev == nullptr) {
+        addRecord(entry, key, m_records.at(next).order - kOrderSpacing);
+      } else {
+        if (m_records.at(next).order - m_records.at(prev).order < 2) {
+          respaceOrders();
+        }
+
+        addRecord(entry, key, (m_records.at(prev).order + m_records.at(next).order) / 2);
+      }
+    }
+
+    void update(const Entry* entry, const DrawCallMatchKey& key) {
+      Record& record = m_records.at(entry);
+
+      const XXH64_hash_t oldExactHash = getExactHash(record.key);
+      const XXH64_hash_t newExactHash = getExactHash(key);
+
+      if (oldExactHash != newExactHash) {
+        eraseExact(oldExactHash, record.entry);
+        m_exactEntries.emplace(newExactHash, record.entry);
+      }
+
+      if (record.key.worldPosition != key.worldPosition) {
+        if (isSearchable(record.key)) {
+          m_spatialMap.erase(record.key.worldPosition, record.entry);
+        }
+        if (isSearchable(key)) {
+          m_spatialMap.insert(key.worldPosition, record.entry);
+        }
+      }
+
+      record.key = key;
+    }
+
+    void erase(const Entry* entry) {
+      auto found = m_records.find(entry);
+      if (found == m_records.end()) {
+        return;
+      }
+
+      const Record& record = found->second;
+      eraseExact(getExactHash(record.key), record.entry);
+      if (isSearchable(record.key)) {
+        m_spatialMap.erase(record.key.worldPosition, record.entry);
+      }
+
+      m_records.erase(found);
+    }
+
+    // Same result as scoring every entry of the bucket in iteration order: the first exact match, otherwise the
+    // first of the highest scoring entries not touched in `currentFrame`, or null if none scores high enough.
+    Entry* find(const DrawCallMatchKey& drawCall, uint32_t currentFrame) const {
+      const Record* best = nullptr;
+
+      auto exactEntries = m_exactEntries.equal_range(getExactHash(drawCall));
+      for (auto iter = exactEntries.first; iter != exactEntries.second; ++iter) {
+        const Record& record = m_records.at(iter->second);
+
+        if (isExactDrawCallMatch(drawCall, record.key) && (best == nullptr || record.order < best->order)) {
+          best = &record;
+        }
+      }
+
+      if (best != nullptr) {
+        return best->entry;
+      }
+
+      // Positions that aren't finite never score above kMinDrawCallMatchScore
+      if (!isSearchable(drawCall)) {
+        return nullptr;
+      }
+
+      float bestScore = kMinDrawCallMatchScore;
+
+      m_spatialMap.forEachInRadius(drawCall.worldPosition, kMaxDrawCallMatchDistance, [&](Entry* entry, float) {
+        const Record& record = m_records.at(entry);
+
+        if (entry->frameLastTouched == currentFrame) {
+          return true;
+        }
+
+        const float score = calcDrawCallMatchScore(drawCall, record.key);
+        if (score > bestScore || (score == bestScore && best != nullptr && record.order < best->order)) {
+          bestScore = score;
+          best = &record;
+        }
+        return true;
+      });
+
+      return best != nullptr ? best->entry : nullptr;
+    }
+
+  private:
+    struct Record {
+      Entry* entry;
+      DrawCallMatchKey key;
+      int64_t order;
+    };
+
+    // Leaves room for a run of insertions between the same two entries before orders need respacing
+    static constexpr int64_t kOrderSpacing = int64_t(1) << 16;
+
+    static XXH64_hash_t getExactHash(const DrawCallMatchKey& key) {
+      XXH64_hash_t h = XXH64(&key.materialHash, sizeof(key.materialHash), key.isSky ? 1 : 0);
+      h = XXH64(&key.fullGeometryHash, sizeof(key.fullGeometryHash), h);
+      return XXH64(&key.boneHash, sizeof(key.boneHash), h);
+    }
+
+    static bool isSearchable(const DrawCallMatchKey& key) {
+      return std::isfinite(key.worldPosition.x) && std::isfinite(key.worldPosition.y) && std::isfinite(key.worldPosition.z);
+    }
+
+    void addRecord(Entry* entry, const DrawCallMatchKey& key, int64_t order) {
+      m_records.emplace(entry, Record { entry, key, order });
+      m_exactEntries.emplace(getExactHash(key), entry);
+      if (isSearchable(key)) {
+        m_spatialMap.insert(key.worldPosition, entry);
+      }
+    }
+
+    void eraseExact(XXH64_hash_t exactHash, const Entry* entry) {
+      auto exactEntries = m_exactEntries.equal_range(exactHash);
+      for (auto iter = exactEntries.first; iter != exactEntries.second; ++iter) {
+        if (iter->second == entry) {
+          m_exactEntries.erase(iter);
+          return;
+        }
+      }
+    }
+
+    void respaceOrders() {
+      std::vector<Record*> records;
+      records.reserve(m_records.size());
+      for (auto& [entry, record] : m_records) {
+        records.push_back(&record);
+      }
+
+      std::sort(records.begin(), records.end(), [](const Record* a, const Record* b) { return a->order < b->order; });
+
+      for (size_t i = 0; i < records.size(); i++) {
+        records[i]->order = int64_t(i) * kOrderSpacing;
+      }
+    }
+
+    std::unordered_map<const Entry*, Record> m_records;
+    std::unordered_multimap<XXH64_hash_t, Entry*, XXH64_hash_passthrough> m_exactEntries;
+    SpatialMap<Entry*> m_spatialMap;
+  };
+}
@@ -26,18 +26,24 @@ namespace dxvk
 {
 
 namespace {
-  bool exactMatch(const DrawCallState& drawCall, BlasEntry& blas) {
-    auto isSky = [](CameraType::Enum t) {
-      return t == CameraType::Sky;
-    };
-
-    if (isSky(drawCall.cameraType) != isSky(blas.input.cameraType)) {
-      return false;
-    }
+  DrawCallMatchKey getMatchKey(const DrawCallState& drawCall) {
+    DrawCallMatchKey key;
+    key.materialHash = drawCall.getMaterialData().getHash();
+    key.fullGeometryHash = drawCall.getGeometryData().getHashForRule<rules::FullGeometryHash>();
+    key.vertexPositionHash = drawCall.getGeometryData().hashes[HashComponents::VertexPosition];
+    key.vertexTexcoordHash = drawCall.getGeometryData().hashes[HashComponents::VertexTexcoord];
+    key.boneHash = drawCall.getSkinningState().boneHash;
+    key.worldPosition = drawCall.getGeometryData().boundingBox.getTransformedCentroid(drawCall.getTransformData().objectToWorld);
+    key.isSky = drawCall.cameraType == CameraType::Sky;
+    return key;
+  }
 
-    return drawCall.getMaterialData().getHash() == blas.input.getMaterialData().getHash()
-        && drawCall.getGeometryData().getHashForRule<rules::FullGeometryHash>() == blas.input.getGeometryData().getHashForRule<rules::FullGeometryHash>()
-        && drawCall.getSkinningState().boneHash == blas.input.getSkinningState().boneHash;
+  DrawCallMatchKey getMatchKey(const BlasEntry& blas) {
+    // Note: vertex hashes are compared against the processed geometry, everything else against the last draw call
+    DrawCallMatchKey key = getMatchKey(blas.input);
+    key.vertexPositionHash = blas.modifiedGeometryData.hashes[HashComponents::VertexPosition];
+    key.vertexTexcoordHash = blas.modifiedGeometryData.hashes[HashComponents::VertexTexcoord];
+    return key;
   }
 }
 
@@ -46,15 +52,19 @@ DrawCallCache::DrawCallCache(DxvkDevice* device) : CommonDeviceObject(device) {
 }
 DrawCallCache::~DrawCallCache() {}
 
-DrawCallCache::CacheState DrawCallCache::get(const DrawCallState& drawCall, BlasEntry** out) {
-  // First, find the right bucket:
+DrawCallCache::CacheState DrawCallCache::get(const DrawCallState& drawCall, uint32_t currentFrame, BlasEntry** out) {
   const XXH64_hash_t hash = drawCall.getGeometryData().getHashForRule<rules::TopologicalHash>();
+
+  // First, find the right bucket:
   auto range = m_entries.equal_range(hash);
   if (range.first == m_entries.end()) {
     // New bucket
-    *out = allocateEntry(hash, drawCall);
+    *out = allocateEntry(hash, drawCall, currentFrame);
     return CacheState::kNew;
   }
+
+  const DrawCallMatchKey drawCallKey = getMatchKey(drawCall);
+
   // Handle buckets with 1 entry:
   auto iter = range.first;
   iter++;
@@ -62,12 +72,12 @@ DrawCallCache::CacheState DrawCallCache::get(const DrawCallState& drawCall, Blas
     // Only 1 element
     BlasEntry& entry = range.first->second;
 
-    const bool updatedThisFrame = entry.frameLastTouched == m_device->getCurrentFrameId();
+    const bool updatedThisFrame = entry.frameLastTouched == currentFrame;
     const bool vertexDataMatches = entry.input.getGeometryData().getHashForRule<rules::VertexDataHash>() == drawCall.getGeometryData().getHashForRule<rules::VertexDataHash>();
     const bool boneHashesMatch = entry.input.getSkinningState().boneHash == drawCall.getSkinningState().boneHash;
     const bool materialHashesMatch = entry.input.getMaterialData().getHash() == drawCall.getMaterialData().getHash();
 
-    if (exactMatch(drawCall, entry) || !updatedThisFrame && (vertexDataMatches && boneHashesMatch || materialHashesMatch)) {
+    if (isExactDrawCallMatch(drawCallKey, getMatchKey(entry)) || !updatedThisFrame && (vertexDataMatches && boneHashesMatch || materialHashesMatch)) {
       // Exact vertex match that is reusable for the current draw call,
       // or something that hasn't been updated this frame and is similar enough.
       // Matching the logic in the multi-element loop below.
@@ -76,62 +86,112 @@ DrawCallCache::CacheState DrawCallCache::get(const DrawCallState& drawCall, Blas
     } else {
       // First frame of having two mismatching instances, and the first instance has already 
       // been paired with the existing BlasEntry.
-      *out = allocateEntry(hash, drawCall);
+      *out = allocateEntry(hash, drawCall, currentFrame);
       return CacheState::kNew;
     }
   }
 
   // Bucket has multiple BlasEntries
 
-  float bestScore = std::numeric_limits<float>::min();
-  Matrix4 newTransform = drawCall.getTransformData().objectToWorld;
-  const Vector3 newWorldPosition = drawCall.getGeometryData().boundingBox.getTransformedCentroid(newTransform);
+  auto index = m_bucketIndices.find(hash);
+  if (index == m_bucketIndices.end() && size_t(std::distance(range.first, range.second)) >= kMinIndexedBucketSize) {
+    index = buildBucketIndex(hash, range.first, range.second);
+  }
 
-  for (auto bucketIter = range.first; bucketIter != range.second; bucketIter++) {
-    BlasEntry& blas  = bucketIter->second;
-    if (exactMatch(drawCall, blas)) {
-      *out = &blas;
-      return CacheState::kExisted;
-    }
-    if (blas.frameLastTouched == m_device->getCurrentFrameId()) {
-      continue;
-    }
-    // TODO these heuristics could use more refinement.
-    float score = 0;
-    if (blas.modifiedGeometryData.hashes[HashComponents::VertexPosition] == drawCall.getGeometryData().hashes[HashComponents::VertexPosition] &&
-        blas.input.getSkinningState().boneHash == drawCall.getSkinningState().boneHash) {
-      score += 1000.f;
-    }
-    if (blas.modifiedGeometryData.hashes[HashComponents::VertexTexcoord] == drawCall.getGeometryData().hashes[HashComponents::VertexTexcoord]) {
-      score += 1000.f;
-    }
-    if (blas.input.getMaterialData().getHash() == drawCall.getMaterialData().getHash()) {
-      score += 1000.f;
-    }
-    // TODO this is only checking the distance to the first instance that created the BlasEntry, not to
-    // each instance.  It also doesn't include the portal logic from InstanceManager.
-    Matrix4 oldTransform = blas.input.getTransformData().objectToWorld;
-    const Vector3 worldPosition = blas.input.getGeometryData().boundingBox.getTransformedCentroid(oldTransform);
-    score -= lengthSqr(newWorldPosition - worldPosition);
-    if (score > bestScore) {
-      bestScore = score;
-      *out = &blas;
+  if (index != m_bucketIndices.end()) {
+    // Large bucket, only look at the entries that can match
+    *out = index->second.find(drawCallKey, currentFrame);
+  } else {
+    float bestScore = kMinDrawCallMatchScore;
+
+    for (auto bucketIter = range.first; bucketIter != range.second; bucketIter++) {
+      BlasEntry& blas  = bucketIter->second;
+      const DrawCallMatchKey blasKey = getMatchKey(blas);
+      if (isExactDrawCallMatch(drawCallKey, blasKey)) {
+        *out = &blas;
+        return CacheState::kExisted;
+      }
+      if (blas.frameLastTouched == currentFrame) {
+        continue;
+      }
+      const float score = calcDrawCallMatchScore(drawCallKey, blasKey);
+      if (score > bestScore) {
+        bestScore = score;
+        *out = &blas;
+      }
     }
   }
+
   if (*out == nullptr) {
     // Failed to find similar blas, so allocate a new one
-    *out = allocateEntry(hash, drawCall);
+    *out = allocateEntry(hash, drawCall, currentFrame);
     return CacheState::kNew;
   }
   return CacheState::kExisted;
 
 }
 
-BlasEntry* DrawCallCache::allocateEntry(XXH64_hash_t hash, const DrawCallState& drawCall) {
+DrawCallCache::MultimapType::iterator DrawCallCache::erase(MultimapType::iterator iter) {
+  BlasEntry* entry = &iter->second;
+
+  auto index = m_bucketIndices.find(iter->first);
+  if (index != m_bucketIndices.end()) {
+    index->second.erase(entry);
+
+    if (index->second.size() == 0) {
+      m_bucketIndices.erase(index);
+    }
+  }
+
+  return m_entries.erase(iter);
+}
+
+void DrawCallCache::updateEntry(const BlasEntry* entry) {
+  // The entry's bucket is the one its draw call was looked up in
+  auto index = m_bucketIndices.find(entry->input.getGeometryData().getHashForRule<rules::TopologicalHash>());
+  if (index != m_bucketIndices.end()) {
+    index->second.update(entry, getMatchKey(*entry));
+  }
+}
+
+BlasEntry* DrawCallCache::allocateEntry(XXH64_hash_t hash, const DrawCallState& drawCall, uint32_t currentFrame) {
   auto iter = m_entries.emplace(hash, drawCall);
   BlasEntry* result = &iter->second;
-  result->frameCreated = m_device->getCurrentFrameId();
+  result->frameCreated = currentFrame;
+
+  auto index = m_bucketIndices.find(hash);
+  if (index != m_bucketIndices.end()) {
+    // The multimap decides where an entry goes among its equivalents, find its neighbours
+    const BlasEntry* prev = nullptr;
+    const BlasEntry* next = nullptr;
+
+    auto range = m_entries.equal_range(hash);
+    for (auto bucketIter = range.first; bucketIter != range.second; bucketIter++) {
+      if (bucketIter == iter) {
+        if (++bucketIter != range.second) {
+          next = &bucketIter->second;
+        }
+        break;
+      }
+      prev = &bucketIter->second;
+    }
+
+    index->second.insert(result, getMatchKey(*result), prev, next);
+  }
+
   return result;
 }
 
+DrawCallCache::BucketIndexMap::iterator DrawCallCache::buildBucketIndex(XXH64_hash_t hash, MultimapType::iterator begin, MultimapType::iterator end) {
+  auto index = m_bucketIndices.try_emplace(hash).first;
+
+  const BlasEntry* prev = nullptr;
+  for (auto bucketIter = begin; bucketIter != end; bucketIter++) {
+    index->second.insert(&bucketIter->second, getMatchKey(bucketIter->second), prev, nullptr);
+    prev = &bucketIter->second;
+  }
+
+  return index;
+}
+
 }  // namespace nvvk
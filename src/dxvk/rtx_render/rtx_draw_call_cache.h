@@ -30,6 +30,7 @@
 
 #include "rtx_types.h"
 #include "rtx_common_object.h"
+#include "rtx_draw_call_bucket_index.h"
 #include <d3d9types.h>
 
 namespace dxvk 
@@ -54,12 +55,20 @@ public:
   explicit DrawCallCache(DxvkDevice* device);
   ~DrawCallCache();
 
-  CacheState get(const DrawCallState& drawCall, BlasEntry** out);
+  CacheState get(const DrawCallState& drawCall, uint32_t currentFrame, BlasEntry** out);
 
+  // Must be called once an entry returned by get() has been updated with its draw call or geometry,
+  // before the next lookup, so large buckets match against the entry's current state
+  void updateEntry(const BlasEntry* entry);
+
+  // Note: entries must be removed through erase() so the bucket indices stay in sync
   MultimapType& getEntries() {return m_entries;}
 
+  MultimapType::iterator erase(MultimapType::iterator iter);
+
   void clear() {
     m_entries.clear();
+    m_bucketIndices.clear();
   }
   
   void rebuildSpatialMaps() {
@@ -69,9 +78,17 @@ public:
   }
 
 private:
+  using BucketIndex = DrawCallBucketIndex<BlasEntry>;
+  using BucketIndexMap = std::unordered_map<XXH64_hash_t, BucketIndex, XXH64_hash_passthrough>;
+
+  // Buckets with at least this many entries get an index, smaller ones are scored linearly
+  static constexpr size_t kMinIndexedBucketSize = 16;
+
   MultimapType m_entries;
+  BucketIndexMap m_bucketIndices;
 
-  BlasEntry* allocateEntry(XXH64_hash_t hash, const DrawCallState& drawCall);
+  BlasEntry* allocateEntry(XXH64_hash_t hash, const DrawCallState& drawCall, uint32_t currentFrame);
+  BucketIndexMap::iterator buildBucketIndex(XXH64_hash_t hash, MultimapType::iterator begin, MultimapType::iterator end);
 };
 
 }  // namespace nvvk
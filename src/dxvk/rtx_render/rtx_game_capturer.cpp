@@ -82,9 +82,9 @@ namespace dxvk {
       const auto& float4x4 = reinterpret_cast<const float(&)[4][4]>(mat4);
       return pxr::GfMatrix4d{pxr::GfMatrix4f(float4x4)};
     }
-    static inline pxr::VtMatrix4dArray matrix4VecToGfMatrix4dVec(const std::vector<Matrix4>& mat4s) {
-      pxr::VtMatrix4dArray result(mat4s.size());
-      for (int i = 0; i < mat4s.size(); ++i) {
+    static inline pxr::VtMatrix4dArray bonePaletteToGfMatrix4dVec(const BonePalette& mat4s) {
+      pxr::VtMatrix4dArray result(mat4s.count);
+      for (uint32_t i = 0; i < mat4s.count; ++i) {
         const auto& float4x4 = reinterpret_cast<const float(&)[4][4]>(mat4s[i]);
         result[i] = pxr::GfMatrix4d { pxr::GfMatrix4f(float4x4) };
       }
@@ -455,7 +455,7 @@ namespace dxvk {
         instance.lssData.xforms.push_back({ m_pCap->currentFrameNum, matrix4ToGfMatrix4d(pRtInstance->getTransform()) * xform });
         const SkinningData& skinData = pRtInstance->getBlas()->input.getSkinningState();
         if (skinData.numBones > 0) {
-          instance.lssData.boneXForms.push_back({ m_pCap->currentFrameNum, matrix4VecToGfMatrix4dVec(skinData.pBoneMatrices) });
+          instance.lssData.boneXForms.push_back({ m_pCap->currentFrameNum, bonePaletteToGfMatrix4dVec(skinData.bonePalette) });
         }
       }
       instance.lssData.finalTime = m_pCap->currentFrameNum;
@@ -615,7 +615,7 @@ namespace dxvk {
 
     if (bIsNewMesh && skinData.numBones > 0) {
       captureMeshBlending(ctx, rasterGeomData, m_pCap->currentFrameNum, pMesh);
-      pMesh->lssData.boneXForms = matrix4VecToGfMatrix4dVec(skinData.pBoneMatrices);
+      pMesh->lssData.boneXForms = bonePaletteToGfMatrix4dVec(skinData.bonePalette);
     }
   }
 
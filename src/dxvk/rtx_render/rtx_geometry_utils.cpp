@@ -73,6 +73,7 @@ namespace dxvk {
         STRUCTURED_BUFFER(BINDING_BLEND_INDICES_INPUT)
         RW_STRUCTURED_BUFFER(BINDING_NORMAL_OUTPUT)
         STRUCTURED_BUFFER(BINDING_NORMAL_INPUT)
+        STRUCTURED_BUFFER(BINDING_BONE_MATRICES)
       END_PARAMETER()
     };
 
@@ -227,6 +228,11 @@ namespace dxvk {
       (VkMemoryPropertyFlagBits) (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT),
       VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
 
+    m_pBoneData = std::make_unique<RtxStagingDataAlloc>(
+      device,
+      (VkMemoryPropertyFlagBits) (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
     m_skinningContext = device->createContext();
   }
 
@@ -234,9 +240,33 @@ namespace dxvk {
 
   void RtxGeometryUtils::onDestroy() {
     m_pCbData = nullptr;
+    m_pBoneData = nullptr;
+    m_uploadedBonePalettes.clear();
     m_skinningContext = nullptr;
   }
 
+  DxvkBufferSlice RtxGeometryUtils::uploadBonePalette(const BonePalette& palette) {
+    // Draws sharing a palette (the same skeleton drawn in several passes, or instances
+    // in the same pose) share the upload. All palettes of the frame are packed
+    // back to back into the bone data buffer.
+    auto it = m_uploadedBonePalettes.find(palette.key);
+
+    if (it != m_uploadedBonePalettes.end()) {
+      return it->second;
+    }
+
+    const auto& devInfo = m_skinningContext->getDevice()->properties().core.properties;
+    const VkDeviceSize alignment = devInfo.limits.minStorageBufferOffsetAlignment;
+
+    DxvkBufferSlice slice = m_pBoneData->alloc(alignment, sizeof(Matrix4) * palette.count);
+    memcpy(slice.mapPtr(0), palette.data(), sizeof(Matrix4) * palette.count);
+    m_skinningContext->getCommandList()->trackResource<DxvkAccess::Write>(slice.buffer());
+
+    m_uploadedBonePalettes.emplace(palette.key, slice);
+
+    return slice;
+  }
+
   void RtxGeometryUtils::dispatchSkinning(const DrawCallState& drawCallState,
                                           const RaytraceGeometry& geo) {
     const Rc<DxvkContext>& ctx = m_skinningContext;
@@ -251,7 +281,8 @@ namespace dxvk {
 
     assert(drawCallState.getGeometryData().blendWeightBuffer.defined());
 
-    memcpy(&params.bones[0], &drawCallState.getSkinningState().pBoneMatrices[0], sizeof(Matrix4) * drawCallState.getSkinningState().numBones);
+    const BonePalette& bonePalette = drawCallState.getSkinningState().bonePalette;
+    assert(bonePalette.count >= drawCallState.getSkinningState().numBones);
 
     params.dstPositionStride = geo.positionBuffer.stride();
     params.dstPositionOffset = geo.positionBuffer.offsetFromSlice();
@@ -303,11 +334,15 @@ namespace dxvk {
       if (drawCallState.getGeometryData().blendIndicesBuffer.defined())
         ctx->bindResourceBuffer(BINDING_BLEND_INDICES_INPUT, drawCallState.getGeometryData().blendIndicesBuffer);
 
+      const DxvkBufferSlice bones = uploadBonePalette(bonePalette);
+      ctx->bindResourceBuffer(BINDING_BONE_MATRICES, bones);
+
       ctx->bindShader(VK_SHADER_STAGE_COMPUTE_BIT, SkinningShader::getShader());
 
       const VkExtent3D workgroups = util::computeBlockCount(VkExtent3D { params.numVertices, 1, 1 }, VkExtent3D { 128, 1, 1 });
       ctx->dispatch(workgroups.width, workgroups.height, workgroups.depth);
       ctx->getCommandList()->trackResource<DxvkAccess::Read>(cb.buffer());
+      ctx->getCommandList()->trackResource<DxvkAccess::Read>(bones.buffer());
     } else {
       const float* srcPosition = reinterpret_cast<float*>(drawCallState.getGeometryData().positionBuffer.mapPtr(0));
       const float* srcNormal = reinterpret_cast<float*>(drawCallState.getGeometryData().normalBuffer.mapPtr(0));
@@ -324,7 +359,7 @@ namespace dxvk {
       float dstNormal[3];
 
       for (uint32_t idx = 0; idx < params.numVertices; idx++) {
-        skinning(idx, &dstPosition[0], &dstNormal[0], srcPosition, srcBlendWeight, srcBlendIndices, srcNormal, params);
+        skinning(idx, &dstPosition[0], &dstNormal[0], srcPosition, srcBlendWeight, srcBlendIndices, srcNormal, bonePalette.data(), params);
 
         ctx->writeToBuffer(geo.positionBuffer.buffer(), geo.positionBuffer.offsetFromSlice() + idx * geo.positionBuffer.stride(), sizeof(dstPosition), &dstPosition[0]);
         ctx->writeToBuffer(geo.normalBuffer.buffer(), geo.normalBuffer.offsetFromSlice() + idx * geo.normalBuffer.stride(), sizeof(dstNormal), &dstNormal[0]);
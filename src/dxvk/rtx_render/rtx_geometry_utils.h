@@ -48,8 +48,11 @@ namespace dxvk {
   */
   class RtxGeometryUtils : public CommonDeviceObject {
     std::unique_ptr<RtxStagingDataAlloc> m_pCbData;
+    std::unique_ptr<RtxStagingDataAlloc> m_pBoneData;
     Rc<DxvkContext> m_skinningContext;
     uint32_t m_skinningCommands = 0;
+    // Bone palettes uploaded for the skinning command list being recorded, by palette key
+    fast_unordered_cache<DxvkBufferSlice> m_uploadedBonePalettes;
 
   public:
     explicit RtxGeometryUtils(DxvkDevice* pDevice);
@@ -183,9 +186,15 @@ namespace dxvk {
       if (m_skinningContext->getCommandList() != nullptr && m_skinningCommands > 0) {
         m_skinningContext->flushCommandList();
       }
+
+      // Slices are only kept from being reused by the staging allocator while the
+      // command list that reads them is pending, upload again for the next one
+      m_uploadedBonePalettes.clear();
     }
 
   private:
+    DxvkBufferSlice uploadBonePalette(const BonePalette& palette);
+
     static uint32_t calculateNumMicroTrianglesToBake(const BakeOpacityMicromapState& bakeState, const BakeOpacityMicromapDesc& desc, const uint32_t allowedNumMicroTriangleAlignment, const float bakingWeightScale, uint32_t& availableBakingBudget);
   };
 }
@@ -103,16 +103,27 @@ namespace dxvk {
   }
 
   template<typename T>
-  XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const std::vector<T>& uniqueIndices) {
+  XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const T* uniqueIndices, const size_t uniqueIndexCount) {
     ScopedCpuProfileZone();
 
     XXH64_hash_t result = 0;
 
     constexpr bool hasIndices = std::is_same<T, uint16_t>::value || std::is_same<T, uint32_t>::value;
 
-    if (hasIndices && uniqueIndices.size() > 0) {
-      for (const T idx : uniqueIndices) {
-        const uint8_t* pData = (query.pBase + idx * query.stride);
+    if (hasIndices && uniqueIndexCount > 0) {
+      // Note: Each element is chained through the seed rather than streamed into a single XXH3 state, since
+      //       these hashes are baked into replacement assets and must stay stable.  Keep the gather fed instead.
+      constexpr size_t kPrefetchDistance = 8;
+      for (size_t i = 0; i < std::min(kPrefetchDistance, uniqueIndexCount); i++) {
+        _mm_prefetch((char const*) (query.pBase + uniqueIndices[i] * query.stride), _MM_HINT_T0);
+      }
+
+      for (size_t i = 0; i < uniqueIndexCount; i++) {
+        if (i + kPrefetchDistance < uniqueIndexCount) {
+          _mm_prefetch((char const*) (query.pBase + uniqueIndices[i + kPrefetchDistance] * query.stride), _MM_HINT_T0);
+        }
+
+        const uint8_t* pData = (query.pBase + uniqueIndices[i] * query.stride);
         result = XXH3_64bits_withSeed(pData, query.elementSize, result);
       }
     } else {
@@ -217,9 +228,9 @@ namespace dxvk {
   }
 
   // Supported template params
-  template XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const std::vector<uint16_t>& uniqueIndices);
-  template XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const std::vector<uint32_t>& uniqueIndices);
-  template XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const std::vector<int>& uniqueIndices);
+  template XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const uint16_t* uniqueIndices, const size_t uniqueIndexCount);
+  template XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const uint32_t* uniqueIndices, const size_t uniqueIndexCount);
+  template XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const int* uniqueIndices, const size_t uniqueIndexCount);
 
   template XXH64_hash_t hashIndicesLegacy<uint16_t>(const void* pIndexData, const size_t indexCount);
   template XXH64_hash_t hashIndicesLegacy<uint32_t>(const void* pIndexData, const size_t indexCount);
@@ -208,9 +208,10 @@ namespace dxvk {
     *
     *   query [in]: structure containing information about the region
     *   uniqueIndices [in]: indices (byte offsets as multiples of query.stride) to hash
+    *   uniqueIndexCount [in]: number of indices, if 0 the entire region is hashed
     */
   template<typename T>
-  XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const std::vector<T>& uniqueIndices);
+  XXH64_hash_t hashVertexRegionIndexed(const HashQuery& query, const T* uniqueIndices, const size_t uniqueIndexCount);
 
   template<typename T>
   [[deprecated("(REMIX-656): Remove this once we can transition content to new hash)")]]
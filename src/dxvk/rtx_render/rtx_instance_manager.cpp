@@ -652,32 +652,37 @@ namespace dxvk {
 
     // Search the BLAS for an instance matching ours
     {
-      const auto adjacentCells = blas.getSpatialMap().getDataNearPos(worldPosition);
-      for (const std::vector<const RtInstance*>* cellPtr : adjacentCells){
-        for (const RtInstance* instance : *cellPtr) {
-          if (instance->m_frameLastUpdated == currentFrameIdx) {
-            // If the transform is an exact match and the instance has already been touched this frame,
-            // then this is a second draw call on a single mesh.
-            const Matrix4 instanceTransform = instance->getTransform();
-            if (memcmp(&transform, &instanceTransform, sizeof(instanceTransform)) == 0) {
-              return const_cast<RtInstance*>(instance);
-            }
-          } else if (instance->m_materialHash == material.getHash()) {
-            // Instance hasn't been touched yet this frame.
+      RtInstance* exactMatch = nullptr;
+      blas.getSpatialMap().forEachNearPos(worldPosition, [&](const RtInstance* instance) {
+        if (instance->m_frameLastUpdated == currentFrameIdx) {
+          // If the transform is an exact match and the instance has already been touched this frame,
+          // then this is a second draw call on a single mesh.
+          const Matrix4 instanceTransform = instance->getTransform();
+          if (memcmp(&transform, &instanceTransform, sizeof(instanceTransform)) == 0) {
+            exactMatch = const_cast<RtInstance*>(instance);
+            return false;
+          }
+        } else if (instance->m_materialHash == material.getHash()) {
+          // Instance hasn't been touched yet this frame.
 
-            const Vector3& prevInstanceWorldPosition = instance->getSpatialCachePosition();
+          const Vector3& prevInstanceWorldPosition = instance->getSpatialCachePosition();
 
-            const float distSqr = lengthSqr(prevInstanceWorldPosition - worldPosition);
-            if (distSqr <= uniqueObjectDistanceSqr && distSqr < nearestDistSqr) {
-              if (distSqr == 0.0f) {
-                // Not going to find anything closer.
-                return const_cast<RtInstance*>(instance);
-              }
-              nearestDistSqr = distSqr;
-              result = const_cast<RtInstance*>(instance);
+          const float distSqr = lengthSqr(prevInstanceWorldPosition - worldPosition);
+          if (distSqr <= uniqueObjectDistanceSqr && distSqr < nearestDistSqr) {
+            if (distSqr == 0.0f) {
+              // Not going to find anything closer.
+              exactMatch = const_cast<RtInstance*>(instance);
+              return false;
             }
+            nearestDistSqr = distSqr;
+            result = const_cast<RtInstance*>(instance);
           }
         }
+        return true;
+      });
+
+      if (exactMatch != nullptr) {
+        return exactMatch;
       }
     }
 
@@ -76,7 +76,8 @@ namespace dxvk {
   static_assert(LIGHT_INDEX_INVALID == kNewLightIdx, "New light index must match invalid light sentinel value");
 
   LightManager::LightManager(DxvkDevice* device)
-    : CommonDeviceObject(device) {
+    : CommonDeviceObject(device)
+    , m_lightIndex(RtxOptions::Get()->getMeterToWorldUnitScale(), RtxOptions::uniqueObjectDistance()) {
     // Legacy light translation Options
     fallbackLightRadianceRef().x = std::max(fallbackLightRadiance().x, 0.0f);
     fallbackLightRadianceRef().y = std::max(fallbackLightRadiance().y, 0.0f);
@@ -96,6 +97,7 @@ namespace dxvk {
 
   void LightManager::clear() {
     m_lights.clear();
+    m_lightIndex.clear();
   }
 
   void LightManager::garbageCollectionInternal() {
@@ -103,6 +105,9 @@ namespace dxvk {
     const uint32_t framesToKeep = RtxOptions::Get()->getNumFramesToKeepLights();
     const uint32_t framesToSleep = RtxOptions::Get()->getNumFramesToPutLightsToSleep();
 
+    // Matching thresholds follow the scene scale and the unique object distance, re-bucket if either changed
+    m_lightIndex.setCellSizes(RtxOptions::Get()->getMeterToWorldUnitScale(), RtxOptions::uniqueObjectDistance());
+
     const bool forceGarbageCollection = (m_lights.size() >= RtxOptions::AntiCulling::Light::numLightsToKeep());
     for (auto it = m_lights.begin(); it != m_lights.end();) {
       const RtLight& light = it->second;
@@ -112,10 +117,12 @@ namespace dxvk {
            frameLastTouched + RtxOptions::AntiCulling::Light::numFramesToExtendLightLifetime() <= currentFrame)) {
         if (light.isChildOfMesh() || light.isDynamic || suppressLightKeeping()) {
           if (light.getFrameLastTouched() < currentFrame) {
+            m_lightIndex.erase(it->first, light);
             it = m_lights.erase(it);
             continue;
           }
         } else if ((light.isStaticCount < framesToSleep) && (frameLastTouched + framesToKeep) <= currentFrame) {
+          m_lightIndex.erase(it->first, light);
           it = m_lights.erase(it);
           continue;
         }
@@ -182,33 +189,21 @@ namespace dxvk {
         continue;
       }
 
-      float currentSimilarity = -1.f;
-      // Note: Using an iterator for the found similar light is safe here because the m_lights map will not change between where
-      // it is found and where it is accessed.
-      std::optional<decltype(m_lights)::iterator> similarLight;
-      for (auto similarLightIterator = m_lights.begin(); similarLightIterator != m_lights.end(); ++similarLightIterator) {
-        const RtLight& newLight = similarLightIterator->second;
-        // Skip comparing to old lights, this check implicitly avoids comparing the exact same light.
-        if (newLight.getBufferIdx() != kNewLightIdx || newLight.isChildOfMesh())
-          continue;
+      // Skip comparing to old lights, this check implicitly avoids comparing the exact same light.
+      const XXH64_hash_t similarLightHash = findSimilarLight(m_lights, m_lightIndex, light, RtxOptions::uniqueObjectDistance(), [](const RtLight& newLight) {
+        return newLight.getBufferIdx() == kNewLightIdx && !newLight.isChildOfMesh();
+      });
 
-        const float similarity = isSimilar(light, newLight, RtxOptions::uniqueObjectDistance());
-        // Update the cached light if it's similar.
-        if (similarity > currentSimilarity) {
-          similarLight = similarLightIterator;
-          currentSimilarity = similarity;
-        }
-      }
-
-      if (currentSimilarity >= 0 && similarLight.has_value()) {
+      if (similarLightHash != kEmptyHash) {
         // This is a dynamic light!
-        RtLight& dynamicLight = (*similarLight)->second;
+        RtLight& dynamicLight = m_lights.at(similarLightHash);
         dynamicLight.isDynamic = true;
 
         // This is the same light, so update our new light
         updateLight(light, dynamicLight);
 
         // Remove the previous frames version
+        m_lightIndex.erase(it->first, light);
         it = m_lights.erase(it);
       } else {
         ++it;
@@ -484,7 +479,6 @@ namespace dxvk {
     m_externalPrevFrameBufferIdx = std::move(externalCurrentFrameBufferIdx);
   }
 
-  static const float kNotSimilar = -1.f;
   float LightManager::isSimilar(const RtLight& a, const RtLight& b, float distanceThreshold) {
     static const float kCosAngleSimilarityThreshold = cos(5.f * kPi / 180.f);
 
@@ -593,6 +587,7 @@ namespace dxvk {
     if (lightToReplace != kEmptyHash && lightToReplace != rtLight.getInstanceHash()) {
       const auto& lightToReplaceIt = m_lights.find(lightToReplace);
       if (lightToReplaceIt != m_lights.end()) {
+        m_lightIndex.erase(lightToReplaceIt->first, lightToReplaceIt->second);
         m_lights.erase(lightToReplaceIt);
       }
     }
@@ -605,6 +600,7 @@ namespace dxvk {
           // If light transform changed, update it.
           if (foundLightIt->second.getTransformedHash() != rtLight.getTransformedHash()) {
             uint16_t bufferIdx = foundLightIt->second.getBufferIdx();
+            m_lightIndex.move(foundLightIt->first, foundLightIt->second, rtLight);
             foundLightIt->second = rtLight;
             foundLightIt->second.setBufferIdx(bufferIdx);
           }
@@ -615,6 +611,7 @@ namespace dxvk {
           // If this light hasnt moved for N frames, put it to sleep.  This is a defeat device to stop games aggressively ramping up/down intensity as lights 
           if (isStaticCount < RtxOptions::Get()->getNumFramesToPutLightsToSleep()) {
             uint16_t bufferIdx = foundLightIt->second.getBufferIdx();
+            m_lightIndex.move(foundLightIt->first, foundLightIt->second, rtLight);
             foundLightIt->second = rtLight;
             foundLightIt->second.setBufferIdx(bufferIdx);
           }
@@ -623,6 +620,7 @@ namespace dxvk {
           foundLightIt->second.isStaticCount = isStaticCount + 1;
         } else {
           uint16_t bufferIdx = foundLightIt->second.getBufferIdx();
+          m_lightIndex.move(foundLightIt->first, foundLightIt->second, rtLight);
           foundLightIt->second = rtLight;
           foundLightIt->second.setBufferIdx(bufferIdx);
         }
@@ -632,27 +630,21 @@ namespace dxvk {
       }
 
     } else {
-      //  Try find a similar light
+      //  Try find a similar light, only lights close enough to pass the similarity check are visited
+      const float kDistanceThresholdMeters = 0.02f;
+      const float kDistanceThresholdWorldUnits = kDistanceThresholdMeters * RtxOptions::Get()->getMeterToWorldUnitScale();
+
       std::optional<RtLight> similarLight;
-      float bestSimilarity = kNotSimilar;
-      for (auto&& pair : m_lights) {
-        const RtLight& light = pair.second;
-
-        // Update the cached light if it's similar.  This should catch minor perturbations in static lights (e.g. due to precision loss)
-        const float kDistanceThresholdMeters = 0.02f;
-        const float kDistanceThresholdWorldUnits = kDistanceThresholdMeters * RtxOptions::Get()->getMeterToWorldUnitScale();
-        const float thisLightsSimilarity = isSimilar(light, rtLight, kDistanceThresholdWorldUnits);
-
-        if (thisLightsSimilarity >= 0.f && thisLightsSimilarity > bestSimilarity) {
-          // Copy off light state.
-          similarLight = light;
-          bestSimilarity = thisLightsSimilarity;
-        } 
+      const XXH64_hash_t similarLightHash = findSimilarLight(m_lights, m_lightIndex, rtLight, kDistanceThresholdWorldUnits);
+      if (similarLightHash != kEmptyHash) {
+        // Copy off light state.  This should catch minor perturbations in static lights (e.g. due to precision loss)
+        similarLight = m_lights.at(similarLightHash);
       }
 
       if (similarLight.has_value()) {
         // Remove it, since we want to re-add it with a (potentially) new hash
-        m_lights.erase(similarLight->getInstanceHash());
+        m_lightIndex.erase(similarLightHash, *similarLight);
+        m_lights.erase(similarLightHash);
       }
 
       // Add as a new light (with/out updated data depending on if a similar light was found)
@@ -666,6 +658,8 @@ namespace dxvk {
       // the desired behavior.
       assert(addedSuccessfully);
 
+      m_lightIndex.insert(localLightIterator->first, rtLight);
+
       // Copy/interpolate any state we like from the similar light.
       if (similarLight.has_value())
         updateLight(similarLight.value(), localLight);
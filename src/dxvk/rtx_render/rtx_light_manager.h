@@ -29,6 +29,7 @@
 #include "rtx/utility/shader_types.h"
 #include "rtx/concept/light/light_types.h"
 #include "rtx_lights.h"
+#include "rtx_light_spatial_index.h"
 #include "rtx_camera_manager.h"
 #include "rtx_common_object.h"
 #include "rtx/pass/common_binding_indices.h"
@@ -98,9 +99,50 @@ public:
   
   uint getLightCount(uint type);
 
+  // Similarity check.
+  //  Returns -1 if not similar
+  //  Returns 0~1 if similar, higher is more similar
+  static float isSimilar(const RtLight& a, const RtLight& b, float distanceThreshold);
+
+  // Finds the light in `lights` most similar to `light`, of those `filter` accepts.  Only lights close enough
+  // to pass the similarity check are visited, through `index` which must be kept in sync with `lights`.
+  //  Returns the hash of the most similar light, or kEmptyHash if none is similar
+  template<typename Filter>
+  static XXH64_hash_t findSimilarLight(const std::unordered_map<XXH64_hash_t, RtLight>& lights, const LightSpatialIndex& index,
+                                       const RtLight& light, float distanceThreshold, Filter&& filter) {
+    XXH64_hash_t similarLightHash = kEmptyHash;
+    float bestSimilarity = kNotSimilar;
+
+    index.forEachCandidate(light, distanceThreshold, [&](XXH64_hash_t candidateHash) {
+      const auto candidateIt = lights.find(candidateHash);
+      assert(candidateIt != lights.end());
+
+      const RtLight& candidate = candidateIt->second;
+      if (!filter(candidate)) {
+        return;
+      }
+
+      const float similarity = isSimilar(candidate, light, distanceThreshold);
+      if (similarity >= 0.f && similarity > bestSimilarity) {
+        similarLightHash = candidateHash;
+        bestSimilarity = similarity;
+      }
+    });
+
+    return similarLightHash;
+  }
+
+  static XXH64_hash_t findSimilarLight(const std::unordered_map<XXH64_hash_t, RtLight>& lights, const LightSpatialIndex& index,
+                                       const RtLight& light, float distanceThreshold) {
+    return findSimilarLight(lights, index, light, distanceThreshold, [](const RtLight&) { return true; });
+  }
 
 private:
+  static constexpr float kNotSimilar = -1.f;
+
   std::unordered_map<XXH64_hash_t, RtLight> m_lights;
+  // Note: Must be kept in sync with m_lights, see LightSpatialIndex.
+  LightSpatialIndex m_lightIndex;
   // Note: A fallback light tracked seperately and handled specially to not be mixed up with
   // lights provided from the application.
   std::optional<RtLight> m_fallbackLight{};
@@ -129,10 +171,6 @@ private:
 
   void garbageCollectionInternal();
 
-  // Similarity check.
-  //  Returns -1 if not similar
-  //  Returns 0~1 if similar, higher is more similar
-  static float isSimilar(const RtLight& a, const RtLight& b, float distanceThreshold);
   static void updateLight(const RtLight& in, RtLight& out);
 
   RTX_OPTION("rtx", bool, suppressLightKeeping, false, 
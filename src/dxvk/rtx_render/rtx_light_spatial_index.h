@@ -0,0 +1,189 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <array>
+
+#include "../../util/util_spatial_map.h"
+#include "rtx/utility/shader_types.h"
+#include "rtx/concept/light/light_types.h"
+#include "rtx_lights.h"
+
+namespace dxvk {
+  // Finds the lights that may pass LightManager::isSimilar against a given light, so matching
+  // doesn't have to compare against every light.  Lights are only similar to lights of the same
+  // type, so every type is indexed separately:
+  //
+  // - Positional lights are bucketed by position twice, in a fine map sized for the small threshold
+  //   used to merge perturbed static lights, and in a coarse map sized for the distance a dynamic
+  //   light may move in a frame.  Queries use whichever map fits the requested threshold.
+  // - Distant lights are bucketed by direction, as points on the unit sphere.
+  //
+  // Entries remember the position they were indexed with, so a light has to be erased or moved
+  // with its indexed state before that state is overwritten.
+  class LightSpatialIndex {
+  public:
+    LightSpatialIndex(float fineCellSize, float coarseCellSize)
+      : m_fineCellSize(fineCellSize)
+      , m_coarseCellSize(coarseCellSize)
+      , m_fineMaps { LightMap(fineCellSize), LightMap(fineCellSize), LightMap(fineCellSize), LightMap(fineCellSize) }
+      , m_coarseMaps { LightMap(coarseCellSize), LightMap(coarseCellSize), LightMap(coarseCellSize), LightMap(coarseCellSize) }
+      , m_directionMap(kDirectionCellSize) {
+    }
+
+    void insert(XXH64_hash_t hash, const RtLight& light) {
+      const Vector3 position = getIndexPosition(light);
+
+      if (light.getType() == RtLightType::Distant) {
+        m_directionMap.insert(position, hash);
+      } else {
+        m_fineMaps[getTypeIndex(light)].insert(position, hash);
+        m_coarseMaps[getTypeIndex(light)].insert(position, hash);
+      }
+    }
+
+    void erase(XXH64_hash_t hash, const RtLight& light) {
+      const Vector3 position = getIndexPosition(light);
+
+      if (light.getType() == RtLightType::Distant) {
+        m_directionMap.erase(position, hash);
+      } else {
+        m_fineMaps[getTypeIndex(light)].erase(position, hash);
+        m_coarseMaps[getTypeIndex(light)].erase(position, hash);
+      }
+    }
+
+    // Updates the entry of a light that is about to be overwritten by `newLight`.
+    void move(XXH64_hash_t hash, const RtLight& oldLight, const RtLight& newLight) {
+      if (oldLight.getType() != newLight.getType()) {
+        erase(hash, oldLight);
+        insert(hash, newLight);
+        return;
+      }
+
+      const Vector3 oldPosition = getIndexPosition(oldLight);
+      const Vector3 newPosition = getIndexPosition(newLight);
+
+      if (oldPosition == newPosition) {
+        return;
+      }
+
+      if (newLight.getType() == RtLightType::Distant) {
+        m_directionMap.move(oldPosition, newPosition, hash);
+      } else {
+        m_fineMaps[getTypeIndex(newLight)].move(oldPosition, newPosition, hash);
+        m_coarseMaps[getTypeIndex(newLight)].move(oldPosition, newPosition, hash);
+      }
+    }
+
+    void clear() {
+      for (uint32_t i = 0; i < kPositionalTypeCount; i++) {
+        m_fineMaps[i] = LightMap(m_fineCellSize);
+        m_coarseMaps[i] = LightMap(m_coarseCellSize);
+      }
+
+      m_directionMap = LightMap(kDirectionCellSize);
+    }
+
+    // Re-buckets the positional lights if either cell size changed, e.g. after the scene scale
+    // or the unique object distance options were modified.
+    void setCellSizes(float fineCellSize, float coarseCellSize) {
+      if (fineCellSize != m_fineCellSize) {
+        m_fineCellSize = fineCellSize;
+
+        for (LightMap& map : m_fineMaps) {
+          map.rebuild(fineCellSize);
+        }
+      }
+
+      if (coarseCellSize != m_coarseCellSize) {
+        m_coarseCellSize = coarseCellSize;
+
+        for (LightMap& map : m_coarseMaps) {
+          map.rebuild(coarseCellSize);
+        }
+      }
+    }
+
+    size_t size() const {
+      size_t size = m_directionMap.size();
+
+      for (const LightMap& map : m_fineMaps) {
+        size += map.size();
+      }
+
+      return size;
+    }
+
+    // Calls `visitor(XXH64_hash_t)` for every indexed light of the same type as `light` which may be
+    // similar to it, i.e. within `distanceThreshold` for positional lights, or within the similarity
+    // angle for distant lights.  Candidates still need to be checked with LightManager::isSimilar.
+    template<typename Visitor>
+    void forEachCandidate(const RtLight& light, float distanceThreshold, Visitor&& visitor) const {
+      auto visitEntry = [&visitor](XXH64_hash_t hash, float) {
+        visitor(hash);
+        return true;
+      };
+
+      if (light.getType() == RtLightType::Distant) {
+        m_directionMap.forEachInRadius(getIndexPosition(light), kDirectionRadius, visitEntry);
+        return;
+      }
+
+      // Padded so rounding never drops a light isSimilar would accept at exactly the threshold
+      const float radius = distanceThreshold * 1.001f;
+      const LightMap& map = radius <= m_fineCellSize ? m_fineMaps[getTypeIndex(light)] : m_coarseMaps[getTypeIndex(light)];
+
+      map.forEachInRadius(getIndexPosition(light), radius, visitEntry);
+    }
+
+  private:
+    using LightMap = SpatialMap<XXH64_hash_t>;
+
+    static_assert(lightTypeDistant == lightTypeCount - 1, "Positional light types are expected to come before distant lights.");
+    static constexpr uint32_t kPositionalTypeCount = lightTypeCount - 1;
+
+    // isSimilar accepts distant lights up to 5 degrees apart, which on the unit sphere is a
+    // chord of 2 * sin(2.5 degrees) ~= 0.0872.
+    static constexpr float kDirectionRadius = 0.0875f;
+    static constexpr float kDirectionCellSize = 0.1f;
+
+    static uint32_t getTypeIndex(const RtLight& light) {
+      return static_cast<uint32_t>(light.getType());
+    }
+
+    static Vector3 getIndexPosition(const RtLight& light) {
+      if (light.getType() != RtLightType::Distant) {
+        return light.getPosition();
+      }
+
+      const Vector3 direction = light.getDirection();
+      return lengthSqr(direction) > 0.f ? normalize(direction) : direction;
+    }
+
+    float m_fineCellSize;
+    float m_coarseCellSize;
+    std::array<LightMap, kPositionalTypeCount> m_fineMaps;
+    std::array<LightMap, kPositionalTypeCount> m_coarseMaps;
+    LightMap m_directionMap;
+  };
+}
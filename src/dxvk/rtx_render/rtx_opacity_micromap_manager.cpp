@@ -69,12 +69,12 @@ namespace dxvk {
                                                      const uint32_t inputSubdivisionLevel,
                                                      const bool enableVertexAndTextureOperations,
                                                      uint32_t currentFrameIndex,
-                                                     std::list<XXH64_hash_t>::iterator _leastRecentlyUsedListIter,
+                                                     uint32_t _leastRecentlyUsedListHandle,
                                                      std::list<XXH64_hash_t>::iterator _cacheStateListIter,
                                                      const OmmRequest& ommRequest)
     : cacheState(_cacheState)
     , lastUseFrameIndex(currentFrameIndex)
-    , leastRecentlyUsedListIter(_leastRecentlyUsedListIter)
+    , leastRecentlyUsedListHandle(_leastRecentlyUsedListHandle)
     , cacheStateListIter(_cacheStateListIter)
     , isUnprocessedCacheStateListIterValid(true)
     , numTriangles(ommRequest.numTriangles)
@@ -386,7 +386,7 @@ namespace dxvk {
     if (ommCacheState <= OpacityMicromapCacheState::eStep2_Baked)
       deleteCachedSourceData(ommSrcHash, ommCacheState, destroyParentInstanceOmmRequestContainer);
 
-    m_leastRecentlyUsedList.erase(ommCacheItemIter->second.leastRecentlyUsedListIter);
+    m_leastRecentlyUsedList.removeHandle(ommCacheItemIter->second.leastRecentlyUsedListHandle);
     m_memoryManager.release(ommCacheItemIter->second.getDeviceSize());
     m_ommCache.erase(ommCacheItemIter);
   }
@@ -1128,14 +1128,13 @@ namespace dxvk {
       return false;
 
     // Place the element to the end of the LRU list, and thus marking it as most recent 
-    m_leastRecentlyUsedList.emplace_back(ommSrcHash);
-    auto lastElementIterator = std::next(m_leastRecentlyUsedList.end(), -1);
+    const uint32_t lruHandle = m_leastRecentlyUsedList.insert(ommSrcHash);
     m_ommCache.emplace(
       std::piecewise_construct,
       std::forward_as_tuple(ommSrcHash),
       std::forward_as_tuple(*m_device, OpacityMicromapCacheState::eStep0_Unprocessed, OpacityMicromapOptions::Building::subdivisionLevel(), 
                             OpacityMicromapOptions::Building::enableVertexAndTextureOperations(), m_device->getCurrentFrameId(),
-                            lastElementIterator, cacheStateListIter, ommRequest));
+                            lruHandle, cacheStateListIter, ommRequest));
 
     return true;
   }
@@ -1361,7 +1360,7 @@ namespace dxvk {
     ommCacheItem.lastUseFrameIndex = m_device->getCurrentFrameId();
 
     // Make the item most recently used
-    m_leastRecentlyUsedList.splice(m_leastRecentlyUsedList.end(), m_leastRecentlyUsedList, ommCacheItem.leastRecentlyUsedListIter);
+    m_leastRecentlyUsedList.touchHandle(ommCacheItem.leastRecentlyUsedListHandle);
 
     // Bind OMM if the data is ready
     switch (ommCacheState) {
@@ -2156,17 +2155,14 @@ namespace dxvk {
         if (m_amountOfMemoryMissing > 0) {
 
           // Start evicting least recently used items 
-          for (auto lruOmmSrcHashIter = m_leastRecentlyUsedList.begin();
-               lruOmmSrcHashIter != m_leastRecentlyUsedList.end() && m_amountOfMemoryMissing > m_memoryManager.calculatePendingAvailableSize();
-               ) {
-            auto cacheItemIter = m_ommCache.find(*lruOmmSrcHashIter);
+          m_leastRecentlyUsedList.evictWhile([&](XXH64_hash_t lruOmmSrcHash) {
+            if (m_amountOfMemoryMissing <= m_memoryManager.calculatePendingAvailableSize())
+              return false;
+
+            auto cacheItemIter = m_ommCache.find(lruOmmSrcHash);
             if (cacheItemIter == m_ommCache.end()) {
-              auto iterToDelete = lruOmmSrcHashIter;
-              // Increment the iterator before any deletion
-              lruOmmSrcHashIter++;
               ONCE(Logger::err("[RTX] Failed to find Opacity Micromap cache entry on LRU eviction"));
-              m_leastRecentlyUsedList.erase(iterToDelete);
-              continue;
+              return true;
             }
 
             const uint32_t cacheItemUsageFrameAge = currentFrameIndex - cacheItemIter->second.lastUseFrameIndex;
@@ -2175,13 +2171,12 @@ namespace dxvk {
             if (cacheItemUsageFrameAge < OpacityMicromapOptions::Cache::minUsageFrameAgeBeforeEviction() &&
               // Force eviction if the VRAM budget decreased to speed fitting into the budget up
               !hasVRamBudgetDecreased)
-              break;
-
-            // Increment the iterator before any deletion
-            lruOmmSrcHashIter++;
+              return false;
 
+            // Also unlinks the item from the LRU list
             destroyOmmData(cacheItemIter);
-          }
+            return true;
+          });
         }
       } else { // budget == 0
         if (prevBudget > 0)
@@ -22,6 +22,7 @@
 #pragma once
 
 #include "../util/rc/util_rc_ptr.h"
+#include "../util/util_lru.h"
 #include "rtx_types.h"
 #include "rtx_geometry_utils.h"
 #include "rtx_option.h"
@@ -256,7 +257,7 @@ namespace dxvk {
     uint16_t subdivisionLevel = UINT16_MAX;
     uint32_t numTriangles = UINT32_MAX;
     VkOpacityMicromapFormatEXT ommFormat = VK_OPACITY_MICROMAP_FORMAT_2_STATE_EXT;
-    std::list<XXH64_hash_t>::iterator leastRecentlyUsedListIter;
+    uint32_t leastRecentlyUsedListHandle = UINT32_MAX;
 
     // Iterator to a cache state list for the current cacheState.
     // Since the iterator is moved between the lists, it is initalized only once
@@ -278,7 +279,7 @@ namespace dxvk {
 
     OpacityMicromapCacheItem();
     OpacityMicromapCacheItem(DxvkDevice& device, OpacityMicromapCacheState _cacheState, const uint32_t subdivisionLevel, const bool enableVertexAndTextureOperations,     
-                             uint32_t currentFrameIndex, std::list<XXH64_hash_t>::iterator _mostRecentlyUsedListIter, std::list<XXH64_hash_t>::iterator _cacheStateListIter,
+                             uint32_t currentFrameIndex, uint32_t _leastRecentlyUsedListHandle, std::list<XXH64_hash_t>::iterator _cacheStateListIter,
                              const OmmRequest& ommRequest);
     OpacityMicromapCacheItem(const OpacityMicromapCacheItem& src) 
     : cacheState(src.cacheState)
@@ -287,7 +288,7 @@ namespace dxvk {
     , useVertexAndTextureOperations(src.useVertexAndTextureOperations)
     , subdivisionLevel(src.subdivisionLevel)
     , ommFormat(src.ommFormat)
-    , leastRecentlyUsedListIter(src.leastRecentlyUsedListIter)
+    , leastRecentlyUsedListHandle(src.leastRecentlyUsedListHandle)
     , cacheStateListIter(src.cacheStateListIter)
     , isUnprocessedCacheStateListIterValid(src.isUnprocessedCacheStateListIterValid) { }
 
@@ -530,7 +531,7 @@ namespace dxvk {
     uint32_t m_numMicroTrianglesBuilt = 0;    // Per frame
 
     // LRU management
-    std::list<XXH64_hash_t> m_leastRecentlyUsedList;  // Items stored in their usage order starting with least recently used item
+    lru_list<XXH64_hash_t, fast_flat_cache<uint32_t>> m_leastRecentlyUsedList;  // Items stored in their usage order starting with least recently used item
 
     fast_unordered_cache<OMMBuildRequestStatistics> m_ommBuildRequestStatistics;
 
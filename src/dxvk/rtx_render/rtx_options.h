@@ -851,6 +851,12 @@ namespace dxvk {
                "A flag controlling if the partial DDS loader should be used, true to enable, false to disable and use GLI instead.\n"
                "Generally this should be always enabled as it allows for simple parsing of DDS header information without loading the entire texture into memory like GLI does to retrieve similar information.\n"
                "Should only be set to false for debugging purposes if the partial DDS loader's logic is suspected to be incorrect to compare against GLI's implementation.");
+    RTX_OPTION("rtx", bool, useMemoryMappedAssetPackages, true,
+               "A flag controlling if asset packages should be memory mapped, allowing uncompressed data blobs to be read in place rather than copied through file reads.\n"
+               "Falls back to regular file reads when a package cannot be mapped.\n"
+               "Without RTX IO this also mounts asset packages so their uncompressed assets are loaded on the CPU, with the blobs of a texture read in parallel.");
+    RTX_OPTION("rtx", bool, validateAssetPackageBlobs, false,
+               "A flag controlling if data blobs read from asset packages should be checked against their stored CRC-32 checksum, blobs failing the check are rejected.");
 
     RTX_OPTION("rtx", TonemappingMode, tonemappingMode, TonemappingMode::Local,
                "The tonemapping type to use, 0 for Global, 1 for Local (Default).\n"
@@ -88,11 +88,17 @@ namespace {
 
 
   // from rtx_mod_usd.cpp
-  XXH64_hash_t hack_getNextGeomHash() {
+  // Reserves 'count' geometry hashes under a single lock, retrieve them with hack_getGeomHash
+  uint64_t hack_reserveGeomHashes(uint64_t count) {
     static uint64_t s_id = UINT64_MAX;
     std::lock_guard lock { s_mutex };
-    --s_id;
-    return XXH64(&s_id, sizeof(s_id), 0);
+    s_id -= count;
+    return s_id + count;
+  }
+
+  XXH64_hash_t hack_getGeomHash(uint64_t reservedBase, uint64_t index) {
+    const uint64_t id = reservedBase - 1 - index;
+    return XXH64(&id, sizeof(id), 0);
   }
 
 
@@ -713,10 +719,11 @@ dxvk::ExternalDrawState dxvk::RemixAPIPrivateAccessor::toRtDrawState(const remix
     prototype.skinningData.minBoneIndex = 0;
     prototype.skinningData.numBones = boneCount;
     prototype.skinningData.numBonesPerVertex = prototype.geometryData.numBonesPerVertex;
-    prototype.skinningData.pBoneMatrices.resize(boneCount);
+    std::vector<Matrix4> boneMatrices(boneCount);
     for (uint32_t boneIdx = 0; boneIdx < boneCount; boneIdx++) {
-      prototype.skinningData.pBoneMatrices[boneIdx] = convert::tomat4(extBones->boneTransforms_values[boneIdx]);
+      boneMatrices[boneIdx] = convert::tomat4(extBones->boneTransforms_values[boneIdx]);
     }
+    prototype.skinningData.bonePalette = BonePalette::create(boneMatrices.data(), boneCount);
   }
 
   if (auto extBlend = pnext::find<remixapi_InstanceInfoBlendEXT>(&info)) {
@@ -943,140 +950,234 @@ namespace {
     return REMIXAPI_ERROR_CODE_REMIX_DEVICE_WAS_NOT_REGISTERED;
   }
 
-  remixapi_ErrorCode REMIXAPI_CALL remixapi_CreateMesh(
-    const remixapi_MeshInfo* info,
-    remixapi_MeshHandle* out_handle) {
-    dxvk::D3D9DeviceEx* remixDevice = tryAsDxvk();
-    if (!remixDevice) {
-      return REMIXAPI_ERROR_CODE_REMIX_DEVICE_WAS_NOT_REGISTERED;
-    }
-    if (!out_handle || !info || info->sType != REMIXAPI_STRUCT_TYPE_MESH_INFO) {
-      return REMIXAPI_ERROR_CODE_INVALID_ARGUMENTS;
+  // Geometry hashes generated per surface, see hack_getGeomHash
+  constexpr uint64_t kGeomHashesPerSurface = 4;
+
+  // Converts a batch of meshes into raster geometry. All surfaces of the batch are packed into one
+  // host visible buffer, so the buffer stays alive until every mesh of the batch has been destroyed.
+  std::vector<std::vector<dxvk::RasterGeometry>> toRtMeshes(
+    dxvk::D3D9DeviceEx* remixDevice,
+    const remixapi_MeshInfo* infos,
+    uint32_t infoCount) {
+    constexpr size_t kNoData = ~size_t(0);
+
+    struct SurfaceLayout {
+      size_t vertexOffset;
+      size_t indexOffset;
+      size_t blendWeightsOffset;
+      size_t blendIndicesOffset;
+      size_t blendWeightsSize;
+      size_t blendIndicesSize;
+    };
+
+    const auto& limits = remixDevice->GetDXVKDevice()->properties().core.properties.limits;
+    const size_t alignment = std::max<size_t>(limits.minStorageBufferOffsetAlignment, dxvk::CACHE_LINE_SIZE);
+
+    // Lay out every surface of the batch in a single allocation
+    size_t totalSize = 0;
+    auto suballocate = [&totalSize, alignment](size_t size) {
+      if (size == 0) {
+        return kNoData;
+      }
+      const size_t offset = dxvk::align(totalSize, alignment);
+      totalSize = offset + size;
+      return offset;
+    };
+
+    std::vector<SurfaceLayout> layouts;
+    for (uint32_t m = 0; m < infoCount; m++) {
+      for (size_t i = 0; i < infos[m].surfaces_count; i++) {
+        const remixapi_MeshInfoSurfaceTriangles& src = infos[m].surfaces_values[i];
+
+        SurfaceLayout layout {};
+        layout.vertexOffset = suballocate(sizeInBytes(src.vertices_values, src.vertices_count));
+        layout.indexOffset = suballocate(sizeInBytes(src.indices_values, src.indices_count));
+        layout.blendWeightsOffset = kNoData;
+        layout.blendIndicesOffset = kNoData;
+        if (src.skinning_hasvalue) {
+          const size_t wordsPerCompressedTuple = dxvk::divCeil(src.skinning_value.bonesPerVertex, 4u);
+          layout.blendWeightsSize = sizeInBytes(src.skinning_value.blendWeights_values, src.skinning_value.blendWeights_count);
+          layout.blendIndicesSize = src.vertices_count * wordsPerCompressedTuple * sizeof(uint32_t);
+          layout.blendWeightsOffset = suballocate(layout.blendWeightsSize);
+          layout.blendIndicesOffset = suballocate(layout.blendIndicesSize);
+        }
+        layouts.push_back(layout);
+      }
     }
-    static_assert(sizeof(remixapi_MeshHandle) == sizeof(info->hash));
-    auto handle = reinterpret_cast<remixapi_MeshHandle>(info->hash);
-    if (!handle) {
-      return REMIXAPI_ERROR_CODE_INVALID_HASH;
+
+    dxvk::Rc<dxvk::DxvkBuffer> buffer;
+    if (totalSize > 0) {
+      auto bufferInfo = dxvk::DxvkBufferCreateInfo {};
+      {
+        bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
+        bufferInfo.stages = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR;
+        bufferInfo.access = VK_ACCESS_TRANSFER_WRITE_BIT;
+        bufferInfo.size = dxvk::align(totalSize, dxvk::CACHE_LINE_SIZE);
+      }
+      buffer = remixDevice->GetDXVKDevice()->createBuffer(
+        bufferInfo,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+        dxvk::DxvkMemoryStats::Category::RTXBuffer);
     }
 
-    auto allocatedSurfaces = std::vector<dxvk::RasterGeometry> {};
+    auto sliceOf = [&buffer](size_t offset, size_t size) {
+      return offset != kNoData ? dxvk::DxvkBufferSlice { buffer, offset, size } : dxvk::DxvkBufferSlice {};
+    };
 
-    for (size_t i = 0; i < info->surfaces_count; i++) {
-      const remixapi_MeshInfoSurfaceTriangles& src = info->surfaces_values[i];
+    const uint64_t geomHashBase = hack_reserveGeomHashes(layouts.size() * kGeomHashesPerSurface);
 
-      const size_t vertexDataSize = sizeInBytes(src.vertices_values, src.vertices_count);
-      const size_t indexDataSize = sizeInBytes(src.indices_values, src.indices_count);
+    std::vector<std::vector<dxvk::RasterGeometry>> meshes(infoCount);
+    size_t surfaceIndex = 0;
 
-      auto allocBuffer = [](dxvk::D3D9DeviceEx* device, size_t sizeInBytes) -> dxvk::Rc<dxvk::DxvkBuffer> {
-        if (sizeInBytes == 0) {
-          return {};
+    for (uint32_t m = 0; m < infoCount; m++) {
+      meshes[m].reserve(infos[m].surfaces_count);
+
+      for (size_t i = 0; i < infos[m].surfaces_count; i++, surfaceIndex++) {
+        const remixapi_MeshInfoSurfaceTriangles& src = infos[m].surfaces_values[i];
+        const SurfaceLayout& layout = layouts[surfaceIndex];
+
+        const size_t vertexDataSize = sizeInBytes(src.vertices_values, src.vertices_count);
+        const size_t indexDataSize = sizeInBytes(src.indices_values, src.indices_count);
+
+        auto vertexSlice = sliceOf(layout.vertexOffset, vertexDataSize);
+        if (vertexDataSize > 0) {
+          memcpy(vertexSlice.mapPtr(0), src.vertices_values, vertexDataSize);
         }
-        auto bufferInfo = dxvk::DxvkBufferCreateInfo {};
-        {
-          bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
-          bufferInfo.stages = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR;
-          bufferInfo.access = VK_ACCESS_TRANSFER_WRITE_BIT;
-          bufferInfo.size = dxvk::align(sizeInBytes, dxvk::CACHE_LINE_SIZE);
+
+        auto indexSlice = sliceOf(layout.indexOffset, indexDataSize);
+        if (indexDataSize > 0) {
+          memcpy(indexSlice.mapPtr(0), src.indices_values, indexDataSize);
         }
-        return device->GetDXVKDevice()->createBuffer(
-            bufferInfo,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
-            dxvk::DxvkMemoryStats::Category::RTXBuffer);
-      };
 
-      dxvk::Rc<dxvk::DxvkBuffer> vertexBuffer = allocBuffer(remixDevice, vertexDataSize);
-      dxvk::Rc<dxvk::DxvkBuffer> indexBuffer = allocBuffer(remixDevice, indexDataSize);
-      dxvk::Rc<dxvk::DxvkBuffer> skinningBuffer = nullptr;
+        auto blendWeightsSlice = dxvk::DxvkBufferSlice {};
+        auto blendIndicesSlice = dxvk::DxvkBufferSlice {};
+        if (src.skinning_hasvalue) {
+          const uint32_t bonesPerVertex = src.skinning_value.bonesPerVertex;
+          const size_t wordsPerCompressedTuple = dxvk::divCeil(bonesPerVertex, 4u);
 
-      auto vertexSlice = dxvk::DxvkBufferSlice { vertexBuffer };
-      memcpy(vertexSlice.mapPtr(0), src.vertices_values, vertexDataSize);
+          blendWeightsSlice = sliceOf(layout.blendWeightsOffset, layout.blendWeightsSize);
+          blendIndicesSlice = sliceOf(layout.blendIndicesOffset, layout.blendIndicesSize);
 
-      auto indexSlice = dxvk::DxvkBufferSlice {};
-      if (indexDataSize > 0) {
-        indexSlice = dxvk::DxvkBufferSlice { indexBuffer };
-        memcpy(indexSlice.mapPtr(0), src.indices_values, indexDataSize);
-      }
+          if (layout.blendWeightsSize > 0) {
+            memcpy(blendWeightsSlice.mapPtr(0), src.skinning_value.blendWeights_values, layout.blendWeightsSize);
+          }
 
-      auto blendWeightsSlice = dxvk::DxvkBufferSlice {};
-      auto blendIndicesSlice = dxvk::DxvkBufferSlice {};
-      if (src.skinning_hasvalue) {
-        size_t wordsPerCompressedTuple = dxvk::divCeil(src.skinning_value.bonesPerVertex, 4u);
-        size_t sizeInBytes_weights = sizeInBytes(src.skinning_value.blendWeights_values, src.skinning_value.blendWeights_count);
-        size_t sizeInBytes_indices = src.vertices_count * wordsPerCompressedTuple * sizeof(uint32_t);
-
-        skinningBuffer = allocBuffer(remixDevice, sizeInBytes_weights + sizeInBytes_indices);
-
-        // Encode bone indices into compressed byte form
-        auto compressedBlendIndices = std::vector<uint32_t> {};
-        compressedBlendIndices.resize(src.vertices_count * wordsPerCompressedTuple);
-        for (size_t vert = 0; vert < src.vertices_count; vert++) {
-          const uint32_t* dstCompressed = &compressedBlendIndices[vert * wordsPerCompressedTuple];
-          const uint32_t* blendIndicesStorage = &src.skinning_value.blendIndices_values[vert * src.skinning_value.bonesPerVertex];
-
-          for (int j = 0; j < src.skinning_value.bonesPerVertex; j += 4) {
-            uint32_t vertIndices = 0;
-            for (int k = 0; k < 4 && j + k < src.skinning_value.bonesPerVertex; ++k) {
-              vertIndices |= blendIndicesStorage[j + k] << 8 * k;
+          // Encode bone indices into compressed byte form, straight into the mapped buffer
+          if (layout.blendIndicesSize > 0) {
+            uint32_t* compressedBlendIndices = static_cast<uint32_t*>(blendIndicesSlice.mapPtr(0));
+            for (size_t vert = 0; vert < src.vertices_count; vert++) {
+              uint32_t* dstCompressed = &compressedBlendIndices[vert * wordsPerCompressedTuple];
+              const uint32_t* blendIndicesStorage = &src.skinning_value.blendIndices_values[vert * bonesPerVertex];
+
+              for (uint32_t j = 0; j < bonesPerVertex; j += 4) {
+                uint32_t vertIndices = 0;
+                for (uint32_t k = 0; k < 4 && j + k < bonesPerVertex; ++k) {
+                  vertIndices |= blendIndicesStorage[j + k] << 8 * k;
+                }
+                dstCompressed[j / 4] = vertIndices;
+              }
             }
-            *(uint32_t*) &dstCompressed[j / 4] = vertIndices;
           }
         }
 
-        assert(sizeInBytes_indices == compressedBlendIndices.size() * sizeof(compressedBlendIndices[0]));
-
-        blendWeightsSlice = dxvk::DxvkBufferSlice { skinningBuffer, 0, sizeInBytes_weights };
-        blendIndicesSlice = dxvk::DxvkBufferSlice { skinningBuffer, sizeInBytes_weights, sizeInBytes_indices };
+        auto dst = dxvk::RasterGeometry {};
+        {
+          dst.externalMaterial = src.material;
+          dst.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+          dst.cullMode = VK_CULL_MODE_NONE; // this will be overwritten by the instance info at draw time
+          dst.frontFace = VK_FRONT_FACE_CLOCKWISE;
+          dst.vertexCount = src.vertices_count; assert(src.vertices_count < std::numeric_limits<uint32_t>::max());
+          dst.positionBuffer = dxvk::RasterBuffer { vertexSlice, offsetof(remixapi_HardcodedVertex, position), sizeof(remixapi_HardcodedVertex), VK_FORMAT_R32G32B32_SFLOAT };
+          dst.normalBuffer =
+            (src.flags & REMIXAPI_MESH_INFO_SURFACE_TRIANGLES_BIT_USE_TRIANGLE_NORMALS)
+              ? dxvk::RasterBuffer{}
+              : dxvk::RasterBuffer{ vertexSlice, offsetof(remixapi_HardcodedVertex, normal), sizeof(remixapi_HardcodedVertex), VK_FORMAT_R32G32B32_SFLOAT };
+          dst.texcoordBuffer = dxvk::RasterBuffer { vertexSlice, offsetof(remixapi_HardcodedVertex, texcoord), sizeof(remixapi_HardcodedVertex), VK_FORMAT_R32G32_SFLOAT };
+          dst.color0Buffer = dxvk::RasterBuffer { vertexSlice, offsetof(remixapi_HardcodedVertex, color), sizeof(remixapi_HardcodedVertex), VK_FORMAT_B8G8R8A8_UNORM };
+          if (src.skinning_hasvalue) {
+            dst.numBonesPerVertex = src.skinning_value.bonesPerVertex;
+            dst.blendWeightBuffer = dxvk::RasterBuffer { blendWeightsSlice, 0, sizeof(float), VK_FORMAT_R32_SFLOAT };
+            dst.blendIndicesBuffer = dxvk::RasterBuffer { blendIndicesSlice, 0, sizeof(uint32_t), VK_FORMAT_R8G8B8A8_USCALED };
+          }
 
-        memcpy(blendWeightsSlice.mapPtr(0), src.skinning_value.blendWeights_values, sizeInBytes_weights);
-        memcpy(blendIndicesSlice.mapPtr(0), compressedBlendIndices.data(), sizeInBytes_indices);
+          dst.indexCount = src.indices_count;
+          static_assert(sizeof(src.indices_values[0]) == 4);
+          dst.indexBuffer =
+            indexSlice.defined()
+              ? dxvk::RasterBuffer{ indexSlice, 0, sizeof(uint32_t), VK_INDEX_TYPE_UINT32 }
+              : dxvk::RasterBuffer{};
+          // look comments in UsdMod::Impl::processMesh, rtx_mod_usd.cpp
+          const uint64_t firstHash = surfaceIndex * kGeomHashesPerSurface;
+          dst.hashes[dxvk::HashComponents::Indices] = dst.hashes[dxvk::HashComponents::VertexPosition] = hack_getGeomHash(geomHashBase, firstHash + 0);
+          dst.hashes[dxvk::HashComponents::VertexTexcoord] = hack_getGeomHash(geomHashBase, firstHash + 1);
+          dst.hashes[dxvk::HashComponents::GeometryDescriptor] = hack_getGeomHash(geomHashBase, firstHash + 2);
+          dst.hashes[dxvk::HashComponents::VertexLayout] = hack_getGeomHash(geomHashBase, firstHash + 3);
+          dst.hashes.precombine();
+        }
+        meshes[m].push_back(std::move(dst));
       }
+    }
 
-      auto dst = dxvk::RasterGeometry {};
-      {
-        dst.externalMaterial = src.material;
-        dst.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-        dst.cullMode = VK_CULL_MODE_NONE; // this will be overwritten by the instance info at draw time
-        dst.frontFace = VK_FRONT_FACE_CLOCKWISE;
-        dst.vertexCount = src.vertices_count; assert(src.vertices_count < std::numeric_limits<uint32_t>::max());
-        dst.positionBuffer = dxvk::RasterBuffer { vertexSlice, offsetof(remixapi_HardcodedVertex, position), sizeof(remixapi_HardcodedVertex), VK_FORMAT_R32G32B32_SFLOAT };
-        dst.normalBuffer =
-          (src.flags & REMIXAPI_MESH_INFO_SURFACE_TRIANGLES_BIT_USE_TRIANGLE_NORMALS)
-            ? dxvk::RasterBuffer{}
-            : dxvk::RasterBuffer{ vertexSlice, offsetof(remixapi_HardcodedVertex, normal), sizeof(remixapi_HardcodedVertex), VK_FORMAT_R32G32B32_SFLOAT };
-        dst.texcoordBuffer = dxvk::RasterBuffer { vertexSlice, offsetof(remixapi_HardcodedVertex, texcoord), sizeof(remixapi_HardcodedVertex), VK_FORMAT_R32G32_SFLOAT };
-        dst.color0Buffer = dxvk::RasterBuffer { vertexSlice, offsetof(remixapi_HardcodedVertex, color), sizeof(remixapi_HardcodedVertex), VK_FORMAT_B8G8R8A8_UNORM };
-        if (src.skinning_hasvalue) {
-          dst.numBonesPerVertex = src.skinning_value.bonesPerVertex;
-          dst.blendWeightBuffer = dxvk::RasterBuffer { blendWeightsSlice, 0, sizeof(float), VK_FORMAT_R32_SFLOAT };;
-          dst.blendIndicesBuffer = dxvk::RasterBuffer { blendIndicesSlice, 0, sizeof(uint32_t), VK_FORMAT_R8G8B8A8_USCALED };
-        }
+    return meshes;
+  }
 
-        dst.indexCount = src.indices_count;
-        static_assert(sizeof(src.indices_values[0]) == 4);
-        dst.indexBuffer =
-          indexSlice.defined()
-            ? dxvk::RasterBuffer{ indexSlice, 0, sizeof(uint32_t), VK_INDEX_TYPE_UINT32 }
-            : dxvk::RasterBuffer{};
-        // look comments in UsdMod::Impl::processMesh, rtx_mod_usd.cpp
-        dst.hashes[dxvk::HashComponents::Indices] = dst.hashes[dxvk::HashComponents::VertexPosition] = hack_getNextGeomHash();
-        dst.hashes[dxvk::HashComponents::VertexTexcoord] = hack_getNextGeomHash();
-        dst.hashes[dxvk::HashComponents::GeometryDescriptor] = hack_getNextGeomHash();
-        dst.hashes[dxvk::HashComponents::VertexLayout] = hack_getNextGeomHash();
-        dst.hashes.precombine();
+  remixapi_ErrorCode REMIXAPI_CALL remixapi_CreateMeshes(
+    const remixapi_MeshInfo* infos_values,
+    uint32_t infos_count,
+    remixapi_MeshHandle* out_handles) {
+    dxvk::D3D9DeviceEx* remixDevice = tryAsDxvk();
+    if (!remixDevice) {
+      return REMIXAPI_ERROR_CODE_REMIX_DEVICE_WAS_NOT_REGISTERED;
+    }
+    if (infos_count == 0) {
+      return REMIXAPI_ERROR_CODE_SUCCESS;
+    }
+    if (!out_handles || !infos_values) {
+      return REMIXAPI_ERROR_CODE_INVALID_ARGUMENTS;
+    }
+    static_assert(sizeof(remixapi_MeshHandle) == sizeof(infos_values->hash));
+    // Validate the whole batch up front, so nothing is created if any of it is invalid
+    for (uint32_t m = 0; m < infos_count; m++) {
+      if (infos_values[m].sType != REMIXAPI_STRUCT_TYPE_MESH_INFO) {
+        return REMIXAPI_ERROR_CODE_INVALID_ARGUMENTS;
+      }
+      if (!infos_values[m].hash) {
+        return REMIXAPI_ERROR_CODE_INVALID_HASH;
       }
-      allocatedSurfaces.push_back(std::move(dst));
     }
+
+    auto meshes = toRtMeshes(remixDevice, infos_values, infos_count);
+
+    auto handles = std::vector<remixapi_MeshHandle>(infos_count);
+    for (uint32_t m = 0; m < infos_count; m++) {
+      handles[m] = reinterpret_cast<remixapi_MeshHandle>(infos_values[m].hash);
+      out_handles[m] = handles[m];
+    }
+
     std::lock_guard lock { s_mutex };
 
-    remixDevice->EmitCs([cHandle = handle, cSurfaces = std::move(allocatedSurfaces)](dxvk::DxvkContext* ctx) mutable {
+    remixDevice->EmitCs([cHandles = std::move(handles), cMeshes = std::move(meshes)](dxvk::DxvkContext* ctx) mutable {
       auto& assets = ctx->getCommonObjects()->getSceneManager().getAssetReplacer();
-      assets->registerExternalMesh(cHandle, std::move(cSurfaces));
+      for (size_t m = 0; m < cHandles.size(); m++) {
+        assets->registerExternalMesh(cHandles[m], std::move(cMeshes[m]));
+      }
     });
 
-    *out_handle = handle;
     return REMIXAPI_ERROR_CODE_SUCCESS;
   }
 
+  remixapi_ErrorCode REMIXAPI_CALL remixapi_CreateMesh(
+    const remixapi_MeshInfo* info,
+    remixapi_MeshHandle* out_handle) {
+    if (!out_handle || !info || info->sType != REMIXAPI_STRUCT_TYPE_MESH_INFO) {
+      if (!tryAsDxvk()) {
+        return REMIXAPI_ERROR_CODE_REMIX_DEVICE_WAS_NOT_REGISTERED;
+      }
+      return REMIXAPI_ERROR_CODE_INVALID_ARGUMENTS;
+    }
+    return remixapi_CreateMeshes(info, 1, out_handle);
+  }
+
   remixapi_ErrorCode REMIXAPI_CALL remixapi_DestroyMesh(
     remixapi_MeshHandle handle) {
     dxvk::D3D9DeviceEx* remixDevice = tryAsDxvk();
@@ -1143,6 +1244,37 @@ namespace {
     return REMIXAPI_ERROR_CODE_SUCCESS;
   }
 
+  remixapi_ErrorCode REMIXAPI_CALL remixapi_DrawInstances(
+    const remixapi_InstanceInfo* infos_values,
+    uint32_t infos_count) {
+    dxvk::D3D9DeviceEx* remixDevice = tryAsDxvk();
+    if (!remixDevice) {
+      return REMIXAPI_ERROR_CODE_REMIX_DEVICE_WAS_NOT_REGISTERED;
+    }
+    if (infos_count == 0) {
+      return REMIXAPI_ERROR_CODE_SUCCESS;
+    }
+    if (!infos_values) {
+      return REMIXAPI_ERROR_CODE_INVALID_ARGUMENTS;
+    }
+
+    // Convert outside of the lock, then submit the whole batch as one CS command
+    auto drawStates = std::vector<dxvk::ExternalDrawState> {};
+    drawStates.reserve(infos_count);
+    for (uint32_t i = 0; i < infos_count; i++) {
+      drawStates.push_back(convert::toRtDrawState(infos_values[i]));
+    }
+
+    std::lock_guard lock { s_mutex };
+    remixDevice->EmitCs([cRtDrawStates = std::move(drawStates)](dxvk::DxvkContext* dxvkCtx) mutable {
+      auto* ctx = static_cast<dxvk::RtxContext*>(dxvkCtx);
+      for (dxvk::ExternalDrawState& drawState : cRtDrawStates) {
+        ctx->commitExternalGeometryToRT(std::move(drawState));
+      }
+    });
+    return REMIXAPI_ERROR_CODE_SUCCESS;
+  }
+
   D3DMATRIX withNewViewerPosition(const D3DMATRIX* pViewMatrix, const remixapi_Float3D& newPosition) {
     auto l_dot = [](const float(&a)[3], const float(&b)[3]) {
       return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
@@ -1454,6 +1586,38 @@ namespace {
     return REMIXAPI_ERROR_CODE_SUCCESS;
   }
 
+  remixapi_ErrorCode REMIXAPI_CALL remixapi_DrawLightInstances(
+    const remixapi_LightHandle* lightHandles_values,
+    uint32_t lightHandles_count) {
+    dxvk::D3D9DeviceEx* remixDevice = tryAsDxvk();
+    if (!remixDevice) {
+      return REMIXAPI_ERROR_CODE_REMIX_DEVICE_WAS_NOT_REGISTERED;
+    }
+    if (lightHandles_count == 0) {
+      return REMIXAPI_ERROR_CODE_SUCCESS;
+    }
+    if (!lightHandles_values) {
+      return REMIXAPI_ERROR_CODE_INVALID_ARGUMENTS;
+    }
+    for (uint32_t i = 0; i < lightHandles_count; i++) {
+      if (!lightHandles_values[i]) {
+        return REMIXAPI_ERROR_CODE_INVALID_ARGUMENTS;
+      }
+    }
+
+    auto lightHandles = std::vector<remixapi_LightHandle>(lightHandles_values, lightHandles_values + lightHandles_count);
+
+    std::lock_guard lock { s_mutex };
+    remixDevice->EmitCs([cLightHandles = std::move(lightHandles)](dxvk::DxvkContext* ctx) {
+      auto& lightMgr = ctx->getCommonObjects()->getSceneManager().getLightManager();
+      for (remixapi_LightHandle lightHandle : cLightHandles) {
+        lightMgr.addExternalLightInstance(lightHandle);
+      }
+    });
+
+    return REMIXAPI_ERROR_CODE_SUCCESS;
+  }
+
   remixapi_ErrorCode REMIXAPI_CALL remixapi_SetConfigVariable(
     const char* key,
     const char* value) {
@@ -1960,8 +2124,11 @@ extern "C"
       interf.dxvk_SetDefaultOutput = remixapi_dxvk_SetDefaultOutput;
       interf.pick_RequestObjectPicking = remixapi_pick_RequestObjectPicking;
       interf.pick_HighlightObjects = remixapi_pick_HighlightObjects;
+      interf.CreateMeshes = remixapi_CreateMeshes;
+      interf.DrawInstances = remixapi_DrawInstances;
+      interf.DrawLightInstances = remixapi_DrawLightInstances;
     }
-    static_assert(sizeof(interf) == 192, "Add/remove function registration");
+    static_assert(sizeof(interf) == 216, "Add/remove function registration");
 
     *out_result = interf;
     return REMIXAPI_ERROR_CODE_SUCCESS;
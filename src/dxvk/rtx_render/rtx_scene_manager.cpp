@@ -47,6 +47,36 @@
 #include "rtx_light_utils.h"
 
 namespace dxvk {
+  namespace {
+    // Uploads the cache slots that changed since the last upload, or the whole table when the
+    // buffer was just (re)created and holds nothing yet. Dirty runs are coalesced by the cache.
+    template<typename Cache>
+    void uploadMaterialTable(Rc<RtxContext>& ctx, const Rc<DxvkBuffer>& buffer, Cache& cache, const std::size_t gpuSize, const bool fullUpload) {
+      auto&& objects = cache.getObjectTable();
+
+      auto uploadRange = [&](uint32_t begin, uint32_t end) {
+        std::size_t dataOffset = 0;
+        std::vector<unsigned char> gpuData((end - begin) * gpuSize);
+
+        for (uint32_t i = begin; i < end; i++) {
+          objects[i].writeGPUData(gpuData.data(), dataOffset);
+        }
+
+        assert(dataOffset == gpuData.size());
+
+        ctx->writeToBuffer(buffer, begin * gpuSize, gpuData.size(), gpuData.data());
+      };
+
+      if (fullUpload) {
+        uploadRange(0, cache.getTotalCount());
+      } else {
+        cache.forEachDirtyRange(uploadRange);
+      }
+
+      cache.clearDirty();
+    }
+  }
+
   SceneManager::SceneManager(DxvkDevice* device)
     : CommonDeviceObject(device)
     , m_instanceManager(device, this)
@@ -190,10 +220,10 @@ namespace dxvk {
     ScopedCpuProfileZone();
 
     const size_t oldestFrame = m_device->getCurrentFrameId() - RtxOptions::Get()->numFramesToKeepGeometryData();
-    auto blasEntryGarbageCollection = [&](auto& iter, auto& entries) -> void {
+    auto blasEntryGarbageCollection = [&](auto& iter) -> void {
       if (iter->second.frameLastTouched < oldestFrame) {
         onSceneObjectDestroyed(iter->second);
-        iter = entries.erase(iter);
+        iter = m_drawCallCache.erase(iter);
       } else {
         ++iter;
       }
@@ -207,12 +237,12 @@ namespace dxvk {
       auto& entries = m_drawCallCache.getEntries();
       if (m_device->getCurrentFrameId() > RtxOptions::Get()->numFramesToKeepGeometryData()) {
         for (auto iter = entries.begin(); iter != entries.end(); ) {
-          blasEntryGarbageCollection(iter, entries);
+          blasEntryGarbageCollection(iter);
         }
       }
     }
     else { // Implement anti-culling BLAS/Scene object GC
-      fast_unordered_cache<const RtInstance*> outsideFrustumInstancesCache;
+      fast_flat_cache<const RtInstance*> outsideFrustumInstancesCache;
 
       auto& entries = m_drawCallCache.getEntries();
       for (auto iter = entries.begin(); iter != entries.end();) {
@@ -277,7 +307,7 @@ namespace dxvk {
         // If all instances in current BLAS are inside the frustum, then use original GC logic to recycle BLAS Objects
         if (isAllInstancesInCurrentBlasInsideFrustum &&
             m_device->getCurrentFrameId() > RtxOptions::Get()->numFramesToKeepGeometryData()) {
-          blasEntryGarbageCollection(iter, entries);
+          blasEntryGarbageCollection(iter);
         } else { // If any instances are outside of the frustum in current BLAS, we need to keep the entity
           ++iter;
         }
@@ -748,8 +778,10 @@ namespace dxvk {
     }
 
     if (newGeoData.positionBuffer.defined()) {
-      newGeoData.positionBufferIndex = m_bufferCache.track(newGeoData.positionBuffer);
+      newGeoData.positionBufferHandle = m_bufferCache.trackHandle(newGeoData.positionBuffer);
+      newGeoData.positionBufferIndex = newGeoData.positionBufferHandle.index;
     } else {
+      newGeoData.positionBufferHandle = {};
       newGeoData.positionBufferIndex = kSurfaceInvalidBufferIndex;
     }
 
@@ -763,6 +795,7 @@ namespace dxvk {
   SceneManager::ObjectCacheState SceneManager::onSceneObjectAdded(Rc<DxvkContext> ctx, const DrawCallState& drawCallState, BlasEntry* pBlas) {
     // This is a new object.
     ObjectCacheState result = processGeometryInfo<true>(ctx, drawCallState, pBlas->modifiedGeometryData);
+    m_drawCallCache.updateEntry(pBlas);
     
     assert(result == ObjectCacheState::KBuildBVH);
 
@@ -773,6 +806,11 @@ namespace dxvk {
   
   SceneManager::ObjectCacheState SceneManager::onSceneObjectUpdated(Rc<DxvkContext> ctx, const DrawCallState& drawCallState, BlasEntry* pBlas) {
     if (pBlas->frameLastTouched == m_device->getCurrentFrameId()) {
+      // Buffer indices from earlier in the frame are stale if the buffer table was cleared since
+      if (!m_bufferCache.isCurrent(pBlas->modifiedGeometryData.positionBufferHandle)) {
+        updateBufferCache(pBlas->modifiedGeometryData);
+      }
+
       pBlas->cacheMaterial(drawCallState.getMaterialData());
       return SceneManager::ObjectCacheState::kUpdateInstance;
     }
@@ -788,6 +826,7 @@ namespace dxvk {
     
     pBlas->clearMaterialCache();
     pBlas->input = drawCallState; // cache the draw state for the next time.
+    m_drawCallCache.updateEntry(pBlas);
     return result;
   }
   
@@ -843,7 +882,35 @@ namespace dxvk {
     }
 
     auto& textureManager = m_device->getCommon()->getTextureManager();
-    textureManager.addTexture(ctx, inputTexture, allowAsync, textureIndex);
+    textureManager.addTexture(ctx, inputTexture, allowAsync, textureIndex, m_textureStreamingHint);
+  }
+
+  // Estimates how prominent the instance of a draw call is on screen, from its bounding sphere
+  TextureStreamingHint SceneManager::calcTextureStreamingHint(const DrawCallState& drawCallState, const BlasEntry& blas) const {
+    const AxisAlignedBoundingBox& boundingBox = blas.input.getGeometryData().boundingBox;
+    const Matrix4& objectToWorld = drawCallState.getTransformData().objectToWorld;
+    const RtCamera& camera = getCamera();
+
+    TextureStreamingHint hint;
+    hint.distance = length(boundingBox.getTransformedCentroid(objectToWorld) - camera.getPosition());
+
+    if (!boundingBox.isValid()) {
+      return hint;
+    }
+
+    const float maxScale = std::max({ length(objectToWorld[0].xyz()), length(objectToWorld[1].xyz()), length(objectToWorld[2].xyz()) });
+    const float radius = 0.5f * length(boundingBox.maxPos - boundingBox.minPos) * maxScale;
+    const float tanHalfFov = std::tan(camera.getFov() * 0.5f);
+
+    if (hint.distance <= radius) {
+      hint.screenCoverage = 1.f;
+    } else if (tanHalfFov > 0.f) {
+      // Projected radius relative to half the vertical screen extent, squared for an area
+      const float projectedRadius = radius / (hint.distance * tanHalfFov);
+      hint.screenCoverage = std::min(projectedRadius * projectedRadius, 1.f);
+    }
+
+    return hint;
   }
 
   uint64_t SceneManager::processDrawCallState(Rc<DxvkContext> ctx, const DrawCallState& drawCallState, const MaterialData* overrideMaterialData) {
@@ -856,7 +923,7 @@ namespace dxvk {
     }
     ObjectCacheState result = ObjectCacheState::kInvalid;
     BlasEntry* pBlas = nullptr;
-    if (m_drawCallCache.get(drawCallState, &pBlas) == DrawCallCache::CacheState::kExisted) {
+    if (m_drawCallCache.get(drawCallState, m_device->getCurrentFrameId(), &pBlas) == DrawCallCache::CacheState::kExisted) {
       result = onSceneObjectUpdated(ctx, drawCallState, pBlas);
     } else {
       result = onSceneObjectAdded(ctx, drawCallState, pBlas);
@@ -881,6 +948,9 @@ namespace dxvk {
 
     const bool hasTexcoords = drawCallState.hasTextureCoordinates();
 
+    // Textures tracked for this draw are ranked for streaming by how prominent it is
+    m_textureStreamingHint = calcTextureStreamingHint(drawCallState, *pBlas);
+
     // We're going to use this to create a modified sampler for replacement textures.
     // Legacy and replacement materials should follow same filtering but due to lack of override capability per texture
     // legacy textures use original sampler to stay true to the original intent while replacements use more advanced filtering
@@ -1109,6 +1179,8 @@ namespace dxvk {
     assert(surfaceMaterial.has_value());
     assert(surfaceMaterial->validate());
 
+    m_textureStreamingHint = TextureStreamingHint {};
+
     // Cache this
     m_surfaceMaterialCache.track(*surfaceMaterial);
 
@@ -1402,21 +1474,13 @@ namespace dxvk {
 
         info.size = align(surfaceMaterialExtensionsGPUSize, kBufferAlignment);
         info.usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+        bool fullUpload = false;
         if (m_surfaceMaterialExtensionBuffer == nullptr || info.size > m_surfaceMaterialExtensionBuffer->info().size) {
           m_surfaceMaterialExtensionBuffer = m_device->createBuffer(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, DxvkMemoryStats::Category::RTXBuffer);
+          fullUpload = true;
         }
 
-        std::size_t dataOffset = 0;
-        std::vector<unsigned char> surfaceMaterialExtensionsGPUData(surfaceMaterialExtensionsGPUSize);
-
-        for (auto&& surfaceMaterialExtension : m_surfaceMaterialExtensionCache.getObjectTable()) {
-          surfaceMaterialExtension.writeGPUData(surfaceMaterialExtensionsGPUData.data(), dataOffset);
-        }
-
-        assert(dataOffset == surfaceMaterialExtensionsGPUSize);
-        assert(surfaceMaterialExtensionsGPUData.size() == surfaceMaterialExtensionsGPUSize);
-
-        ctx->writeToBuffer(m_surfaceMaterialExtensionBuffer, 0, surfaceMaterialExtensionsGPUData.size(), surfaceMaterialExtensionsGPUData.data());
+        uploadMaterialTable(ctx, m_surfaceMaterialExtensionBuffer, m_surfaceMaterialExtensionCache, kSurfaceMaterialGPUSize, fullUpload);
       }
 
       // Volume Material buffer
@@ -1426,21 +1490,13 @@ namespace dxvk {
 
         info.size = align(volumeMaterialsGPUSize, kBufferAlignment);
         info.usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+        bool fullUpload = false;
         if (m_volumeMaterialBuffer == nullptr || info.size > m_volumeMaterialBuffer->info().size) {
           m_volumeMaterialBuffer = m_device->createBuffer(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, DxvkMemoryStats::Category::RTXBuffer);
+          fullUpload = true;
         }
 
-        std::size_t dataOffset = 0;
-        std::vector<unsigned char> volumeMaterialsGPUData(volumeMaterialsGPUSize);
-
-        for (auto&& volumeMaterial : m_volumeMaterialCache.getObjectTable()) {
-          volumeMaterial.writeGPUData(volumeMaterialsGPUData.data(), dataOffset);
-        }
-
-        assert(dataOffset == volumeMaterialsGPUSize);
-        assert(volumeMaterialsGPUData.size() == volumeMaterialsGPUSize);
-
-        ctx->writeToBuffer(m_volumeMaterialBuffer, 0, volumeMaterialsGPUData.size(), volumeMaterialsGPUData.data());
+        uploadMaterialTable(ctx, m_volumeMaterialBuffer, m_volumeMaterialCache, kVolumeMaterialGPUSize, fullUpload);
       }
     }
 
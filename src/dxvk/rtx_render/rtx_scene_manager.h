@@ -225,6 +225,8 @@ private:
   // Consumes a draw call state and updates the scene state accordingly
   uint64_t processDrawCallState(Rc<DxvkContext> ctx, const DrawCallState& blasInput, const MaterialData* replacementMaterialData);
 
+  TextureStreamingHint calcTextureStreamingHint(const DrawCallState& drawCallState, const BlasEntry& blas) const;
+
   // Updates ref counts for new buffers
   void updateBufferCache(RaytraceGeometry& newGeoData);
 
@@ -283,6 +285,9 @@ private:
   
   float m_uniqueObjectSearchDistance = 1.f;
 
+  // Streaming hint of the draw call being processed, passed along to the textures it tracks
+  TextureStreamingHint m_textureStreamingHint;
+
   struct DrawCallMetaInfo {
     XXH64_hash_t legacyTextureHash { kEmptyHash };
     XXH64_hash_t legacyTextureHash2 { kEmptyHash };
@@ -22,8 +22,10 @@
 #pragma once
 
 #include <vector>
-#include <queue>
-#include <unordered_map>
+#include <functional>
+#include <type_traits>
+
+#include "../../util/util_bit.h"
 
 namespace dxvk 
 {
@@ -50,6 +52,12 @@ namespace dxvk
 *  This structure is particularly useful for tracking GPU objects, where persistent
 *  indices for large, dynamic arrays are required.  e.g. bindless resources.
 * 
+*  Lookups go through a flat open-addressing table of (hash, index) pairs.  Every
+*  slot carries a generation which is bumped when the slot is freed, so a Handle
+*  can tell whether the object it was issued for still owns its index.  Slots that
+*  were (re)populated or freed are recorded in a dirty bitset, which consumers can
+*  walk to upload only what changed, and then reset with clearDirty().
+* 
 *  NOTE: This object does no ref counting - its expected that the user supply T 
    as a ref-counted object if that behavior is desired.
 */
@@ -57,6 +65,13 @@ template<typename T, class HashFn, class KeyEqual = std::equal_to<T>>
 struct SparseUniqueCache
 {
 public:
+  static constexpr uint32_t kInvalidIndex = ~0u;
+
+  struct Handle {
+    uint32_t index = kInvalidIndex;
+    uint32_t generation = 0;
+  };
+
   SparseUniqueCache(SparseUniqueCache const&) = delete;
   SparseUniqueCache& operator=(SparseUniqueCache const&) = delete;
 
@@ -64,47 +79,116 @@ public:
   ~SparseUniqueCache() {}
 
   void clear() {
-    m_freeBuffers = {};
+    // Outstanding handles must not survive a clear, even though indices restart at 0
+    for (uint32_t& generation : m_generations) {
+      ++generation;
+    }
+
+    m_freeSlots.clear();
+    m_freeHead = 0;
     m_objects.clear();
-    m_bufferMap.clear();
+    m_buckets.clear();
+    m_numBucketsUsed = 0;
+    m_dirtySlots.clear();
+  }
+
+  template<typename OnFirstCache = std::nullptr_t>
+  uint32_t track(const T& obj, OnFirstCache&& onFirstCache = nullptr) {
+    return trackHandle(obj, std::forward<OnFirstCache>(onFirstCache)).index;
   }
 
-  uint32_t track(const T& obj, std::function<T(const T&)> onFirstCache = [](const T& in) { return in; }) {
+  template<typename OnFirstCache = std::nullptr_t>
+  Handle trackHandle(const T& obj, OnFirstCache&& onFirstCache = nullptr) {
     uint32_t idx;
     if (!find(obj, idx)) {
-      const T& objectToCache = onFirstCache(obj);
-      if (!m_freeBuffers.empty()) {
-        idx = m_freeBuffers.front();
-        m_freeBuffers.pop();
-        m_objects.at(idx) = objectToCache;
+      if constexpr (std::is_same_v<std::decay_t<OnFirstCache>, std::nullptr_t>) {
+        idx = insert(obj);
       } else {
-        idx = m_objects.size();
-        m_objects.push_back(objectToCache);
+        idx = insert(onFirstCache(obj));
       }
-      m_bufferMap.insert({ objectToCache, idx });
     }
-    return idx;
+    return Handle { idx, m_generations[idx] };
   }
 
   bool find(const T& buf, uint32_t& outIdx) const {
-    const auto& vtxBuffer = m_bufferMap.find(buf);
-    if (vtxBuffer != m_bufferMap.end()) {
-      outIdx = vtxBuffer->second;
+    const uint32_t bucket = findBucket(buf, HashFn()(buf));
+    if (bucket != kInvalidIndex) {
+      outIdx = m_buckets[bucket].index;
       return true;
     }
     return false;
   }
 
   void free(const T& buf) {
-    auto iter = m_bufferMap.find(buf);
-    if (iter != m_bufferMap.end()) {
-      m_objects.at(iter->second) = T();
-      m_freeBuffers.push(iter->second);
-      m_bufferMap.erase(iter);
+    const uint32_t bucket = findBucket(buf, HashFn()(buf));
+    if (bucket != kInvalidIndex) {
+      const uint32_t idx = m_buckets[bucket].index;
+      m_buckets[bucket].index = kTombstone;
+      m_objects.at(idx) = T();
+      ++m_generations[idx];
+      m_freeSlots.push_back(idx);
+      markDirty(idx);
     }
   }
 
-  uint32_t getActiveCount() const { return m_objects.size() - m_freeBuffers.size(); }
+  // Handle of whatever object currently owns the slot
+  Handle getHandle(const uint32_t i) const {
+    return Handle { i, m_generations[i] };
+  }
+
+  // True when the handle's object still owns its index
+  bool isCurrent(const Handle& handle) const {
+    return handle.index < m_objects.size() && m_generations[handle.index] == handle.generation;
+  }
+
+  // Flags a slot whose object was modified in place through at()
+  void markDirty(const uint32_t i) {
+    const uint32_t word = i / 64;
+    if (word >= m_dirtySlots.size()) {
+      m_dirtySlots.resize(word + 1, 0);
+    }
+    m_dirtySlots[word] |= uint64_t(1) << (i % 64);
+  }
+
+  bool hasDirtySlots() const {
+    return !m_dirtySlots.empty();
+  }
+
+  // Calls `fn(begin, end)` for every run of contiguous dirty slots within the table
+  template<typename Fn>
+  void forEachDirtyRange(Fn&& fn) const {
+    const uint32_t count = getTotalCount();
+    uint32_t runBegin = 0;
+    uint32_t runEnd = 0;
+
+    for (uint32_t word = 0; word < m_dirtySlots.size(); word++) {
+      for (uint64_t mask = m_dirtySlots[word]; mask != 0; mask &= mask - 1) {
+        const uint32_t lo = uint32_t(mask);
+        const uint32_t bit = lo != 0 ? bit::tzcnt(lo) : 32 + bit::tzcnt(uint32_t(mask >> 32));
+        const uint32_t i = word * 64 + bit;
+        if (i >= count) {
+          break;
+        }
+        if (i != runEnd) {
+          if (runEnd > runBegin) {
+            fn(runBegin, runEnd);
+          }
+          runBegin = i;
+        }
+        runEnd = i + 1;
+      }
+    }
+
+    if (runEnd > runBegin) {
+      fn(runBegin, runEnd);
+    }
+  }
+
+  void clearDirty() {
+    m_dirtySlots.clear();
+  }
+
+  uint32_t getActiveCount() const { return m_objects.size() - (m_freeSlots.size() - m_freeHead); }
   uint32_t getTotalCount() const { return m_objects.size(); }
 
   T& at(const uint32_t i) { return m_objects[i]; }
@@ -113,10 +197,100 @@ public:
   std::vector<T>& getObjectTable() { return m_objects; }
 
 private:
-  std::queue<uint32_t> m_freeBuffers;
+  static constexpr uint32_t kEmpty = ~0u;
+  static constexpr uint32_t kTombstone = ~0u - 1;
+  static constexpr uint32_t kMinBuckets = 64;
+
+  struct Bucket {
+    size_t hash;
+    uint32_t index = kEmpty;
+  };
+
+  uint32_t findBucket(const T& obj, const size_t hash) const {
+    if (m_buckets.empty()) {
+      return kInvalidIndex;
+    }
+
+    const size_t mask = m_buckets.size() - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+      const Bucket& bucket = m_buckets[i];
+      if (bucket.index == kEmpty) {
+        return kInvalidIndex;
+      }
+      if (bucket.index != kTombstone && bucket.hash == hash && KeyEqual()(m_objects[bucket.index], obj)) {
+        return uint32_t(i);
+      }
+    }
+  }
+
+  void insertBucket(const size_t hash, const uint32_t idx) {
+    const size_t mask = m_buckets.size() - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+      Bucket& bucket = m_buckets[i];
+      if (bucket.index == kEmpty || bucket.index == kTombstone) {
+        m_numBucketsUsed += bucket.index == kEmpty ? 1 : 0;
+        bucket.hash = hash;
+        bucket.index = idx;
+        return;
+      }
+    }
+  }
+
+  // Regrows (or just purges tombstones from) the bucket table when it is over half full
+  void reserveBucket() {
+    if ((m_numBucketsUsed + 1) * 2 <= m_buckets.size()) {
+      return;
+    }
+
+    size_t numBuckets = kMinBuckets;
+    while (numBuckets < (size_t(getActiveCount()) + 1) * 4) {
+      numBuckets *= 2;
+    }
+
+    std::vector<Bucket> oldBuckets(numBuckets);
+    oldBuckets.swap(m_buckets);
+    m_numBucketsUsed = 0;
+
+    for (const Bucket& bucket : oldBuckets) {
+      if (bucket.index != kEmpty && bucket.index != kTombstone) {
+        insertBucket(bucket.hash, bucket.index);
+      }
+    }
+  }
+
+  uint32_t insert(const T& objectToCache) {
+    uint32_t idx;
+    if (m_freeHead < m_freeSlots.size()) {
+      idx = m_freeSlots[m_freeHead++];
+      // Drop the consumed front once it is half the FIFO, so the FIFO stays
+      // bounded by the number of free slots even if it never fully drains
+      if (m_freeHead * 2 >= m_freeSlots.size()) {
+        m_freeSlots.erase(m_freeSlots.begin(), m_freeSlots.begin() + m_freeHead);
+        m_freeHead = 0;
+      }
+      m_objects.at(idx) = objectToCache;
+    } else {
+      idx = m_objects.size();
+      m_objects.push_back(objectToCache);
+      if (idx >= m_generations.size()) {
+        m_generations.push_back(0);
+      }
+    }
+
+    reserveBucket();
+    insertBucket(HashFn()(objectToCache), idx);
+    markDirty(idx);
+    return idx;
+  }
+
+  // FIFO of freed indices, consumed from m_freeHead
+  std::vector<uint32_t> m_freeSlots;
+  size_t m_freeHead = 0;
   std::vector<T> m_objects;
-  std::unordered_map<T, uint32_t, HashFn, KeyEqual> m_bufferMap;
+  std::vector<uint32_t> m_generations;
+  std::vector<Bucket> m_buckets;
+  size_t m_numBucketsUsed = 0;
+  std::vector<uint64_t> m_dirtySlots;
 };
 
 }  // namespace dxvk
-
@@ -203,6 +203,9 @@ namespace dxvk {
 
     Rc<DxvkImage> image = device->createImage(desc, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, DxvkMemoryStats::Category::RTXMaterialTexture, "material texture");
 
+    // Read all levels in one batch so packaged blobs are loaded and validated in parallel
+    assetData.prefetch(0, 0, assetInfo.mipLevels);
+
     // copy image data from disk
     for (uint32_t level = 0; level < assetInfo.mipLevels; ++level) {
       const VkExtent3D levelExtent = util::computeMipLevelExtent(assetInfo.extent, level);
@@ -245,6 +248,7 @@ namespace dxvk {
       // Evict large image
       allMipsImageView = nullptr;
       completionSyncpt = ~0;
+      loadedMip = -1;
 
       if (!RtxIo::enabled()) {
         // RTXIO path does not evict small images
@@ -315,6 +319,12 @@ namespace dxvk {
       // There's no point in loading same texture again, we can just
       // set all mips view to the small mips view.
       texture->allMipsImageView = texture->smallMipsImageView;
+      texture->loadedMip = texture->minPreloadedMip;
+
+      // Nothing was uploaded, so there is no upload to wait for either
+      if (!RtxIo::enabled()) {
+        texture->state = ManagedTexture::State::kVidMem;
+      }
       return;
     }
 
@@ -337,9 +347,11 @@ namespace dxvk {
       if (texture->minPreloadedMip == 0) {
         // If texture was fully loaded, set all mips view as well and skip future load.
         texture->allMipsImageView = viewTarget;
+        texture->loadedMip = 0;
       }
     } else {
       texture->allMipsImageView = viewTarget;
+      texture->loadedMip = baseLevel;
 
       // Get rid of cached higher res mips. Wipe caches of images that skipped
       // the preload phase, but keep the fully preloaded images.
@@ -21,6 +21,10 @@
 */
 #pragma once
 
+#include <atomic>
+#include <cfloat>
+
+#include "../../util/util_time.h"
 #include "rtx_utils.h"
 #include "dxvk_context_state.h"
 #include "rtx_asset_data.h"
@@ -43,6 +47,13 @@ namespace dxvk {
     AUTO
   };
 
+  // How prominently a texture was seen this frame, used to rank streaming requests.
+  //  Taken from the draws referencing the texture, the largest and closest one wins.
+  struct TextureStreamingHint {
+    float screenCoverage = 0.f;   // fraction of the screen covered by the referencing instance's bounding sphere, 0 to 1
+    float distance = FLT_MAX;     // distance from the camera to the referencing instance, in world units
+  };
+
   // The ManagedTexture holds streaming state for a given texture.
   //  A texture can be loaded in many states, if it's initial 
   //  memory location is host (system) memory, then there are 
@@ -92,6 +103,19 @@ namespace dxvk {
     bool canDemote = true;
     uint32_t frameQueuedForUpload = 0;
 
+    // Streaming, see RtxTextureManager
+    int loadedMip = -1;                                 // highest resolution mip in allMipsImageView, -1 if not loaded
+    int requestedMip = 0;                               // highest resolution mip a queued mip change should load
+    std::atomic<bool> mipChangeInFlight = false;        // a resident texture is being reloaded at another resolution
+    VkDeviceSize bytesRequested = 0;                    // estimated size of the queued upload
+    dxvk::high_resolution_clock::time_point timeQueuedForUpload;
+    std::atomic<float> streamingCoverage = 0.f;         // TextureStreamingHint accumulated over frameLastRequested
+    std::atomic<float> streamingDistance = FLT_MAX;
+    std::atomic<uint32_t> frameLastRequested = 0;
+    std::atomic<bool> streamingPriorityDirty = false;   // hints changed while queued, re-ranked once per frame
+    uint32_t streamingPriorityVersion = 0;              // guarded by the streaming queue lock, like inStreamingQueue
+    bool inStreamingQueue = false;
+
     bool good() const {
       return state != State::kUnknown && state != State::kFailed;
     }
@@ -186,6 +210,14 @@ namespace dxvk {
       m_imageView = nullptr;
     }
 
+    // Picks up the mip chain of a resident texture that the streaming scheduler reloaded at another resolution
+    void refreshStreamedMips() {
+      if (isFullyResident() && m_managedTexture.ptr() && m_managedTexture->state == ManagedTexture::State::kVidMem &&
+          m_managedTexture->allMipsImageView.ptr()) {
+        m_imageView = m_managedTexture->allMipsImageView;
+      }
+    }
+
     // If we have a valid full resource here, the managed texture has served it's purpose.
     bool finalizePendingPromotion() {
       if (!isFullyResident() && (m_managedTexture->state == ManagedTexture::State::kVidMem)) {
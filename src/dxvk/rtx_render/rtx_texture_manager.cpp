@@ -25,6 +25,7 @@
 #include "../../util/rc/util_rc_ptr.h"
 #include "dxvk_context.h"
 #include "dxvk_scoped_annotation.h"
+#include <algorithm>
 #include <chrono>
 
 #include "rtx_texture.h"
@@ -37,6 +38,8 @@ namespace dxvk {
   // by this number of frames to make sure the previously used memory is released and there
   // will be no overcommit.
   constexpr uint32_t kPromotionDelayFrames = 2;
+  // Resident textures are only promoted while the texture memory usage is below this share of the budget
+  constexpr VkDeviceSize kPercentageOfBudgetForPromotion = 90;
 
   void RtxTextureManager::work(Rc<ManagedTexture>& texture, Rc<DxvkContext>& ctx) {
     if (m_dropRequests) {
@@ -55,15 +58,143 @@ namespace dxvk {
     }
 
     if (m_dropRequests) {
-      texture->state = ManagedTexture::State::kFailed;
-      texture->demote();
+      if (texture->mipChangeInFlight && texture->allMipsImageView != nullptr) {
+        // Only the change of resolution is dropped, the texture keeps the mips it has
+        texture->state = ManagedTexture::State::kVidMem;
+      } else {
+        texture->state = ManagedTexture::State::kFailed;
+        texture->demote();
+      }
     } else {
       loadTexture(texture, ctx);
+      recordStreamingLatency(*texture);
+    }
+
+    m_bytesInFlight -= texture->bytesRequested;
+    texture->bytesRequested = 0;
+    texture->mipChangeInFlight = false;
+  }
+
+  void RtxTextureManager::pushItem(const Rc<ManagedTexture>& item) {
+    item->inStreamingQueue = true;
+    m_streamingQueue.push(item, calcStreamingPriority(*item, m_pDevice->getCurrentFrameId()),
+                          item->streamingPriorityVersion, item->frameQueuedForUpload);
+  }
+
+  bool RtxTextureManager::popItem(Rc<ManagedTexture>& item) {
+    const uint32_t currentFrame = m_pDevice->getCurrentFrameId();
+    // Requests of the current frame are held back until the next one in work(), prefer the ones that can start now
+    const bool holdsBackRequests = !RtxIo::enabled() && !RtxOptions::Get()->alwaysWaitForAsyncTextures();
+
+    auto getPriority = [this, currentFrame](const Rc<ManagedTexture>& texture, uint32_t version, double& priority) {
+      // Superseded by a request pushed again in refreshStreamingPriorities
+      if (version != texture->streamingPriorityVersion) {
+        return false;
+      }
+
+      priority = calcStreamingPriority(*texture, currentFrame);
+      return true;
+    };
+
+    if (!m_streamingQueue.pop(item, currentFrame, holdsBackRequests, getPriority)) {
+      return false;
     }
+
+    item->inStreamingQueue = false;
+    return true;
+  }
+
+  bool RtxTextureManager::hasQueuedItems() const {
+    return !m_streamingQueue.empty();
+  }
+
+  void RtxTextureManager::refreshStreamingPriorities() {
+    if (m_streamingPriorityUpdates.empty()) {
+      return;
+    }
+
+    const uint32_t currentFrame = m_pDevice->getCurrentFrameId();
+
+    // Priorities that went down are caught when the request reaches the top of the queue,
+    // ones that went up need the request to be pushed again
+    RenderProcessor::updateQueue([&] {
+      for (const Rc<ManagedTexture>& texture : m_streamingPriorityUpdates) {
+        texture->streamingPriorityDirty = false;
+
+        if (texture->inStreamingQueue) {
+          m_streamingQueue.push(texture, calcStreamingPriority(*texture, currentFrame),
+                                ++texture->streamingPriorityVersion, texture->frameQueuedForUpload);
+        }
+      }
+    });
+
+    m_streamingPriorityUpdates.clear();
+  }
+
+  TextureStreamingWeights RtxTextureManager::getStreamingWeights() const {
+    return TextureStreamingWeights {
+      streamingCoverageWeight(),
+      streamingDistanceWeight(),
+      streamingAgeWeight(),
+      streamingMipDeficitWeight(),
+      RtxOptions::Get()->getMeterToWorldUnitScale()
+    };
+  }
+
+  float RtxTextureManager::calcStreamingVisibility(const ManagedTexture& texture, uint32_t currentFrame) const {
+    return calcTextureStreamingVisibility(texture.streamingCoverage, texture.streamingDistance, texture.frameLastRequested,
+                                          currentFrame, getStreamingWeights());
+  }
+
+  double RtxTextureManager::calcStreamingPriority(const ManagedTexture& texture, uint32_t currentFrame) const {
+    TextureStreamingRequest request;
+    request.coverage = texture.streamingCoverage;
+    request.distance = texture.streamingDistance;
+    request.frameLastRequested = texture.frameLastRequested;
+    request.frameQueued = texture.frameQueuedForUpload;
+    // Mips missing from the level the request will load
+    request.currentMip = texture.loadedMip >= 0 ? texture.loadedMip :
+                         texture.minPreloadedMip >= 0 ? texture.minPreloadedMip : texture.mipCount;
+    request.targetMip = texture.mipChangeInFlight ? texture.requestedMip : 0;
+
+    return calcTextureStreamingPriority(request, currentFrame, getStreamingWeights());
+  }
+
+  VkDeviceSize RtxTextureManager::estimateTextureBytes(const ManagedTexture& texture, int baseMip) {
+    const AssetInfo& info = texture.assetData->sourceInfo();
+    const DxvkFormatInfo* formatInfo = imageFormatInfo(info.format);
+
+    if (formatInfo == nullptr || info.mipLevels == 0) {
+      return 0;
+    }
+
+    VkDeviceSize bytes = 0;
+    for (uint32_t level = std::min<uint32_t>(std::max(baseMip, 0), info.mipLevels - 1); level < info.mipLevels; level++) {
+      const VkExtent3D blockCount = util::computeBlockCount(util::computeMipLevelExtent(info.extent, level), formatInfo->blockSize);
+      bytes += VkDeviceSize(blockCount.width) * blockCount.height * blockCount.depth * formatInfo->elementSize;
+    }
+
+    return bytes * std::max(info.numLayers, 1u);
+  }
+
+  void RtxTextureManager::queueStreamingRequest(const Rc<ManagedTexture>& texture, int baseMip) {
+    texture->bytesRequested = estimateTextureBytes(*texture, baseMip);
+    texture->timeQueuedForUpload = dxvk::high_resolution_clock::now();
+    m_bytesInFlight += texture->bytesRequested;
+
+    RenderProcessor::add(std::move(texture));
+  }
+
+  void RtxTextureManager::recordStreamingLatency(const ManagedTexture& texture) {
+    const float latencyMs = std::chrono::duration<float, std::milli>(dxvk::high_resolution_clock::now() - texture.timeQueuedForUpload).count();
+
+    std::lock_guard<dxvk::mutex> lock(m_latencyMutex);
+    m_latencySamplesMs[m_numLatencySamples % kNumLatencySamples] = latencyMs;
+    m_numLatencySamples++;
   }
 
   RtxTextureManager::RtxTextureManager(DxvkDevice* device)
-    : RenderProcessor(device, "rtx-texture-manager")
+    : RenderProcessor(device, "rtx-texture-manager", RtxIo::enabled() ? 1 : clamp(numLoaderThreads(), 1u, 8u))
     , m_pDevice(device) {
   }
 
@@ -149,7 +280,7 @@ namespace dxvk {
     if (!allowAsync) {
       loadTexture(managedTexture, immediateContext);
     } else {
-      RenderProcessor::add(std::move(managedTexture));
+      queueStreamingRequest(managedTexture, RtxOptions::Get()->minReplacementTextureMipMapLevel());
     }
   }
 
@@ -166,6 +297,8 @@ namespace dxvk {
   }
 
   void RtxTextureManager::kickoff() {
+    refreshStreamingPriorities();
+
     if (m_itemsPending == 0) {
       m_kickoff = true;
       m_condOnAdd.notify_one();
@@ -177,6 +310,26 @@ namespace dxvk {
     }
 
     m_pDevice->statCounters().setCtr(DxvkStatCounter::RtxTexturesInFlight, m_itemsPending.load());
+    m_pDevice->statCounters().setCtr(DxvkStatCounter::RtxTextureBytesInFlight, m_bytesInFlight.load());
+
+    std::array<float, kNumLatencySamples> latencies;
+    uint32_t numLatencies;
+    {
+      std::lock_guard<dxvk::mutex> lock(m_latencyMutex);
+      numLatencies = std::min(m_numLatencySamples, kNumLatencySamples);
+      std::copy_n(m_latencySamplesMs.begin(), numLatencies, latencies.begin());
+    }
+
+    if (numLatencies > 0) {
+      auto percentile = [&](uint32_t percent) {
+        auto nth = latencies.begin() + (numLatencies - 1) * percent / 100;
+        std::nth_element(latencies.begin(), nth, latencies.begin() + numLatencies);
+        return static_cast<uint64_t>(*nth);
+      };
+
+      m_pDevice->statCounters().setCtr(DxvkStatCounter::RtxTextureLatencyP50, percentile(50));
+      m_pDevice->statCounters().setCtr(DxvkStatCounter::RtxTextureLatencyP95, percentile(95));
+    }
   }
 
   void RtxTextureManager::finalizeAllPendingTexturePromotions() {
@@ -196,7 +349,8 @@ namespace dxvk {
     }
   }
 
-  void RtxTextureManager::addTexture(Rc<DxvkContext>& immediateContext, TextureRef inputTexture, bool allowAsync, uint32_t& textureIndexOut) {
+  void RtxTextureManager::addTexture(Rc<DxvkContext>& immediateContext, TextureRef inputTexture, bool allowAsync, uint32_t& textureIndexOut,
+                                     const TextureStreamingHint& hint) {
     // If theres valid texture backing this ref, then skip
     if (!inputTexture.isValid())
       return;
@@ -206,13 +360,35 @@ namespace dxvk {
 
     // Fetch the texture object from cache
     TextureRef& cachedTexture = m_textureCache.at(textureIndexOut);
+    const uint32_t currentFrame = m_pDevice->getCurrentFrameId();
+
+    // Keep the most prominent draw of this frame for ranking the streaming requests of the texture
+    if (const Rc<ManagedTexture>& managedTexture = cachedTexture.getManagedTexture(); managedTexture != nullptr) {
+      if (managedTexture->frameLastRequested != currentFrame) {
+        managedTexture->streamingCoverage = hint.screenCoverage;
+        managedTexture->streamingDistance = hint.distance;
+        managedTexture->frameLastRequested = currentFrame;
+      } else {
+        managedTexture->streamingCoverage = std::max(managedTexture->streamingCoverage.load(), hint.screenCoverage);
+        managedTexture->streamingDistance = std::min(managedTexture->streamingDistance.load(), hint.distance);
+      }
+
+      // Re-rank the queued request once per frame
+      if (managedTexture->state == ManagedTexture::State::kQueuedForUpload && !managedTexture->streamingPriorityDirty.exchange(true)) {
+        m_streamingPriorityUpdates.push_back(managedTexture);
+      }
+    }
 
     // If there is a pending promotion, schedule it
     if (cachedTexture.isPromotable()) {
       scheduleTextureLoad(cachedTexture, immediateContext, allowAsync);
     }
 
-    cachedTexture.frameLastUsed = m_pDevice->getCurrentFrameId();
+    // Textures are added once per draw, only reorder the LRU on the first use in a frame
+    if (cachedTexture.frameLastUsed != currentFrame || !m_textureLru.contains(textureIndexOut)) {
+      m_textureLru.touch(textureIndexOut);
+    }
+    cachedTexture.frameLastUsed = currentFrame;
   }
 
 
@@ -230,6 +406,9 @@ namespace dxvk {
     demoteAllTextures();
 
     m_textureCache.clear();
+    m_textureLru.clear();
+    m_deferredDemotions.clear();
+    m_pendingMipChanges.clear();
 
     // Reset texture budget.
     m_textureBudgetMib = 0;
@@ -248,14 +427,213 @@ namespace dxvk {
     if (m_pDevice->getCurrentFrameId() > RtxOptions::Get()->numFramesToKeepMaterialTextures()) {
       const size_t oldestFrame = m_pDevice->getCurrentFrameId() - RtxOptions::Get()->numFramesToKeepMaterialTextures();
 
-      for (auto& texture : m_textureCache.getObjectTable()) {
+      auto isInFlight = [](const TextureRef& texture) {
+        return texture.getManagedTexture()->state == ManagedTexture::State::kQueuedForUpload;
+      };
+
+      // Retry textures whose upload was still in flight when they aged out
+      for (size_t i = 0; i < m_deferredDemotions.size();) {
+        const TextureCache::Handle textureHandle = m_deferredDemotions[i];
+        // Released (or the slot was reused) since, or used again
+        const bool isStale = !m_textureCache.isCurrent(textureHandle) || m_textureLru.contains(textureHandle.index);
+        if (!isStale) {
+          TextureRef& texture = m_textureCache.at(textureHandle.index);
+          if (isInFlight(texture)) {
+            ++i;
+            continue;
+          }
+          texture.demote();
+        }
+        m_deferredDemotions[i] = m_deferredDemotions.back();
+        m_deferredDemotions.pop_back();
+      }
+
+      // Only textures that aged out are visited, oldest first
+      m_textureLru.evictWhile([&](uint32_t textureIndex) {
+        TextureRef& texture = m_textureCache.at(textureIndex);
+        if (texture.frameLastUsed >= oldestFrame) {
+          return false;
+        }
+
         const bool isDemotable = texture.getManagedTexture() != nullptr && texture.getManagedTexture()->canDemote;
-        if (isDemotable){
-          const bool shouldEvict = (texture.frameLastUsed < oldestFrame);
-          if (shouldEvict) {
+        if (isDemotable) {
+          if (isInFlight(texture)) {
+            m_deferredDemotions.push_back(m_textureCache.getHandle(textureIndex));
+          } else {
             texture.demote();
           }
         }
+        return true;
+      });
+    }
+
+    updateStreamingMips();
+  }
+
+  void RtxTextureManager::requestMipChange(const TextureCache::Handle& textureHandle, const Rc<ManagedTexture>& texture, int mip) {
+    texture->requestedMip = mip;
+    texture->mipChangeInFlight = true;
+    texture->state = ManagedTexture::State::kQueuedForUpload;
+    texture->frameQueuedForUpload = m_pDevice->getCurrentFrameId();
+
+    m_pendingMipChanges.emplace_back(textureHandle, texture);
+    queueStreamingRequest(texture, mip);
+  }
+
+  void RtxTextureManager::updateStreamingMips() {
+    ScopedCpuProfileZone();
+
+    // Hand the mips of finished changes over to the texture table
+    for (size_t i = 0; i < m_pendingMipChanges.size();) {
+      const auto& [textureHandle, managedTexture] = m_pendingMipChanges[i];
+      if (managedTexture->mipChangeInFlight) {
+        ++i;
+        continue;
+      }
+
+      // The slot may have been released or reused since
+      if (m_textureCache.isCurrent(textureHandle)) {
+        m_textureCache.at(textureHandle.index).refreshStreamedMips();
+      }
+
+      m_pendingMipChanges[i] = std::move(m_pendingMipChanges.back());
+      m_pendingMipChanges.pop_back();
+    }
+
+    // Mip changes reload textures at another resolution, which only adaptive resolution allows.
+    // RTX IO keeps the preloaded mips of demoted textures and is left to its own batching.
+    const uint32_t currentFrame = m_pDevice->getCurrentFrameId();
+    const VkDeviceSize textureBudgetMib = m_textureBudgetMib.load();
+    if (!RtxOptions::Get()->enableAdaptiveResolutionReplacementTextures() ||
+        RtxOptions::Get()->forceHighResolutionReplacementTextures() ||
+        RtxIo::enabled() || textureBudgetMib == 0 || currentFrame < m_promotionStartFrame) {
+      return;
+    }
+
+    // Between the promotion threshold and the budget there is nothing to do
+    const VkDeviceSize usageMib = textureUsageMib();
+    const VkDeviceSize promotionBudgetMib = textureBudgetMib * kPercentageOfBudgetForPromotion / 100;
+    if (usageMib >= promotionBudgetMib && usageMib <= textureBudgetMib) {
+      return;
+    }
+
+    struct Candidate {
+      uint32_t textureIndex;
+      float visibility;
+    };
+
+    const std::vector<TextureRef>& textureTable = m_textureCache.getObjectTable();
+
+    auto isCandidate = [&textureTable](uint32_t textureIndex) {
+      const TextureRef& texture = textureTable[textureIndex];
+      const Rc<ManagedTexture>& managedTexture = texture.getManagedTexture();
+
+      return texture.isFullyResident() && managedTexture != nullptr && managedTexture->canDemote &&
+             managedTexture->state == ManagedTexture::State::kVidMem && !managedTexture->mipChangeInFlight &&
+             managedTexture->loadedMip >= 0;
+    };
+
+    // Only textures used within the last few frames can be visible, they are the most recently used
+    // end of the texture LRU which addTexture() keeps up to date, so the whole table is never walked.
+    // Resident textures that aged out of the LRU were demoted by garbageCollection().
+    auto isRecentlyUsed = [&textureTable, currentFrame](uint32_t textureIndex) {
+      return static_cast<int32_t>(currentFrame - textureTable[textureIndex].frameLastUsed) <= kStreamingVisibleFrames;
+    };
+
+    auto collectRecentlyUsed = [&]() {
+      std::vector<Candidate> candidates;
+      for (uint32_t i = m_textureLru.mostRecentlyUsed(); i != lru_index_list::kInvalid && isRecentlyUsed(i); i = m_textureLru.prev(i)) {
+        if (isCandidate(i)) {
+          candidates.push_back({ i, calcStreamingVisibility(*textureTable[i].getManagedTexture(), currentFrame) });
+        }
+      }
+      return candidates;
+    };
+
+    uint32_t numChanges = 0;
+
+    if (usageMib > textureBudgetMib) {
+      // Drop one mip of the least visible textures until the spill is covered
+      const VkDeviceSize spillBytes = (usageMib - textureBudgetMib) << 20;
+      VkDeviceSize freedBytes = 0;
+
+      auto demoteOneMip = [&](uint32_t textureIndex) {
+        const Rc<ManagedTexture>& texture = textureTable[textureIndex].getManagedTexture();
+        const int mip = texture->loadedMip + 1;
+
+        // The preloaded mips stay resident, demoting within them frees nothing
+        if (mip >= texture->mipCount || (texture->minPreloadedMip >= 0 && texture->loadedMip >= texture->minPreloadedMip)) {
+          return;
+        }
+
+        freedBytes += estimateTextureBytes(*texture, texture->loadedMip) - estimateTextureBytes(*texture, mip);
+        requestMipChange(m_textureCache.getHandle(textureIndex), texture, mip);
+        numChanges++;
+      };
+
+      auto isDone = [&]() {
+        return numChanges >= maxStreamingMipChangesPerFrame() || freedBytes >= spillBytes;
+      };
+
+      // Textures not used lately are invisible, the least recently used go first
+      for (uint32_t i = m_textureLru.leastRecentlyUsed(); i != lru_index_list::kInvalid && !isRecentlyUsed(i); i = m_textureLru.next(i)) {
+        if (isDone()) {
+          break;
+        }
+
+        if (isCandidate(i)) {
+          demoteOneMip(i);
+        }
+      }
+
+      if (isDone()) {
+        return;
+      }
+
+      std::vector<Candidate> candidates = collectRecentlyUsed();
+      std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.visibility < b.visibility;
+      });
+
+      for (const Candidate& candidate : candidates) {
+        if (isDone()) {
+          break;
+        }
+
+        demoteOneMip(candidate.textureIndex);
+      }
+    } else {
+      // Add one mip to the most visible textures within the headroom left
+      std::vector<Candidate> candidates = collectRecentlyUsed();
+      std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.visibility > b.visibility;
+      });
+
+      const VkDeviceSize headroomBytes = (promotionBudgetMib - usageMib) << 20;
+      VkDeviceSize usedBytes = m_bytesInFlight.load();
+      const int minMip = RtxOptions::Get()->minReplacementTextureMipMapLevel();
+
+      for (const Candidate& candidate : candidates) {
+        // Textures off screen keep their resolution
+        if (numChanges >= maxStreamingMipChangesPerFrame() || candidate.visibility <= 0.f) {
+          break;
+        }
+
+        const Rc<ManagedTexture>& texture = textureTable[candidate.textureIndex].getManagedTexture();
+        const int mip = texture->loadedMip - 1;
+
+        if (mip < minMip) {
+          continue;
+        }
+
+        const VkDeviceSize addedBytes = estimateTextureBytes(*texture, mip) - estimateTextureBytes(*texture, texture->loadedMip);
+        if (usedBytes + addedBytes > headroomBytes) {
+          continue;
+        }
+
+        usedBytes += addedBytes;
+        requestMipChange(m_textureCache.getHandle(candidate.textureIndex), texture, mip);
+        numChanges++;
       }
     }
   }
@@ -296,13 +674,18 @@ namespace dxvk {
     try {
       uint32_t largestMipToLoad = 0;
 
-      const uint32_t kPercentageOfBudgetConsideredSpilling = 75;
-      const VkDeviceSize spillMib = overBudgetMib(kPercentageOfBudgetConsideredSpilling);
-
-      // If we're over budget, aggressively limit the texture resolution for new textures, every 512Mib we go over budget
-      if (spillMib) {
-        const uint32_t kReduceMipsEveryMib = 512;
-        largestMipToLoad += spillMib / kReduceMipsEveryMib;
+      if (texture->mipChangeInFlight) {
+        // A resident texture moved one mip by updateStreamingMips
+        largestMipToLoad = texture->requestedMip;
+      } else {
+        const uint32_t kPercentageOfBudgetConsideredSpilling = 75;
+        const VkDeviceSize spillMib = overBudgetMib(kPercentageOfBudgetConsideredSpilling);
+
+        // If we're over budget, aggressively limit the texture resolution for new textures, every 512Mib we go over budget
+        if (spillMib) {
+          const uint32_t kReduceMipsEveryMib = 512;
+          largestMipToLoad += spillMib / kReduceMipsEveryMib;
+        }
       }
 
       TextureUtils::loadTexture(texture, ctx, false, largestMipToLoad);
@@ -316,13 +699,15 @@ namespace dxvk {
         ctx->flushCommandList();
       }
     } catch (const DxvkError& e) {
-      texture->state = ManagedTexture::State::kFailed;
+      // A resident texture that failed to change resolution keeps the mips it has
+      const bool keepsResidentMips = texture->mipChangeInFlight && texture->allMipsImageView != nullptr;
+      texture->state = keepsResidentMips ? ManagedTexture::State::kVidMem : ManagedTexture::State::kFailed;
       Logger::err("Failed to load texture!");
       Logger::err(e.message());
     }
   }
 
-  VkDeviceSize RtxTextureManager::overBudgetMib(VkDeviceSize percentageOfBudget) const {
+  VkDeviceSize RtxTextureManager::textureUsageMib() const {
     // Get the current memory usage for material textures
     VkDeviceSize currentUsageMib = 0;
     for (uint32_t i = 0; i < m_pDevice->adapter()->memoryProperties().memoryHeapCount; i++) {
@@ -332,7 +717,13 @@ namespace dxvk {
       }
     }
 
-    VkDeviceSize budgetMib = m_textureBudgetMib * percentageOfBudget / 100;
+    return currentUsageMib;
+  }
+
+  VkDeviceSize RtxTextureManager::overBudgetMib(VkDeviceSize percentageOfBudget) const {
+    const VkDeviceSize currentUsageMib = textureUsageMib();
+
+    VkDeviceSize budgetMib = m_textureBudgetMib.load() * percentageOfBudget / 100;
 
     // If we're under budget, great
     if (currentUsageMib < budgetMib)
@@ -20,15 +20,18 @@
 * DEALINGS IN THE SOFTWARE.
 */
 #pragma once
+#include <array>
 #include <mutex>
 #include <queue>
 
+#include "../../util/util_lru.h"
 #include "../../util/util_renderprocessor.h"
 #include "../../util/thread.h"
 #include "../../util/rc/util_rc_ptr.h"
 #include "../../util/sync/sync_signal.h"
 #include "rtx_texture.h"
 #include "rtx_sparse_unique_cache.h"
+#include "rtx_texture_streaming.h"
 
 namespace dxvk {
   class DxvkContext;
@@ -69,8 +72,10 @@ namespace dxvk {
       * \param [in] inputTexture The texture to be added.
       * \param [in] allowAsync Whether asynchronous texture upload is allowed for this texture.
       * \param [out] textureIndexOut Index of the added texture in resource table.
+      * \param [in] hint How prominently the draw referencing the texture is seen, ranks its streaming requests.
     */
-    void addTexture(Rc<DxvkContext>& immediateContext, TextureRef inputTexture, bool allowAsync, uint32_t& textureIndexOut);
+    void addTexture(Rc<DxvkContext>& immediateContext, TextureRef inputTexture, bool allowAsync, uint32_t& textureIndexOut,
+                    const TextureStreamingHint& hint = {});
 
     /**
       * \brief Synchronizes the resource manager.
@@ -128,6 +133,10 @@ namespace dxvk {
 
     // Do not use. This is here temporarily for WAR for REMIX-1557
     void releaseTexture(TextureRef& textureRef) {
+      uint32_t textureIndex;
+      if (m_textureCache.find(textureRef, textureIndex)) {
+        m_textureLru.remove(textureIndex);
+      }
       m_textureCache.free(textureRef);
     }
 
@@ -136,6 +145,11 @@ namespace dxvk {
 
     bool wakeWorkerCondition() override;
 
+    // Streaming requests are taken in order of their score rather than FIFO
+    void pushItem(const Rc<ManagedTexture>& item) override;
+    bool popItem(Rc<ManagedTexture>& item) override;
+    bool hasQueuedItems() const override;
+
   private:
     void flushRtxIo(bool async);
 
@@ -149,7 +163,12 @@ namespace dxvk {
         return lhs.getUniqueKey() == rhs.getUniqueKey();
       }
     };
-    SparseUniqueCache<TextureRef, TextureHashFn, TextureEquality> m_textureCache;
+    using TextureCache = SparseUniqueCache<TextureRef, TextureHashFn, TextureEquality>;
+    TextureCache m_textureCache;
+    // Texture cache slots ordered by the frame they were last used in, for demotion
+    lru_index_list m_textureLru;
+    // Slots that aged out while their upload was in flight, demoted once the upload lands
+    std::vector<TextureCache::Handle> m_deferredDemotions;
 
     DxvkDevice* m_pDevice;
     std::atomic<bool> m_dropRequests = false;
@@ -158,19 +177,53 @@ namespace dxvk {
     dxvk::high_resolution_clock::time_point m_batchStartTime { dxvk::high_resolution_clock::duration(0) };
     dxvk::high_resolution_clock::duration m_lastBatchDuration { dxvk::high_resolution_clock::duration(0) };
 
-    VkDeviceSize m_textureBudgetMib = 0;
+    // Written by the loader threads in loadTexture(), read on the main thread
+    std::atomic<VkDeviceSize> m_textureBudgetMib = 0;
     uint32_t m_promotionStartFrame = 0;
     bool m_preloadInflight = false;
 
-    fast_unordered_cache<Rc<ManagedTexture>> m_assetHashToTextures;
+    fast_flat_cache<Rc<ManagedTexture>> m_assetHashToTextures;
+
+    // Queued streaming requests, guarded by the RenderProcessor queue lock
+    TextureStreamingQueue<Rc<ManagedTexture>> m_streamingQueue;
+    // Queued textures whose streaming hints changed this frame
+    std::vector<Rc<ManagedTexture>> m_streamingPriorityUpdates;
+    // Texture cache slots with a mip change in flight, refreshed once the new mips land
+    std::vector<std::pair<TextureCache::Handle, Rc<ManagedTexture>>> m_pendingMipChanges;
+    std::atomic<VkDeviceSize> m_bytesInFlight = 0;
+
+    // Most recent request latencies in ms, from queueing to upload completion
+    static constexpr uint32_t kNumLatencySamples = 256;
+    std::array<float, kNumLatencySamples> m_latencySamplesMs;
+    uint32_t m_numLatencySamples = 0;
+    dxvk::mutex m_latencyMutex;
 
     RTX_OPTION("rtx.texturemanager", uint32_t, budgetPercentageOfAvailableVram, 50, "The percentage of available VRAM we should use for material textures.  If material textures are required beyond this budget, then those textures will be loaded at lower quality.  Important note, it's impossible to perfectly match the budget while maintaining reasonable quality levels, so use this as more of a guideline.  If the replacements assets are simply too large for the target GPUs available vid mem, we may end up going overbudget regularly.  Defaults to 50% of the available VRAM.");
     RTX_OPTION("rtx.texturemanager", bool, showProgress, false, "Show texture loading progress in the HUD.");
+    RTX_OPTION("rtx.texturemanager", uint32_t, numLoaderThreads, 2, "The number of threads loading replacement textures concurrently, clamped to [1, 8].  RTX IO always uses a single thread since it batches the loads itself.");
+    RTX_OPTION("rtx.texturemanager", float, streamingCoverageWeight, 1.f, "Weight of the screen coverage of the instances referencing a texture, from 0 to 1, in its streaming priority.");
+    RTX_OPTION("rtx.texturemanager", float, streamingDistanceWeight, 0.25f, "Weight of the closeness of the instances referencing a texture in its streaming priority, scaled by 1 / (1 + distance in meters).");
+    RTX_OPTION("rtx.texturemanager", float, streamingAgeWeight, 0.01f, "Streaming priority a texture request gains for every frame it has been waiting, so requests off screen still get loaded eventually.");
+    RTX_OPTION("rtx.texturemanager", float, streamingMipDeficitWeight, 0.05f, "Streaming priority a texture request gains for every mip level it is missing compared to the level requested.");
+    RTX_OPTION("rtx.texturemanager", uint32_t, maxStreamingMipChangesPerFrame, 8, "The maximum number of resident textures promoted or demoted by one mip level per frame to follow the texture budget.  Only used with adaptive resolution replacement textures.");
 
     bool isTextureSuboptimal(const Rc<ManagedTexture>& texture) const;
     void scheduleTextureLoad(TextureRef& texture, Rc<DxvkContext>& immediateContext, bool allowAsync);
     void loadTexture(const Rc<ManagedTexture>& texture, Rc<DxvkContext>& ctx);
 
+    void queueStreamingRequest(const Rc<ManagedTexture>& texture, int baseMip);
+    void requestMipChange(const TextureCache::Handle& textureHandle, const Rc<ManagedTexture>& texture, int mip);
+    void updateStreamingMips();
+    void recordStreamingLatency(const ManagedTexture& texture);
+
+    void refreshStreamingPriorities();
+
+    TextureStreamingWeights getStreamingWeights() const;
+    float calcStreamingVisibility(const ManagedTexture& texture, uint32_t currentFrame) const;
+    double calcStreamingPriority(const ManagedTexture& texture, uint32_t currentFrame) const;
+    static VkDeviceSize estimateTextureBytes(const ManagedTexture& texture, int baseMip);
+
+    VkDeviceSize textureUsageMib() const;
     VkDeviceSize overBudgetMib(VkDeviceSize percentageOfBudget = 100) const;
   };
 
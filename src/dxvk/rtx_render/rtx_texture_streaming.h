@@ -0,0 +1,199 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace dxvk {
+  // Textures not referenced by a draw for this many frames no longer count as visible when streaming
+  constexpr int32_t kStreamingVisibleFrames = 2;
+
+  struct TextureStreamingWeights {
+    float coverage;
+    float distance;
+    float age;
+    float mipDeficit;
+    float meterToWorldUnits;
+  };
+
+  // What a streaming request is ranked by, taken from the ManagedTexture
+  struct TextureStreamingRequest {
+    float coverage;
+    float distance;
+    uint32_t frameLastRequested;
+    uint32_t frameQueued;
+    // Highest resolution mip available now, and the one the request will load
+    int currentMip;
+    int targetMip;
+  };
+
+  inline float calcTextureStreamingVisibility(float coverage, float distance, uint32_t frameLastRequested,
+                                              uint32_t currentFrame, const TextureStreamingWeights& weights) {
+    if (static_cast<int32_t>(currentFrame - frameLastRequested) > kStreamingVisibleFrames) {
+      return 0.f;
+    }
+
+    const float distanceMeters = distance / weights.meterToWorldUnits;
+
+    return weights.coverage * coverage + weights.distance / (1.f + distanceMeters);
+  }
+
+  // The score of a request without the age term every queued request gains at the same rate.  Ranking by it
+  // gives the same order as ranking by the full score, and it only changes when the hints of the texture do,
+  // or when it stops being visible.
+  inline double calcTextureStreamingPriority(const TextureStreamingRequest& request, uint32_t currentFrame,
+                                             const TextureStreamingWeights& weights) {
+    const float mipDeficit = static_cast<float>(std::max(request.currentMip - request.targetMip, 0));
+
+    return double(calcTextureStreamingVisibility(request.coverage, request.distance, request.frameLastRequested, currentFrame, weights)) +
+           double(weights.mipDeficit) * mipDeficit -
+           double(weights.age) * request.frameQueued;
+  }
+
+  inline double calcTextureStreamingScore(const TextureStreamingRequest& request, uint32_t currentFrame,
+                                          const TextureStreamingWeights& weights) {
+    const uint32_t frameQueued = std::min(request.frameQueued, currentFrame);
+    TextureStreamingRequest clamped = request;
+    clamped.frameQueued = frameQueued;
+
+    return calcTextureStreamingPriority(clamped, currentFrame, weights) + double(weights.age) * currentFrame;
+  }
+
+  // Streaming requests ordered by priority, highest first, ties in the order they were last pushed.
+  //
+  // Requests queued in the current frame can be held back until the next one, those are kept apart and only
+  // taken once no older request is left.
+  //
+  // Priorities are checked lazily: when a request reaches the top, `getPriority(item, version, priority)`
+  // recomputes it.  A lower priority (the texture went out of view) moves the request down.  Priorities that
+  // increase have to be pushed again with a new version, `getPriority` returns false for the old one so
+  // it's dropped when it reaches the top.
+  template<typename Item>
+  class TextureStreamingQueue {
+  public:
+    void push(const Item& item, double priority, uint32_t version, uint32_t frameQueued) {
+      // Re-pushed requests of an earlier frame are never held back
+      if (frameQueued < m_pendingFrame) {
+        pushNode(m_ready, Node { priority, m_nextSequence++, version, item });
+        return;
+      }
+
+      // Everything held back from an earlier frame can go now
+      if (!m_pending.empty() && m_pendingFrame < frameQueued) {
+        releasePending();
+      }
+
+      m_pendingFrame = frameQueued;
+      pushNode(m_pending, Node { priority, m_nextSequence++, version, item });
+    }
+
+    template<typename GetPriority>
+    bool pop(Item& item, uint32_t currentFrame, bool holdBack, GetPriority&& getPriority) {
+      if (!m_pending.empty() && (!holdBack || m_pendingFrame < currentFrame)) {
+        releasePending();
+      }
+
+      Heap* heap = nullptr;
+      if (settleTop(m_ready, getPriority)) {
+        heap = &m_ready;
+      } else if (settleTop(m_pending, getPriority)) {
+        heap = &m_pending;
+      } else {
+        return false;
+      }
+
+      std::pop_heap(heap->begin(), heap->end(), NodeOrder());
+      item = std::move(heap->back().item);
+      heap->pop_back();
+      return true;
+    }
+
+    size_t size() const {
+      return m_ready.size() + m_pending.size();
+    }
+
+    bool empty() const {
+      return m_ready.empty() && m_pending.empty();
+    }
+
+  private:
+    struct Node {
+      double priority;
+      uint64_t sequence;
+      uint32_t version;
+      Item item;
+    };
+
+    struct NodeOrder {
+      bool operator()(const Node& a, const Node& b) const {
+        if (a.priority != b.priority) {
+          return a.priority < b.priority;
+        }
+        return a.sequence > b.sequence;
+      }
+    };
+
+    using Heap = std::vector<Node>;
+
+    static void pushNode(Heap& heap, Node&& node) {
+      heap.push_back(std::move(node));
+      std::push_heap(heap.begin(), heap.end(), NodeOrder());
+    }
+
+    // Drops superseded requests and re-ranks ones whose priority went down until the top is up to date.
+    // Every other node has a priority at least as high as its actual one, so the top is the best request.
+    template<typename GetPriority>
+    static bool settleTop(Heap& heap, GetPriority& getPriority) {
+      while (!heap.empty()) {
+        Node& top = heap.front();
+        double priority;
+
+        if (!getPriority(static_cast<const Item&>(top.item), top.version, priority)) {
+          std::pop_heap(heap.begin(), heap.end(), NodeOrder());
+          heap.pop_back();
+        } else if (priority < top.priority) {
+          std::pop_heap(heap.begin(), heap.end(), NodeOrder());
+          heap.back().priority = priority;
+          std::push_heap(heap.begin(), heap.end(), NodeOrder());
+        } else {
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    void releasePending() {
+      for (Node& node : m_pending) {
+        pushNode(m_ready, std::move(node));
+      }
+      m_pending.clear();
+    }
+
+    Heap m_ready;
+    Heap m_pending;
+    uint32_t m_pendingFrame = 0;
+    uint64_t m_nextSequence = 0;
+  };
+}
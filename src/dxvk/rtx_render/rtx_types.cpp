@@ -65,8 +65,9 @@ namespace dxvk {
   }
 
   bool DrawCallState::finalizeGeometryHashes() {
+    // Hashes reused from the geometry hash cache are set without a future
     if (!geometryData.futureGeometryHashes.valid())
-      return false;
+      return geometryData.hashes[HashComponents::VertexPosition] != kEmptyHash;
 
     geometryData.hashes = geometryData.futureGeometryHashes.get();
 
@@ -103,7 +104,7 @@ namespace dxvk {
       // In rare cases when the mesh is skinned but has only one active bone, skip the skinning pass
       // and bake that single bone into the objectToWorld/View matrices.
       if (skinningData.minBoneIndex + 1 == skinningData.numBones) {
-        const Matrix4& skinningMatrix = skinningData.pBoneMatrices[skinningData.minBoneIndex];
+        const Matrix4& skinningMatrix = skinningData.bonePalette[skinningData.minBoneIndex];
 
         transformData.objectToWorld = transformData.objectToWorld * skinningMatrix;
         transformData.objectToView = transformData.objectToView * skinningMatrix;
@@ -351,14 +352,7 @@ namespace dxvk {
   }
 
   void BlasEntry::rebuildSpatialMap() {
-    InstanceMap newMap(RtxOptions::uniqueObjectDistance() * 2.f);
-    
-    for (const auto& iter : m_spatialMap.getAll()){
-      for (const RtInstance* instance : iter.second) {
-        newMap.insert(instance->getSpatialCachePosition(), instance);
-      }
-    }
-    m_spatialMap = std::move(newMap);
+    m_spatialMap.rebuild(RtxOptions::uniqueObjectDistance() * 2.f);
   }
 
 } // namespace dxvk
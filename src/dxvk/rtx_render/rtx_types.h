@@ -26,6 +26,7 @@
 #include "rtx_materials.h"
 #include "rtx_hashing.h"
 #include "rtx_camera.h"
+#include "rtx_bone_palette.h"
 #include "vulkan/vulkan_core.h"
 #include "../../util/util_threadpool.h"
 #include "../../util/util_spatial_map.h"
@@ -55,7 +56,7 @@ constexpr uint32_t kDLFGMaxGPUFramesInFlight = 2;
 // circular includes.  This probably requires a 
 // general cleanup.
 struct SkinningData {
-  std::vector<Matrix4> pBoneMatrices;
+  BonePalette bonePalette; // Shared with other draws submitting the same matrices this frame
   uint32_t numBones = 0;
   uint32_t numBonesPerVertex = 0;
   XXH64_hash_t boneHash = 0;
@@ -64,7 +65,7 @@ struct SkinningData {
   void computeHash() {
     if (numBones > 0) {
       assert(minBoneIndex >= 0);
-      const Matrix4* firstBone = &pBoneMatrices[minBoneIndex];
+      const Matrix4* firstBone = &bonePalette[minBoneIndex];
       assert(numBones > minBoneIndex);
       boneHash = XXH3_64bits(firstBone, (numBones - minBoneIndex) * sizeof(Matrix4));
     } else {
@@ -100,6 +101,9 @@ struct RaytraceGeometry {
   uint32_t texcoordBufferIndex = kSurfaceInvalidBufferIndex;
   uint32_t color0BufferIndex = kSurfaceInvalidBufferIndex;
   uint32_t indexBufferIndex = kSurfaceInvalidBufferIndex;
+  // Slot of the position buffer in the scene buffer table.  The other indices
+  // are tracked along with it and go stale when it does.
+  BufferRefTable<RaytraceBuffer>::Handle positionBufferHandle;
 
   Rc<DxvkBuffer> historyBuffer[2] = {nullptr};
   Rc<DxvkBuffer> indexCacheBuffer = nullptr;
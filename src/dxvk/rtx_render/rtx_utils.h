@@ -152,8 +152,16 @@ class GeometryBuffer : public DxvkBufferSlice {
 // the DxvkBufferSlice information into matching which is good enough for bindless manager purposes.
 // It is a drop-in replacement for SparseUniqueCache<RaytraceBuffer> where references cannot
 // be removed one-by-one, however the whole container can be cleared of references using clear() method.
+// clear() frees every slot at once, so all handles share the generation of the table.
 template<typename BufferType>
 struct BufferRefTable {
+  static constexpr uint32_t kInvalidIndex = ~0u;
+
+  struct Handle {
+    uint32_t index = kInvalidIndex;
+    uint32_t generation = 0;
+  };
+
   struct DefaultMatcher {
     bool operator() (const BufferType& a, const BufferType& b) {
       return a.matches(b);
@@ -162,18 +170,29 @@ struct BufferRefTable {
 
   void clear() {
     m_table.clear();
+    ++m_generation;
   }
 
   template<typename Matcher = DefaultMatcher>
   uint32_t track(const BufferType& b, Matcher&& eq = DefaultMatcher()) {
+    return trackHandle(b, std::forward<Matcher>(eq)).index;
+  }
+
+  template<typename Matcher = DefaultMatcher>
+  Handle trackHandle(const BufferType& b, Matcher&& eq = DefaultMatcher()) {
     const uint32_t idx = m_table.size();
 
     if (idx > 0 && eq(b, m_table.back())) {
-      return idx - 1;
+      return Handle { idx - 1, m_generation };
     }
 
     m_table.push_back(b);
-    return idx;
+    return Handle { idx, m_generation };
+  }
+
+  // True when the handle was issued since the last clear
+  bool isCurrent(const Handle& handle) const {
+    return handle.index < m_table.size() && handle.generation == m_generation;
   }
 
   const std::vector<BufferType>& getObjectTable() const {
@@ -189,6 +208,8 @@ struct BufferRefTable {
   }
 
   std::vector<BufferType> m_table;
+  // Starts at 1 so default constructed handles are never current
+  uint32_t m_generation = 1;
 };
 
 inline uint32_t setBit(uint32_t target, bool value, uint32_t oneBitMask) {
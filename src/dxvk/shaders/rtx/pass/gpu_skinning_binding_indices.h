@@ -30,13 +30,12 @@
 #define BINDING_BLEND_INDICES_INPUT   4
 #define BINDING_NORMAL_OUTPUT         5
 #define BINDING_NORMAL_INPUT          6
+#define BINDING_BONE_MATRICES         7
 
 /**
 * \brief Args required to perform skinning
 */
 struct SkinningArgs {
-  mat4 bones[256]; // 256 is the max bone count in DX (swvp)
-
   uint dstPositionOffset;
   uint dstPositionStride;
   uint srcPositionOffset;
@@ -67,6 +67,7 @@ void skinning(const uint32_t idx,
               ReadBuffer(float) srcBlendWeight,
               ReadByteBuffer srcBlendIndices,
               ReadBuffer(float) srcNormal,
+              ReadBuffer(Matrix4) bones,
               ConstBuffer(SkinningArgs) cb) {
   const uint32_t baseWeightsOffset = (cb.blendWeightOffset + idx * cb.blendWeightStride) / 4;
 
@@ -95,7 +96,7 @@ void skinning(const uint32_t idx,
       for (uint i = 0; i < 4 && i + j < cb.numBones; ++i) {
         float blendWeight = i + j == cb.numBones - 1 ? lastWeight : srcBlendWeight[baseWeightsOffset + i + j];
         if (blendWeight > 0) {
-          Matrix4 bone = toMatrix4(cb.bones[blendIndices[i]]);
+          Matrix4 bone = toMatrix4(bones[blendIndices[i]]);
           positionOut += mul(bone, position) * blendWeight;
           normalOut += mul(bone, normal) * blendWeight;
         }
@@ -105,14 +106,14 @@ void skinning(const uint32_t idx,
     for (uint i = 0; i < cb.numBones - 1; ++i) {
       float blendWeight = srcBlendWeight[baseWeightsOffset + i];
       if (blendWeight > 0.f) {
-        Matrix4 bone = toMatrix4(cb.bones[i]);
+        Matrix4 bone = toMatrix4(bones[i]);
         positionOut += mul(bone, position) * blendWeight;
         normalOut += mul(bone, normal) * blendWeight;
       }
     }
     // Unwrap the last bone, since blendWeights only contains numBones - 1 weights
     if (lastWeight > 0.f) {
-      Matrix4 bone = toMatrix4(cb.bones[cb.numBones - 1]);
+      Matrix4 bone = toMatrix4(bones[cb.numBones - 1]);
       positionOut += mul(bone, position) * lastWeight;
       normalOut += mul(bone, normal) * lastWeight;
     }
@@ -334,7 +334,8 @@ namespace lss {
     indicesOut.resize(numIndices);
     m_vertexData.resize(numVertexElements);
 
-    fast_unordered_cache<uint32_t> uniqueVertexToIndex;
+    fast_flat_cache<uint32_t> uniqueVertexToIndex;
+    uniqueVertexToIndex.reserve(numIndices);
 
     // Temp stack storage for blend weights/indices
     uint32_t blendIndicesStorage[MaxSupportedNumBones];
@@ -21,58 +21,259 @@
 */
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <cstdint>
 #include <cstring>
 #include <utility>
 
+#include "util_math.h"
+
 namespace dxvk {
+  namespace atomic_queue {
+    // Ring sizes are rounded up to a power of two so indices wrap with a mask
+    constexpr uint32_t ringSize(uint32_t capacity) {
+      uint32_t size = 1;
+      while (size < capacity) {
+        size <<= 1;
+      }
+      return size;
+    }
+  }
+
   /**
     * \brief Implements a (SPSC) queue with similar functionality to STL.
-    *        Not implemented as a linked list, but  as a ring buffer 
+    *        Not implemented as a linked list, but  as a ring buffer
     *        of fixed size to avoid runtime alloc overhead.
     *        Since this object is SPSC, only a single thread may "push",
-    *        while another thread may "pop" simultaneously.
+    *        while another thread may "pop" simultaneously.  Several
+    *        producers (or consumers) must serialize among themselves.
     *  T: Type of the object
-    *  Capacity: Number of elements in the ring buffer.
+    *  Capacity: Minimum number of elements the queue can hold, rounded
+    *            up to a power of two.
     */
   template <typename T, uint32_t Capacity>
   class AtomicQueue {
+    static constexpr uint32_t kSize = atomic_queue::ringSize(Capacity);
+    static constexpr uint32_t kMask = kSize - 1;
+    static_assert(kSize <= (1u << 31), "Capacity too large for 32-bit ring positions");
+
   public:
-    AtomicQueue() {
-      m_head = m_tail = 0;
+    static constexpr uint32_t capacity() {
+      return kSize;
     }
 
+    // Producer side
     bool isFull() const {
-      return ((m_tail + 1) % Capacity) == m_head;
+      return m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_acquire) == kSize;
+    }
+
+    bool isEmpty() const {
+      return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_relaxed);
     }
 
     bool push(T&& item) {
-      auto tail = m_tail.load();
-      auto nextTail = (tail + 1) % Capacity;
-      if (nextTail == m_head.load()) {
-        return false;  // queue is full
+      return push(&item, 1) == 1;
+    }
+
+    bool pop(T& item) {
+      return pop(&item, 1) == 1;
+    }
+
+    // Moves up to count items into the queue, returns the number pushed
+    uint32_t push(T* items, uint32_t count) {
+      const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+
+      // Only reload the consumer's position when the cached one says we're full
+      if (kSize - (tail - m_cachedHead) < count) {
+        m_cachedHead = m_head.load(std::memory_order_acquire);
+      }
+
+      const uint32_t numPushed = std::min(count, kSize - (tail - m_cachedHead));
+      for (uint32_t i = 0; i < numPushed; i++) {
+        m_data[(tail + i) & kMask] = std::move(items[i]);
+      }
+
+      if (numPushed > 0) {
+        m_tail.store(tail + numPushed, std::memory_order_release);
+      }
+      return numPushed;
+    }
+
+    // Moves up to maxCount items out of the queue, returns the number popped
+    uint32_t pop(T* items, uint32_t maxCount) {
+      const uint32_t head = m_head.load(std::memory_order_relaxed);
+
+      if (m_cachedTail - head < maxCount) {
+        m_cachedTail = m_tail.load(std::memory_order_acquire);
+      }
+
+      const uint32_t numPopped = std::min(maxCount, m_cachedTail - head);
+      for (uint32_t i = 0; i < numPopped; i++) {
+        items[i] = std::move(m_data[(head + i) & kMask]);
+      }
+
+      if (numPopped > 0) {
+        m_head.store(head + numPopped, std::memory_order_release);
+      }
+      return numPopped;
+    }
+
+  private:
+    // Producer and consumer state live on separate cache lines, each side
+    // keeps a cached copy of the other's position to avoid bouncing lines.
+    // Positions increase monotonically and are masked on access.
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> m_head = 0;
+    uint32_t m_cachedTail = 0;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> m_tail = 0;
+    uint32_t m_cachedHead = 0;
+
+    alignas(CACHE_LINE_SIZE) std::array<T, kSize> m_data;
+  };
+
+  /**
+    * \brief Bounded, lock-free, multi-producer multi-consumer queue.
+    *        Every cell carries a sequence number telling producers
+    *        and consumers whether it's free for the current lap or
+    *        holds an element (D. Vyukov's bounded MPMC queue).
+    *        Any number of threads may push and pop concurrently.
+    *  T: Type of the object
+    *  Capacity: Minimum number of elements the queue can hold, rounded
+    *            up to a power of two.
+    */
+  template <typename T, uint32_t Capacity>
+  class MpmcAtomicQueue {
+    static constexpr uint32_t kSize = atomic_queue::ringSize(Capacity);
+    static constexpr uint32_t kMask = kSize - 1;
+    static_assert(kSize >= 2, "Sequence numbers need at least two cells to tell full from empty");
+    static_assert(kSize <= (1u << 30), "Capacity too large for 32-bit sequence numbers");
+
+  public:
+    MpmcAtomicQueue() {
+      for (uint32_t i = 0; i < kSize; i++) {
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
       }
-      m_data[tail] = std::move(item);
-      m_tail.store(nextTail);
-      return true;
+    }
+
+    static constexpr uint32_t capacity() {
+      return kSize;
+    }
+
+    // A hint only, other threads may change the queue right after
+    bool isFull() const {
+      const uint32_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+      return static_cast<int32_t>(m_cells[pos & kMask].sequence.load(std::memory_order_acquire) - pos) < 0;
+    }
+
+    bool push(T&& item) {
+      return push(&item, 1) == 1;
     }
 
     bool pop(T& item) {
-      uint32_t head, nextHead;
-      do {
-        head = m_head.load();
-        if (head == m_tail.load()) {
-          return false;  // queue is empty
+      return pop(&item, 1) == 1;
+    }
+
+    /**
+      * \brief Moves up to count items into the queue
+      *
+      *  A contiguous run of free cells is claimed with a single CAS,
+      *  so batches from one producer stay in order.
+      * \returns Number of items pushed, 0 when the queue is full
+      */
+    uint32_t push(T* items, uint32_t count) {
+      if (count == 0) {
+        return 0;
+      }
+
+      uint32_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+      uint32_t numClaimed;
+
+      while (true) {
+        numClaimed = countReady(pos, count, 0);
+        if (numClaimed == 0) {
+          const int32_t diff = static_cast<int32_t>(m_cells[pos & kMask].sequence.load(std::memory_order_acquire) - pos);
+          if (diff < 0) {
+            return 0;  // queue is full
+          }
+          // Another producer got here first
+          pos = m_enqueuePos.load(std::memory_order_relaxed);
+          continue;
+        }
+
+        if (m_enqueuePos.compare_exchange_weak(pos, pos + numClaimed, std::memory_order_relaxed)) {
+          break;
         }
-        nextHead = (head + 1) % Capacity;
-      } while (!m_head.compare_exchange_weak(head, nextHead));
-      item = std::move(m_data[head]);
-      return true;
+      }
+
+      for (uint32_t i = 0; i < numClaimed; i++) {
+        Cell& cell = m_cells[(pos + i) & kMask];
+        cell.data = std::move(items[i]);
+        cell.sequence.store(pos + i + 1, std::memory_order_release);
+      }
+      return numClaimed;
+    }
+
+    /**
+      * \brief Moves up to maxCount items out of the queue
+      * \returns Number of items popped, 0 when the queue is empty
+      */
+    uint32_t pop(T* items, uint32_t maxCount) {
+      if (maxCount == 0) {
+        return 0;
+      }
+
+      uint32_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+      uint32_t numClaimed;
+
+      while (true) {
+        numClaimed = countReady(pos, maxCount, 1);
+        if (numClaimed == 0) {
+          const int32_t diff = static_cast<int32_t>(m_cells[pos & kMask].sequence.load(std::memory_order_acquire) - (pos + 1));
+          if (diff < 0) {
+            return 0;  // queue is empty
+          }
+          // Another consumer got here first
+          pos = m_dequeuePos.load(std::memory_order_relaxed);
+          continue;
+        }
+
+        if (m_dequeuePos.compare_exchange_weak(pos, pos + numClaimed, std::memory_order_relaxed)) {
+          break;
+        }
+      }
+
+      for (uint32_t i = 0; i < numClaimed; i++) {
+        Cell& cell = m_cells[(pos + i) & kMask];
+        items[i] = std::move(cell.data);
+        // Free the cell for the producers of the next lap
+        cell.sequence.store(pos + i + kSize, std::memory_order_release);
+      }
+      return numClaimed;
     }
 
   private:
-    std::array<T, Capacity> m_data;
-    std::atomic<uint32_t> m_head;
-    std::atomic<uint32_t> m_tail;
+    struct Cell {
+      std::atomic<uint32_t> sequence;
+      T data;
+    };
+
+    // Number of consecutive cells starting at pos whose sequence is (pos + i + offset),
+    // i.e. free (offset 0) or filled (offset 1) for this lap.  A cell observed in that
+    // state can only be changed by whoever claims its position, so the run stays valid
+    // for as long as the CAS on the position succeeds.
+    uint32_t countReady(uint32_t pos, uint32_t maxCount, uint32_t offset) const {
+      const uint32_t limit = std::min(maxCount, kSize);
+      uint32_t n = 0;
+      while (n < limit && m_cells[(pos + n) & kMask].sequence.load(std::memory_order_acquire) == pos + n + offset) {
+        n++;
+      }
+      return n;
+    }
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> m_enqueuePos = 0;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> m_dequeuePos = 0;
+    alignas(CACHE_LINE_SIZE) std::array<Cell, kSize> m_cells;
   };
 } //dxvk
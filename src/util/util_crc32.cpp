@@ -0,0 +1,83 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <array>
+#include <cstring>
+
+#include "util_crc32.h"
+
+namespace dxvk {
+
+  namespace {
+
+    // Slicing-by-8 tables, table[0] is the classic byte-at-a-time table
+    using Crc32Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+    Crc32Tables buildCrc32Tables() {
+      Crc32Tables tables;
+
+      for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (uint32_t bit = 0; bit < 8; bit++) {
+          crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320u : 0u);
+        }
+        tables[0][i] = crc;
+      }
+
+      for (uint32_t i = 0; i < 256; i++) {
+        for (uint32_t slice = 1; slice < 8; slice++) {
+          const uint32_t prev = tables[slice - 1][i];
+          tables[slice][i] = (prev >> 8) ^ tables[0][prev & 0xff];
+        }
+      }
+
+      return tables;
+    }
+
+    const Crc32Tables s_crc32Tables = buildCrc32Tables();
+
+  }
+
+  uint32_t crc32(const void* data, size_t size, uint32_t crc) {
+    const Crc32Tables& t = s_crc32Tables;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+    crc = ~crc;
+
+    // Note: assumes a little-endian host, like the rest of the code base
+    for (; size >= 8; size -= 8, bytes += 8) {
+      uint32_t lo, hi;
+      std::memcpy(&lo, bytes, 4);
+      std::memcpy(&hi, bytes + 4, 4);
+      lo ^= crc;
+
+      crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+            t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+    }
+
+    for (; size > 0; size--, bytes++) {
+      crc = (crc >> 8) ^ t[0][(crc ^ *bytes) & 0xff];
+    }
+
+    return ~crc;
+  }
+
+}
@@ -24,6 +24,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include "xxHash/xxhash.h"
+#include "util_flat_cache.h"
 
 
 namespace dxvk {
@@ -54,6 +55,7 @@ namespace dxvk {
   };
 
   // A fast caching structure for use ONLY with already hashed keys.
+  // See fast_flat_cache / fast_stable_cache for open addressing alternatives with the same interface.
   template<class T>
   struct fast_unordered_cache : public std::unordered_map<XXH64_hash_t, T, XXH64_hash_passthrough> {
     template<typename P>
@@ -23,6 +23,7 @@
 #include <math.h>
 #include <intrin.h>
 #include "util_math.h"
+#include "util_bit.h"
 #include "util_fastops.h"
 #include <algorithm>
 #include <ppl.h>
@@ -76,6 +77,14 @@ namespace fast {
 
   static const bool g_supportsBMI2 = initBmi2Support();
 
+  static bool initF16CSupport() {
+    int result[4];
+    __cpuid(result, 0x1);
+    return (result[2] & (1 << 29));
+  }
+
+  static const bool g_supportsF16C = initF16CSupport();
+
   SIMD getSimdSupportLevel() {
     return g_simdSupportLevel;
   }
@@ -931,6 +940,168 @@ namespace fast {
   template void copySubtract<uint16_t>(uint16_t* dstData, const uint16_t* srcData, const uint32_t count, const uint16_t value, const bool ignoreSentinel, const uint16_t sentinelValue);
   template void copySubtract<uint32_t>(uint32_t* dstData, const uint32_t* srcData, const uint32_t count, const uint32_t value, const bool ignoreSentinel, const uint32_t sentinelValue);
 
+  template<typename T>
+  __forceinline void markIndices(const uint32_t count, const T* data, uint8_t* flags) {
+    // Plain byte stores carry no read-modify-write dependency between neighbouring indices (unlike a bitset),
+    // so consecutive indices into the same region don't serialize.  Unrolled to overlap the independent stores.
+    const uint32_t alignedCount = dxvk::alignDown(count, 4u);
+
+    for (uint32_t i = 0; i < alignedCount; i += 4) {
+      flags[data[i + 0]] = 1;
+      flags[data[i + 1]] = 1;
+      flags[data[i + 2]] = 1;
+      flags[data[i + 3]] = 1;
+    }
+
+    for (uint32_t i = alignedCount; i < count; i++) {
+      flags[data[i]] = 1;
+    }
+  }
+
+  template<typename T>
+  __forceinline uint32_t emitSetBits(uint32_t mask, const uint32_t base, T* uniqueOut) {
+    uint32_t n = 0;
+    while (mask) {
+      unsigned long bit;
+      _BitScanForward(&bit, mask);
+      uniqueOut[n++] = (T) (base + bit);
+      mask &= mask - 1;
+    }
+    return n;
+  }
+
+  template<typename T>
+  __forceinline void emitRun_SSE(const uint32_t base, T* uniqueOut) {
+    // Writes the 16 contiguous values [base, base + 16)
+    if constexpr (sizeof(T) == 2) {
+      const __m128i values = _mm_add_epi16(_mm_set1_epi16((short) base), _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7));
+      _mm_storeu_si128((__m128i*) &uniqueOut[0], values);
+      _mm_storeu_si128((__m128i*) &uniqueOut[8], _mm_add_epi16(values, _mm_set1_epi16(8)));
+    } else {
+      const __m128i values = _mm_add_epi32(_mm_set1_epi32((int) base), _mm_setr_epi32(0, 1, 2, 3));
+      _mm_storeu_si128((__m128i*) &uniqueOut[0], values);
+      _mm_storeu_si128((__m128i*) &uniqueOut[4], _mm_add_epi32(values, _mm_set1_epi32(4)));
+      _mm_storeu_si128((__m128i*) &uniqueOut[8], _mm_add_epi32(values, _mm_set1_epi32(8)));
+      _mm_storeu_si128((__m128i*) &uniqueOut[12], _mm_add_epi32(values, _mm_set1_epi32(12)));
+    }
+  }
+
+  template<typename T>
+  __forceinline void emitRun_AVX2(const uint32_t base, T* uniqueOut) {
+    // Writes the 32 contiguous values [base, base + 32)
+    if constexpr (sizeof(T) == 2) {
+      const __m256i values = _mm256_add_epi16(_mm256_set1_epi16((short) base), _mm256_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+      _mm256_storeu_si256((__m256i*) &uniqueOut[0], values);
+      _mm256_storeu_si256((__m256i*) &uniqueOut[16], _mm256_add_epi16(values, _mm256_set1_epi16(16)));
+    } else {
+      const __m256i values = _mm256_add_epi32(_mm256_set1_epi32((int) base), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+      _mm256_storeu_si256((__m256i*) &uniqueOut[0], values);
+      _mm256_storeu_si256((__m256i*) &uniqueOut[8], _mm256_add_epi32(values, _mm256_set1_epi32(8)));
+      _mm256_storeu_si256((__m256i*) &uniqueOut[16], _mm256_add_epi32(values, _mm256_set1_epi32(16)));
+      _mm256_storeu_si256((__m256i*) &uniqueOut[24], _mm256_add_epi32(values, _mm256_set1_epi32(24)));
+    }
+  }
+
+  template<typename T>
+  uint32_t deduplicateSortIndices_slow(const uint32_t count, const T* data, const uint32_t maxValue, uint8_t* flagsScratch, T* uniqueOut) {
+    const uint32_t range = maxValue + 1;
+    memset(flagsScratch, 0, range);
+
+    markIndices(count, data, flagsScratch);
+
+    uint32_t uniqueCount = 0;
+    for (uint32_t i = 0; i < range; i++) {
+      uniqueOut[uniqueCount] = (T) i;
+      uniqueCount += flagsScratch[i];
+    }
+    return uniqueCount;
+  }
+
+  template<typename T>
+  uint32_t deduplicateSortIndices_SSE(const uint32_t count, const T* data, const uint32_t maxValue, uint8_t* flagsScratch, T* uniqueOut) {
+    const uint32_t numLanes = 16;
+    const uint32_t scratchSize = deduplicateSortIndicesScratchSize(maxValue);
+    memset(flagsScratch, 0, scratchSize);
+
+    markIndices(count, data, flagsScratch);
+
+    const __m128i zero = _mm_setzero_si128();
+
+    uint32_t uniqueCount = 0;
+    for (uint32_t i = 0; i < scratchSize; i += numLanes) {
+      const __m128i flags = _mm_loadu_si128((const __m128i*) &flagsScratch[i]);
+      const uint32_t mask = (uint32_t) _mm_movemask_epi8(_mm_cmpgt_epi8(flags, zero));
+
+      if (mask == 0) {
+        // Unused region of the index range
+        continue;
+      } else if (mask == 0xFFFF) {
+        // Fully referenced, very common for strips and well ordered meshes
+        emitRun_SSE(i, &uniqueOut[uniqueCount]);
+        uniqueCount += numLanes;
+      } else {
+        uniqueCount += emitSetBits(mask, i, &uniqueOut[uniqueCount]);
+      }
+    }
+    return uniqueCount;
+  }
+
+  template<typename T>
+  uint32_t deduplicateSortIndices_AVX2(const uint32_t count, const T* data, const uint32_t maxValue, uint8_t* flagsScratch, T* uniqueOut) {
+    const uint32_t numLanes = 32;
+    const uint32_t scratchSize = deduplicateSortIndicesScratchSize(maxValue);
+    memset(flagsScratch, 0, scratchSize);
+
+    markIndices(count, data, flagsScratch);
+
+    const __m256i zero = _mm256_setzero_si256();
+
+    uint32_t uniqueCount = 0;
+    for (uint32_t i = 0; i < scratchSize; i += numLanes) {
+      const __m256i flags = _mm256_loadu_si256((const __m256i*) &flagsScratch[i]);
+      const uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpgt_epi8(flags, zero));
+
+      if (mask == 0) {
+        // Unused region of the index range
+        continue;
+      } else if (mask == 0xFFFFFFFF) {
+        // Fully referenced, very common for strips and well ordered meshes
+        emitRun_AVX2(i, &uniqueOut[uniqueCount]);
+        uniqueCount += numLanes;
+      } else {
+        uniqueCount += emitSetBits(mask, i, &uniqueOut[uniqueCount]);
+      }
+    }
+    return uniqueCount;
+  }
+
+  template<typename T>
+  uint32_t deduplicateSortIndices(const uint32_t count, const T* data, const uint32_t maxValue, uint8_t* flagsScratch, T* uniqueOut) {
+    static_assert(std::is_same<T, uint16_t>::value || std::is_same<T, uint32_t>::value, "not a supported type");
+
+    switch (g_simdSupportLevel) {
+    case SIMD::AVX512:
+    case SIMD::AVX2:
+      return deduplicateSortIndices_AVX2(count, data, maxValue, flagsScratch, uniqueOut);
+    case SIMD::SSE4_1:
+    case SIMD::SSE3:
+    case SIMD::SSE2:
+      return deduplicateSortIndices_SSE(count, data, maxValue, flagsScratch, uniqueOut);
+    default:
+      return deduplicateSortIndices_slow(count, data, maxValue, flagsScratch, uniqueOut);
+    }
+  }
+
+  template uint32_t deduplicateSortIndices_slow<uint16_t>(const uint32_t count, const uint16_t* data, const uint32_t maxValue, uint8_t* flagsScratch, uint16_t* uniqueOut);
+  template uint32_t deduplicateSortIndices_slow<uint32_t>(const uint32_t count, const uint32_t* data, const uint32_t maxValue, uint8_t* flagsScratch, uint32_t* uniqueOut);
+  template uint32_t deduplicateSortIndices_SSE<uint16_t>(const uint32_t count, const uint16_t* data, const uint32_t maxValue, uint8_t* flagsScratch, uint16_t* uniqueOut);
+  template uint32_t deduplicateSortIndices_SSE<uint32_t>(const uint32_t count, const uint32_t* data, const uint32_t maxValue, uint8_t* flagsScratch, uint32_t* uniqueOut);
+  template uint32_t deduplicateSortIndices_AVX2<uint16_t>(const uint32_t count, const uint16_t* data, const uint32_t maxValue, uint8_t* flagsScratch, uint16_t* uniqueOut);
+  template uint32_t deduplicateSortIndices_AVX2<uint32_t>(const uint32_t count, const uint32_t* data, const uint32_t maxValue, uint8_t* flagsScratch, uint32_t* uniqueOut);
+
+  template uint32_t deduplicateSortIndices<uint16_t>(const uint32_t count, const uint16_t* data, const uint32_t maxValue, uint8_t* flagsScratch, uint16_t* uniqueOut);
+  template uint32_t deduplicateSortIndices<uint32_t>(const uint32_t count, const uint32_t* data, const uint32_t maxValue, uint8_t* flagsScratch, uint32_t* uniqueOut);
+
   void parallel_memcpy(void* dst, const void* src, const size_t count, const size_t chunkSize) {
     const uint8_t* srcBytes = static_cast<const uint8_t*>(src);
     uint8_t* dstBytes = static_cast<uint8_t*>(dst);
@@ -981,4 +1152,266 @@ namespace fast {
   template uint8_t findNthBit(const uint8_t num, const uint8_t n);
   template uint16_t findNthBit(const uint16_t num, const uint16_t n);
   template uint32_t findNthBit(const uint32_t num, const uint32_t n);
-}
\ No newline at end of file
+
+  __forceinline float halfToFloat(const uint16_t half) {
+    // Moves the exponent and mantissa into place and rebiases with a multiply, which also handles denormals
+    const uint32_t expMant = half & 0x7FFF;
+    uint32_t bits = dxvk::bit::cast<uint32_t>(dxvk::bit::cast<float>(expMant << 13) * dxvk::bit::cast<float>(uint32_t(254 - 15) << 23));
+
+    if (expMant > 0x7BFF)
+      bits |= 255u << 23; // Inf / NaN
+
+    if (expMant > 0x7C00)
+      bits |= 1u << 22;   // Quiet NaNs, as F16C does
+
+    return dxvk::bit::cast<float>(bits | (uint32_t(half & 0x8000) << 16));
+  }
+
+  __forceinline __m128 halfToFloat_SSE2(const __m128i halves) {
+    // Same as halfToFloat, for the 4 halves in the low 64 bits
+    const __m128i h = _mm_unpacklo_epi16(halves, _mm_setzero_si128());
+    const __m128i expMant = _mm_and_si128(h, _mm_set1_epi32(0x7FFF));
+    const __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, expMant), 16);
+    const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMant, 13)), _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+    const __m128i infNan = _mm_and_si128(_mm_cmpgt_epi32(expMant, _mm_set1_epi32(0x7BFF)), _mm_set1_epi32(255 << 23));
+    const __m128i quietNan = _mm_and_si128(_mm_cmpgt_epi32(expMant, _mm_set1_epi32(0x7C00)), _mm_set1_epi32(1 << 22));
+    return _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(_mm_or_si128(sign, infNan), quietNan)));
+  }
+
+  __forceinline void storeFloat3_SSE(uint8_t* dst, const __m128 value) {
+    _mm_storel_pi((__m64*) dst, value);
+    _mm_store_ss((float*) (dst + 8), _mm_movehl_ps(value, value));
+  }
+
+  __forceinline void storeFloat3(uint8_t* dst, const float x, const float y, const float z) {
+    const float value[3] = { x, y, z };
+    memcpy(dst, value, sizeof(value));
+  }
+
+  __forceinline uint32_t loadDword(const uint8_t* src) {
+    uint32_t value;
+    memcpy(&value, src, sizeof(value));
+    return value;
+  }
+
+  __forceinline uint32_t rgba8ToBgra8(const uint32_t value) {
+    return (value & 0xFF00FF00) | ((value >> 16) & 0xFF) | ((value & 0xFF) << 16);
+  }
+
+  template<typename Fn>
+  __forceinline void forEachVertex(uint8_t* dst, const uint32_t dstStride, const uint8_t* src, const uint32_t srcStride, const uint32_t count, Fn fn) {
+    for (uint32_t i = 0; i < count; i++) {
+      fn(dst, src);
+      dst += dstStride;
+      src += srcStride;
+    }
+  }
+
+  __forceinline void packElement_slow(uint8_t* dst, const uint32_t dstStride, const uint8_t* src, const uint32_t srcStride, const uint32_t count, const PackedVertexElement& element) {
+    switch (element.conversion) {
+    case VertexElementConversion::Copy:
+      forEachVertex(dst, dstStride, src, srcStride, count, [size = element.size] (uint8_t* d, const uint8_t* s) {
+        memcpy(d, s, size);
+      });
+      break;
+    case VertexElementConversion::Half4ToFloat3:
+      forEachVertex(dst, dstStride, src, srcStride, count, [] (uint8_t* d, const uint8_t* s) {
+        uint16_t h[4];
+        memcpy(h, s, sizeof(h));
+        storeFloat3(d, halfToFloat(h[0]), halfToFloat(h[1]), halfToFloat(h[2]));
+      });
+      break;
+    case VertexElementConversion::Short4NToFloat3:
+      forEachVertex(dst, dstStride, src, srcStride, count, [] (uint8_t* d, const uint8_t* s) {
+        int16_t c[4];
+        memcpy(c, s, sizeof(c));
+        storeFloat3(d, std::max(float(c[0]) * (1.0f / 32767.0f), -1.0f),
+                       std::max(float(c[1]) * (1.0f / 32767.0f), -1.0f),
+                       std::max(float(c[2]) * (1.0f / 32767.0f), -1.0f));
+      });
+      break;
+    case VertexElementConversion::Dec3NToFloat3:
+      forEachVertex(dst, dstStride, src, srcStride, count, [] (uint8_t* d, const uint8_t* s) {
+        const uint32_t v = loadDword(s);
+        storeFloat3(d, std::max(float(int32_t(v << 22) >> 22) * (1.0f / 511.0f), -1.0f),
+                       std::max(float(int32_t(v << 12) >> 22) * (1.0f / 511.0f), -1.0f),
+                       std::max(float(int32_t(v << 2) >> 22) * (1.0f / 511.0f), -1.0f));
+      });
+      break;
+    case VertexElementConversion::Ubyte4NToFloat3:
+      forEachVertex(dst, dstStride, src, srcStride, count, [] (uint8_t* d, const uint8_t* s) {
+        storeFloat3(d, float(s[0]) * (2.0f / 255.0f) - 1.0f,
+                       float(s[1]) * (2.0f / 255.0f) - 1.0f,
+                       float(s[2]) * (2.0f / 255.0f) - 1.0f);
+      });
+      break;
+    case VertexElementConversion::Rgba8ToBgra8:
+      forEachVertex(dst, dstStride, src, srcStride, count, [] (uint8_t* d, const uint8_t* s) {
+        const uint32_t value = rgba8ToBgra8(loadDword(s));
+        memcpy(d, &value, sizeof(value));
+      });
+      break;
+    }
+  }
+
+  template<uint32_t Size>
+  __forceinline void copyElements_SSE(uint8_t* dst, const uint32_t dstStride, const uint8_t* src, const uint32_t srcStride, const uint32_t count) {
+    forEachVertex(dst, dstStride, src, srcStride, count, [] (uint8_t* d, const uint8_t* s) {
+      for (uint32_t i = 0; i + 16 <= Size; i += 16) {
+        _mm_storeu_si128((__m128i*) (d + i), _mm_loadu_si128((const __m128i*) (s + i)));
+      }
+
+      if constexpr ((Size & 8) != 0) {
+        _mm_storel_epi64((__m128i*) (d + (Size & ~15u)), _mm_loadl_epi64((const __m128i*) (s + (Size & ~15u))));
+      }
+
+      if constexpr ((Size & 4) != 0) {
+        memcpy(d + (Size & ~7u), s + (Size & ~7u), 4);
+      }
+    });
+  }
+
+  template<SIMD V>
+  __forceinline void packElement_SSE(uint8_t* dst, const uint32_t dstStride, const uint8_t* src, const uint32_t srcStride, const uint32_t count, const PackedVertexElement& element) {
+    switch (element.conversion) {
+    case VertexElementConversion::Copy:
+      // Fixed size moves for the common element sizes, instead of a memcpy call per vertex
+      switch (element.size) {
+      case 4:  copyElements_SSE<4>(dst, dstStride, src, srcStride, count); break;
+      case 8:  copyElements_SSE<8>(dst, dstStride, src, srcStride, count); break;
+      case 12: copyElements_SSE<12>(dst, dstStride, src, srcStride, count); break;
+      case 16: copyElements_SSE<16>(dst, dstStride, src, srcStride, count); break;
+      case 20: copyElements_SSE<20>(dst, dstStride, src, srcStride, count); break;
+      case 24: copyElements_SSE<24>(dst, dstStride, src, srcStride, count); break;
+      case 28: copyElements_SSE<28>(dst, dstStride, src, srcStride, count); break;
+      case 32: copyElements_SSE<32>(dst, dstStride, src, srcStride, count); break;
+      default:
+        packElement_slow(dst, dstStride, src, srcStride, count, element);
+        break;
+      }
+      break;
+    case VertexElementConversion::Half4ToFloat3:
+      forEachVertex(dst, dstStride, src, srcStride, count, [] (uint8_t* d, const uint8_t* s) {
+        const __m128i halves = _mm_loadl_epi64((const __m128i*) s);
+
+        if constexpr (V >= SIMD::AVX2) {
+          storeFloat3_SSE(d, _mm_cvtph_ps(halves));
+        } else {
+          storeFloat3_SSE(d, halfToFloat_SSE2(halves));
+        }
+      });
+      break;
+    case VertexElementConversion::Short4NToFloat3:
+      forEachVertex(dst, dstStride, src, srcStride, count, [] (uint8_t* d, const uint8_t* s) {
+        const __m128i c = _mm_loadl_epi64((const __m128i*) s);
+        // Sign extend to 32-bit by duplicating each short into the high half and shifting back down
+        const __m128 values = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(c, c), 16));
+        storeFloat3_SSE(d, _mm_max_ps(_mm_mul_ps(values, _mm_set1_ps(1.0f / 32767.0f)), _mm_set1_ps(-1.0f)));
+      });
+      break;
+    case VertexElementConversion::Dec3NToFloat3:
+      forEachVertex(dst, dstStride, src, srcStride, count, [] (uint8_t* d, const uint8_t* s) {
+        const __m128i v = _mm_cvtsi32_si128((int) loadDword(s));
+        // Move each 10-bit field to the top of its own lane, then sign extend with an arithmetic shift
+        const __m128i xy = _mm_unpacklo_epi32(_mm_slli_epi32(v, 22), _mm_slli_epi32(v, 12));
+        const __m128 values = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi64(xy, _mm_slli_epi32(v, 2)), 22));
+        storeFloat3_SSE(d, _mm_max_ps(_mm_mul_ps(values, _mm_set1_ps(1.0f / 511.0f)), _mm_set1_ps(-1.0f)));
+      });
+      break;
+    case VertexElementConversion::Ubyte4NToFloat3:
+      forEachVertex(dst, dstStride, src, srcStride, count, [] (uint8_t* d, const uint8_t* s) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i c = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int) loadDword(s)), zero), zero);
+        storeFloat3_SSE(d, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(c), _mm_set1_ps(2.0f / 255.0f)), _mm_set1_ps(1.0f)));
+      });
+      break;
+    case VertexElementConversion::Rgba8ToBgra8:
+      packElement_slow(dst, dstStride, src, srcStride, count, element);
+      break;
+    }
+  }
+
+  template<SIMD V>
+  __forceinline void packElement(uint8_t* dst, const uint32_t dstStride, const uint8_t* src, const uint32_t srcStride, const uint32_t count, const PackedVertexElement& element) {
+    if constexpr (V == SIMD::None) {
+      packElement_slow(dst, dstStride, src, srcStride, count, element);
+    } else {
+      packElement_SSE<V>(dst, dstStride, src, srcStride, count, element);
+    }
+  }
+
+  template<SIMD V>
+  __forceinline void packVertexBlocks(uint8_t* dst, const uint32_t dstStride, const uint8_t* src, const uint32_t srcStride, const uint32_t count,
+                                      const PackedVertexElement* elements, uint32_t elementCount) {
+    // Merge copies that are adjacent in both streams, e.g. position and normal in their original order
+    constexpr uint32_t kMaxMergedElements = 16;
+    PackedVertexElement merged[kMaxMergedElements];
+
+    if (elementCount <= kMaxMergedElements) {
+      uint32_t mergedCount = 0;
+
+      for (uint32_t i = 0; i < elementCount; i++) {
+        PackedVertexElement* prev = mergedCount ? &merged[mergedCount - 1] : nullptr;
+
+        if (prev && prev->conversion == VertexElementConversion::Copy && elements[i].conversion == VertexElementConversion::Copy &&
+            prev->srcOffset + prev->size == elements[i].srcOffset && prev->dstOffset + prev->size == elements[i].dstOffset) {
+          prev->size += elements[i].size;
+        } else {
+          merged[mergedCount++] = elements[i];
+        }
+      }
+
+      elements = merged;
+      elementCount = mergedCount;
+    }
+
+    // Every byte of the source is kept in place
+    if (elementCount == 1 && elements[0].conversion == VertexElementConversion::Copy && srcStride == dstStride &&
+        elements[0].srcOffset == 0 && elements[0].dstOffset == 0 && elements[0].size == srcStride) {
+      memcpy(dst, src, size_t(count) * srcStride);
+      return;
+    }
+
+    // Gather every element for a block of vertices before moving on, so each source cache line is fetched once
+    // while the per element loops stay free of format branches.
+    constexpr uint32_t kBlockBytes = 8 * 1024;
+    const uint32_t blockSize = std::max(kBlockBytes / std::max(srcStride, 1u), 1u);
+
+    for (uint32_t first = 0; first < count; first += blockSize) {
+      const uint32_t blockCount = std::min(blockSize, count - first);
+
+      for (uint32_t i = 0; i < elementCount; i++) {
+        packElement<V>(dst + size_t(first) * dstStride + elements[i].dstOffset, dstStride,
+                    src + size_t(first) * srcStride + elements[i].srcOffset, srcStride,
+                    blockCount, elements[i]);
+      }
+    }
+  }
+
+  void packVertexStream_slow(void* dst, const uint32_t dstStride, const void* src, const uint32_t srcStride, const uint32_t count,
+                             const PackedVertexElement* elements, const uint32_t elementCount) {
+    packVertexBlocks<SIMD::None>((uint8_t*) dst, dstStride, (const uint8_t*) src, srcStride, count, elements, elementCount);
+  }
+
+  void packVertexStream_SSE(void* dst, const uint32_t dstStride, const void* src, const uint32_t srcStride, const uint32_t count,
+                            const PackedVertexElement* elements, const uint32_t elementCount) {
+    packVertexBlocks<SIMD::SSE2>((uint8_t*) dst, dstStride, (const uint8_t*) src, srcStride, count, elements, elementCount);
+  }
+
+  // Note: Uses F16C for half conversions, which every AVX2 capable CPU implements
+  void packVertexStream_AVX2(void* dst, const uint32_t dstStride, const void* src, const uint32_t srcStride, const uint32_t count,
+                             const PackedVertexElement* elements, const uint32_t elementCount) {
+    packVertexBlocks<SIMD::AVX2>((uint8_t*) dst, dstStride, (const uint8_t*) src, srcStride, count, elements, elementCount);
+  }
+
+  void packVertexStream(void* dst, const uint32_t dstStride, const void* src, const uint32_t srcStride, const uint32_t count,
+                        const PackedVertexElement* elements, const uint32_t elementCount) {
+    if (g_simdSupportLevel >= SIMD::AVX2 && g_supportsF16C) {
+      packVertexStream_AVX2(dst, dstStride, src, srcStride, count, elements, elementCount);
+    } else if (g_simdSupportLevel >= SIMD::SSE2) {
+      packVertexStream_SSE(dst, dstStride, src, srcStride, count, elements, elementCount);
+    } else {
+      packVertexStream_slow(dst, dstStride, src, srcStride, count, elements, elementCount);
+    }
+  }
+}
@@ -70,6 +70,31 @@ namespace fast {
   template<typename T>
   void copySubtract(T* dstData, const T* srcData, const uint32_t count, const T value, const bool ignoreSentinel = false, const T sentinelValue = 0);
 
+  /**
+    * \brief Size in bytes of the scratch memory required by deduplicateSortIndices
+    *
+    * maxValue: largest value that may appear in the input array
+    */
+  inline uint32_t deduplicateSortIndicesScratchSize(const uint32_t maxValue) {
+    // Padded so the SIMD variants can always scan whole registers
+    return (maxValue + 32) & ~31u;
+  }
+
+  /**
+    * \brief Sorts and deduplicates an array of unsigned integers, does not allocate
+    *
+    * count: number of integers
+    * data: array of unsigned integers
+    * maxValue: largest value in array (must be known by caller, e.g. from findMinMax)
+    * flagsScratch: scratch memory of at least deduplicateSortIndicesScratchSize(maxValue) bytes, contents are overwritten
+    * uniqueOut: array of at least (maxValue + 1) integers to receive the sorted unique values
+    * returns: number of unique values written to uniqueOut
+    *
+    * Supports unsigned 32-bit and 16-bit integers.  All other uses undefined.
+    */
+  template<typename T>
+  uint32_t deduplicateSortIndices(const uint32_t count, const T* data, const uint32_t maxValue, uint8_t* flagsScratch, T* uniqueOut);
+
   /**
     * \brief Memory copy function that uses threads internally, can be useful for very large memcpy's
     *
@@ -90,4 +115,54 @@ namespace fast {
     */
   template<typename T>
   T findNthBit(const T num, const T n);
+
+  /**
+    * \brief Conversions packVertexStream can apply to a vertex element
+    */
+  enum class VertexElementConversion : uint32_t {
+    Copy,             // Bit exact copy of 'size' bytes, a multiple of 4
+    Half4ToFloat3,    // R16G16B16A16_SFLOAT -> R32G32B32_SFLOAT
+    Short4NToFloat3,  // R16G16B16A16_SNORM -> R32G32B32_SFLOAT
+    Dec3NToFloat3,    // A2B10G10R10_SNORM_PACK32 -> R32G32B32_SFLOAT
+    Ubyte4NToFloat3,  // R8G8B8A8_UNORM -> R32G32B32_SFLOAT, remapped from [0, 1] to [-1, 1] like the geometry interleaver does for normals
+    Rgba8ToBgra8,     // R8G8B8A8_UNORM -> B8G8R8A8_UNORM
+  };
+
+  /**
+    * \brief Describes where one vertex element is read from and written to by packVertexStream
+    */
+  struct PackedVertexElement {
+    uint32_t srcOffset;
+    uint32_t dstOffset;
+    uint32_t size;  // Bytes copied, only used by VertexElementConversion::Copy
+    VertexElementConversion conversion;
+  };
+
+  /**
+    * \brief Size in bytes an element occupies in the packed stream
+    */
+  inline uint32_t packedVertexElementSize(const PackedVertexElement& element) {
+    switch (element.conversion) {
+    case VertexElementConversion::Copy:
+      return element.size;
+    case VertexElementConversion::Rgba8ToBgra8:
+      return sizeof(uint32_t);
+    default:
+      return sizeof(float) * 3;
+    }
+  }
+
+  /**
+    * \brief Gathers a subset of the elements of an interleaved vertex stream into a new, tightly packed stream
+    *
+    * dst: memory to write the packed vertices to, at least count * dstStride bytes
+    * dstStride: byte distance between packed vertices
+    * src: first source vertex
+    * srcStride: byte distance between source vertices, every element must lie within it
+    * count: number of vertices
+    * elements: elements to gather and the conversion applied to each
+    * elementCount: number of elements
+    */
+  void packVertexStream(void* dst, const uint32_t dstStride, const void* src, const uint32_t srcStride, const uint32_t count,
+                        const PackedVertexElement* elements, const uint32_t elementCount);
 }
\ No newline at end of file
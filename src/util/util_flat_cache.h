@@ -0,0 +1,716 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DXVK_FLAT_CACHE_SSE2 1
+#else
+#define DXVK_FLAT_CACHE_SSE2 0
+#endif
+
+#include "util_bit.h"
+#include "xxHash/xxhash.h"
+
+namespace dxvk {
+
+  namespace flat_cache {
+
+    // Per-slot control byte. Full slots store the low 7 bits of the key (H2),
+    // special states have the top bit set so they never match an H2.
+    using ctrl_t = int8_t;
+
+    constexpr ctrl_t kEmpty = -128;   // 0b10000000
+    constexpr ctrl_t kDeleted = -2;   // 0b11111110
+    constexpr ctrl_t kSentinel = -1;  // 0b11111111, terminates iteration
+
+    constexpr size_t kGroupWidth = 16;
+    constexpr size_t kNumClonedBytes = kGroupWidth - 1;
+
+    // Keys are XXH64 values, so they are used as the hash directly:
+    // H1 picks the probe start, H2 is kept in the control byte to filter candidates.
+    inline size_t h1(XXH64_hash_t key) { return static_cast<size_t>(key >> 7); }
+    inline ctrl_t h2(XXH64_hash_t key) { return static_cast<ctrl_t>(key & 0x7f); }
+
+    inline bool isFull(ctrl_t c) { return c >= 0; }
+
+    // Control bytes for a table that has not allocated yet: a lone sentinel,
+    // so lookups terminate on the first group and begin() == end().
+    alignas(kGroupWidth) inline const ctrl_t kEmptyGroup[kGroupWidth] = {
+      kSentinel, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty,
+      kEmpty,    kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty
+    };
+
+    // Bitmask of matching slots within a group, one bit per slot
+    class BitMask {
+    public:
+      explicit BitMask(uint32_t mask) : m_mask(mask) { }
+
+      explicit operator bool() const { return m_mask != 0; }
+
+      uint32_t lowest() const { return bit::tzcnt(m_mask); }
+
+      // Number of unset slots at the end / start of the group
+      uint32_t leadingZeros() const { return bit::lzcnt(m_mask) - (32 - kGroupWidth); }
+      uint32_t trailingZeros() const { return std::min<uint32_t>(bit::tzcnt(m_mask), kGroupWidth); }
+
+      BitMask& operator++() { m_mask &= m_mask - 1; return *this; }
+
+      // Allows 'for (uint32_t i : mask)'
+      uint32_t operator*() const { return lowest(); }
+      BitMask begin() const { return *this; }
+      BitMask end() const { return BitMask(0); }
+      bool operator!=(const BitMask& other) const { return m_mask != other.m_mask; }
+
+    private:
+      uint32_t m_mask;
+    };
+
+    // A group of kGroupWidth control bytes, probed in parallel
+    class Group {
+    public:
+      explicit Group(const ctrl_t* pos) {
+#if DXVK_FLAT_CACHE_SSE2
+        m_ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+#else
+        std::memcpy(m_ctrl, pos, kGroupWidth);
+#endif
+      }
+
+      BitMask match(ctrl_t hash) const {
+#if DXVK_FLAT_CACHE_SSE2
+        return BitMask(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(hash), m_ctrl))));
+#else
+        uint32_t mask = 0;
+        for (uint32_t i = 0; i < kGroupWidth; i++) {
+          mask |= uint32_t(m_ctrl[i] == hash) << i;
+        }
+        return BitMask(mask);
+#endif
+      }
+
+      BitMask matchEmpty() const {
+        return match(kEmpty);
+      }
+
+      BitMask matchEmptyOrDeleted() const {
+#if DXVK_FLAT_CACHE_SSE2
+        // Empty and deleted are the only states below the sentinel
+        return BitMask(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(kSentinel), m_ctrl))));
+#else
+        uint32_t mask = 0;
+        for (uint32_t i = 0; i < kGroupWidth; i++) {
+          mask |= uint32_t(m_ctrl[i] < kSentinel) << i;
+        }
+        return BitMask(mask);
+#endif
+      }
+
+    private:
+#if DXVK_FLAT_CACHE_SSE2
+      __m128i m_ctrl;
+#else
+      ctrl_t m_ctrl[kGroupWidth];
+#endif
+    };
+
+    // Triangular probing over groups, visits every group once for power of two minus one capacities
+    class ProbeSeq {
+    public:
+      ProbeSeq(size_t hash, size_t mask) : m_mask(mask), m_offset(hash & mask) { }
+
+      size_t offset(size_t i) const { return (m_offset + i) & m_mask; }
+      size_t offset() const { return m_offset; }
+
+      void next() {
+        m_index += kGroupWidth;
+        m_offset = (m_offset + m_index) & m_mask;
+      }
+
+      size_t index() const { return m_index; }
+
+    private:
+      size_t m_mask;
+      size_t m_offset;
+      size_t m_index = 0;
+    };
+
+    // Maximum number of elements before the table grows, 7/8 max load
+    inline size_t capacityToGrowth(size_t capacity) {
+      return capacity - capacity / 8;
+    }
+
+    inline size_t normalizeCapacity(size_t n) {
+      size_t capacity = kGroupWidth - 1;
+      while (capacity < n) {
+        capacity = capacity * 2 + 1;
+      }
+      return capacity;
+    }
+
+    // Values are stored inline in the slot array, references are invalidated on rehash
+    template<typename V>
+    struct FlatSlots {
+      using slot_type = V;
+
+      template<typename... Args>
+      static void construct(slot_type* slot, Args&&... args) { new (slot) V(std::forward<Args>(args)...); }
+      static void destroy(slot_type* slot) { slot->~V(); }
+      static void transfer(slot_type* dst, slot_type* src) {
+        new (dst) V(std::move(*src));
+        src->~V();
+      }
+      static V& element(slot_type* slot) { return *slot; }
+    };
+
+    // Values are heap allocated nodes, references stay valid until the element is erased
+    template<typename V>
+    struct NodeSlots {
+      using slot_type = V*;
+
+      template<typename... Args>
+      static void construct(slot_type* slot, Args&&... args) { *slot = new V(std::forward<Args>(args)...); }
+      static void destroy(slot_type* slot) { delete *slot; }
+      static void transfer(slot_type* dst, slot_type* src) { *dst = *src; }
+      static V& element(slot_type* slot) { return **slot; }
+    };
+
+    template<typename T, template<typename> class Slots>
+    struct MapPolicy {
+      using key_type = XXH64_hash_t;
+      using value_type = std::pair<const XXH64_hash_t, T>;
+      using slots = Slots<value_type>;
+
+      static const key_type& key(const value_type& v) { return v.first; }
+    };
+
+    struct SetPolicy {
+      using key_type = XXH64_hash_t;
+      using value_type = XXH64_hash_t;
+      using slots = FlatSlots<value_type>;
+
+      static const key_type& key(const value_type& v) { return v; }
+    };
+
+    /**
+     * \brief Open addressing hash table for pre-hashed keys
+     *
+     * Control bytes and slots live in flat arrays, lookups compare the
+     * 7 bit key fragment of 16 slots at once and only touch slots whose
+     * fragment matches. Erasing leaves a tombstone unless no probe
+     * sequence can have passed the slot, so erasing never moves elements.
+     * Iterators are invalidated by rehashing, like std::unordered_map.
+     */
+    template<typename Policy>
+    class Table {
+      using slots = typename Policy::slots;
+      using slot_type = typename slots::slot_type;
+
+    public:
+      using key_type = typename Policy::key_type;
+      using value_type = typename Policy::value_type;
+      using size_type = size_t;
+      using difference_type = ptrdiff_t;
+      using reference = value_type&;
+      using const_reference = const value_type&;
+
+      template<bool Const>
+      class Iterator {
+        friend class Table;
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename Policy::value_type;
+        using difference_type = ptrdiff_t;
+        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+        using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+
+        Iterator() = default;
+
+        // iterator -> const_iterator
+        template<bool C = Const, typename = std::enable_if_t<C>>
+        Iterator(const Iterator<false>& other) : m_ctrl(other.m_ctrl), m_slot(other.m_slot) { }
+
+        reference operator*() const { return slots::element(m_slot); }
+        pointer operator->() const { return &slots::element(m_slot); }
+
+        Iterator& operator++() {
+          ++m_ctrl;
+          ++m_slot;
+          skipEmptyOrDeleted();
+          return *this;
+        }
+
+        Iterator operator++(int) {
+          Iterator tmp = *this;
+          ++*this;
+          return tmp;
+        }
+
+        friend bool operator==(const Iterator& a, const Iterator& b) { return a.m_ctrl == b.m_ctrl; }
+        friend bool operator!=(const Iterator& a, const Iterator& b) { return a.m_ctrl != b.m_ctrl; }
+
+      private:
+        Iterator(const ctrl_t* ctrl, slot_type* slot) : m_ctrl(ctrl), m_slot(slot) { }
+
+        void skipEmptyOrDeleted() {
+          while (*m_ctrl < kSentinel) {
+            ++m_ctrl;
+            ++m_slot;
+          }
+        }
+
+        const ctrl_t* m_ctrl = nullptr;
+        slot_type* m_slot = nullptr;
+
+        friend class Iterator<!Const>;
+      };
+
+      using iterator = Iterator<false>;
+      using const_iterator = Iterator<true>;
+
+      Table() = default;
+
+      Table(std::initializer_list<value_type> init) {
+        insert(init.begin(), init.end());
+      }
+
+      Table(const Table& other) {
+        reserve(other.size());
+        for (const value_type& v : other) {
+          emplaceUnique(Policy::key(v), v);
+        }
+      }
+
+      Table(Table&& other) noexcept {
+        swap(other);
+      }
+
+      Table& operator=(const Table& other) {
+        if (this != &other) {
+          Table tmp(other);
+          swap(tmp);
+        }
+        return *this;
+      }
+
+      Table& operator=(Table&& other) noexcept {
+        if (this != &other) {
+          destroyAll();
+          swap(other);
+        }
+        return *this;
+      }
+
+      ~Table() {
+        destroyAll();
+      }
+
+      iterator begin() {
+        iterator it(m_ctrl, m_slots);
+        it.skipEmptyOrDeleted();
+        return it;
+      }
+
+      iterator end() { return iterator(m_ctrl + m_capacity, nullptr); }
+
+      const_iterator begin() const { return const_cast<Table*>(this)->begin(); }
+      const_iterator end() const { return const_cast<Table*>(this)->end(); }
+      const_iterator cbegin() const { return begin(); }
+      const_iterator cend() const { return end(); }
+
+      bool empty() const { return m_size == 0; }
+      size_t size() const { return m_size; }
+      size_t capacity() const { return m_capacity; }
+
+      void clear() {
+        if (m_capacity == 0) {
+          return;
+        }
+        forEachFull([](slot_type* slot) { slots::destroy(slot); });
+        m_size = 0;
+        resetCtrl();
+      }
+
+      void reserve(size_t count) {
+        if (count > m_size + m_growthLeft) {
+          resize(normalizeCapacity(growthToLowerBoundCapacity(count)));
+        }
+      }
+
+      iterator find(const key_type& key) {
+        const size_t index = findIndex(key);
+        return index != kNotFound ? iteratorAt(index) : end();
+      }
+
+      const_iterator find(const key_type& key) const {
+        return const_cast<Table*>(this)->find(key);
+      }
+
+      bool contains(const key_type& key) const { return findIndex(key) != kNotFound; }
+      size_t count(const key_type& key) const { return contains(key) ? 1 : 0; }
+
+      std::pair<iterator, bool> insert(const value_type& value) {
+        return emplaceUnique(Policy::key(value), value);
+      }
+
+      std::pair<iterator, bool> insert(value_type&& value) {
+        const key_type key = Policy::key(value);
+        return emplaceUnique(key, std::move(value));
+      }
+
+      template<typename It>
+      void insert(It first, It last) {
+        for (; first != last; ++first) {
+          insert(*first);
+        }
+      }
+
+      size_t erase(const key_type& key) {
+        const size_t index = findIndex(key);
+        if (index == kNotFound) {
+          return 0;
+        }
+        eraseAt(index);
+        return 1;
+      }
+
+      iterator erase(const_iterator it) {
+        const size_t index = static_cast<size_t>(it.m_ctrl - m_ctrl);
+        eraseAt(index);
+        iterator next(it.m_ctrl, m_slots + index);
+        ++next;
+        return next;
+      }
+
+      iterator erase(iterator it) {
+        return erase(const_iterator(it));
+      }
+
+      // Predicate receives an iterator, matching fast_unordered_cache::erase_if
+      template<typename P>
+      void erase_if(P&& p) {
+        for (auto it = begin(); it != end();) {
+          if (!p(it)) {
+            ++it;
+          } else {
+            it = erase(it);
+          }
+        }
+      }
+
+      void swap(Table& other) noexcept {
+        std::swap(m_ctrl, other.m_ctrl);
+        std::swap(m_slots, other.m_slots);
+        std::swap(m_size, other.m_size);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_growthLeft, other.m_growthLeft);
+      }
+
+      friend bool operator==(const Table& a, const Table& b) {
+        if (a.size() != b.size()) {
+          return false;
+        }
+        for (const value_type& v : a) {
+          auto it = b.find(Policy::key(v));
+          if (it == b.end() || !(*it == v)) {
+            return false;
+          }
+        }
+        return true;
+      }
+
+      friend bool operator!=(const Table& a, const Table& b) { return !(a == b); }
+
+    protected:
+      static constexpr size_t kNotFound = ~size_t(0);
+
+      size_t findIndex(const key_type& key) const {
+        const ctrl_t fragment = h2(key);
+        ProbeSeq seq(h1(key), m_capacity);
+        while (true) {
+          const Group group(m_ctrl + seq.offset());
+          for (uint32_t i : group.match(fragment)) {
+            const size_t index = seq.offset(i);
+            if (Policy::key(slots::element(m_slots + index)) == key) {
+              return index;
+            }
+          }
+          if (group.matchEmpty()) {
+            return kNotFound;
+          }
+          seq.next();
+          assert(seq.index() <= m_capacity && "flat cache probed a full table");
+        }
+      }
+
+      // Constructs the element from args if the key is not present yet
+      template<typename... Args>
+      std::pair<iterator, bool> emplaceUnique(const key_type& key, Args&&... args) {
+        size_t index = findIndex(key);
+        if (index != kNotFound) {
+          return { iteratorAt(index), false };
+        }
+        index = prepareInsert(key);
+        slots::construct(m_slots + index, std::forward<Args>(args)...);
+        return { iteratorAt(index), true };
+      }
+
+      iterator iteratorAt(size_t index) {
+        return iterator(m_ctrl + index, m_slots + index);
+      }
+
+    private:
+      static size_t growthToLowerBoundCapacity(size_t growth) {
+        return growth + (growth - 1) / 7;
+      }
+
+      // Finds the slot for a key known to be absent, growing the table if needed
+      size_t prepareInsert(const key_type& key) {
+        size_t index = findFirstNonFull(key);
+        if (m_growthLeft == 0 && m_ctrl[index] != kDeleted) {
+          rehashAndGrowIfNecessary();
+          index = findFirstNonFull(key);
+        }
+        m_size++;
+        m_growthLeft -= m_ctrl[index] == kEmpty ? 1 : 0;
+        setCtrl(index, h2(key));
+        return index;
+      }
+
+      size_t findFirstNonFull(const key_type& key) const {
+        ProbeSeq seq(h1(key), m_capacity);
+        while (true) {
+          const Group group(m_ctrl + seq.offset());
+          if (auto mask = group.matchEmptyOrDeleted()) {
+            return seq.offset(mask.lowest());
+          }
+          seq.next();
+          assert(seq.index() <= m_capacity && "flat cache probed a full table");
+        }
+      }
+
+      void rehashAndGrowIfNecessary() {
+        if (m_capacity == 0) {
+          resize(kGroupWidth - 1);
+        } else if (m_size * 32 <= m_capacity * 25) {
+          // Mostly tombstones, rehash without growing to reclaim them
+          resize(m_capacity);
+        } else {
+          resize(m_capacity * 2 + 1);
+        }
+      }
+
+      void setCtrl(size_t index, ctrl_t value) {
+        m_ctrl[index] = value;
+        // Mirror the first group past the sentinel, so groups can be loaded at any offset
+        m_ctrl[((index - kNumClonedBytes) & m_capacity) + kNumClonedBytes] = value;
+      }
+
+      void eraseAt(size_t index) {
+        slots::destroy(m_slots + index);
+        m_size--;
+
+        // If there's an empty slot within a group width on either side, no probe
+        // sequence can have seen this slot in a full group, so it may become empty
+        const size_t indexBefore = (index - kGroupWidth) & m_capacity;
+        const BitMask emptyAfter = Group(m_ctrl + index).matchEmpty();
+        const BitMask emptyBefore = Group(m_ctrl + indexBefore).matchEmpty();
+        const bool wasNeverFull = emptyBefore && emptyAfter &&
+          (emptyAfter.trailingZeros() + emptyBefore.leadingZeros()) < kGroupWidth;
+
+        setCtrl(index, wasNeverFull ? kEmpty : kDeleted);
+        m_growthLeft += wasNeverFull ? 1 : 0;
+      }
+
+      template<typename F>
+      void forEachFull(F&& f) {
+        for (size_t i = 0; i < m_capacity; i++) {
+          if (isFull(m_ctrl[i])) {
+            f(m_slots + i);
+          }
+        }
+      }
+
+      void resetCtrl() {
+        std::memset(m_ctrl, kEmpty, m_capacity + 1 + kNumClonedBytes);
+        m_ctrl[m_capacity] = kSentinel;
+        m_growthLeft = capacityToGrowth(m_capacity);
+      }
+
+      void resize(size_t newCapacity) {
+        ctrl_t* oldCtrl = m_ctrl;
+        slot_type* oldSlots = m_slots;
+        const size_t oldCapacity = m_capacity;
+
+        m_capacity = newCapacity;
+        m_ctrl = static_cast<ctrl_t*>(::operator new(m_capacity + 1 + kNumClonedBytes));
+        m_slots = std::allocator<slot_type>().allocate(m_capacity);
+        resetCtrl();
+
+        for (size_t i = 0; i < oldCapacity; i++) {
+          if (isFull(oldCtrl[i])) {
+            const key_type& key = Policy::key(slots::element(oldSlots + i));
+            const size_t index = findFirstNonFull(key);
+            setCtrl(index, h2(key));
+            slots::transfer(m_slots + index, oldSlots + i);
+          }
+        }
+        m_growthLeft -= m_size;
+
+        if (oldCapacity) {
+          ::operator delete(oldCtrl);
+          std::allocator<slot_type>().deallocate(oldSlots, oldCapacity);
+        }
+      }
+
+      void destroyAll() {
+        if (m_capacity == 0) {
+          return;
+        }
+        forEachFull([](slot_type* slot) { slots::destroy(slot); });
+        ::operator delete(m_ctrl);
+        std::allocator<slot_type>().deallocate(m_slots, m_capacity);
+        m_ctrl = const_cast<ctrl_t*>(kEmptyGroup);
+        m_slots = nullptr;
+        m_size = 0;
+        m_capacity = 0;
+        m_growthLeft = 0;
+      }
+
+      ctrl_t* m_ctrl = const_cast<ctrl_t*>(kEmptyGroup);
+      slot_type* m_slots = nullptr;
+      size_t m_size = 0;
+      size_t m_capacity = 0;
+      size_t m_growthLeft = 0;
+    };
+
+    template<typename T, template<typename> class Slots>
+    class Map : public Table<MapPolicy<T, Slots>> {
+      using Base = Table<MapPolicy<T, Slots>>;
+    public:
+      using mapped_type = T;
+      using typename Base::key_type;
+      using typename Base::value_type;
+      using typename Base::iterator;
+      using typename Base::const_iterator;
+      using Base::Base;
+      using Base::insert;
+
+      template<typename P, typename = std::enable_if_t<std::is_constructible_v<value_type, P&&>>>
+      std::pair<iterator, bool> insert(P&& value) {
+        return emplace(std::forward<P>(value));
+      }
+
+      template<typename... Args>
+      std::pair<iterator, bool> emplace(Args&&... args) {
+        // Keys are trivially cheap, so build the pair only once the key is known to be absent
+        return emplaceFromArgs(std::forward<Args>(args)...);
+      }
+
+      template<typename... Args>
+      std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args) {
+        return this->emplaceUnique(key, std::piecewise_construct,
+                                   std::forward_as_tuple(key),
+                                   std::forward_as_tuple(std::forward<Args>(args)...));
+      }
+
+      template<typename M>
+      std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj) {
+        auto result = try_emplace(key, std::forward<M>(obj));
+        if (!result.second) {
+          result.first->second = std::forward<M>(obj);
+        }
+        return result;
+      }
+
+      T& operator[](const key_type& key) {
+        return try_emplace(key).first->second;
+      }
+
+      T& at(const key_type& key) {
+        auto it = this->find(key);
+        if (it == this->end()) {
+          throw std::out_of_range("fast_flat_cache::at");
+        }
+        return it->second;
+      }
+
+      const T& at(const key_type& key) const {
+        auto it = this->find(key);
+        if (it == this->end()) {
+          throw std::out_of_range("fast_flat_cache::at");
+        }
+        return it->second;
+      }
+
+    private:
+      template<typename K, typename... Args>
+      std::pair<iterator, bool> emplaceFromArgs(K&& key, Args&&... args) {
+        if constexpr (sizeof...(Args) == 0) {
+          // Single argument, a pair-like value
+          const key_type k = key.first;
+          return this->emplaceUnique(k, std::forward<K>(key));
+        } else {
+          const key_type k = key;
+          return this->emplaceUnique(k, std::piecewise_construct,
+                                     std::forward_as_tuple(k),
+                                     std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+      }
+    };
+
+    class Set : public Table<SetPolicy> {
+      using Base = Table<SetPolicy>;
+    public:
+      using Base::Base;
+
+      std::pair<iterator, bool> emplace(const key_type& key) {
+        return insert(key);
+      }
+    };
+  }
+
+  // A flat hash map for use ONLY with already hashed keys. Values are stored inline,
+  // so references and iterators are invalidated when the table grows.
+  template<class T>
+  using fast_flat_cache = flat_cache::Map<T, flat_cache::FlatSlots>;
+
+  // Same as fast_flat_cache, but values are individually allocated so references
+  // remain valid until the element is erased, as with std::unordered_map.
+  template<class T>
+  using fast_stable_cache = flat_cache::Map<T, flat_cache::NodeSlots>;
+
+  // A flat set for use ONLY with already hashed keys.
+  using fast_flat_set = flat_cache::Set;
+}
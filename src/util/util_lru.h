@@ -1,24 +1,319 @@
+#pragma once
+
 #include <cstdint>
-#include <list>
 #include <unordered_map>
+// NV-DXVK start: intrusive, allocation-free LRU
+#include <algorithm>
+#include <iterator>
+#include <vector>
+// NV-DXVK end
 
 namespace dxvk {
 
-  template<typename T>
+  // NV-DXVK start: intrusive, allocation-free LRU
+  /**
+   * \brief LRU order over dense, caller owned ids
+   *
+   * Links are stored in flat arrays indexed by id, so touching and
+   * removing an id is O(1) and does not allocate once the arrays
+   * cover it. Meant for ids that already index a table, e.g. slots
+   * of a SparseUniqueCache.
+   */
+  class lru_index_list {
+
+  public:
+    static constexpr uint32_t kInvalid = ~0u;
+
+    bool contains(uint32_t id) const {
+      return id < m_links.size() && m_links[id].prev != kUnlinked;
+    }
+
+    // Inserts the id as most recently used, or moves it there
+    void touch(uint32_t id) {
+      if (id >= m_links.size())
+        grow(id + 1);
+
+      if (m_links[id].prev != kUnlinked) {
+        if (id == m_tail)
+          return;
+        unlink(id);
+      } else {
+        m_size++;
+      }
+
+      pushBack(id);
+    }
+
+    // Batched touch, the last id in the array becomes most recently used
+    void touch(const uint32_t* ids, size_t count) {
+      uint32_t maxId = 0;
+      for (size_t i = 0; i < count; i++)
+        maxId = std::max(maxId, ids[i]);
+
+      if (count > 0 && maxId >= m_links.size())
+        grow(maxId + 1);
+
+      for (size_t i = 0; i < count; i++)
+        touch(ids[i]);
+    }
+
+    bool remove(uint32_t id) {
+      if (!contains(id))
+        return false;
+
+      unlink(id);
+      m_links[id] = { kUnlinked, kUnlinked };
+      m_size--;
+      return true;
+    }
+
+    /**
+     * \brief Evicts least recently used ids while the callback agrees
+     *
+     * \c shouldEvict(id) is called with the current least recently used
+     * id and returns false to stop, e.g. once usage is under budget.
+     * The callback may remove the id itself.
+     * \returns Number of evicted ids
+     */
+    template<typename F>
+    size_t evictWhile(F&& shouldEvict) {
+      size_t numEvicted = 0;
+      while (m_head != kInvalid) {
+        const uint32_t id = m_head;
+        if (!shouldEvict(id))
+          break;
+        remove(id);
+        numEvicted++;
+      }
+      return numEvicted;
+    }
+
+    uint32_t leastRecentlyUsed() const { return m_head; }
+    uint32_t mostRecentlyUsed() const { return m_tail; }
+
+    // Next more recently used id, kInvalid at the end
+    uint32_t next(uint32_t id) const { return m_links[id].next; }
+
+    // Previous less recently used id, kInvalid at the start
+    uint32_t prev(uint32_t id) const { return m_links[id].prev; }
+
+    void reserve(uint32_t maxId) {
+      if (maxId > m_links.size())
+        grow(maxId);
+    }
+
+    void clear() {
+      m_links.clear();
+      m_head = kInvalid;
+      m_tail = kInvalid;
+      m_size = 0;
+    }
+
+    bool empty() const { return m_size == 0; }
+    uint32_t size() const { return m_size; }
+
+  private:
+    static constexpr uint32_t kUnlinked = ~0u - 1;
+
+    struct Link {
+      uint32_t prev;
+      uint32_t next;
+    };
+
+    void grow(size_t minSize) {
+      m_links.resize(std::max(minSize, m_links.size() * 2), Link { kUnlinked, kUnlinked });
+    }
+
+    void unlink(uint32_t id) {
+      const Link link = m_links[id];
+      if (link.prev != kInvalid)
+        m_links[link.prev].next = link.next;
+      else
+        m_head = link.next;
+
+      if (link.next != kInvalid)
+        m_links[link.next].prev = link.prev;
+      else
+        m_tail = link.prev;
+    }
+
+    void pushBack(uint32_t id) {
+      m_links[id] = { m_tail, kInvalid };
+      if (m_tail != kInvalid)
+        m_links[m_tail].next = id;
+      else
+        m_head = id;
+      m_tail = id;
+    }
+
+    std::vector<Link> m_links;
+    uint32_t m_head = kInvalid;
+    uint32_t m_tail = kInvalid;
+    uint32_t m_size = 0;
+
+  };
+
+  /**
+   * \brief CLOCK (second chance) replacement over dense, caller owned ids
+   *
+   * Approximates LRU: a touch only sets a reference byte, and
+   * eviction sweeps a hand over the ids, giving every referenced
+   * id a second chance. Cheaper than lru_index_list when ids are
+   * touched far more often than anything gets evicted.
+   */
+  class clock_index_list {
+
+  public:
+    bool contains(uint32_t id) const {
+      return id < m_state.size() && m_state[id] != kAbsent;
+    }
+
+    // Inserts the id, or marks it as referenced
+    void touch(uint32_t id) {
+      if (id >= m_state.size())
+        m_state.resize(std::max<size_t>(id + 1, m_state.size() * 2), kAbsent);
+
+      m_size += m_state[id] == kAbsent ? 1 : 0;
+      m_state[id] = kReferenced;
+    }
+
+    void touch(const uint32_t* ids, size_t count) {
+      for (size_t i = 0; i < count; i++)
+        touch(ids[i]);
+    }
+
+    bool remove(uint32_t id) {
+      if (!contains(id))
+        return false;
+
+      m_state[id] = kAbsent;
+      m_size--;
+      return true;
+    }
+
+    /**
+     * \brief Evicts unreferenced ids while the callback agrees
+     *
+     * Same contract as lru_index_list::evictWhile. Referenced ids
+     * passed by the hand lose their reference and are skipped.
+     * \returns Number of evicted ids
+     */
+    template<typename F>
+    size_t evictWhile(F&& shouldEvict) {
+      size_t numEvicted = 0;
+      // Two full sweeps visit every id once unreferenced
+      size_t budget = 2 * m_state.size();
+
+      while (m_size > 0 && budget-- > 0) {
+        if (m_hand >= m_state.size())
+          m_hand = 0;
+
+        const uint32_t id = m_hand;
+        if (m_state[id] == kReferenced) {
+          m_state[id] = kResident;
+        } else if (m_state[id] == kResident) {
+          if (!shouldEvict(id))
+            break;
+          remove(id);
+          numEvicted++;
+        }
+        m_hand++;
+      }
+      return numEvicted;
+    }
+
+    void clear() {
+      m_state.clear();
+      m_hand = 0;
+      m_size = 0;
+    }
+
+    bool empty() const { return m_size == 0; }
+    uint32_t size() const { return m_size; }
+
+  private:
+    enum : uint8_t {
+      kAbsent = 0,
+      kResident,
+      kReferenced
+    };
+
+    std::vector<uint8_t> m_state;
+    uint32_t m_hand = 0;
+    uint32_t m_size = 0;
+
+  };
+
+  /**
+   * \brief LRU list of values
+   *
+   * Values live in a flat pool linked by an lru_index_list, so touch
+   * and remove never allocate. Handles returned by insert stay valid
+   * until the value is removed and allow touching without a lookup.
+   */
+  template<typename T, typename Map = std::unordered_map<T, uint32_t>>
   class lru_list {
 
   public:
-    typedef typename std::list<T>::const_iterator const_iterator;
+    using Handle = uint32_t;
+    static constexpr Handle kInvalidHandle = lru_index_list::kInvalid;
+
+    class const_iterator {
+      friend class lru_list;
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = T;
+      using difference_type = ptrdiff_t;
+      using pointer = const T*;
+      using reference = const T&;
+
+      const T& operator*() const { return m_list->m_values[m_handle]; }
+      const T* operator->() const { return &m_list->m_values[m_handle]; }
+
+      const_iterator& operator++() {
+        m_handle = m_list->m_order.next(m_handle);
+        return *this;
+      }
+
+      const_iterator operator++(int) {
+        const_iterator tmp = *this;
+        ++*this;
+        return tmp;
+      }
+
+      bool operator==(const const_iterator& other) const { return m_handle == other.m_handle; }
+      bool operator!=(const const_iterator& other) const { return m_handle != other.m_handle; }
+
+      Handle handle() const { return m_handle; }
+
+    private:
+      const_iterator(const lru_list* list, Handle handle) : m_list(list), m_handle(handle) { }
+
+      const lru_list* m_list;
+      Handle m_handle;
+    };
 
-    void insert(T value) {
+    // Inserts the value as most recently used, or moves it there
+    Handle insert(T value) {
       auto cacheIter = m_cache.find(value);
-      if (cacheIter != m_cache.end())
-        m_list.erase(cacheIter->second);
+      if (cacheIter != m_cache.end()) {
+        m_order.touch(cacheIter->second);
+        return cacheIter->second;
+      }
 
-      m_list.push_back(value);
-      auto iter = m_list.cend();
-      iter--;
-      m_cache[value] = iter;
+      Handle handle;
+      if (!m_freeHandles.empty()) {
+        handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+        m_values[handle] = value;
+      } else {
+        handle = static_cast<Handle>(m_values.size());
+        m_values.push_back(value);
+      }
+
+      m_cache.emplace(std::move(value), handle);
+      m_order.touch(handle);
+      return handle;
     }
 
     void remove(const T& value) {
@@ -26,14 +321,24 @@ namespace dxvk {
       if (cacheIter == m_cache.end())
         return;
 
-      m_list.erase(cacheIter->second);
+      const Handle handle = cacheIter->second;
       m_cache.erase(cacheIter);
+      release(handle);
     }
 
     const_iterator remove(const_iterator iter) {
-      auto cacheIter = m_cache.find(*iter);
-      m_cache.erase(cacheIter);
-      return m_list.erase(iter);
+      const_iterator next = iter;
+      ++next;
+      removeHandle(iter.m_handle);
+      return next;
+    }
+
+    void removeHandle(Handle handle) {
+      if (!m_order.contains(handle))
+        return;
+
+      m_cache.erase(m_values[handle]);
+      release(handle);
     }
 
     void touch(const T& value) {
@@ -41,29 +346,85 @@ namespace dxvk {
       if (cacheIter == m_cache.end())
         return;
 
-      m_list.erase(cacheIter->second);
-      m_list.push_back(value);
-      auto iter = m_list.cend();
-      --iter;
-      m_cache[value] = iter;
+      m_order.touch(cacheIter->second);
+    }
+
+    // Batched touch, values that are not in the list are ignored
+    void touch(const T* values, size_t count) {
+      for (size_t i = 0; i < count; i++)
+        touch(values[i]);
+    }
+
+    void touchHandle(Handle handle) {
+      if (m_order.contains(handle))
+        m_order.touch(handle);
+    }
+
+    Handle find(const T& value) const {
+      auto cacheIter = m_cache.find(value);
+      return cacheIter != m_cache.end() ? cacheIter->second : kInvalidHandle;
+    }
+
+    const T& get(Handle handle) const {
+      return m_values[handle];
+    }
+
+    /**
+     * \brief Evicts least recently used values while the callback agrees
+     *
+     * \c shouldEvict(value) returns false to stop, e.g. once usage is
+     * under budget. The callback may remove the value itself.
+     * \returns Number of evicted values
+     */
+    template<typename F>
+    size_t evictWhile(F&& shouldEvict) {
+      size_t numEvicted = 0;
+      while (!m_order.empty()) {
+        const Handle handle = m_order.leastRecentlyUsed();
+        if (!shouldEvict(static_cast<const T&>(m_values[handle])))
+          break;
+        removeHandle(handle);
+        numEvicted++;
+      }
+      return numEvicted;
     }
 
     const_iterator leastRecentlyUsedIter() const {
-      return m_list.cbegin();
+      return const_iterator(this, m_order.leastRecentlyUsed());
     }
 
     const_iterator leastRecentlyUsedEndIter() const {
-      return m_list.cend();
+      return const_iterator(this, kInvalidHandle);
+    }
+
+    void clear() {
+      m_order.clear();
+      m_cache.clear();
+      m_values.clear();
+      m_freeHandles.clear();
+    }
+
+    bool empty() const noexcept {
+      return m_order.empty();
     }
 
     uint32_t size() const noexcept {
-      return m_list.size();
+      return m_order.size();
     }
 
   private:
-    std::list<T> m_list;
-    std::unordered_map<T, const_iterator> m_cache;
+    void release(Handle handle) {
+      m_order.remove(handle);
+      m_values[handle] = T();
+      m_freeHandles.push_back(handle);
+    }
+
+    lru_index_list m_order;
+    std::vector<T> m_values;
+    std::vector<Handle> m_freeHandles;
+    Map m_cache;
 
   };
+  // NV-DXVK end
 
 }
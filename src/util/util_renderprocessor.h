@@ -21,10 +21,13 @@
 */
 #pragma once 
 
+#include <algorithm>
 #include <condition_variable>
 #include <functional>
 #include <mutex>
 #include <queue>
+#include <string>
+#include <vector>
 #include <assert.h>
 #include "thread.h"
 #include "util_env.h"
@@ -47,9 +50,12 @@ namespace dxvk {
   template<typename T>
   struct RenderProcessor {
     RenderProcessor() = delete;
-    RenderProcessor(DxvkDevice* pDevice, const std::string& threadName)
-      : m_threadName (threadName)
-      , m_ctx(pDevice->createContext()) {
+    RenderProcessor(DxvkDevice* pDevice, const std::string& threadName, uint32_t numThreads = 1)
+      : m_threadName (threadName) {
+      m_contexts.resize(std::max(numThreads, 1u));
+
+      for (auto& ctx : m_contexts)
+        ctx = pDevice->createContext();
     }
 
     ~RenderProcessor() {
@@ -63,31 +69,36 @@ namespace dxvk {
       if (!m_stopped) {
         std::unique_lock<dxvk::mutex> lock(m_mutex);
         m_stopped.store(true);
-        m_condOnAdd.notify_one();
+        m_condOnAdd.notify_all();
       }
 
-      if (m_thread.joinable()) {
-        m_thread.join();
+      for (auto& thread : m_threads) {
+        if (thread.joinable()) {
+          thread.join();
+        }
       }
 
-      m_ctx = nullptr;
+      m_contexts.clear();
     }
 
     /**
-      * \brief Starts the worker thread.
+      * \brief Starts the worker threads, one per context.
       */
     void start() {
       std::unique_lock<dxvk::mutex> lock(m_mutex);
-      if (m_thread.joinable())
+      if (!m_threads.empty())
         return;
 
-      m_ctx->beginRecording(m_ctx->getDevice()->createCommandList());
+      for (uint32_t i = 0; i < m_contexts.size(); i++) {
+        Rc<DxvkContext>& ctx = m_contexts[i];
+        ctx->beginRecording(ctx->getDevice()->createCommandList());
 
-      m_thread = dxvk::thread([this] {
-        env::setThreadName(m_threadName);
+        m_threads.emplace_back([this, i] {
+          env::setThreadName(i == 0 ? m_threadName : m_threadName + "-" + std::to_string(i));
 
-        threadFunc();
-      });
+          threadFunc(m_contexts[i]);
+        });
+      }
     }
 
     /**
@@ -99,14 +110,15 @@ namespace dxvk {
 
       std::unique_lock<dxvk::mutex> lock(m_mutex);
 
-      if (!m_thread.joinable())
+      if (m_threads.empty())
         return;
 
       m_condOnSync.wait(lock, [this] {
         return !m_itemsPending.load();
       });
 
-      m_ctx->flushCommandList();
+      for (auto& ctx : m_contexts)
+        ctx->flushCommandList();
     }
 
     /**
@@ -116,7 +128,7 @@ namespace dxvk {
       ScopedCpuProfileZone();
 
       std::unique_lock<dxvk::mutex> lock(m_mutex);
-      m_itemQueue.emplace(std::move(item));
+      pushItem(item);
 
       ++m_itemsPending;
 
@@ -140,7 +152,45 @@ namespace dxvk {
       * \brief Conditions under which to wake worker, can be augmented by implementation.
       */
     virtual bool wakeWorkerCondition() {
-      return !m_itemQueue.empty() || m_stopped.load();
+      return hasQueuedItems() || m_stopped.load();
+    }
+
+    /**
+      * \brief Queues an item, called with the queue lock held.  The default
+      *        queue is FIFO, implementations may order items themselves
+      *        by overriding pushItem, popItem and hasQueuedItems together.
+      */
+    virtual void pushItem(const T& item) {
+      m_itemQueue.emplace(item);
+    }
+
+    /**
+      * \brief Takes the next item to work on, called with the queue lock held.
+      */
+    virtual bool popItem(T& item) {
+      if (m_itemQueue.empty())
+        return false;
+
+      item = std::move(m_itemQueue.front());
+      m_itemQueue.pop();
+      return true;
+    }
+
+    /**
+      * \brief Queries if items are waiting, called with the queue lock held.
+      */
+    virtual bool hasQueuedItems() const {
+      return !m_itemQueue.empty();
+    }
+
+    /**
+      * \brief Runs func with the queue lock held, for implementations
+      *        updating their queue outside of pushItem and popItem.
+      */
+    template<typename F>
+    void updateQueue(F&& func) {
+      std::unique_lock<dxvk::mutex> lock(m_mutex);
+      func();
     }
 
     std::atomic<uint32_t> m_itemsPending = { 0u };
@@ -150,14 +200,14 @@ namespace dxvk {
     dxvk::mutex m_mutex;
     std::atomic<bool> m_stopped = { false };
     dxvk::condition_variable m_condOnSync;
-    dxvk::thread m_thread;
+    std::vector<dxvk::thread> m_threads;
     std::string m_threadName;
 
-    Rc<DxvkContext> m_ctx;
+    std::vector<Rc<DxvkContext>> m_contexts;
 
     std::queue<T> m_itemQueue;
 
-    void threadFunc() {
+    void threadFunc(Rc<DxvkContext>& ctx) {
       std::optional<T> optItem;
 
       try {
@@ -167,12 +217,12 @@ namespace dxvk {
 
             if (optItem.has_value()) {
               if (--m_itemsPending == 0)
-                m_condOnSync.notify_one();
+                m_condOnSync.notify_all();
 
               optItem.reset();
             }
 
-            if (m_itemQueue.empty()) {
+            if (!hasQueuedItems()) {
               m_condOnAdd.wait(lock, [this] {
                 return wakeWorkerCondition();
               });
@@ -181,9 +231,9 @@ namespace dxvk {
             if (m_stopped.load())
               break;
 
-            if (!m_itemQueue.empty()) {
-              optItem = std::move(m_itemQueue.front());
-              m_itemQueue.pop();
+            T item;
+            if (popItem(item)) {
+              optItem = std::move(item);
             }
           }
 
@@ -194,7 +244,7 @@ namespace dxvk {
 
           T& item = optItem.value();
 
-          work(item, m_ctx);
+          work(item, ctx);
         }
       } catch (const DxvkError& e) {
         Logger::err(str::format("Exception on, ", m_threadName, ", thread!"));
@@ -21,31 +21,47 @@
 */
 
 #pragma once
-#include <unordered_map>
+#include <algorithm>
+#include <array>
+#include <vector>
 
 #include "util_vector.h"
 #include "./log/log.h"
 
 namespace dxvk {
   // A structure to allow for quickly returning data close to a specific position.
+  //
+  // Cells live in a flat open-addressing table, and each cell owns a contiguous
+  // range of a shared entry pool.  Growing a cell relocates its range to the end
+  // of the pool, the pool is compacted (sorted by cell) once half of it is unused.
+  // Cells are removed from the table as soon as they run empty, so a map whose
+  // entries keep moving doesn't accumulate dead cells.  Queries take a visitor and
+  // never allocate.
   template<class T>
   class SpatialMap {
   public:
-    SpatialMap(float cellSize) : m_cellSize(cellSize) {
-      if (m_cellSize <= 0) {
-        ONCE(Logger::err("Invalid cell size in SpatialMap. cellSize must be greater than 0."));
-        m_cellSize = 1.f;
-      }
+    struct Neighbour {
+      T data;
+      float distanceSqr;
+    };
+
+    SpatialMap(float cellSize) : m_cellSize(validateCellSize(cellSize)) {
+      m_cells.resize(kMinCells);
     }
 
     SpatialMap& operator=(SpatialMap&& other) {
       m_cellSize = other.m_cellSize;
-      m_cache = std::move(other.m_cache);
+      m_cells = std::move(other.m_cells);
+      m_entries = std::move(other.m_entries);
+      m_usedCells = other.m_usedCells;
+      m_size = other.m_size;
       return *this;
     }
 
-    // returns the 8 cells closest to `position`
-    const std::vector<const std::vector<T>*> getDataNearPos(const Vector3& position) const {
+    // Calls `visitor(const T&)` for the data in the 8 cells closest to `position`.
+    // The visitor returns false to stop early, in which case this returns false too.
+    template<typename Visitor>
+    bool forEachNearPos(const Vector3& position, Visitor&& visitor) const {
       static const std::array kOffsets{
         Vector3i{0, 0, 0},
         Vector3i{0, 0, 1},
@@ -56,25 +72,134 @@ namespace dxvk {
         Vector3i{1, 1, 0},
         Vector3i{1, 1, 1}
       };
-      std::vector<const std::vector<T>*> result;
-      result.reserve(8);
 
       const Vector3 cellPosition = position / m_cellSize - Vector3(0.5f, 0.5f, 0.5f);
       const Vector3i floorPos(int(std::floor(cellPosition.x)), int(std::floor(cellPosition.y)), int(std::floor(cellPosition.z)));
 
       for (const Vector3i& offset : kOffsets) {
-        auto iter = m_cache.find(floorPos + offset);
-        if (iter != m_cache.end()) {
-          const std::vector<T>* value = &iter->second;
-          result.push_back(value);
+        const Cell* cell = findCell(floorPos + offset);
+        if (cell == nullptr) {
+          continue;
+        }
+
+        for (uint32_t i = cell->begin; i < cell->begin + cell->count; i++) {
+          if (!visitor(m_entries[i].data)) {
+            return false;
+          }
         }
       }
-      
-      return result;
-    };
-    
+
+      return true;
+    }
+
+    // Calls `visitor(const T&, float distanceSqr)` for all data within `radius` of `position`.
+    // The visitor returns false to stop early, in which case this returns false too.
+    template<typename Visitor>
+    bool forEachInRadius(const Vector3& position, float radius, Visitor&& visitor) const {
+      const float radiusSqr = radius * radius;
+
+      auto visitCell = [&](const Cell& cell) {
+        for (uint32_t i = cell.begin; i < cell.begin + cell.count; i++) {
+          const float distanceSqr = lengthSqr(m_entries[i].position - position);
+          if (distanceSqr <= radiusSqr && !visitor(m_entries[i].data, distanceSqr)) {
+            return false;
+          }
+        }
+        return true;
+      };
+
+      const float cellsPerAxis = 2.f * radius / m_cellSize + 2.f;
+
+      // Huge radius compared to the map, walking the table is cheaper than probing every cell in range
+      if (cellsPerAxis * cellsPerAxis * cellsPerAxis > float(m_cells.size())) {
+        for (const Cell& cell : m_cells) {
+          if (cell.isUsed() && !visitCell(cell)) {
+            return false;
+          }
+        }
+        return true;
+      }
+
+      const Vector3i minPos = getCellPos(position - Vector3(radius, radius, radius));
+      const Vector3i maxPos = getCellPos(position + Vector3(radius, radius, radius));
+      for (int z = minPos.z; z <= maxPos.z; z++) {
+        for (int y = minPos.y; y <= maxPos.y; y++) {
+          for (int x = minPos.x; x <= maxPos.x; x++) {
+            const Cell* cell = findCell(Vector3i(x, y, z));
+            if (cell != nullptr && !visitCell(*cell)) {
+              return false;
+            }
+          }
+        }
+      }
+
+      return true;
+    }
+
+    // Finds up to `k` entries closest to `position` and no further than `maxDistance`,
+    // written to `out` sorted by distance.  Returns the number of entries found.
+    uint32_t findNearest(const Vector3& position, uint32_t k, float maxDistance, Neighbour* out) const {
+      if (k == 0 || m_size == 0) {
+        return 0;
+      }
+
+      const float maxDistanceSqr = maxDistance * maxDistance;
+      uint32_t found = 0;
+
+      auto visitCell = [&](const Cell& cell) {
+        for (uint32_t i = cell.begin; i < cell.begin + cell.count; i++) {
+          const float distanceSqr = lengthSqr(m_entries[i].position - position);
+          if (distanceSqr > maxDistanceSqr || (found == k && distanceSqr >= out[k - 1].distanceSqr)) {
+            continue;
+          }
+
+          // Insertion into the sorted output, dropping the furthest when full
+          uint32_t j = found < k ? found++ : k - 1;
+          while (j > 0 && out[j - 1].distanceSqr > distanceSqr) {
+            out[j] = out[j - 1];
+            j--;
+          }
+          out[j] = Neighbour { m_entries[i].data, distanceSqr };
+        }
+      };
+
+      // Visit shells of cells around the query cell, every cell of shell `r` is at least
+      // (r - 1) cells away, so we can stop once the k-th neighbour is closer than that.
+      const Vector3i center = getCellPos(position);
+      for (int r = 0; ; r++) {
+        const uint64_t side = 2 * uint64_t(r) + 1;
+        if (side * side * side > m_cells.size()) {
+          // Shells have outgrown the table, finish with a linear pass instead
+          found = 0;
+          for (const Cell& cell : m_cells) {
+            if (cell.isUsed()) {
+              visitCell(cell);
+            }
+          }
+          return found;
+        }
+
+        for (int z = -r; z <= r; z++) {
+          for (int y = -r; y <= r; y++) {
+            const bool onShellFace = std::abs(z) == r || std::abs(y) == r;
+            for (int x = -r; x <= r; x += onShellFace ? 1 : 2 * std::max(r, 1)) {
+              const Cell* cell = findCell(center + Vector3i(x, y, z));
+              if (cell != nullptr) {
+                visitCell(*cell);
+              }
+            }
+          }
+        }
+
+        const float shellDistance = float(r) * m_cellSize;
+        if (shellDistance > maxDistance || (found == k && out[k - 1].distanceSqr <= shellDistance * shellDistance)) {
+          return found;
+        }
+      }
+    }
+
     void insert(const Vector3& position, T data) {
-      insert(getCellPos(position), data);
+      insert(getCellPos(position), Entry { position, data });
     }
 
     void erase(const Vector3& position, T data) {
@@ -85,49 +210,247 @@ namespace dxvk {
       Vector3i oldPos = getCellPos(oldPosition);
       Vector3i newPos = getCellPos(newPosition);
       if (oldPos != newPos) {
-        erase(oldPosition, data);
-        insert(newPos, data);
+        erase(oldPos, data);
+        insert(newPos, Entry { newPosition, data });
+      } else if (Entry* entry = findEntry(oldPos, data)) {
+        entry->position = newPosition;
       }
     }
 
-    const std::unordered_map<Vector3i, std::vector<T>>& getAll() {
-      return m_cache;
+    // Re-buckets all entries for a new cell size in a single sort-by-cell pass,
+    // leaving every cell's data packed contiguously.
+    void rebuild(float cellSize) {
+      m_cellSize = validateCellSize(cellSize);
+      rebuildTable(m_usedCells);
+    }
+
+    size_t size() const {
+      return m_size;
+    }
+
+    // Number of slots in the cell table, for diagnostics
+    size_t tableSize() const {
+      return m_cells.size();
     }
 
   private:
+    static constexpr uint32_t kMinCells = 16;
+    static constexpr uint32_t kMinCellCapacity = 4;
+    static constexpr uint32_t kUnusedCell = ~0u;
+
+    struct Entry {
+      Vector3 position;
+      T data;
+    };
+
+    struct Cell {
+      Vector3i pos;
+      uint32_t begin = kUnusedCell;
+      uint32_t count = 0;
+      uint32_t capacity = 0;
+
+      bool isUsed() const {
+        return begin != kUnusedCell;
+      }
+    };
+
+    static float validateCellSize(float cellSize) {
+      if (cellSize <= 0) {
+        ONCE(Logger::err("Invalid cell size in SpatialMap. cellSize must be greater than 0."));
+        return 1.f;
+      }
+      return cellSize;
+    }
+
+    static uint32_t hashCellPos(const Vector3i& pos) {
+      uint32_t h = uint32_t(pos.x) * 73856093u ^ uint32_t(pos.y) * 19349663u ^ uint32_t(pos.z) * 83492791u;
+      // Final avalanche, the probe start only uses the low bits
+      h ^= h >> 16;
+      h *= 0x85ebca6bu;
+      h ^= h >> 13;
+      return h;
+    }
 
     Vector3i getCellPos(const Vector3& position) const {
       const Vector3 scaledPos = position / m_cellSize;
       return Vector3i(int(std::floor(scaledPos.x)), int(std::floor(scaledPos.y)), int(std::floor(scaledPos.z))); 
     }
 
-    void insert(const Vector3i& pos, T data) {
-      m_cache[pos].push_back(data);
+    const Cell* findCell(const Vector3i& pos) const {
+      const size_t mask = m_cells.size() - 1;
+      for (size_t i = hashCellPos(pos) & mask; ; i = (i + 1) & mask) {
+        const Cell& cell = m_cells[i];
+        if (!cell.isUsed()) {
+          return nullptr;
+        }
+        if (cell.pos == pos) {
+          return &cell;
+        }
+      }
+    }
+
+    Cell* findCell(const Vector3i& pos) {
+      return const_cast<Cell*>(static_cast<const SpatialMap*>(this)->findCell(pos));
+    }
+
+    // Backward shift deletion, pulls later cells of the probe sequence into the freed
+    // slot so lookups never need tombstones.  The cell's pool range becomes a hole.
+    void removeCell(Cell* cell) {
+      const size_t mask = m_cells.size() - 1;
+      size_t hole = size_t(cell - m_cells.data());
+
+      for (size_t i = (hole + 1) & mask; m_cells[i].isUsed(); i = (i + 1) & mask) {
+        const size_t home = hashCellPos(m_cells[i].pos) & mask;
+
+        // Cells whose home slot lies cyclically in (hole, i] have to stay where they are
+        const bool staysPut = hole <= i ? (hole < home && home <= i) : (hole < home || home <= i);
+        if (!staysPut) {
+          m_cells[hole] = m_cells[i];
+          hole = i;
+        }
+      }
+
+      m_cells[hole] = Cell();
+      --m_usedCells;
+    }
+
+    Cell& findOrAddCell(const Vector3i& pos) {
+      // Keep the load factor under 1/2 so probe sequences stay short
+      if ((m_usedCells + 1) * 2 > m_cells.size()) {
+        rebuildTable(m_usedCells + 1);
+      }
+
+      const size_t mask = m_cells.size() - 1;
+      for (size_t i = hashCellPos(pos) & mask; ; i = (i + 1) & mask) {
+        Cell& cell = m_cells[i];
+        if (!cell.isUsed()) {
+          cell.pos = pos;
+          cell.begin = uint32_t(m_entries.size());
+          cell.count = 0;
+          cell.capacity = 0;
+          ++m_usedCells;
+          return cell;
+        }
+        if (cell.pos == pos) {
+          return cell;
+        }
+      }
     }
 
-    void erase(const Vector3i& pos, T data) {
-      auto cellIter = m_cache.find(pos);
-      if (cellIter == m_cache.end()) {
+    Entry* findEntry(const Vector3i& pos, const T& data) {
+      Cell* cell = findCell(pos);
+      if (cell == nullptr) {
+        return nullptr;
+      }
+
+      for (uint32_t i = cell->begin; i < cell->begin + cell->count; i++) {
+        if (m_entries[i].data == data) {
+          return &m_entries[i];
+        }
+      }
+      return nullptr;
+    }
+
+    void insert(const Vector3i& pos, const Entry& entry) {
+      Cell& cell = findOrAddCell(pos);
+
+      if (cell.count == cell.capacity) {
+        // Move the cell's range to the end of the pool with room to grow
+        const uint32_t newCapacity = std::max(kMinCellCapacity, cell.capacity * 2);
+        const uint32_t newBegin = uint32_t(m_entries.size());
+        m_entries.resize(m_entries.size() + newCapacity);
+        std::move(m_entries.begin() + cell.begin, m_entries.begin() + cell.begin + cell.count, m_entries.begin() + newBegin);
+        cell.begin = newBegin;
+        cell.capacity = newCapacity;
+      }
+
+      m_entries[cell.begin + cell.count++] = entry;
+      ++m_size;
+
+      // Relocations and erases leave holes in the pool, compact once they dominate
+      if (m_entries.size() - m_size > m_entries.size() / 2 && m_entries.size() > 1024) {
+        rebuildTable(m_usedCells);
+      }
+    }
+
+    void erase(const Vector3i& pos, const T& data) {
+      Cell* cell = findCell(pos);
+      if (cell == nullptr || cell->count == 0) {
         Logger::err("Specified cell was already empty in SpatialMap::erase().");
         return;
       }
 
-      std::vector<T>& cell = cellIter->second;
-      auto iter = std::find(cell.begin(), cell.end(), data);
-      if (iter != cell.end()) {
-        if (cell.size() > 1) {
-          // Swap & pop - faster than "erase", but doesn't preserve order, which is fine here.
-          std::swap(*iter, cell.back());
-          cell.pop_back();
-        } else {
-          m_cache.erase(cellIter);
+      Entry* entry = findEntry(pos, data);
+      if (entry != nullptr) {
+        // Swap & pop - faster than "erase", but doesn't preserve order, which is fine here.
+        std::swap(*entry, m_entries[cell->begin + cell->count - 1]);
+        --cell->count;
+        --m_size;
+
+        if (cell->count == 0) {
+          removeCell(cell);
         }
       } else {
         Logger::err("Couldn't find matching data in SpatialMap::erase().");
       }
     }
 
+    // Rebuckets every live entry with the current cell size into a table sized for
+    // `minCells`, sorted by cell so each cell ends up as one packed range.
+    void rebuildTable(size_t minCells) {
+      std::vector<std::pair<Vector3i, uint32_t>> order;
+      order.reserve(m_size);
+      for (const Cell& cell : m_cells) {
+        if (cell.isUsed()) {
+          for (uint32_t i = cell.begin; i < cell.begin + cell.count; i++) {
+            order.emplace_back(getCellPos(m_entries[i].position), i);
+          }
+        }
+      }
+
+      // Entries of a cell keep their pool order, so the result doesn't depend on the sort implementation
+      std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) {
+        if (a.first.x != b.first.x) return a.first.x < b.first.x;
+        if (a.first.y != b.first.y) return a.first.y < b.first.y;
+        if (a.first.z != b.first.z) return a.first.z < b.first.z;
+        return a.second < b.second;
+      });
+
+      size_t numCells = 0;
+      for (size_t i = 0; i < order.size(); i++) {
+        if (i == 0 || order[i].first != order[i - 1].first) {
+          ++numCells;
+        }
+      }
+
+      size_t tableSize = kMinCells;
+      while (tableSize < std::max(numCells, minCells) * 2) {
+        tableSize *= 2;
+      }
+
+      std::vector<Entry> entries;
+      entries.reserve(order.size());
+      m_cells.assign(tableSize, Cell());
+      m_usedCells = 0;
+
+      Cell* cell = nullptr;
+      for (size_t i = 0; i < order.size(); i++) {
+        if (cell == nullptr || order[i].first != cell->pos) {
+          cell = &findOrAddCell(order[i].first);
+          cell->begin = uint32_t(entries.size());
+        }
+        entries.push_back(m_entries[order[i].second]);
+        ++cell->count;
+        ++cell->capacity;
+      }
+
+      m_entries = std::move(entries);
+    }
+
     float m_cellSize;
-    std::unordered_map<Vector3i, std::vector<T>> m_cache;
+    std::vector<Cell> m_cells;
+    std::vector<Entry> m_entries;
+    size_t m_usedCells = 0;
+    size_t m_size = 0;
   };
 }
@@ -266,11 +266,20 @@ namespace dxvk {
     *        work stealing algorithm.
     *
     *  NumThreads: How many threads to spawn (up to 255)
-    *  NumTasksPerThread: Size of the task queue ring buffer
+    *  NumTasksPerThread: Size of the task queue ring buffer, rounded up to a power of two
     *  WorkStealing: Enables the work stealing features of the scheduler
     *  LowLatency: Enables the low-latency mode where workers will spin instead of
     *              waiting for tasks on a conditional variable
     *  (ctor)workerName: Name given to threads with the pattern: workerName(N)
+    *
+    *  Any number of threads may call Schedule concurrently.  When every eligible
+    *  queue is full, Schedule applies back-pressure: the calling thread helps execute
+    *  queued tasks until space is available, rather than dropping the task.
+    *
+    *  Note: Task storage is a ring of (queue capacity * NumThreads * 2) entries, rounded
+    *        up to a power of two.  Slots that are still queued or executing are skipped,
+    *        but a finished one is reused, so a Future must be consumed before about that
+    *        many further tasks are scheduled.
     * 
     *  Example usage:
     *   // Creates 1 thread, and uses it to return PI via a future
@@ -280,8 +289,13 @@ namespace dxvk {
     */
   template<size_t NumTasksPerThread, bool WorkStealing = true, bool LowLatency = true>
   class WorkerThreadPool {
-    using Queue = AtomicQueue<TaskId, NumTasksPerThread>;
-    using QueuePtr = std::unique_ptr<Queue>;
+    using Queue = MpmcAtomicQueue<TaskId, NumTasksPerThread>;
+
+    struct WorkerQueue {
+      // Pushed by any scheduling thread, popped by its worker and by stealing threads
+      Queue tasks;
+    };
+    using QueuePtr = std::unique_ptr<WorkerQueue>;
 
     struct Nop { };
     using OnAddCondition = std::conditional_t<LowLatency, Nop, dxvk::condition_variable>;
@@ -290,16 +304,19 @@ namespace dxvk {
   public:
     WorkerThreadPool(uint8_t numThreads, const char* workerName = "Nameless Worker Thread") 
     : m_numThread(numThreads) {
-      // Note: round up to a closest power-of-two so we can use mask as modulo
-      m_taskCount = 1 << (32 - bit::lzcnt(static_cast<uint32_t>(NumTasksPerThread*numThreads) - 1));
+      // Note: round up to a closest power-of-two so we can use mask as modulo.
+      //       Doubled so tasks which are already popped and still executing (or helping
+      //       producers under back-pressure) are never recycled by a full set of queues.
+      m_taskCount = 1 << (32 - bit::lzcnt(static_cast<uint32_t>(Queue::capacity()*numThreads*2) - 1));
       m_tasks.resize(m_taskCount);
+      m_taskBusy = std::make_unique<std::atomic<bool>[]>(m_taskCount);
       m_workerTasks.resize(m_numThread);
       m_workerThreads.resize(m_numThread);
       // Create the work queues first!  We need to create
       // then all since work stealing may access the other
       // queues.
       for (int i = 0; i < m_numThread; i++) {
-        m_workerTasks[i] = std::make_unique<Queue>();
+        m_workerTasks[i] = std::make_unique<WorkerQueue>();
       }
 
       // Start the worker threads
@@ -327,7 +344,7 @@ namespace dxvk {
       if (m_numTasks > 0) {
         for (auto& workerTasks : m_workerTasks) {
           TaskId taskId;
-          while (workerTasks->pop(taskId)) {
+          while (workerTasks->tasks.pop(taskId)) {
             // Cancel the actual task job
             m_tasks[taskId].cancel();
             // Execute the task to dispatch the destructor
@@ -340,49 +357,144 @@ namespace dxvk {
       assert(m_numTasks == 0 && "Tasks left in thread pool queue after destruction!");
     }
 
-    // Schedule a task to be executed by the thread pool
+    // Schedule a task to be executed by the thread pool, safe to call from any number of threads
     template <uint8_t Affinity = 0xFF, typename F, typename R = std::invoke_result_t<std::decay_t<F>>>
     Future<R> Schedule(F&& f) {
-      // Add the task to the queue and notify a worker thread
-      //  just distribute evenly to all threads for some mask denoted by Affinity.
-      static size_t s_idx = 0;
-
       // Is the affinity mask valid?
       const uint8_t affinityMask = std::min(popcnt_uint8(Affinity), m_numThread);
 
-      // Schedule work on the appropriate thread
-      const uint32_t thread = fast::findNthBit(Affinity, (uint8_t) (s_idx++ % affinityMask));
-      assert(thread < m_numThread);
+      // Add the task to the queue and notify a worker thread
+      //  just distribute evenly to all threads for some mask denoted by Affinity.
+      const uint32_t first = m_scheduleIdx++ % affinityMask;
 
-      // Atomic queue is SPSC, so we don't need to take a lock here
-      // since we know this will always be called from a single thread.
+      // Get next free task id.  Producers no longer serialize, so one that gets preempted
+      // here may be lapped by the others, skip slots which are still captured or executing.
+      TaskId taskId;
+      do {
+        taskId = m_taskId++ & (m_taskCount - 1);
+      } while (m_taskBusy[taskId].exchange(true, std::memory_order_acquire));
 
-      Future<R> future;
-      if (!m_workerTasks[thread]->isFull()) {
-        // Get next task id
-        TaskId taskId = m_taskId++ & (m_taskCount - 1);
+      // Capture task lambda
+      Future<R> future = m_tasks[taskId].capture<F, R>(std::forward<F>(f));
 
-        // Capture task lambda
-        future = m_tasks[taskId].capture<F, R>(std::forward<F>(f));
+      // Count the task before it becomes visible to the workers
+      ++m_numTasks;
 
-        // Place task into queue
-        m_workerTasks[thread]->push(std::move(taskId));
+      while (true) {
+        // Prefer the round-robin thread, fall back to the other threads in the mask if its queue is full
+        for (uint32_t i = 0; i < affinityMask; i++) {
+          const uint32_t thread = fast::findNthBit(Affinity, (uint8_t) ((first + i) % affinityMask));
+          assert(thread < m_numThread);
+
+          // Place task into queue
+          TaskId queuedId = taskId;
+          if (!m_workerTasks[thread]->tasks.push(std::move(queuedId))) {
+            continue;
+          }
 
-        if constexpr (!LowLatency) {
-          std::unique_lock<TaskMutex> lock(m_taskMutex);
-          if constexpr (WorkStealing) {
-            // Notify only one worker when workers can steal from the others
-            m_condOnAdd.notify_one();
-          } else {
-            // Notify all workers when they cannot steal
-            m_condOnAdd.notify_all();
+          if constexpr (!LowLatency) {
+            std::unique_lock<TaskMutex> condLock(m_taskMutex);
+            if constexpr (WorkStealing) {
+              // Notify only one worker when workers can steal from the others
+              m_condOnAdd.notify_one();
+            } else {
+              // Notify all workers when they cannot steal
+              m_condOnAdd.notify_all();
+            }
           }
+
+          return future;
+        }
+
+        // Every eligible queue is full, so apply back-pressure by helping
+        // the workers drain their queues until a slot frees up.
+        if (!executeTask(fast::findNthBit(Affinity, (uint8_t) first))) {
+          std::this_thread::yield();
         }
+      }
+    }
 
-        ++m_numTasks;
+    /**
+      * \brief Splits the range [begin, end) into chunks and processes them across the
+      *        worker threads, the calling thread participates as well.  Returns once
+      *        every chunk has completed (fork-join).
+      *
+      *  chunkSize: number of elements per chunk, the unit of work distribution
+      *  func: invoked as func(chunkBegin, chunkEnd) once per chunk, from any thread
+      *
+      *  Safe to call from within a task running on this pool, since the caller
+      *  executes other queued tasks while waiting for the join.
+      */
+    template<typename F>
+    void ParallelFor(const uint32_t begin, const uint32_t end, const uint32_t chunkSize, F&& func) {
+      if (begin >= end) {
+        return;
       }
 
-      return future;
+      const uint32_t elementsPerChunk = std::max(chunkSize, 1u);
+      const uint32_t numChunks = divCeil(end - begin, elementsPerChunk);
+
+      std::atomic<uint32_t> nextChunk = 0;
+      auto runChunks = [&nextChunk, &func, numChunks, begin, end, elementsPerChunk]() {
+        uint32_t chunk;
+        while ((chunk = nextChunk++) < numChunks) {
+          const uint32_t chunkBegin = begin + chunk * elementsPerChunk;
+          func(chunkBegin, std::min(chunkBegin + elementsPerChunk, end));
+        }
+      };
+
+      // Fork: one helper per worker at most, each pulls chunks until none are left
+      std::atomic<uint32_t> pendingHelpers = 0;
+      const uint32_t numHelpers = std::min<uint32_t>(m_numThread, numChunks - 1);
+      for (uint32_t i = 0; i < numHelpers; i++) {
+        ++pendingHelpers;
+        Schedule([&runChunks, &pendingHelpers]() {
+          runChunks();
+          // Note: must be the last access to the caller's stack
+          --pendingHelpers;
+        });
+      }
+
+      runChunks();
+
+      // Join: helpers may still be queued behind other work, keep the queues moving while we wait
+      while (pendingHelpers.load() > 0) {
+        if (!executeAnyTask()) {
+          std::this_thread::yield();
+        }
+      }
+    }
+
+    /**
+      * \brief Parallel map-reduce over the range [begin, end), see ParallelFor.
+      *
+      *  identity: initial value for the reduction
+      *  map: invoked as map(chunkBegin, chunkEnd) -> T once per chunk
+      *  reduce: invoked as reduce(T, T) -> T, partial results are combined in chunk
+      *          order so the result is deterministic for a given chunkSize
+      */
+    template<typename T, typename MapF, typename ReduceF>
+    T ParallelReduce(const uint32_t begin, const uint32_t end, const uint32_t chunkSize, const T& identity, MapF&& map, ReduceF&& reduce) {
+      if (begin >= end) {
+        return identity;
+      }
+
+      const uint32_t elementsPerChunk = std::max(chunkSize, 1u);
+      std::vector<T> partials(divCeil(end - begin, elementsPerChunk), identity);
+
+      ParallelFor(begin, end, elementsPerChunk, [&partials, &map, begin, elementsPerChunk](uint32_t chunkBegin, uint32_t chunkEnd) {
+        partials[(chunkBegin - begin) / elementsPerChunk] = map(chunkBegin, chunkEnd);
+      });
+
+      T result = identity;
+      for (const T& partial : partials) {
+        result = reduce(result, partial);
+      }
+      return result;
+    }
+
+    uint8_t numThreads() const {
+      return m_numThread;
     }
 
   private:
@@ -425,32 +537,41 @@ namespace dxvk {
       }
     }
 
+    // True if a task was executed from any of the queues
+    bool executeAnyTask() {
+      for (uint32_t i = 0; i < m_numThread; i++) {
+        if (executeTask(i)) {
+          return true;
+        }
+      }
+      return false;
+    }
+
     // True if front pop, False if back pop
     bool executeTask(const uint32_t workerId) {
+      // The queues are MPMC, so stealing needs no lock
       TaskId taskId;
-      {
-        // Since we're using an SPSC queue, we must take a lock when
-        // popping, since we may be stealing (or be stolen from) by
-        // another thread.
-        std::unique_lock<sync::Spinlock> lock(m_threadMutex);
-
-        if (!m_workerTasks[workerId]->pop(taskId)) {
-          return false;
-        }
-
-        --m_numTasks;
+      if (!m_workerTasks[workerId]->tasks.pop(taskId)) {
+        return false;
       }
 
+      --m_numTasks;
+
       // Execute the task
       m_tasks[taskId]();
+      m_taskBusy[taskId].store(false, std::memory_order_release);
 
       return true;
     }
 
     std::vector<Task> m_tasks;
+    std::unique_ptr<std::atomic<bool>[]> m_taskBusy;
     std::atomic<TaskId> m_taskId = 0;
     uint32_t m_taskCount;
 
+    // Round-robin cursor for distributing scheduled tasks
+    std::atomic<uint32_t> m_scheduleIdx = 0;
+
     uint8_t m_numThread;
 
     std::atomic<bool> m_stopWork = false;
@@ -459,9 +580,6 @@ namespace dxvk {
     TaskMutex m_taskMutex;
     OnAddCondition m_condOnAdd;
 
-    // Used to synchronize intra-thread stealing
-    sync::Spinlock m_threadMutex;
-
     std::vector<std::thread> m_workerThreads;
 
     // We expect high volume of potentially small tasks via "Schedule" per-
@@ -470,6 +588,6 @@ namespace dxvk {
     //  1. Non-circular queue incurs allocation overhead thats unacceptable
     //  2. Use of mutex, and CVs, incur overhead thats unacceptable
     std::vector<QueuePtr> m_workerTasks;
-    std::atomic_uint32_t m_numTasks;
+    std::atomic_uint32_t m_numTasks = 0;
   };
-} //dxvk
\ No newline at end of file
+} //dxvk
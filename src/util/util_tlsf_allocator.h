@@ -0,0 +1,373 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "util_bit.h"
+
+namespace dxvk {
+  /**
+   * \brief Two-level segregated fit (TLSF) offset allocator
+   *
+   * Hands out offsets into a range of a given size without touching
+   * the memory itself, e.g. a device memory chunk. Free blocks are
+   * binned by size on two levels, by power of two and then linearly
+   * within it, with a bitmap per level, so both alloc and free are
+   * O(1) regardless of how fragmented the range is. Physically
+   * adjacent free blocks are always merged.
+   *
+   * Block bookkeeping lives in a node pool which only grows when the
+   * number of blocks reaches a new high, so steady state use does
+   * not allocate. Not thread-safe.
+   */
+  class TlsfAllocator {
+    // Second level subdivides each power of two into 32 bins, the first
+    // level covers sizes up to 2^36, which is plenty for a memory chunk
+    static constexpr uint32_t kSlBits  = 5;
+    static constexpr uint32_t kSlCount = 1u << kSlBits;
+    static constexpr uint32_t kFlCount = 32;
+
+  public:
+    using Node = uint32_t;
+    static constexpr Node kInvalidNode = ~0u;
+
+    struct Allocation {
+      uint64_t offset = 0;
+      uint64_t size   = 0;
+      Node     node   = kInvalidNode;
+
+      explicit operator bool () const {
+        return node != kInvalidNode;
+      }
+    };
+
+    // Largest range the bins can describe
+    static constexpr uint64_t kMaxSize = (1ull << (kFlCount + kSlBits - 1)) - 1;
+
+    explicit TlsfAllocator(uint64_t size)
+    : m_size(size), m_freeBytes(size) {
+      assert(size <= kMaxSize);
+
+      std::fill(&m_heads[0][0], &m_heads[0][0] + kFlCount * kSlCount, kInvalidNode);
+
+      if (size > 0) {
+        insertFree(createNode(0, size, kInvalidNode, kInvalidNode));
+      }
+    }
+
+    /**
+     * \brief Allocates a block
+     *
+     * \param [in] size Number of bytes, rounded up to the alignment
+     * \param [in] align Required alignment of the offset, a power of two
+     * \returns The allocation, evaluates to \c false on failure
+     */
+    Allocation alloc(uint64_t size, uint64_t align) {
+      align = std::max<uint64_t>(align, 1);
+      const uint64_t alignedSize = alignUp(std::max<uint64_t>(size, 1), align);
+
+      // Blocks start at arbitrary offsets, so first try a block that
+      // is large enough for the size alone and happens to be aligned,
+      // then fall back to one that has room for any alignment padding
+      Node node = findFreeBlock(alignedSize);
+      if (node != kInvalidNode && !fits(m_nodes[node], alignedSize, align)) {
+        node = align > 1 ? findFreeBlock(alignedSize + align - 1) : kInvalidNode;
+      }
+
+      if (node == kInvalidNode) {
+        return Allocation();
+      }
+
+      removeFree(node);
+
+      // Return the padding in front of the aligned offset
+      const uint64_t alignedOffset = alignUp(m_nodes[node].offset, align);
+      const uint64_t padding = alignedOffset - m_nodes[node].offset;
+      if (padding > 0) {
+        const Node front = createNode(m_nodes[node].offset, padding, m_nodes[node].prevPhys, node);
+        linkPhysBefore(front, node);
+        m_nodes[node].offset = alignedOffset;
+        m_nodes[node].size -= padding;
+        insertFree(front);
+      }
+
+      // And whatever is left behind the allocation
+      if (m_nodes[node].size > alignedSize) {
+        const Node back = createNode(alignedOffset + alignedSize, m_nodes[node].size - alignedSize, node, m_nodes[node].nextPhys);
+        linkPhysAfter(back, node);
+        m_nodes[node].size = alignedSize;
+        insertFree(back);
+      }
+
+      m_freeBytes -= alignedSize;
+      m_numAllocations++;
+
+      Allocation allocation;
+      allocation.offset = alignedOffset;
+      allocation.size = alignedSize;
+      allocation.node = node;
+      return allocation;
+    }
+
+    /**
+     * \brief Returns a block to the allocator
+     * \param [in] node Node of an allocation returned by \c alloc
+     */
+    void free(Node node) {
+      assert(node < m_nodes.size() && !m_nodes[node].isFree && m_nodes[node].size > 0);
+
+      m_freeBytes += m_nodes[node].size;
+      m_numAllocations--;
+
+      const Node next = m_nodes[node].nextPhys;
+      if (next != kInvalidNode && m_nodes[next].isFree) {
+        removeFree(next);
+        m_nodes[node].size += m_nodes[next].size;
+        unlinkPhys(next);
+        releaseNode(next);
+      }
+
+      const Node prev = m_nodes[node].prevPhys;
+      if (prev != kInvalidNode && m_nodes[prev].isFree) {
+        removeFree(prev);
+        m_nodes[prev].size += m_nodes[node].size;
+        unlinkPhys(node);
+        releaseNode(node);
+        node = prev;
+      }
+
+      insertFree(node);
+    }
+
+    bool isEmpty() const {
+      return m_numAllocations == 0;
+    }
+
+    uint64_t size() const {
+      return m_size;
+    }
+
+    uint64_t freeBytes() const {
+      return m_freeBytes;
+    }
+
+    uint32_t freeBlockCount() const {
+      return m_numFreeBlocks;
+    }
+
+    uint32_t allocationCount() const {
+      return m_numAllocations;
+    }
+
+    /**
+     * \brief Size of the largest free block
+     *
+     * Only walks the highest non-empty bin.
+     */
+    uint64_t largestFreeBlock() const {
+      if (m_flBitmap == 0) {
+        return 0;
+      }
+
+      const uint32_t fl = 31 - bit::lzcnt(m_flBitmap);
+      const uint32_t sl = 31 - bit::lzcnt(m_slBitmaps[fl]);
+
+      uint64_t largest = 0;
+      for (Node node = m_heads[fl][sl]; node != kInvalidNode; node = m_nodes[node].nextFree) {
+        largest = std::max(largest, m_nodes[node].size);
+      }
+      return largest;
+    }
+
+  private:
+    struct Block {
+      uint64_t offset;
+      uint64_t size;
+      Node     prevPhys;
+      Node     nextPhys;
+      Node     prevFree;
+      Node     nextFree;
+      bool     isFree;
+    };
+
+    uint64_t m_size;
+    uint64_t m_freeBytes;
+    uint32_t m_numFreeBlocks = 0;
+    uint32_t m_numAllocations = 0;
+
+    uint32_t m_flBitmap = 0;
+    uint32_t m_slBitmaps[kFlCount] = { };
+    Node     m_heads[kFlCount][kSlCount];
+
+    std::vector<Block> m_nodes;
+    std::vector<Node>  m_unusedNodes;
+
+    static uint64_t alignUp(uint64_t value, uint64_t align) {
+      return (value + align - 1) & ~(align - 1);
+    }
+
+    static uint32_t log2(uint64_t value) {
+      const uint32_t hi = uint32_t(value >> 32);
+      return hi != 0 ? 63 - bit::lzcnt(hi) : 31 - bit::lzcnt(uint32_t(value));
+    }
+
+    // Bin that a block of the given size is filed under
+    static void mapping(uint64_t size, uint32_t& fl, uint32_t& sl) {
+      if (size < kSlCount) {
+        fl = 0;
+        sl = uint32_t(size);
+      } else {
+        const uint32_t log = log2(size);
+        fl = log - kSlBits + 1;
+        sl = uint32_t(size >> (log - kSlBits)) - kSlCount;
+      }
+    }
+
+    static bool fits(const Block& block, uint64_t size, uint64_t align) {
+      return alignUp(block.offset, align) + size <= block.offset + block.size;
+    }
+
+    // Any block in the returned bin, or a larger one, is large enough
+    Node findFreeBlock(uint64_t size) const {
+      if (size >= kSlCount) {
+        size += (1ull << (log2(size) - kSlBits)) - 1;
+      }
+
+      uint32_t fl, sl;
+      mapping(size, fl, sl);
+      if (fl >= kFlCount) {
+        return kInvalidNode;
+      }
+
+      uint32_t slMap = m_slBitmaps[fl] & (~0u << sl);
+      if (slMap == 0) {
+        const uint32_t flMap = fl + 1 < kFlCount ? m_flBitmap & (~0u << (fl + 1)) : 0;
+        if (flMap == 0) {
+          return kInvalidNode;
+        }
+
+        fl = bit::tzcnt(flMap);
+        slMap = m_slBitmaps[fl];
+      }
+
+      return m_heads[fl][bit::tzcnt(slMap)];
+    }
+
+    void insertFree(Node node) {
+      uint32_t fl, sl;
+      mapping(m_nodes[node].size, fl, sl);
+
+      Block& block = m_nodes[node];
+      block.isFree = true;
+      block.prevFree = kInvalidNode;
+      block.nextFree = m_heads[fl][sl];
+
+      if (block.nextFree != kInvalidNode) {
+        m_nodes[block.nextFree].prevFree = node;
+      }
+
+      m_heads[fl][sl] = node;
+      m_flBitmap |= 1u << fl;
+      m_slBitmaps[fl] |= 1u << sl;
+      m_numFreeBlocks++;
+    }
+
+    void removeFree(Node node) {
+      uint32_t fl, sl;
+      mapping(m_nodes[node].size, fl, sl);
+
+      Block& block = m_nodes[node];
+      if (block.prevFree != kInvalidNode) {
+        m_nodes[block.prevFree].nextFree = block.nextFree;
+      } else {
+        m_heads[fl][sl] = block.nextFree;
+      }
+
+      if (block.nextFree != kInvalidNode) {
+        m_nodes[block.nextFree].prevFree = block.prevFree;
+      }
+
+      if (m_heads[fl][sl] == kInvalidNode) {
+        m_slBitmaps[fl] &= ~(1u << sl);
+        if (m_slBitmaps[fl] == 0) {
+          m_flBitmap &= ~(1u << fl);
+        }
+      }
+
+      block.isFree = false;
+      m_numFreeBlocks--;
+    }
+
+    Node createNode(uint64_t offset, uint64_t size, Node prevPhys, Node nextPhys) {
+      const Block block = { offset, size, prevPhys, nextPhys, kInvalidNode, kInvalidNode, false };
+
+      if (!m_unusedNodes.empty()) {
+        const Node node = m_unusedNodes.back();
+        m_unusedNodes.pop_back();
+        m_nodes[node] = block;
+        return node;
+      }
+
+      m_nodes.push_back(block);
+      return Node(m_nodes.size() - 1);
+    }
+
+    void releaseNode(Node node) {
+      m_nodes[node].size = 0;
+      m_unusedNodes.push_back(node);
+    }
+
+    // Links a node created with the right neighbours into the physical list
+    void linkPhysBefore(Node node, Node next) {
+      const Node prev = m_nodes[node].prevPhys;
+      if (prev != kInvalidNode) {
+        m_nodes[prev].nextPhys = node;
+      }
+      m_nodes[next].prevPhys = node;
+    }
+
+    void linkPhysAfter(Node node, Node prev) {
+      const Node next = m_nodes[node].nextPhys;
+      if (next != kInvalidNode) {
+        m_nodes[next].prevPhys = node;
+      }
+      m_nodes[prev].nextPhys = node;
+    }
+
+    void unlinkPhys(Node node) {
+      const Node prev = m_nodes[node].prevPhys;
+      const Node next = m_nodes[node].nextPhys;
+      if (prev != kInvalidNode) {
+        m_nodes[prev].nextPhys = next;
+      }
+      if (next != kInvalidNode) {
+        m_nodes[next].prevPhys = prev;
+      }
+    }
+
+  };
+
+}
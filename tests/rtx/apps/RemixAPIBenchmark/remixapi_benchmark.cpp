@@ -0,0 +1,318 @@
+// CPU-side throughput of the Remix API submission paths:
+// one call per object (CreateMesh / DrawInstance / DrawLightInstance) against
+// the batched variants (CreateMeshes / DrawInstances / DrawLightInstances).
+//
+// Usage: RemixAPIBenchmark.exe [numObjects] [numFrames]
+
+#include <remix/remix.h>
+
+#include <chrono>
+#include <vector>
+
+namespace {
+  remix::Interface* g_remix = nullptr;
+
+  uint32_t g_numObjects = 4096;
+  uint32_t g_numLights = 64;
+  uint32_t g_numFrames = 128;
+
+  std::vector<remixapi_MeshHandle> g_meshes;
+  std::vector<remixapi_LightHandle> g_lights;
+
+  // Shared geometry, each mesh references the same source data
+  remixapi_HardcodedVertex g_verts[] = {
+    { .position = { 1, -1, 10 }, .normal = { 0, 0, -1 }, .texcoord = { 0, 0 }, .color = 0xFFFFFFFF },
+    { .position = { 0,  1, 10 }, .normal = { 0, 0, -1 }, .texcoord = { 0, 0 }, .color = 0xFFFFFFFF },
+    { .position = {-1, -1, 10 }, .normal = { 0, 0, -1 }, .texcoord = { 0, 0 }, .color = 0xFFFFFFFF },
+  };
+  uint32_t g_indices[] = { 0, 1, 2 };
+
+  remixapi_MeshInfoSurfaceTriangles g_surface = {
+    .vertices_values = g_verts,
+    .vertices_count = std::size(g_verts),
+    .indices_values = g_indices,
+    .indices_count = std::size(g_indices),
+    .skinning_hasvalue = false,
+    .skinning_value = {},
+    .material = nullptr,
+  };
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  }
+
+  void report(const char* name, uint64_t submissions, double seconds) {
+    printf("%-36s %10llu submissions in %9.3f ms, %12.0f submissions/s\n",
+           name, static_cast<unsigned long long>(submissions), seconds * 1000.0,
+           seconds > 0.0 ? double(submissions) / seconds : 0.0);
+  }
+
+  remixapi_MeshInfo makeMeshInfo(uint64_t hash) {
+    return remixapi_MeshInfo {
+      .sType = REMIXAPI_STRUCT_TYPE_MESH_INFO,
+      .pNext = nullptr,
+      .hash = hash,
+      .surfaces_values = &g_surface,
+      .surfaces_count = 1,
+    };
+  }
+
+  std::vector<remixapi_InstanceInfo> makeInstances() {
+    auto instances = std::vector<remixapi_InstanceInfo>(g_numObjects);
+    for (uint32_t i = 0; i < g_numObjects; i++) {
+      const float x = float(i % 64) - 32.0f;
+      const float y = float(i / 64) - 32.0f;
+      instances[i] = remixapi_InstanceInfo {
+        .sType = REMIXAPI_STRUCT_TYPE_INSTANCE_INFO,
+        .categoryFlags = 0,
+        .mesh = g_meshes[i],
+        .transform = { {
+          {1,0,0,x},
+          {0,1,0,y},
+          {0,0,1,0},
+        } },
+        .doubleSided = true,
+      };
+    }
+    return instances;
+  }
+
+  void benchmarkCreateMeshes() {
+    // One call per mesh
+    {
+      const auto start = Clock::now();
+      for (uint32_t i = 0; i < g_numObjects; i++) {
+        auto meshHandle = g_remix->CreateMesh(makeMeshInfo(0x10000 + i));
+        if (!meshHandle) {
+          throw std::runtime_error { "remix::CreateMesh() failed " + std::to_string(meshHandle.status()) };
+        }
+        g_meshes.push_back(meshHandle.value());
+      }
+      report("CreateMesh", g_numObjects, secondsSince(start));
+
+      for (remixapi_MeshHandle mesh : g_meshes) {
+        g_remix->DestroyMesh(mesh);
+      }
+      g_meshes.clear();
+    }
+
+    // Whole batch at once
+    {
+      auto meshInfos = std::vector<remixapi_MeshInfo> {};
+      for (uint32_t i = 0; i < g_numObjects; i++) {
+        meshInfos.push_back(makeMeshInfo(0x20000 + i));
+      }
+      g_meshes.resize(g_numObjects);
+
+      const auto start = Clock::now();
+      auto success = g_remix->CreateMeshes(meshInfos.data(), g_numObjects, g_meshes.data());
+      if (!success) {
+        throw std::runtime_error { "remix::CreateMeshes() failed " + std::to_string(success.status()) };
+      }
+      report("CreateMeshes", g_numObjects, secondsSince(start));
+    }
+  }
+
+  void createLights() {
+    for (uint32_t i = 0; i < g_numLights; i++) {
+      auto sphereLight = remixapi_LightInfoSphereEXT {
+        .sType = REMIXAPI_STRUCT_TYPE_LIGHT_INFO_SPHERE_EXT,
+        .pNext = nullptr,
+        .position = { float(i) - float(g_numLights) / 2, -1, 5 },
+        .radius = 0.1f,
+        .shaping_hasvalue = false,
+        .shaping_value = {},
+      };
+      auto lightInfo = remixapi_LightInfo {
+        .sType = REMIXAPI_STRUCT_TYPE_LIGHT_INFO,
+        .pNext = &sphereLight,
+        .hash = 0x30000 + i,
+        .radiance = { 10, 10, 10 },
+      };
+      auto lightHandle = g_remix->CreateLight(lightInfo);
+      if (!lightHandle) {
+        throw std::runtime_error { "remix::CreateLight() failed " + std::to_string(lightHandle.status()) };
+      }
+      g_lights.push_back(lightHandle.value());
+    }
+  }
+
+  void setupCamera(uint32_t windowWidth, uint32_t windowHeight) {
+    auto parametersForCamera = remixapi_CameraInfoParameterizedEXT {
+      .sType = REMIXAPI_STRUCT_TYPE_CAMERA_INFO_PARAMETERIZED_EXT,
+      .position = { 0,0,-40 },
+      .forward = { 0,0,1 },
+      .up = { 0,1,0 },
+      .right = { 1,0,0 },
+      .fovYInDegrees = 70,
+      .aspect = float(windowWidth) / float(std::max(windowHeight, 1u)),
+      .nearPlane = 0.1f,
+      .farPlane = 1000.0f,
+    };
+    auto cameraInfo = remixapi_CameraInfo {
+      .sType = REMIXAPI_STRUCT_TYPE_CAMERA_INFO,
+      .pNext = &parametersForCamera,
+    };
+    g_remix->SetupCamera(cameraInfo);
+  }
+
+  // Only the submission calls are timed, Present is excluded
+  void benchmarkDraws(uint32_t windowWidth, uint32_t windowHeight) {
+    const auto instances = makeInstances();
+
+    double perObjectSeconds = 0.0;
+    double batchedSeconds = 0.0;
+
+    for (uint32_t frame = 0; frame < g_numFrames; frame++) {
+      setupCamera(windowWidth, windowHeight);
+      {
+        const auto start = Clock::now();
+        for (const remixapi_InstanceInfo& instance : instances) {
+          g_remix->DrawInstance(instance);
+        }
+        for (remixapi_LightHandle light : g_lights) {
+          g_remix->DrawLightInstance(light);
+        }
+        perObjectSeconds += secondsSince(start);
+      }
+      g_remix->Present();
+    }
+
+    for (uint32_t frame = 0; frame < g_numFrames; frame++) {
+      setupCamera(windowWidth, windowHeight);
+      {
+        const auto start = Clock::now();
+        g_remix->DrawInstances(instances.data(), uint32_t(instances.size()));
+        g_remix->DrawLightInstances(g_lights.data(), uint32_t(g_lights.size()));
+        batchedSeconds += secondsSince(start);
+      }
+      g_remix->Present();
+    }
+
+    const uint64_t submissions = uint64_t(g_numFrames) * (g_numObjects + g_numLights);
+    report("DrawInstance + DrawLightInstance", submissions, perObjectSeconds);
+    report("DrawInstances + DrawLightInstances", submissions, batchedSeconds);
+  }
+
+  void init(HWND hwnd) {
+    const wchar_t* path = L"d3d9.dll";
+    if (GetFileAttributesW(path) == INVALID_FILE_ATTRIBUTES) {
+      path = L"bin\\d3d9.dll";
+      if (GetFileAttributesW(path) == INVALID_FILE_ATTRIBUTES) {
+        printf("d3d9.dll not found.\nPlease, place it in the same folder as this .exe");
+      }
+    }
+
+    if (auto interf = remix::lib::loadRemixDllAndInitialize(path)) {
+      g_remix = new remix::Interface { *interf };
+    } else {
+      throw std::runtime_error { "remix::loadRemixDllAndInitialize() failed" + std::to_string(interf.status()) };
+    }
+
+    auto startInfo = remixapi_StartupInfo {
+      .sType = REMIXAPI_STRUCT_TYPE_STARTUP_INFO,
+      .pNext = nullptr,
+      .hwnd = hwnd,
+      .disableSrgbConversionForOutput = false,
+      .forceNoVkSwapchain = false,
+    };
+    auto success = g_remix->Startup(startInfo);
+    if (!success) {
+      throw std::runtime_error { "remix::Startup() failed " + std::to_string(success.status()) };
+    }
+  }
+
+  void destroy() {
+    if (g_remix) {
+      for (remixapi_LightHandle light : g_lights) {
+        g_remix->DestroyLight(light);
+      }
+      for (remixapi_MeshHandle mesh : g_meshes) {
+        g_remix->DestroyMesh(mesh);
+      }
+      remix::lib::shutdownAndUnloadRemixDll(*g_remix);
+      delete g_remix;
+    }
+  }
+}
+
+
+
+#pragma region HWND boilerplate
+
+LRESULT WINAPI MsgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+  switch (msg) {
+  case WM_DESTROY:
+    PostQuitMessage(0);
+    return 0;
+  default:
+    break;
+  }
+  return DefWindowProc(hwnd, msg, wParam, lParam);
+}
+
+int main(int argc, char* argv[]) {
+  if (argc >= 2) {
+    g_numObjects = std::max(1, atoi(argv[1]));
+  }
+  if (argc >= 3) {
+    g_numFrames = std::max(1, atoi(argv[2]));
+  }
+
+  auto wc = WNDCLASSEX {
+    .cbSize = sizeof(WNDCLASSEX),
+    .style = CS_CLASSDC,
+    .lpfnWndProc = MsgProc,
+    .cbClsExtra = 0L,
+    .cbWndExtra = 0L,
+    .hInstance = GetModuleHandle(NULL),
+    .hIcon = NULL,
+    .hCursor = NULL,
+    .hbrBackground = NULL,
+    .lpszMenuName = NULL,
+    .lpszClassName = "Remix API Benchmark",
+    .hIconSm = NULL,
+  };
+  RegisterClassEx(&wc);
+
+  DWORD dwStyle = WS_OVERLAPPEDWINDOW;
+  RECT clientRect = { 0, 0, 1280, 720 };
+  AdjustWindowRect(&clientRect, dwStyle, FALSE);
+
+  HWND hwnd = CreateWindow(wc.lpszClassName, "Remix API Benchmark",
+                            dwStyle,
+                            CW_USEDEFAULT, CW_USEDEFAULT,
+                            clientRect.right - clientRect.left,
+                            clientRect.bottom - clientRect.top,
+                            GetDesktopWindow(), NULL, wc.hInstance, NULL);
+
+  int result = 0;
+  try {
+    init(hwnd);
+    ShowWindow(hwnd, SW_SHOWDEFAULT);
+    UpdateWindow(hwnd);
+
+    printf("Objects: %u, lights: %u, frames: %u\n", g_numObjects, g_numLights, g_numFrames);
+    benchmarkCreateMeshes();
+    createLights();
+
+    auto hwndRect = RECT {};
+    GetClientRect(hwnd, &hwndRect);
+    benchmarkDraws(static_cast<uint32_t>(std::max(0l, hwndRect.right - hwndRect.left)),
+                   static_cast<uint32_t>(std::max(0l, hwndRect.bottom - hwndRect.top)));
+  }
+  catch (const std::exception& error) {
+    printf("FAILED: %s", error.what());
+    result = 1;
+  }
+
+  destroy();
+
+  DestroyWindow(hwnd);
+  UnregisterClass(wc.lpszClassName, wc.hInstance);
+  return result;
+}
+
+#pragma endregion
@@ -0,0 +1,323 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <unordered_map>
+#include "../../test_utils.h"
+#include "../../../src/util/rc/util_rc_ptr.h"
+#include "../../../src/dxvk/rtx_render/rtx_asset_package.h"
+#include "../../../src/util/util_threadpool.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_asset_package.log");
+}
+
+namespace dxvk {
+  class TestApp {
+  public:
+    static constexpr uint32_t kNumBlobs = 96;
+    static constexpr uint32_t kNumRuns = 5;
+    static constexpr uint8_t kNumWorkers = 4;
+
+    using BlobReaders = WorkerThreadPool<16, true, false>;
+
+    // Writes a package of buffer assets, one blob each, in the layout AssetPackage expects
+    void writePackage(const std::filesystem::path& path, const std::vector<std::vector<uint8_t>>& blobs, int corruptBlobIdx) {
+      std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+      AssetPackage::Header header { AssetPackage::kMagic, AssetPackage::kVersion, 0 };
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+      std::vector<AssetPackage::AssetDesc> assetDescs(blobs.size());
+      std::vector<AssetPackage::BlobDesc> blobDescs(blobs.size());
+
+      for (uint32_t i = 0; i < blobs.size(); i++) {
+        AssetPackage::BlobDesc& blobDesc = blobDescs[i];
+        blobDesc.offset = uint64_t(file.tellp());
+        blobDesc.compression = 0;
+        blobDesc.flags = 0;
+        blobDesc.size = uint32_t(blobs[i].size());
+        // Every 8th blob carries no checksum
+        blobDesc.crc32 = (i % 8 == 7) ? 0 : crc32(blobs[i].data(), blobs[i].size());
+        if (int(i) == corruptBlobIdx) {
+          blobDesc.crc32 ^= 0x1;
+        }
+
+        AssetPackage::AssetDesc& assetDesc = assetDescs[i];
+        memset(&assetDesc, 0, sizeof(assetDesc));
+        assetDesc.nameIdx = uint16_t(i);
+        assetDesc.type = AssetPackage::AssetDesc::Type::BUFFER;
+        assetDesc.size = blobDesc.size;
+        assetDesc.numMips = 1;
+        assetDesc.arraySize = 1;
+        assetDesc.baseBlobIdx = uint16_t(i);
+        assetDesc.tailBlobIdx = uint16_t(i);
+
+        file.write(reinterpret_cast<const char*>(blobs[i].data()), blobs[i].size());
+      }
+
+      header.dictOffset = uint64_t(file.tellp());
+
+      const uint16_t count = uint16_t(blobs.size());
+      file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+      file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+      file.write(reinterpret_cast<const char*>(assetDescs.data()), assetDescs.size() * sizeof(AssetPackage::AssetDesc));
+      file.write(reinterpret_cast<const char*>(blobDescs.data()), blobDescs.size() * sizeof(AssetPackage::BlobDesc));
+
+      for (uint32_t i = 0; i < blobs.size(); i++) {
+        const std::string name = str::format("asset_", i, ".bin");
+        file.write(name.c_str(), name.size() + 1);
+      }
+
+      file.seekp(0);
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    std::vector<std::vector<uint8_t>> makeBlobs() {
+      std::mt19937 rng(7);
+      std::uniform_int_distribution<uint32_t> sizeDist(256 * 1024, 1024 * 1024);
+
+      std::vector<std::vector<uint8_t>> blobs(kNumBlobs);
+      for (auto& blob : blobs) {
+        // Odd sizes on purpose, to cover the byte-wise checksum tail
+        blob.resize(sizeDist(rng) | 1);
+        for (uint8_t& b : blob) {
+          b = uint8_t(rng());
+        }
+      }
+      return blobs;
+    }
+
+    void checkBlob(const std::vector<uint8_t>& expected, const void* data, const char* what, uint32_t idx) {
+      if (data == nullptr || memcmp(expected.data(), data, expected.size()) != 0) {
+        throw DxvkError(str::format(what, ": data blob ", idx, " does not match"));
+      }
+    }
+
+    // Best of a few runs, so every reader sees the package in the page cache
+    template<typename F>
+    double measureThroughput(const char* what, size_t totalSize, F&& load) {
+      double bestSeconds = std::numeric_limits<double>::max();
+      for (uint32_t run = 0; run < kNumRuns; run++) {
+        const auto start = std::chrono::high_resolution_clock::now();
+        load();
+        const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+        bestSeconds = std::min(bestSeconds, elapsed.count());
+      }
+
+      const double throughput = double(totalSize) / double(1 << 20) / bestSeconds;
+      std::cout << what << " --> " << uint32_t(throughput) << " MB/s" << std::endl;
+      return throughput;
+    }
+
+    std::vector<AssetPackage::BlobRead> makeReads(std::vector<std::vector<uint8_t>>& copies) {
+      std::vector<AssetPackage::BlobRead> reads(copies.size());
+      for (uint32_t i = 0; i < copies.size(); i++) {
+        reads[i] = { i, copies[i].data(), copies[i].size(), false };
+      }
+      return reads;
+    }
+
+    // Loads every blob with checksum validation, one blob at a time and then in one parallel batch
+    void benchmarkLoad(Rc<AssetPackage>& package, BlobReaders& pool, const std::vector<std::vector<uint8_t>>& blobs,
+                       size_t totalSize, const char* mode) {
+      std::vector<std::vector<uint8_t>> copies(kNumBlobs);
+      for (uint32_t i = 0; i < kNumBlobs; i++) {
+        copies[i].resize(blobs[i].size());
+      }
+
+      const double serial = measureThroughput(str::format(mode, ", serial load, verified").c_str(), totalSize, [&] {
+        for (uint32_t i = 0; i < kNumBlobs; i++) {
+          if (package->readDataBlob(i, copies[i].data(), copies[i].size()) != copies[i].size() ||
+              !package->verifyDataBlob(i, copies[i].data())) {
+            throw DxvkError(str::format(mode, ": serial load failed on data blob ", i));
+          }
+        }
+      });
+
+      for (uint32_t i = 0; i < kNumBlobs; i++) {
+        checkBlob(blobs[i], copies[i].data(), "readDataBlob", i);
+        std::fill(copies[i].begin(), copies[i].end(), uint8_t(0));
+      }
+
+      auto reads = makeReads(copies);
+      const double parallel = measureThroughput(str::format(mode, ", parallel load (", uint32_t(pool.numThreads()), " workers), verified").c_str(), totalSize, [&] {
+        if (package->readDataBlobs(pool, reads.data(), kNumBlobs, true) != 0) {
+          throw DxvkError(str::format(mode, ": readDataBlobs failed on an intact package"));
+        }
+      });
+
+      for (uint32_t i = 0; i < kNumBlobs; i++) {
+        if (!reads[i].succeeded) {
+          throw DxvkError(str::format("readDataBlobs: data blob ", i, " not marked as read"));
+        }
+        checkBlob(blobs[i], copies[i].data(), "readDataBlobs", i);
+      }
+
+      std::cout << mode << ", parallel speedup --> " << parallel / serial << "x" << std::endl;
+    }
+
+    void testAndBenchmark(const std::filesystem::path& path) {
+      const auto blobs = makeBlobs();
+      writePackage(path, blobs, -1);
+
+      size_t totalSize = 0;
+      for (const auto& blob : blobs) {
+        totalSize += blob.size();
+      }
+      std::cout << "Package with " << kNumBlobs << " blobs, " << (totalSize >> 20) << " MB" << std::endl;
+
+      Rc<AssetPackage> package = new AssetPackage(path.string());
+      if (!package->initialize() || package->getAssetCount() != kNumBlobs) {
+        throw DxvkError("initialize: failed to parse the synthetic package");
+      }
+
+      if (package->findAsset("asset_42.bin") != 42) {
+        throw DxvkError("findAsset: name table lookup failed");
+      }
+
+      BlobReaders pool(kNumWorkers, "test-blob-readers");
+
+      // Stream reader: one shared file handle, reads are serialized and only the checksums overlap
+      benchmarkLoad(package, pool, blobs, totalSize, "Stream reader");
+
+      if (package->getDataBlobView(0) != nullptr) {
+        throw DxvkError("getDataBlobView: must fail when the package is not mapped");
+      }
+
+      // In place checks need the mapping
+      {
+        AssetPackage::BlobRead read = { 0, nullptr, 0, true };
+        if (package->readDataBlobs(pool, &read, 1, true) != 1 || read.succeeded) {
+          throw DxvkError("readDataBlobs: in place check must fail when the package is not mapped");
+        }
+      }
+
+      if (!package->mapFile()) {
+        throw DxvkError("mapFile: failed to map the synthetic package");
+      }
+
+      // Mapped: each blob is copied and checksummed piece by piece in one pass
+      benchmarkLoad(package, pool, blobs, totalSize, "Mapped");
+
+      // Zero-copy views, verified in place
+      {
+        std::vector<AssetPackage::BlobRead> reads(kNumBlobs);
+        for (uint32_t i = 0; i < kNumBlobs; i++) {
+          reads[i] = { i, nullptr, 0, false };
+        }
+
+        measureThroughput("Mapped views, parallel in place check", totalSize, [&] {
+          if (package->readDataBlobs(pool, reads.data(), kNumBlobs, true) != 0) {
+            throw DxvkError("readDataBlobs: in place check failed on an intact package");
+          }
+        });
+
+        for (uint32_t i = 0; i < kNumBlobs; i++) {
+          checkBlob(blobs[i], package->getDataBlobView(i), "getDataBlobView", i);
+        }
+      }
+
+      // A destination that is too small fails without being written
+      {
+        std::vector<uint8_t> copy(blobs[0].size() - 1);
+        if (package->readDataBlob(0, copy.data(), copy.size()) != 0) {
+          throw DxvkError("readDataBlob: undersized destination must fail");
+        }
+
+        AssetPackage::BlobRead read = { 0, copy.data(), copy.size(), true };
+        if (package->readDataBlobs(pool, &read, 1, false) != 1 || read.succeeded) {
+          throw DxvkError("readDataBlobs: undersized destination must fail");
+        }
+      }
+
+      package = nullptr;
+    }
+
+    void testCorruption(const std::filesystem::path& path) {
+      const auto blobs = makeBlobs();
+      const uint32_t corruptIdx = 5;
+      writePackage(path, blobs, corruptIdx);
+
+      Rc<AssetPackage> package = new AssetPackage(path.string());
+      if (!package->initialize() || !package->mapFile()) {
+        throw DxvkError("corruption: failed to open the synthetic package");
+      }
+
+      if (package->verifyDataBlob(corruptIdx, package->getDataBlobView(corruptIdx)) ||
+          !package->verifyDataBlob(corruptIdx + 1, package->getDataBlobView(corruptIdx + 1))) {
+        throw DxvkError("corruption: verifyDataBlob did not single out the bad blob");
+      }
+
+      std::vector<std::vector<uint8_t>> copies(kNumBlobs);
+      for (uint32_t i = 0; i < kNumBlobs; i++) {
+        copies[i].resize(blobs[i].size());
+      }
+      auto reads = makeReads(copies);
+
+      BlobReaders pool(kNumWorkers, "test-blob-readers");
+      if (package->readDataBlobs(pool, reads.data(), kNumBlobs, true) != 1) {
+        throw DxvkError("corruption: readDataBlobs must fail exactly one read");
+      }
+
+      for (uint32_t i = 0; i < kNumBlobs; i++) {
+        if (reads[i].succeeded == (i == corruptIdx)) {
+          throw DxvkError("corruption: readDataBlobs did not single out the bad blob");
+        }
+      }
+
+      // Without verification the bad blob reads fine
+      if (package->readDataBlobs(pool, reads.data(), kNumBlobs, false) != 0) {
+        throw DxvkError("corruption: readDataBlobs failed without verification");
+      }
+    }
+
+    void run() {
+      const auto path = std::filesystem::temp_directory_path() / "test_asset_package.pkg";
+
+      testAndBenchmark(path);
+      testCorruption(path);
+
+      std::filesystem::remove(path);
+      std::cout << "All passed\n";
+    }
+  };
+}
+
+
+int main() {
+  try {
+    dxvk::TestApp testApp;
+    testApp.run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
@@ -0,0 +1,269 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "../../test_utils.h"
+#include "../../../src/util/util_atomic_queue.h"
+#include "../../../src/util/util_timer.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_atomic_queue.log");
+}
+
+namespace dxvk {
+  class TestApp {
+  public:
+    // Values encode the producer in the top byte and a per-producer sequence below it
+    static constexpr uint32_t kProducerShift = 24;
+
+    // Baseline for the benchmark, what a queue shared between threads looks like without lock-free tricks
+    template<typename T, uint32_t Capacity>
+    class LockedQueue {
+    public:
+      uint32_t push(T* items, uint32_t count) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const uint32_t numPushed = std::min<uint32_t>(count, Capacity - uint32_t(m_queue.size()));
+        for (uint32_t i = 0; i < numPushed; i++) {
+          m_queue.push(items[i]);
+        }
+        return numPushed;
+      }
+
+      uint32_t pop(T* items, uint32_t maxCount) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const uint32_t numPopped = std::min<uint32_t>(maxCount, uint32_t(m_queue.size()));
+        for (uint32_t i = 0; i < numPopped; i++) {
+          items[i] = m_queue.front();
+          m_queue.pop();
+        }
+        return numPopped;
+      }
+
+    private:
+      std::mutex m_mutex;
+      std::queue<T> m_queue;
+    };
+
+    /**
+      * \brief Runs producers and consumers against one queue, each producer pushes
+      *        itemsPerProducer unique values in batches of up to batchSize.
+      * \returns Values seen by every consumer, in pop order
+      */
+    template<typename Queue>
+    static std::vector<std::vector<uint32_t>> runThreads(Queue& queue, uint32_t numProducers, uint32_t numConsumers,
+                                                         uint32_t itemsPerProducer, uint32_t batchSize) {
+      const uint32_t totalItems = numProducers * itemsPerProducer;
+      std::atomic<uint32_t> numConsumed = 0;
+      std::vector<std::vector<uint32_t>> consumed(numConsumers);
+      std::vector<std::thread> threads;
+
+      for (uint32_t p = 0; p < numProducers; p++) {
+        threads.emplace_back([&queue, p, itemsPerProducer, batchSize]() {
+          std::vector<uint32_t> batch(batchSize);
+          uint32_t next = 0;
+          while (next < itemsPerProducer) {
+            const uint32_t count = std::min(batchSize, itemsPerProducer - next);
+            for (uint32_t i = 0; i < count; i++) {
+              batch[i] = (p << kProducerShift) | (next + i);
+            }
+            uint32_t pushed = 0;
+            while (pushed < count) {
+              const uint32_t n = queue.push(batch.data() + pushed, count - pushed);
+              if (n == 0) {
+                std::this_thread::yield();
+              }
+              pushed += n;
+            }
+            next += count;
+          }
+        });
+      }
+
+      for (uint32_t c = 0; c < numConsumers; c++) {
+        threads.emplace_back([&queue, &numConsumed, &consumed, c, totalItems, batchSize]() {
+          std::vector<uint32_t> batch(batchSize);
+          std::vector<uint32_t>& seen = consumed[c];
+          seen.reserve(totalItems);
+          while (numConsumed.load() < totalItems) {
+            const uint32_t n = queue.pop(batch.data(), batchSize);
+            if (n == 0) {
+              std::this_thread::yield();
+              continue;
+            }
+            seen.insert(seen.end(), batch.begin(), batch.begin() + n);
+            numConsumed += n;
+          }
+        });
+      }
+
+      for (auto& thread : threads) {
+        thread.join();
+      }
+      return consumed;
+    }
+
+    // Every value popped exactly once, and each consumer sees each producer's values in push order
+    static void validate(const std::vector<std::vector<uint32_t>>& consumed, uint32_t numProducers, uint32_t itemsPerProducer, const char* name) {
+      std::vector<uint8_t> seenCount(numProducers * itemsPerProducer, 0);
+
+      for (const auto& seen : consumed) {
+        std::vector<int64_t> lastSequence(numProducers, -1);
+        for (const uint32_t value : seen) {
+          const uint32_t producer = value >> kProducerShift;
+          const uint32_t sequence = value & ((1u << kProducerShift) - 1);
+          if (producer >= numProducers || sequence >= itemsPerProducer) {
+            throw DxvkError(str::format(name, ": popped a value that was never pushed ", value));
+          }
+          if (int64_t(sequence) <= lastSequence[producer]) {
+            throw DxvkError(str::format(name, ": values of producer ", producer, " popped out of order"));
+          }
+          lastSequence[producer] = sequence;
+          seenCount[producer * itemsPerProducer + sequence]++;
+        }
+      }
+
+      for (size_t i = 0; i < seenCount.size(); i++) {
+        if (seenCount[i] != 1) {
+          throw DxvkError(str::format(name, ": value ", i, " popped ", uint32_t(seenCount[i]), " times"));
+        }
+      }
+    }
+
+    void testSingleThreaded() {
+      static_assert(AtomicQueue<uint32_t, 100>::capacity() == 128);
+      static_assert(MpmcAtomicQueue<uint32_t, 64>::capacity() == 64);
+
+      MpmcAtomicQueue<uint32_t, 8> mpmc;
+      AtomicQueue<uint32_t, 8> spsc;
+      uint32_t items[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+      if (mpmc.push(items, 10) != 8 || !mpmc.isFull() || mpmc.push(uint32_t(11))) {
+        throw DxvkError("MpmcAtomicQueue: batch push must stop at capacity");
+      }
+      if (spsc.push(items, 10) != 8 || !spsc.isFull() || spsc.push(uint32_t(11))) {
+        throw DxvkError("AtomicQueue: batch push must stop at capacity");
+      }
+
+      // Wrap around a few laps with odd batch sizes
+      uint32_t expected = 0;
+      uint32_t next = 8;
+      for (uint32_t lap = 0; lap < 50; lap++) {
+        uint32_t out[8];
+        const uint32_t numPopped = mpmc.pop(out, 3);
+        if (spsc.pop(out + 3, 3) != numPopped) {
+          throw DxvkError("AtomicQueue: pop count differs from MpmcAtomicQueue");
+        }
+        for (uint32_t i = 0; i < numPopped; i++) {
+          if (out[i] != expected || out[3 + i] != expected) {
+            throw DxvkError("atomic queues: FIFO order broken on wrap around");
+          }
+          expected++;
+        }
+        uint32_t refill[3] = { next, next + 1, next + 2 };
+        uint32_t refillCopy[3] = { next, next + 1, next + 2 };
+        if (mpmc.push(refill, 3) != 3 || spsc.push(refillCopy, 3) != 3) {
+          throw DxvkError("atomic queues: refill after pop failed");
+        }
+        next += 3;
+      }
+
+      uint32_t item;
+      while (mpmc.pop(item)) { }
+      while (spsc.pop(item)) { }
+      if (!spsc.isEmpty() || mpmc.isFull()) {
+        throw DxvkError("atomic queues: not empty after draining");
+      }
+    }
+
+    void testStress() {
+      const uint32_t itemsPerProducer = 200000;
+      const uint32_t numThreads = std::max(2u, std::min(8u, std::thread::hardware_concurrency()));
+
+      {
+        AtomicQueue<uint32_t, 1024> spsc;
+        validate(runThreads(spsc, 1, 1, itemsPerProducer, 1), 1, itemsPerProducer, "AtomicQueue");
+        validate(runThreads(spsc, 1, 1, itemsPerProducer, 37), 1, itemsPerProducer, "AtomicQueue (batched)");
+      }
+
+      // A small ring so producers and consumers constantly lap each other
+      for (const uint32_t batchSize : { 1u, 16u }) {
+        MpmcAtomicQueue<uint32_t, 64> mpmc;
+        const uint32_t half = numThreads / 2;
+        validate(runThreads(mpmc, half, numThreads - half, itemsPerProducer, batchSize), half, itemsPerProducer, "MpmcAtomicQueue");
+        validate(runThreads(mpmc, 1, numThreads - 1, itemsPerProducer, batchSize), 1, itemsPerProducer, "MpmcAtomicQueue (1 producer)");
+        validate(runThreads(mpmc, numThreads - 1, 1, itemsPerProducer, batchSize), numThreads - 1, itemsPerProducer, "MpmcAtomicQueue (1 consumer)");
+      }
+    }
+
+    template<typename Queue>
+    static void benchmark(const char* name, uint32_t numProducers, uint32_t numConsumers, uint32_t batchSize) {
+      const uint32_t itemsPerProducer = 1000000 / numProducers;
+      auto queue = std::make_unique<Queue>();
+
+      std::cout << "  " << name << " " << numProducers << "p/" << numConsumers << "c, batch " << batchSize << " --> ";
+      Timer time;
+      runThreads(*queue, numProducers, numConsumers, itemsPerProducer, batchSize);
+    }
+
+    void runBenchmarks() {
+      using Locked = LockedQueue<uint32_t, 4096>;
+      using Mpmc = MpmcAtomicQueue<uint32_t, 4096>;
+      using Spsc = AtomicQueue<uint32_t, 4096>;
+
+      std::cout << "1M items" << std::endl;
+      for (const uint32_t batchSize : { 1u, 32u }) {
+        benchmark<Locked>("mutex + std::queue", 1, 1, batchSize);
+        benchmark<Spsc>("AtomicQueue", 1, 1, batchSize);
+        benchmark<Mpmc>("MpmcAtomicQueue", 1, 1, batchSize);
+
+        for (const uint32_t numThreads : { 2u, 4u }) {
+          benchmark<Locked>("mutex + std::queue", numThreads, numThreads, batchSize);
+          benchmark<Mpmc>("MpmcAtomicQueue", numThreads, numThreads, batchSize);
+        }
+      }
+    }
+
+    void run() {
+      testSingleThreaded();
+      testStress();
+      runBenchmarks();
+      std::cout << "All passed\n";
+    }
+  };
+}
+
+
+int main() {
+  try {
+    dxvk::TestApp testApp;
+    testApp.run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
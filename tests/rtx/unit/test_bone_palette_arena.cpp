@@ -0,0 +1,180 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+// Checks that the bone palette arena stores each distinct palette once per
+// frame, keeps handed out palettes intact across resets and page changes,
+// and deduplicates palettes acquired concurrently from several threads.
+
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/dxvk/rtx_render/rtx_bone_palette.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_bone_palette_arena.log");
+}
+
+namespace test_bone_palette_arena_app {
+  using namespace dxvk;
+
+  std::vector<Matrix4> makeBones(uint32_t count, float seed) {
+    std::vector<Matrix4> bones(count);
+
+    for (uint32_t i = 0; i < count; i++) {
+      bones[i][3] = Vector4(seed, float(i), 0.f, 1.f);
+    }
+
+    return bones;
+  }
+
+  XXH64_hash_t keyOf(const std::vector<Matrix4>& bones) {
+    return XXH3_64bits(bones.data(), bones.size() * sizeof(Matrix4));
+  }
+
+  bool matches(const BonePalette& palette, const std::vector<Matrix4>& bones) {
+    return palette.count == bones.size() && memcmp(palette.data(), bones.data(), bones.size() * sizeof(Matrix4)) == 0;
+  }
+
+  void testDeduplication() {
+    BonePaletteArena arena;
+
+    const auto a = makeBones(64, 1.f);
+    const auto b = makeBones(64, 2.f);
+
+    const BonePalette first = arena.acquire(keyOf(a), a.data(), 64);
+    const BonePalette second = arena.acquire(keyOf(b), b.data(), 64);
+    const BonePalette again = arena.acquire(keyOf(a), a.data(), 64);
+
+    if (again.page != first.page || again.offset != first.offset) {
+      throw DxvkError("Identical palettes must share storage within a frame");
+    }
+
+    if (second.page == first.page && second.offset == first.offset) {
+      throw DxvkError("Distinct palettes must not share storage");
+    }
+
+    arena.reset();
+
+    const BonePalette nextFrame = arena.acquire(keyOf(a), a.data(), 64);
+
+    if (nextFrame.page == first.page && nextFrame.offset == first.offset) {
+      throw DxvkError("Deduplication must not carry over a reset");
+    }
+
+    if (!matches(first, a) || !matches(second, b) || !matches(nextFrame, a)) {
+      throw DxvkError("Palette contents changed");
+    }
+  }
+
+  void testPageRollover() {
+    BonePaletteArena arena;
+    std::vector<BonePalette> palettes;
+
+    // Enough full palettes to fill several pages, and one bigger than a page
+    const uint32_t paletteCount = 3 * BonePaletteArena::kPageMatrixCount / 256;
+
+    for (uint32_t i = 0; i < paletteCount; i++) {
+      const auto bones = makeBones(256, float(i));
+      palettes.push_back(arena.acquire(keyOf(bones), bones.data(), 256));
+    }
+
+    const auto huge = makeBones(BonePaletteArena::kPageMatrixCount + 1, -1.f);
+    const BonePalette hugePalette = arena.acquire(keyOf(huge), huge.data(), uint32_t(huge.size()));
+
+    arena.reset();
+
+    for (uint32_t i = 0; i < paletteCount; i++) {
+      if (!matches(palettes[i], makeBones(256, float(i)))) {
+        throw DxvkError(str::format("Palette ", i, " was overwritten"));
+      }
+    }
+
+    if (!matches(hugePalette, huge)) {
+      throw DxvkError("Palette larger than a page was not stored");
+    }
+  }
+
+  void testConcurrentAcquire() {
+    constexpr uint32_t kThreadCount = 8;
+    constexpr uint32_t kPaletteCount = 32;
+
+    BonePaletteArena arena;
+
+    std::vector<std::vector<Matrix4>> bones;
+    for (uint32_t i = 0; i < kPaletteCount; i++) {
+      bones.push_back(makeBones(1 + i * 7, float(i)));
+    }
+
+    std::vector<std::vector<BonePalette>> results(kThreadCount);
+    std::vector<std::thread> threads;
+
+    for (uint32_t t = 0; t < kThreadCount; t++) {
+      threads.emplace_back([&, t] {
+        for (uint32_t i = 0; i < kPaletteCount; i++) {
+          const auto& palette = bones[(i + t) % kPaletteCount];
+          results[t].push_back(arena.acquire(keyOf(palette), palette.data(), uint32_t(palette.size())));
+        }
+      });
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    for (uint32_t t = 0; t < kThreadCount; t++) {
+      for (uint32_t i = 0; i < kPaletteCount; i++) {
+        const BonePalette& palette = results[t][i];
+        const BonePalette& reference = results[0][(i + t) % kPaletteCount];
+
+        if (palette.page != reference.page || palette.offset != reference.offset) {
+          throw DxvkError("Concurrently acquired palettes were not deduplicated");
+        }
+
+        if (!matches(palette, bones[(i + t) % kPaletteCount])) {
+          throw DxvkError("Concurrently acquired palette has the wrong contents");
+        }
+      }
+    }
+  }
+
+  void run_test() {
+    testDeduplication();
+    testPageRollover();
+    testConcurrentAcquire();
+  }
+}
+
+int main() {
+  try {
+    test_bone_palette_arena_app::run_test();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
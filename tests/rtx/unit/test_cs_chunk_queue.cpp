@@ -0,0 +1,305 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+// Checks ordering and completion tracking of the CS chunk queue, then
+// measures chunk throughput and dispatch-to-execution latency with no-op
+// commands, against the mutex and condition variable handoff it replaced.
+// Runs on the CPU only, the consumer executes chunks without a context.
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/dxvk/dxvk_cs.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_cs_chunk_queue.log");
+}
+
+namespace test_cs_chunk_queue_app {
+  using namespace dxvk;
+  using Clock = std::chrono::steady_clock;
+
+  // The previous DxvkCsThread handoff, kept as a baseline
+  class LockedChunkQueue {
+
+  public:
+
+    uint64_t push(DxvkCsChunkRef&& chunk, std::chrono::microseconds& stallTime) {
+      uint64_t seq;
+
+      { std::unique_lock<dxvk::mutex> lock(m_mutex);
+        seq = ++m_chunksDispatched;
+        m_chunksQueued.push(std::move(chunk));
+      }
+
+      stallTime = std::chrono::microseconds(0);
+      m_condOnAdd.notify_one();
+      return seq;
+    }
+
+    bool pop(DxvkCsChunkRef& chunk) {
+      std::unique_lock<dxvk::mutex> lock(m_mutex);
+      m_condOnAdd.wait(lock, [this] {
+        return !m_chunksQueued.empty() || m_stopped.load();
+      });
+
+      if (m_stopped.load())
+        return false;
+
+      chunk = std::move(m_chunksQueued.front());
+      m_chunksQueued.pop();
+      return true;
+    }
+
+    void completeChunk() {
+      std::unique_lock<dxvk::mutex> lock(m_mutex);
+      m_chunksExecuted++;
+      m_condOnSync.notify_one();
+    }
+
+    void synchronize(uint64_t seq) {
+      if (seq > m_chunksExecuted.load()) {
+        std::unique_lock<dxvk::mutex> lock(m_mutex);
+        m_condOnSync.wait(lock, [this, seq] {
+          return m_chunksExecuted.load() >= seq;
+        });
+      }
+    }
+
+    void stop() {
+      { std::unique_lock<dxvk::mutex> lock(m_mutex);
+        m_stopped.store(true);
+      }
+
+      m_condOnAdd.notify_one();
+    }
+
+    bool stopped() const {
+      return m_stopped.load();
+    }
+
+  private:
+
+    std::atomic<uint64_t>       m_chunksDispatched = { 0ull };
+    std::atomic<uint64_t>       m_chunksExecuted   = { 0ull };
+    std::atomic<bool>           m_stopped = { false };
+    dxvk::mutex                 m_mutex;
+    dxvk::condition_variable    m_condOnAdd;
+    dxvk::condition_variable    m_condOnSync;
+    std::queue<DxvkCsChunkRef>  m_chunksQueued;
+
+  };
+
+  // Same loop as DxvkCsThread::threadFunc
+  template<typename Queue>
+  class ChunkConsumer {
+
+  public:
+
+    ChunkConsumer(Queue& queue)
+    : m_queue(queue), m_thread([this] { run(); }) { }
+
+    ~ChunkConsumer() {
+      m_queue.stop();
+      m_thread.join();
+    }
+
+  private:
+
+    Queue&       m_queue;
+    dxvk::thread m_thread;
+
+    void run() {
+      DxvkCsChunkRef chunk;
+
+      while (!m_queue.stopped()) {
+        if (!m_queue.pop(chunk))
+          continue;
+
+        chunk->executeAll(nullptr);
+        chunk = DxvkCsChunkRef();
+        m_queue.completeChunk();
+      }
+    }
+
+  };
+
+  DxvkCsChunkRef allocChunk(DxvkCsChunkPool& pool) {
+    return DxvkCsChunkRef(pool.allocChunk(DxvkCsChunkFlag::SingleUse), &pool);
+  }
+
+  template<typename Cmd>
+  void pushCommand(DxvkCsChunkRef& chunk, Cmd&& command) {
+    if (!chunk->push(command))
+      throw DxvkError("Command does not fit into an empty chunk");
+  }
+
+  template<typename Queue>
+  void testOrdering() {
+    constexpr uint32_t ChunkCount = 100000;
+    constexpr uint32_t CommandsPerChunk = 8;
+
+    DxvkCsChunkPool pool;
+    Queue queue;
+
+    uint64_t executed = 0;
+    bool inOrder = true;
+
+    { ChunkConsumer<Queue> consumer(queue);
+      std::chrono::microseconds stallTime;
+
+      for (uint32_t i = 0; i < ChunkCount; i++) {
+        DxvkCsChunkRef chunk = allocChunk(pool);
+
+        for (uint32_t j = 0; j < CommandsPerChunk; j++) {
+          const uint64_t expected = uint64_t(i) * CommandsPerChunk + j;
+
+          pushCommand(chunk, [&executed, &inOrder, expected] (DxvkContext*) {
+            inOrder &= executed++ == expected;
+          });
+        }
+
+        const uint64_t seq = queue.push(std::move(chunk), stallTime);
+
+        if (seq != i + 1)
+          throw DxvkError(str::format("Unexpected sequence number ", seq, " for chunk ", i));
+
+        // Synchronize every now and then, and check that
+        // everything up to that chunk has been executed
+        if (i % 1000 == 999) {
+          queue.synchronize(seq);
+
+          if (executed < seq * CommandsPerChunk)
+            throw DxvkError(str::format("Synchronized to chunk ", seq, " but only ", executed, " commands executed"));
+        }
+      }
+
+      queue.synchronize(ChunkCount);
+    }
+
+    if (!inOrder || executed != uint64_t(ChunkCount) * CommandsPerChunk)
+      throw DxvkError(str::format("Executed ", executed, " commands, in order: ", inOrder));
+  }
+
+  template<typename Queue>
+  double measureThroughput(uint32_t chunkCount, uint32_t commandsPerChunk) {
+    DxvkCsChunkPool pool;
+    Queue queue;
+
+    ChunkConsumer<Queue> consumer(queue);
+    std::chrono::microseconds stallTime;
+
+    const auto t0 = Clock::now();
+    uint64_t seq = 0;
+
+    for (uint32_t i = 0; i < chunkCount; i++) {
+      DxvkCsChunkRef chunk = allocChunk(pool);
+
+      for (uint32_t j = 0; j < commandsPerChunk; j++)
+        pushCommand(chunk, [] (DxvkContext*) { });
+
+      seq = queue.push(std::move(chunk), stallTime);
+    }
+
+    queue.synchronize(seq);
+    const auto t1 = Clock::now();
+
+    return double(chunkCount) / std::chrono::duration<double>(t1 - t0).count();
+  }
+
+  struct Latency {
+    double p50;
+    double p99;
+  };
+
+  // Time from dispatching a chunk until its first command runs
+  template<typename Queue>
+  Latency measureLatency(uint32_t sampleCount, std::chrono::microseconds gap) {
+    DxvkCsChunkPool pool;
+    Queue queue;
+
+    ChunkConsumer<Queue> consumer(queue);
+    std::chrono::microseconds stallTime;
+
+    std::vector<double> samples(sampleCount);
+
+    for (uint32_t i = 0; i < sampleCount; i++) {
+      if (gap.count())
+        std::this_thread::sleep_for(gap);
+
+      DxvkCsChunkRef chunk = allocChunk(pool);
+      double* sample = &samples[i];
+
+      const auto t0 = Clock::now();
+
+      pushCommand(chunk, [sample, t0] (DxvkContext*) {
+        *sample = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+      });
+
+      queue.synchronize(queue.push(std::move(chunk), stallTime));
+    }
+
+    std::sort(samples.begin(), samples.end());
+    return Latency { samples[sampleCount / 2], samples[(sampleCount * 99) / 100] };
+  }
+
+  template<typename Queue>
+  void runBenchmarks(const char* name) {
+    std::cout << name << ":" << std::endl;
+
+    std::cout << "  1 command/chunk --> " << measureThroughput<Queue>(200000, 1) << " chunks/s" << std::endl;
+    std::cout << "  64 commands/chunk --> " << measureThroughput<Queue>(50000, 64) << " chunks/s" << std::endl;
+
+    Latency busy = measureLatency<Queue>(20000, std::chrono::microseconds(0));
+    std::cout << "  back-to-back latency --> p50 " << busy.p50 << " us, p99 " << busy.p99 << " us" << std::endl;
+
+    Latency idle = measureLatency<Queue>(200, std::chrono::microseconds(2000));
+    std::cout << "  latency after 2 ms idle --> p50 " << idle.p50 << " us, p99 " << idle.p99 << " us" << std::endl;
+  }
+
+  void run_test() {
+    std::cout << "Checking chunk ordering and synchronization" << std::endl;
+    testOrdering<DxvkCsChunkQueue>();
+
+    std::cout << std::fixed << std::setprecision(1);
+    runBenchmarks<DxvkCsChunkQueue>("DxvkCsChunkQueue");
+    runBenchmarks<LockedChunkQueue>("Mutex + condition variable");
+  }
+}
+
+int main() {
+  try {
+    test_cs_chunk_queue_app::run_test();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
@@ -0,0 +1,413 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+// Replays recorded draw call sequences of a mesh instanced hundreds of times
+// against one DrawCallCache bucket, once scoring every entry in bucket order
+// like the cache used to and once through DrawCallBucketIndex.  Checks both
+// reuse the same entries for every draw and reports the time per frame at
+// increasing instance counts.  Also checks DrawCallCache itself picks up
+// changes callers make to the entries it returns.  Runs on the CPU only, no
+// device is created.
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/dxvk/rtx_render/rtx_draw_call_bucket_index.h"
+#include "../../../src/dxvk/rtx_render/rtx_draw_call_cache.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_draw_call_cache.log");
+}
+
+namespace test_draw_call_cache_app {
+  using namespace dxvk;
+
+  constexpr uint32_t FrameCount = 32;
+  // Entries not touched for this many frames are garbage collected
+  constexpr uint32_t MaxEntryAge = 2;
+  constexpr uint32_t MaterialCount = 4;
+  constexpr float Extent = 2000.f;
+
+  struct Entry {
+    uint32_t id;
+    DrawCallMatchKey key;
+    uint32_t frameLastTouched;
+  };
+
+  using Frame = std::vector<DrawCallMatchKey>;
+
+  struct ReplayResult {
+    // Id of the entry every draw ended up with, new entries get the next free id
+    std::vector<uint32_t> entries;
+    uint32_t numExact = 0;
+    uint32_t numSimilar = 0;
+    // Entries allocated after the first frame filled the bucket
+    uint32_t numNew = 0;
+    double matchMs = 0.0;
+  };
+
+  // One bucket worth of draws, i.e. the same topology drawn once per instance.  Mixes the cases the cache
+  // has to tell apart: static instances matching exactly, skinned and animated instances whose geometry
+  // hashes change every frame and can only be matched by score, instances stacked on top of each other,
+  // sky draws, instances respawning elsewhere and draws with a broken transform.
+  std::vector<Frame> makeRecording(uint32_t instanceCount) {
+    std::mt19937 rng(instanceCount);
+    std::uniform_real_distribution<float> position(-Extent, Extent);
+    std::uniform_real_distribution<float> step(-4.f, 4.f);
+    std::uniform_int_distribution<uint32_t> chance(0, 63);
+
+    std::vector<DrawCallMatchKey> instances(instanceCount);
+
+    for (uint32_t i = 0; i < instanceCount; i++) {
+      DrawCallMatchKey& key = instances[i];
+      key.materialHash = 0x100 + i % MaterialCount;
+      key.vertexPositionHash = 0x200;
+      key.vertexTexcoordHash = 0x300 + (i % 7 == 0 ? 1 : 0);
+      key.fullGeometryHash = key.vertexPositionHash ^ (key.vertexTexcoordHash << 16);
+      key.isSky = i % 29 == 0;
+
+      // Every eighth instance is drawn twice at the same spot
+      key.worldPosition = i % 8 == 1 ? instances[i - 1].worldPosition : Vector3(position(rng), position(rng), position(rng));
+    }
+
+    std::vector<Frame> frames(FrameCount);
+
+    for (uint32_t f = 0; f < FrameCount; f++) {
+      for (uint32_t i = 0; i < instanceCount; i++) {
+        DrawCallMatchKey& key = instances[i];
+
+        if (i % 3 == 0) {
+          // Skinned, new bone and vertex hashes every frame
+          key.boneHash = XXH64(&f, sizeof(f), i);
+          key.vertexPositionHash = XXH64(&f, sizeof(f), ~uint64_t(i));
+          key.fullGeometryHash = key.vertexPositionHash ^ (key.vertexTexcoordHash << 16);
+          key.worldPosition += Vector3(step(rng), step(rng), step(rng));
+        } else if (i % 5 == 0) {
+          // Moving, but the geometry stays the same
+          key.worldPosition += Vector3(step(rng), step(rng), step(rng));
+        }
+
+        if (chance(rng) == 0) {
+          // Respawned far away, rarely with a different material
+          key.worldPosition = Vector3(position(rng), position(rng), position(rng));
+          key.materialHash = chance(rng) < 8 ? 0x100 + (key.materialHash + 1) % MaterialCount : key.materialHash;
+        }
+
+        // Some frames skip instances, which lets their entries age out
+        if ((i + f) % 23 == 0) {
+          continue;
+        }
+
+        frames[f].push_back(key);
+
+        if (i % 61 == 0) {
+          DrawCallMatchKey broken = key;
+          broken.worldPosition = Vector3(NAN, 0.f, 0.f);
+          frames[f].push_back(broken);
+        }
+      }
+
+      std::shuffle(frames[f].begin(), frames[f].end(), rng);
+    }
+
+    return frames;
+  }
+
+  // The bucket, iterated in order by both replays.  Where new entries land is decided by the multimap in
+  // the cache, here it is derived from the entry id, so it's the same for both as long as they agree.
+  class Bucket {
+  public:
+    using List = std::list<Entry>;
+
+    List::iterator allocate(uint32_t id, const DrawCallMatchKey& key, uint32_t frame) {
+      List::iterator position = m_entries.end();
+
+      if (id % 3 == 1) {
+        position = m_entries.begin();
+      } else if (id % 3 == 2 && !m_entries.empty()) {
+        position = std::next(m_entries.begin(), id % m_entries.size());
+      }
+
+      return m_entries.insert(position, Entry { id, key, frame });
+    }
+
+    List& entries() {
+      return m_entries;
+    }
+
+  private:
+    List m_entries;
+  };
+
+  // The multi-entry search DrawCallCache ran before it had an index
+  Entry* findLinear(Bucket& bucket, const DrawCallMatchKey& drawCall, uint32_t frame) {
+    Entry* best = nullptr;
+    float bestScore = kMinDrawCallMatchScore;
+
+    for (Entry& entry : bucket.entries()) {
+      if (isExactDrawCallMatch(drawCall, entry.key)) {
+        return &entry;
+      }
+      if (entry.frameLastTouched == frame) {
+        continue;
+      }
+      const float score = calcDrawCallMatchScore(drawCall, entry.key);
+      if (score > bestScore) {
+        bestScore = score;
+        best = &entry;
+      }
+    }
+
+    return best;
+  }
+
+  ReplayResult replay(const std::vector<Frame>& frames, bool useIndex) {
+    Bucket bucket;
+    DrawCallBucketIndex<Entry> index;
+    ReplayResult result;
+    uint32_t nextId = 0;
+
+    for (uint32_t f = 0; f < frames.size(); f++) {
+      const auto t0 = std::chrono::steady_clock::now();
+
+      for (const DrawCallMatchKey& drawCall : frames[f]) {
+        Entry* entry = useIndex ? index.find(drawCall, f) : findLinear(bucket, drawCall, f);
+
+        if (entry == nullptr) {
+          auto iter = bucket.allocate(nextId++, drawCall, f);
+          entry = &*iter;
+
+          if (useIndex) {
+            const Entry* prev = iter != bucket.entries().begin() ? &*std::prev(iter) : nullptr;
+            const Entry* next = std::next(iter) != bucket.entries().end() ? &*std::next(iter) : nullptr;
+            index.insert(entry, entry->key, prev, next);
+          }
+
+          if (f > 0) {
+            result.numNew++;
+          }
+        } else {
+          if (isExactDrawCallMatch(drawCall, entry->key)) {
+            result.numExact++;
+          } else {
+            result.numSimilar++;
+          }
+
+          // Like SceneManager, an entry only takes the draw call it was first reused for each frame
+          if (entry->frameLastTouched != f) {
+            entry->key = drawCall;
+            entry->frameLastTouched = f;
+
+            if (useIndex) {
+              index.update(entry, entry->key);
+            }
+          }
+        }
+
+        result.entries.push_back(entry->id);
+      }
+
+      result.matchMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+      for (auto iter = bucket.entries().begin(); iter != bucket.entries().end();) {
+        if (iter->frameLastTouched + MaxEntryAge < f) {
+          if (useIndex) {
+            index.erase(&*iter);
+          }
+          iter = bucket.entries().erase(iter);
+        } else {
+          ++iter;
+        }
+      }
+    }
+
+    if (useIndex && index.size() != bucket.entries().size()) {
+      throw DxvkError(str::format("Index holds ", index.size(), " entries, bucket holds ", bucket.entries().size()));
+    }
+
+    return result;
+  }
+
+  void runCount(uint32_t instanceCount) {
+    const auto frames = makeRecording(instanceCount);
+
+    const ReplayResult linear = replay(frames, false);
+    const ReplayResult indexed = replay(frames, true);
+
+    if (linear.entries != indexed.entries) {
+      size_t draw = 0;
+      while (linear.entries[draw] == indexed.entries[draw]) {
+        draw++;
+      }
+      throw DxvkError(str::format("Index picked entry ", indexed.entries[draw], " instead of ", linear.entries[draw],
+                                  " for draw ", draw, " with ", instanceCount, " instances"));
+    }
+
+    // Make sure the recording went through every path of the search
+    if (indexed.numExact == 0 || indexed.numSimilar == 0 || indexed.numNew == 0) {
+      throw DxvkError(str::format("Recording with ", instanceCount, " instances only had ", indexed.numExact, " exact, ",
+                                  indexed.numSimilar, " similar and ", indexed.numNew, " new entries"));
+    }
+
+    std::cout << "  " << std::setw(5) << instanceCount << " instances, " << std::setw(6) << indexed.numExact << " exact, "
+              << std::setw(6) << indexed.numSimilar << " similar, " << std::setw(5) << indexed.numNew << " new --> "
+              << "linear " << std::setw(9) << linear.matchMs / FrameCount << " ms/frame, "
+              << "index " << std::setw(9) << indexed.matchMs / FrameCount << " ms/frame ("
+              << linear.matchMs / indexed.matchMs << "x)" << std::endl;
+  }
+
+  void testOrderedInserts() {
+    // Every entry is an exact match for the same draw call, the first one in bucket order has to win
+    // no matter how often entries were squeezed in between the same two neighbours.
+    std::list<Entry> entries;
+    DrawCallBucketIndex<Entry> index;
+
+    DrawCallMatchKey key;
+    key.materialHash = 1;
+
+    entries.push_back(Entry { 0, key, 0 });
+    index.insert(&entries.back(), key, nullptr, nullptr);
+    entries.push_back(Entry { 1, key, 0 });
+    index.insert(&entries.back(), key, &entries.front(), nullptr);
+
+    for (uint32_t id = 2; id < 64; id++) {
+      auto second = std::next(entries.begin());
+      auto iter = entries.insert(second, Entry { id, key, 0 });
+      index.insert(&*iter, key, &entries.front(), &*second);
+    }
+
+    auto front = entries.insert(entries.begin(), Entry { 64, key, 0 });
+    index.insert(&*front, key, nullptr, &*std::next(front));
+
+    if (index.find(key, 1) != &entries.front()) {
+      throw DxvkError("Exact match did not resolve to the first entry in bucket order");
+    }
+
+    // Once the first entry is re-keyed, the next one in order takes over
+    DrawCallMatchKey moved = key;
+    moved.materialHash = 2;
+    front->key = moved;
+    index.update(&*front, moved);
+
+    if (index.find(key, 1) != &*std::next(entries.begin())) {
+      throw DxvkError("Exact match did not move on to the next entry after an update");
+    }
+
+    for (const Entry& entry : entries) {
+      index.erase(&entry);
+    }
+    if (index.size() != 0) {
+      throw DxvkError("Index should be empty");
+    }
+  }
+
+  // Goes through DrawCallCache: entries returned by get() are changed by the caller like SceneManager does,
+  // the next lookup has to see that change, also once the bucket is large enough to be indexed.
+  void testCacheUpdateEntry() {
+    constexpr uint32_t EntryCount = 24;
+
+    DrawCallCache cache(nullptr);
+    DrawCallState drawCall;
+    std::vector<BlasEntry*> entries;
+    uint32_t frame = 1;
+
+    // The same draw call every time, but each entry is turned into a sky entry once returned, so the next
+    // draw call can't match it exactly, and since it was touched this frame it can't reuse it either
+    for (uint32_t i = 0; i < EntryCount; i++) {
+      BlasEntry* entry = nullptr;
+      if (cache.get(drawCall, frame, &entry) != DrawCallCache::CacheState::kNew ||
+          std::find(entries.begin(), entries.end(), entry) != entries.end()) {
+        throw DxvkError(str::format("Draw call ", i, " reused an entry that was changed to no longer match it"));
+      }
+
+      entry->frameLastTouched = frame;
+      entry->input.cameraType = CameraType::Sky;
+      cache.updateEntry(entry);
+      entries.push_back(entry);
+    }
+
+    // Turning one back makes it the exact match of the next draw call
+    frame++;
+    BlasEntry* exact = entries[EntryCount / 2];
+    exact->input.cameraType = drawCall.cameraType;
+    cache.updateEntry(exact);
+
+    BlasEntry* entry = nullptr;
+    if (cache.get(drawCall, frame, &entry) != DrawCallCache::CacheState::kExisted || entry != exact) {
+      throw DxvkError("Draw call did not find the entry changed to match it exactly");
+    }
+
+    // And once every entry was touched this frame and none matches exactly anymore, a new one is needed
+    exact->input.cameraType = CameraType::Sky;
+    cache.updateEntry(exact);
+    for (BlasEntry* touched : entries) {
+      touched->frameLastTouched = frame;
+    }
+
+    if (cache.get(drawCall, frame, &entry) != DrawCallCache::CacheState::kNew ||
+        std::find(entries.begin(), entries.end(), entry) != entries.end()) {
+      throw DxvkError("Draw call reused an entry that was changed to no longer match it");
+    }
+
+    for (auto iter = cache.getEntries().begin(); iter != cache.getEntries().end();) {
+      iter = cache.erase(iter);
+    }
+    if (!cache.getEntries().empty()) {
+      throw DxvkError("Cache should be empty");
+    }
+  }
+
+  void run_test() {
+    std::cout << "Checking bucket index ordering" << std::endl;
+    testOrderedInserts();
+
+    std::cout << "Checking entries are re-keyed when updated" << std::endl;
+    testCacheUpdateEntry();
+
+    std::cout << "Replaying " << FrameCount << " frames of instanced draw calls" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (uint32_t instanceCount = 64; instanceCount <= 4096; instanceCount *= 4) {
+      runCount(instanceCount);
+    }
+  }
+}
+
+int main() {
+  try {
+    test_draw_call_cache_app::run_test();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
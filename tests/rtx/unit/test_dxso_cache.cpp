@@ -0,0 +1,361 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+#include "../../test_utils.h"
+#include "../../../src/dxso/dxso_cache.h"
+#include "../../../src/util/util_timer.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_dxso_cache.log");
+}
+
+namespace dxvk {
+  class TestApp {
+  public:
+    static constexpr uint32_t kNumShaders = 500;
+
+    struct TestShader {
+      Sha1Hash              key;
+      VkShaderStageFlagBits stage;
+      DxsoCompiledShader    compiled;
+    };
+
+    std::filesystem::path m_path = std::filesystem::temp_directory_path() / "test_dxso_cache.dxso-cache";
+    std::vector<TestShader> m_shaders;
+
+    static DxsoModuleInfo makeModuleInfo() {
+      DxsoModuleInfo info;
+      info.options.useDemoteToHelperInvocation = true;
+      info.options.useSubgroupOpsForEarlyDiscard = false;
+      info.options.strictConstantCopies = false;
+      info.options.d3d9FloatEmulation = D3D9FloatEmulation::Enabled;
+      info.options.strictPow = true;
+      info.options.shaderModel = 3;
+      info.options.invariantPosition = false;
+      info.options.forceSamplerTypeSpecConstants = false;
+      info.options.vertexFloatConstantBufferAsSSBO = false;
+      info.options.longMad = false;
+      info.options.alphaTestWiggleRoom = false;
+      info.options.robustness2Supported = true;
+      return info;
+    }
+
+    // SPIR-V that DxvkShader can walk: a header, binding decorations for the slots, then filler
+    static Rc<DxvkShader> makeShader(std::mt19937& rng, VkShaderStageFlagBits stage, uint32_t numSlots, uint32_t numDwords) {
+      std::vector<uint32_t> code = { spv::MagicNumber, 0x00010300u, 0u, 64u, 0u };
+      std::vector<DxvkResourceSlot> slots;
+
+      for (uint32_t i = 0; i < numSlots; i++) {
+        code.insert(code.end(), { (4u << 16) | uint32_t(spv::OpDecorate), i + 1, uint32_t(spv::DecorationBinding), i });
+        slots.push_back(DxvkResourceSlot(i, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_IMAGE_VIEW_TYPE_2D));
+      }
+
+      // Unique per shader so compression and checksums see different data
+      code.insert(code.end(), { (3u << 16) | uint32_t(spv::OpSource), uint32_t(rng()), uint32_t(rng()) });
+
+      while (code.size() < numDwords) {
+        code.push_back((1u << 16) | uint32_t(spv::OpNop));
+      }
+
+      DxvkInterfaceSlots iface;
+      iface.inputSlots = rng();
+      iface.outputSlots = rng();
+      iface.pushConstOffset = 0;
+      iface.pushConstSize = 64;
+
+      DxvkShaderOptions shaderOptions = { };
+      DxvkShaderConstData constData = { };
+      return new DxvkShader(stage, uint32_t(slots.size()), slots.data(), iface,
+        SpirvCodeBuffer(uint32_t(code.size()), code.data()), shaderOptions, std::move(constData));
+    }
+
+    void createShaders() {
+      std::mt19937 rng(7);
+      const DxsoModuleInfo moduleInfo = makeModuleInfo();
+      const D3D9ConstantLayout layout = { 256, 16, 16, 1 };
+
+      for (uint32_t i = 0; i < kNumShaders; i++) {
+        TestShader shader;
+        shader.stage = (i & 1) ? VK_SHADER_STAGE_FRAGMENT_BIT : VK_SHADER_STAGE_VERTEX_BIT;
+
+        Sha1Digest bytecodeHash;
+        for (auto& byte : bytecodeHash) {
+          byte = uint8_t(rng());
+        }
+        shader.key = DxsoShaderCache::computeKey(DxvkShaderKey(shader.stage, Sha1Hash(bytecodeHash)), moduleInfo, layout);
+
+        // Roughly the size range of translated game shaders
+        const uint32_t numDwords = 500 + rng() % 4000;
+        shader.compiled.shaders[D3D9ShaderPermutations::None] = makeShader(rng, shader.stage, rng() % 8, numDwords);
+
+        if (shader.stage == VK_SHADER_STAGE_FRAGMENT_BIT) {
+          shader.compiled.shaders[D3D9ShaderPermutations::FlatShade] = makeShader(rng, shader.stage, rng() % 8, numDwords);
+        }
+
+        shader.compiled.isgn.elemCount = rng() % 8;
+        for (uint32_t j = 0; j < shader.compiled.isgn.elemCount; j++) {
+          shader.compiled.isgn.elems[j].regNumber = j;
+          shader.compiled.isgn.elems[j].slot = rng() % 16;
+          shader.compiled.isgn.elems[j].semantic = DxsoSemantic { DxsoUsage::Texcoord, j };
+        }
+        shader.compiled.osgn.elemCount = 1;
+        shader.compiled.usedSamplers = rng();
+        shader.compiled.usedRTs = rng() % 16;
+        shader.compiled.meta.maxConstIndexF = rng() % 256;
+        shader.compiled.meta.needsConstantCopies = (rng() & 1) != 0;
+        shader.compiled.constants.resize(rng() % 4);
+        for (auto& constant : shader.compiled.constants) {
+          constant.uboIdx = rng() % 256;
+          constant.float32[0] = float(rng());
+        }
+        shader.compiled.maxDefinedConst = rng() % 256;
+
+        m_shaders.push_back(std::move(shader));
+      }
+    }
+
+    static void compareShaders(const Rc<DxvkShader>& a, const Rc<DxvkShader>& b) {
+      if ((a == nullptr) != (b == nullptr)) {
+        throw DxvkError("DxsoShaderCache: permutation missing after load");
+      }
+      if (a == nullptr) {
+        return;
+      }
+
+      const SpirvCodeBuffer codeA = a->getCode();
+      const SpirvCodeBuffer codeB = b->getCode();
+      if (codeA.dwords() != codeB.dwords() || std::memcmp(codeA.data(), codeB.data(), codeA.size())) {
+        throw DxvkError("DxsoShaderCache: SPIR-V differs after load");
+      }
+
+      const auto& slotsA = a->getResourceSlots();
+      const auto& slotsB = b->getResourceSlots();
+      if (slotsA.size() != slotsB.size()) {
+        throw DxvkError("DxsoShaderCache: resource slots differ after load");
+      }
+      for (size_t i = 0; i < slotsA.size(); i++) {
+        if (slotsA[i].slot != slotsB[i].slot || slotsA[i].type != slotsB[i].type || slotsA[i].view != slotsB[i].view) {
+          throw DxvkError("DxsoShaderCache: resource slots differ after load");
+        }
+      }
+
+      const DxvkInterfaceSlots ifaceA = a->interfaceSlots();
+      const DxvkInterfaceSlots ifaceB = b->interfaceSlots();
+      if (a->stage() != b->stage()
+       || ifaceA.inputSlots != ifaceB.inputSlots
+       || ifaceA.outputSlots != ifaceB.outputSlots
+       || ifaceA.pushConstOffset != ifaceB.pushConstOffset
+       || ifaceA.pushConstSize != ifaceB.pushConstSize) {
+        throw DxvkError("DxsoShaderCache: shader interface differs after load");
+      }
+    }
+
+    static bool equal(const DxsoIsgn& a, const DxsoIsgn& b) {
+      if (a.elemCount != b.elemCount) {
+        return false;
+      }
+      for (uint32_t i = 0; i < a.elemCount; i++) {
+        if (a.elems[i].regNumber != b.elems[i].regNumber
+         || a.elems[i].slot != b.elems[i].slot
+         || a.elems[i].semantic.usage != b.elems[i].semantic.usage
+         || a.elems[i].semantic.usageIndex != b.elems[i].semantic.usageIndex
+         || a.elems[i].centroid != b.elems[i].centroid) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    static void compare(const DxsoCompiledShader& a, const DxsoCompiledShader& b) {
+      for (uint32_t i = 0; i < D3D9ShaderPermutations::Count; i++) {
+        compareShaders(a.shaders[i], b.shaders[i]);
+      }
+
+      if (!equal(a.isgn, b.isgn)
+       || !equal(a.osgn, b.osgn)
+       || a.usedSamplers != b.usedSamplers
+       || a.usedRTs != b.usedRTs
+       || a.meta.maxConstIndexF != b.meta.maxConstIndexF
+       || a.meta.needsConstantCopies != b.meta.needsConstantCopies
+       || a.constants.size() != b.constants.size()
+       || a.maxDefinedConst != b.maxDefinedConst) {
+        throw DxvkError("DxsoShaderCache: shader info differs after load");
+      }
+
+      for (size_t i = 0; i < a.constants.size(); i++) {
+        if (a.constants[i].uboIdx != b.constants[i].uboIdx
+         || std::memcmp(a.constants[i].float32, b.constants[i].float32, sizeof(a.constants[i].float32))) {
+          throw DxvkError("DxsoShaderCache: defined constants differ after load");
+        }
+      }
+    }
+
+    void populate(const char* version) {
+      std::filesystem::remove(m_path);
+
+      Rc<DxsoShaderCache> cache = new DxsoShaderCache(m_path.string(), version);
+      for (const TestShader& shader : m_shaders) {
+        cache->store(shader.key, shader.compiled);
+      }
+      cache->flush();
+    }
+
+    uint32_t countHits(const char* version) {
+      Rc<DxsoShaderCache> cache = new DxsoShaderCache(m_path.string(), version);
+
+      uint32_t numHits = 0;
+      for (const TestShader& shader : m_shaders) {
+        DxsoCompiledShader loaded;
+        if (cache->lookup(shader.key, shader.stage, loaded)) {
+          compare(shader.compiled, loaded);
+          numHits++;
+        }
+      }
+      return numHits;
+    }
+
+    void testKeys() {
+      const DxvkShaderKey shaderKey(VK_SHADER_STAGE_VERTEX_BIT, Sha1Hash::compute("bytecode", 8));
+      const D3D9ConstantLayout layout = { 256, 16, 16, 1 };
+      const D3D9ConstantLayout swvpLayout = { 8192, 2048, 2048, 256 };
+
+      DxsoModuleInfo moduleInfo = makeModuleInfo();
+      const Sha1Hash key = DxsoShaderCache::computeKey(shaderKey, moduleInfo, layout);
+
+      if (key != DxsoShaderCache::computeKey(shaderKey, moduleInfo, layout)) {
+        throw DxvkError("DxsoShaderCache: key is not deterministic");
+      }
+      if (key == DxsoShaderCache::computeKey(shaderKey, moduleInfo, swvpLayout)) {
+        throw DxvkError("DxsoShaderCache: key ignores the constant layout");
+      }
+      if (key == DxsoShaderCache::computeKey(DxvkShaderKey(VK_SHADER_STAGE_FRAGMENT_BIT, shaderKey.sha1()), moduleInfo, layout)) {
+        throw DxvkError("DxsoShaderCache: key ignores the shader stage");
+      }
+
+      moduleInfo.options.longMad = true;
+      if (key == DxsoShaderCache::computeKey(shaderKey, moduleInfo, layout)) {
+        throw DxvkError("DxsoShaderCache: key ignores the module options");
+      }
+    }
+
+    void testRoundTrip() {
+      populate("1.0");
+
+      if (countHits("1.0") != kNumShaders) {
+        throw DxvkError("DxsoShaderCache: not all stored shaders found after reload");
+      }
+
+      // Another build must not pick up the file, and leaves a fresh one behind
+      if (countHits("1.1") != 0 || countHits("1.0") != 0) {
+        throw DxvkError("DxsoShaderCache: file from a different compiler version was used");
+      }
+    }
+
+    void testRecovery() {
+      // A crash while appending leaves a partial entry at the end of the file
+      populate("1.0");
+      const uintmax_t size = std::filesystem::file_size(m_path);
+      std::filesystem::resize_file(m_path, size - 100);
+
+      if (countHits("1.0") != kNumShaders - 1) {
+        throw DxvkError("DxsoShaderCache: truncated entry not dropped");
+      }
+      // The damaged file was rewritten with the remaining entries
+      if (countHits("1.0") != kNumShaders - 1) {
+        throw DxvkError("DxsoShaderCache: recovered file lost entries");
+      }
+
+      // Flip a byte inside the first entry
+      populate("1.0");
+      { std::fstream file(m_path, std::ios::binary | std::ios::in | std::ios::out);
+        const std::streamoff offset = sizeof(DxsoShaderCacheHeader) + sizeof(DxsoShaderCacheEntryHeader) + 16;
+        char byte;
+        file.seekg(offset);
+        file.read(&byte, 1);
+        byte ^= 0x5a;
+        file.seekp(offset);
+        file.write(&byte, 1);
+      }
+
+      if (countHits("1.0") != kNumShaders - 1) {
+        throw DxvkError("DxsoShaderCache: corrupted entry not detected");
+      }
+    }
+
+    // The startup cost the cache adds on a warm run, i.e. what replaces translating every shader
+    void runBenchmarks() {
+      std::cout << kNumShaders << " shaders" << std::endl;
+
+      std::filesystem::remove(m_path);
+      {
+        std::cout << "  store + write --> ";
+        Timer time;
+        Rc<DxsoShaderCache> cache = new DxsoShaderCache(m_path.string(), "1.0");
+        for (const TestShader& shader : m_shaders) {
+          cache->store(shader.key, shader.compiled);
+        }
+        cache->flush();
+      }
+
+      std::cout << "  cache file: " << (std::filesystem::file_size(m_path) >> 10) << " KB" << std::endl;
+
+      {
+        std::cout << "  load + lookup all --> ";
+        Timer time;
+        Rc<DxsoShaderCache> cache = new DxsoShaderCache(m_path.string(), "1.0");
+        for (const TestShader& shader : m_shaders) {
+          DxsoCompiledShader loaded;
+          cache->lookup(shader.key, shader.stage, loaded);
+        }
+      }
+    }
+
+    void run() {
+      createShaders();
+      testKeys();
+      testRoundTrip();
+      testRecovery();
+      runBenchmarks();
+      std::filesystem::remove(m_path);
+      std::cout << "All passed\n";
+    }
+  };
+}
+
+
+int main() {
+  try {
+    dxvk::TestApp testApp;
+    testApp.run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
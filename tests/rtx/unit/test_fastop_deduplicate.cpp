@@ -0,0 +1,209 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <cstring>
+#include <random>
+#include <vector>
+#include "../../test_utils.h"
+#include "../../../src/util/util_fastops.h"
+#include "../../../src/util/util_timer.h"
+#include "../../../src/util/xxHash/xxhash.h"
+
+using namespace dxvk;
+
+#define TEST(ISA) \
+      {                                                                    \
+        {                                                                  \
+          std::cout << "Running: deduplicateSortIndices_"#ISA" --> ";      \
+          Timer time;                                                      \
+          for (uint32_t r = 0; r < kRepeats; r++)                          \
+            uniqueCount = fast::deduplicateSortIndices_##ISA(count, pData, maxValue, flags.data(), unique.data()); \
+        }                                                                  \
+        validate(reference, unique, uniqueCount, "deduplicateSortIndices_"#ISA); \
+      }                                                                    \
+
+#define TEST_CHECK(ISA, level) \
+      if (fast::getSimdSupportLevel() >= SIMD::level) {                   \
+        TEST(ISA);                                                        \
+      } else {                                                            \
+        std::cout << #ISA" not supported by this processor" << std::endl; \
+      }                                                                   \
+
+namespace fast {
+
+  template<typename T>
+  extern uint32_t deduplicateSortIndices_slow(const uint32_t count, const T* data, const uint32_t maxValue, uint8_t* flagsScratch, T* uniqueOut);
+  template<typename T>
+  extern uint32_t deduplicateSortIndices_SSE(const uint32_t count, const T* data, const uint32_t maxValue, uint8_t* flagsScratch, T* uniqueOut);
+  template<typename T>
+  extern uint32_t deduplicateSortIndices_AVX2(const uint32_t count, const T* data, const uint32_t maxValue, uint8_t* flagsScratch, T* uniqueOut);
+
+class DeduplicateTestApp {
+public:
+  static void run() { 
+    std::cout << std::endl << "Begin test (16-bit)" << std::endl;
+    test_correctness<uint16_t>();
+    test_smoke<uint16_t>(false);
+    test_smoke<uint16_t>(true);
+
+    std::cout << std::endl << "Begin test (32-bit)" << std::endl;
+    test_correctness<uint32_t>();
+    test_smoke<uint32_t>(false);
+    test_smoke<uint32_t>(true);
+  }
+  
+private:
+  static constexpr uint32_t kRepeats = 100;
+
+  // The implementation this replaced, used as reference for both results and timing
+  template<typename T>
+  static void deduplicateSortIndices_legacy(const T* pIndexData, const size_t indexCount, const uint32_t maxIndexValue, std::vector<T>& uniqueIndicesOut) {
+    const uint32_t indexRange = maxIndexValue + 1;
+    uniqueIndicesOut.resize(indexRange, (T) 0);
+
+    for (uint32_t i = 0; i < indexCount; i++) {
+      uniqueIndicesOut[pIndexData[i]] = 1;
+    }
+
+    uint32_t uniqueIndexCount = 0;
+    for (uint32_t i = 0; i < indexRange; i++) {
+      if (uniqueIndicesOut[i])
+        uniqueIndicesOut[uniqueIndexCount++] = i;
+    }
+
+    uniqueIndicesOut.resize(uniqueIndexCount);
+  }
+
+  // Vertex hashes chain each element through the seed, so identical index lists must produce identical hashes
+  template<typename T>
+  static XXH64_hash_t hashVertices(const std::vector<float>& vertices, const T* indices, const size_t count) {
+    XXH64_hash_t result = 0;
+    for (size_t i = 0; i < count; i++) {
+      result = XXH3_64bits_withSeed(&vertices[indices[i] * 3], sizeof(float) * 3, result);
+    }
+    return result;
+  }
+
+  template<typename T>
+  static void validate(const std::vector<T>& reference, const std::vector<T>& unique, const uint32_t uniqueCount, const char* name) {
+    if (uniqueCount != reference.size() || memcmp(reference.data(), unique.data(), uniqueCount * sizeof(T)) != 0)
+      throw dxvk::DxvkError(str::format("Unique indices not matching ", name));
+  }
+
+  template<typename T>
+  static void test_correctness() {
+    T data1[] = { 29, 1, 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 1, 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 0, 0 };
+    const T expected1[] = { 0, 1, 2, 3, 5, 7, 11, 13, 17, 19, 23, 29 };
+    const uint32_t count1 = sizeof(data1) / sizeof(data1[0]);
+
+    std::vector<uint8_t> flags(fast::deduplicateSortIndicesScratchSize(29));
+    std::vector<T> unique(30);
+    uint32_t uniqueCount = fast::deduplicateSortIndices<T>(count1, data1, 29, flags.data(), unique.data());
+
+    if (uniqueCount != sizeof(expected1) / sizeof(expected1[0]) || memcmp(expected1, unique.data(), sizeof(expected1)) != 0)
+      throw dxvk::DxvkError("Unique indices not matching correctness check 1");
+
+    // Contiguous strip covering several full 16/32 byte flag blocks, plus a sparse tail
+    const uint32_t maxValue = 1000;
+    std::vector<T> data2;
+    for (uint32_t i = 0; i < 300; i++) {
+      data2.push_back((T) i);
+      data2.push_back((T) (299 - i));
+    }
+    data2.push_back((T) maxValue);
+    data2.push_back((T) 640);
+
+    std::vector<T> reference;
+    deduplicateSortIndices_legacy(data2.data(), data2.size(), maxValue, reference);
+
+    flags.resize(fast::deduplicateSortIndicesScratchSize(maxValue));
+    unique.resize(maxValue + 1);
+    uniqueCount = fast::deduplicateSortIndices<T>((uint32_t) data2.size(), data2.data(), maxValue, flags.data(), unique.data());
+    validate(reference, unique, uniqueCount, "correctness check 2");
+
+    std::vector<float> vertices((maxValue + 1) * 3);
+    for (uint32_t i = 0; i < vertices.size(); i++) {
+      vertices[i] = (float) i * 0.25f;
+    }
+    if (hashVertices(vertices, reference.data(), reference.size()) != hashVertices(vertices, unique.data(), uniqueCount))
+      throw dxvk::DxvkError("Vertex hash not matching correctness check 2");
+
+    std::cout << "Deduplicate fast ops successfully tested for correctness" << std::endl;
+  }
+
+  template<typename T>
+  static void test_smoke(const bool sparse) {
+    std::random_device rd;
+    std::mt19937 rng(rd());
+
+    // Sparse: random references into a large vertex buffer.  Dense: a typical triangle list over a compact range.
+    const uint32_t count = 64 * 1024 * 3 + 7;
+    const uint32_t range = sparse ? (uint32_t) std::numeric_limits<uint16_t>::max() : 20000;
+    std::uniform_int_distribution<uint32_t> uni(0, range - 1);
+
+    std::vector<T> data(count);
+    for (uint32_t i = 0; i < count; i++) {
+      data[i] = (T) (sparse ? uni(rng) : (i / 3 + uni(rng) % 3) % range);
+    }
+
+    uint32_t maxValue, minValue;
+    fast::findMinMax<T>(count, data.data(), minValue, maxValue);
+
+    const T* pData = data.data();
+    std::vector<uint8_t> flags(fast::deduplicateSortIndicesScratchSize(maxValue));
+    std::vector<T> unique(maxValue + 1);
+    std::vector<T> reference;
+    uint32_t uniqueCount = 0;
+
+    std::cout << "Running " << (sparse ? "sparse" : "dense") << " smoke check, number of indices: " << count << ", repeats: " << kRepeats << std::endl;
+
+    {
+      std::cout << "Running: deduplicateSortIndices_legacy --> ";
+      Timer time;
+      for (uint32_t r = 0; r < kRepeats; r++) {
+        // The legacy path allocated per draw, include that in the measurement
+        std::vector<T> uniqueIndices;
+        deduplicateSortIndices_legacy(pData, count, maxValue, uniqueIndices);
+        if (r == 0)
+          reference = std::move(uniqueIndices);
+      }
+    }
+
+    TEST(slow);
+    TEST_CHECK(SSE, SSE2);
+    TEST_CHECK(AVX2, AVX2);
+
+    std::cout << "Deduplicate fast ops successfully smoke tested" << std::endl;
+  }
+};
+}
+
+int main() {
+  try {
+    fast::DeduplicateTestApp::run();
+  }
+  catch (const dxvk::DxvkError& e) {
+    std::cerr << e.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
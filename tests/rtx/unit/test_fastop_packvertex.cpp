@@ -0,0 +1,287 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "../../test_utils.h"
+#include "../../../src/util/util_fastops.h"
+#include "../../../src/util/util_timer.h"
+
+using namespace dxvk;
+
+#define TEST(ISA) \
+      {                                                                    \
+        {                                                                  \
+          std::cout << "Running: packVertexStream_"#ISA" --> ";            \
+          Timer time;                                                      \
+          for (uint32_t r = 0; r < kRepeats; r++)                          \
+            fast::packVertexStream_##ISA(packed.data(), layout.packedStride, source.data(), layout.stride, kVertexCount, layout.elements.data(), (uint32_t) layout.elements.size()); \
+        }                                                                  \
+        validate(reference, packed, "packVertexStream_"#ISA);              \
+      }                                                                    \
+
+#define TEST_CHECK(ISA, level) \
+      if (fast::getSimdSupportLevel() >= SIMD::level) {                   \
+        TEST(ISA);                                                        \
+      } else {                                                            \
+        std::cout << #ISA" not supported by this processor" << std::endl; \
+      }                                                                   \
+
+namespace fast {
+
+  extern void packVertexStream_slow(void* dst, const uint32_t dstStride, const void* src, const uint32_t srcStride, const uint32_t count,
+                                    const PackedVertexElement* elements, const uint32_t elementCount);
+  extern void packVertexStream_SSE(void* dst, const uint32_t dstStride, const void* src, const uint32_t srcStride, const uint32_t count,
+                                   const PackedVertexElement* elements, const uint32_t elementCount);
+  extern void packVertexStream_AVX2(void* dst, const uint32_t dstStride, const void* src, const uint32_t srcStride, const uint32_t count,
+                                    const PackedVertexElement* elements, const uint32_t elementCount);
+
+class PackVertexTestApp {
+public:
+  static void run() { 
+    std::cout << std::endl << "Begin test (conversions)" << std::endl;
+    test_conversions();
+
+    std::cout << std::endl << "Begin test (vertex declarations)" << std::endl;
+    test_declarations();
+  }
+  
+private:
+  static constexpr uint32_t kRepeats = 100;
+  static constexpr uint32_t kVertexCount = 64 * 1024 + 7;
+
+  using PackFn = void (*)(void*, const uint32_t, const void*, const uint32_t, const uint32_t, const PackedVertexElement*, const uint32_t);
+
+  // Reference decoders, written from the format definitions rather than sharing the tricks of the implementation
+  static float decodeHalf(const uint16_t half) {
+    const float sign = (half & 0x8000) ? -1.0f : 1.0f;
+    const int exponent = (half >> 10) & 0x1F;
+    const int mantissa = half & 0x3FF;
+
+    if (exponent == 0)
+      return sign * std::ldexp(float(mantissa), -24);
+    if (exponent == 31)
+      return sign * INFINITY;
+
+    return sign * std::ldexp(float(mantissa + 1024), exponent - 25);
+  }
+
+  static float decodeSnorm(const int32_t value, const int32_t maxValue) {
+    return std::max(float(value) / float(maxValue), -1.0f);
+  }
+
+  static void expectFloat3(const uint8_t* packed, const float expected[3], const float tolerance, const char* name) {
+    float actual[3];
+    memcpy(actual, packed, sizeof(actual));
+
+    for (uint32_t c = 0; c < 3; c++) {
+      const bool matches = std::isinf(expected[c])
+        ? actual[c] == expected[c]
+        : std::abs(actual[c] - expected[c]) <= tolerance;
+
+      if (!matches || (expected[c] == 0.0f && std::signbit(actual[c]) != std::signbit(expected[c])))
+        throw DxvkError(str::format("Conversion not matching ", name, ": expected ", expected[c], ", got ", actual[c]));
+    }
+  }
+
+  // Packs a stream containing one element of every conversion out of a stride
+  // with padding around each element, and checks every vertex against the reference
+  static void test_conversions(const char* name, PackFn pack) {
+    constexpr uint32_t kCount = 4099;
+    constexpr uint32_t kSrcStride = 64;
+
+    const PackedVertexElement elements[] = {
+      { 4,  0,  12, VertexElementConversion::Copy },
+      { 20, 12, 0,  VertexElementConversion::Half4ToFloat3 },
+      { 28, 24, 0,  VertexElementConversion::Short4NToFloat3 },
+      { 36, 36, 0,  VertexElementConversion::Dec3NToFloat3 },
+      { 40, 48, 0,  VertexElementConversion::Ubyte4NToFloat3 },
+      { 48, 60, 0,  VertexElementConversion::Rgba8ToBgra8 },
+      { 52, 64, 8,  VertexElementConversion::Copy },
+    };
+    constexpr uint32_t kDstStride = 72;
+
+    std::mt19937 rng(kCount);
+    std::vector<uint8_t> source(kCount * kSrcStride);
+    for (auto& byte : source) {
+      byte = (uint8_t) rng();
+    }
+
+    // Make sure the interesting half values show up, avoiding NaNs which have no unique representation
+    const uint16_t specialHalves[] = { 0x0000, 0x8000, 0x0001, 0x83FF, 0x0400, 0x3C00, 0xBC00, 0x7BFF, 0x7C00, 0xFC00 };
+    for (uint32_t i = 0; i < kCount; i++) {
+      uint16_t* halves = (uint16_t*) &source[i * kSrcStride + 20];
+      for (uint32_t c = 0; c < 4; c++) {
+        if (((halves[c] >> 10) & 0x1F) == 31 && (halves[c] & 0x3FF) != 0)
+          halves[c] &= 0xFC00;
+        if (i < sizeof(specialHalves) / sizeof(specialHalves[0]))
+          halves[c] = specialHalves[(i + c) % (sizeof(specialHalves) / sizeof(specialHalves[0]))];
+      }
+    }
+
+    // Most negative snorm values, which clamp to -1
+    *(int16_t*) &source[28] = -32768;
+    *(uint32_t*) &source[36] = 0x200u | (0x200u << 10) | (0x1FFu << 20);
+
+    std::vector<uint8_t> packed(kCount * kDstStride, 0xCD);
+    pack(packed.data(), kDstStride, source.data(), kSrcStride, kCount, elements, sizeof(elements) / sizeof(elements[0]));
+
+    for (uint32_t i = 0; i < kCount; i++) {
+      const uint8_t* src = &source[i * kSrcStride];
+      const uint8_t* dst = &packed[i * kDstStride];
+
+      if (memcmp(dst + 0, src + 4, 12) != 0 || memcmp(dst + 64, src + 52, 8) != 0)
+        throw DxvkError(str::format("Copied element not bit exact ", name, " at vertex ", i));
+
+      const uint16_t* halves = (const uint16_t*) (src + 20);
+      const float halfExpected[3] = { decodeHalf(halves[0]), decodeHalf(halves[1]), decodeHalf(halves[2]) };
+      expectFloat3(dst + 12, halfExpected, 0.0f, name);
+
+      const int16_t* shorts = (const int16_t*) (src + 28);
+      const float shortExpected[3] = { decodeSnorm(shorts[0], 32767), decodeSnorm(shorts[1], 32767), decodeSnorm(shorts[2], 32767) };
+      expectFloat3(dst + 24, shortExpected, 1e-6f, name);
+
+      const uint32_t dec3n = *(const uint32_t*) (src + 36);
+      const auto field = [dec3n] (uint32_t shift) {
+        const int32_t value = (dec3n >> shift) & 0x3FF;
+        return value >= 512 ? value - 1024 : value;
+      };
+      const float dec3nExpected[3] = { decodeSnorm(field(0), 511), decodeSnorm(field(10), 511), decodeSnorm(field(20), 511) };
+      expectFloat3(dst + 36, dec3nExpected, 1e-6f, name);
+
+      const float ubyteExpected[3] = { src[40] / 255.0f * 2.0f - 1.0f, src[41] / 255.0f * 2.0f - 1.0f, src[42] / 255.0f * 2.0f - 1.0f };
+      expectFloat3(dst + 48, ubyteExpected, 1e-6f, name);
+
+      if (dst[60] != src[50] || dst[61] != src[49] || dst[62] != src[48] || dst[63] != src[51])
+        throw DxvkError(str::format("Color swizzle not matching ", name, " at vertex ", i));
+    }
+  }
+
+  static void test_conversions() {
+    test_conversions("packVertexStream_slow", packVertexStream_slow);
+    test_conversions("packVertexStream", packVertexStream);
+
+    if (fast::getSimdSupportLevel() >= SIMD::SSE2)
+      test_conversions("packVertexStream_SSE", packVertexStream_SSE);
+
+    if (fast::getSimdSupportLevel() >= SIMD::AVX2)
+      test_conversions("packVertexStream_AVX2", packVertexStream_AVX2);
+
+    std::cout << "Pack vertex fast ops successfully tested for correctness" << std::endl;
+  }
+
+  struct Declaration {
+    const char* name;
+    uint32_t stride;
+    uint32_t packedStride;
+    std::vector<PackedVertexElement> elements;
+  };
+
+  // Common D3D9 vertex declarations, and the elements the RT geometry consumes from them.
+  // Position and texcoord are copied unchanged, normals and colors converted to GPU friendly formats.
+  static std::vector<Declaration> declarations() {
+    return {
+      { "FLOAT3 position, FLOAT3 normal, FLOAT2 texcoord", 32, 32, {
+        { 0,  0,  12, VertexElementConversion::Copy },
+        { 12, 12, 12, VertexElementConversion::Copy },
+        { 24, 24, 8,  VertexElementConversion::Copy } } },
+      { "FLOAT3 position, FLOAT3 normal, FLOAT2 texcoord0, FLOAT2 texcoord1, FLOAT4 tangent, FLOAT3 binormal", 68, 32, {
+        { 0,  0,  12, VertexElementConversion::Copy },
+        { 12, 12, 12, VertexElementConversion::Copy },
+        { 24, 24, 8,  VertexElementConversion::Copy } } },
+      { "FLOAT3 position, FLOAT16_4 normal, FLOAT2 texcoord, D3DCOLOR color, SHORT4N tangent", 40, 36, {
+        { 0,  0,  12, VertexElementConversion::Copy },
+        { 12, 12, 0,  VertexElementConversion::Half4ToFloat3 },
+        { 20, 24, 8,  VertexElementConversion::Copy },
+        { 28, 32, 4,  VertexElementConversion::Copy } } },
+      { "FLOAT3 position, SHORT4N normal, FLOAT2 texcoord0, FLOAT2 texcoord1, UBYTE4N color", 40, 36, {
+        { 0,  0,  12, VertexElementConversion::Copy },
+        { 12, 12, 0,  VertexElementConversion::Short4NToFloat3 },
+        { 20, 24, 8,  VertexElementConversion::Copy },
+        { 36, 32, 0,  VertexElementConversion::Rgba8ToBgra8 } } },
+      { "FLOAT3 position, DEC3N normal, FLOAT2 texcoord, DEC3N tangent, DEC3N binormal", 32, 32, {
+        { 0,  0,  12, VertexElementConversion::Copy },
+        { 12, 12, 0,  VertexElementConversion::Dec3NToFloat3 },
+        { 16, 24, 8,  VertexElementConversion::Copy } } },
+      { "Skinned: FLOAT3 position, FLOAT3 blendweight, UBYTE4 blendindices, FLOAT3 normal, FLOAT2 texcoord, FLOAT4 tangent (RT elements)", 64, 32, {
+        { 0,  0,  12, VertexElementConversion::Copy },
+        { 28, 12, 12, VertexElementConversion::Copy },
+        { 40, 24, 8,  VertexElementConversion::Copy } } },
+      { "Skinned: FLOAT3 position, FLOAT3 blendweight, UBYTE4 blendindices, FLOAT3 normal, FLOAT2 texcoord, FLOAT4 tangent (skinning elements)", 64, 16, {
+        { 12, 0,  12, VertexElementConversion::Copy },
+        { 24, 12, 4,  VertexElementConversion::Copy } } },
+    };
+  }
+
+  static void validate(const std::vector<uint8_t>& reference, const std::vector<uint8_t>& packed, const char* name) {
+    if (memcmp(reference.data(), packed.data(), reference.size()) != 0)
+      throw DxvkError(str::format("Packed vertices not matching ", name));
+  }
+
+  static void test_declarations() {
+    std::mt19937 rng(kVertexCount);
+
+    for (const Declaration& layout : declarations()) {
+      std::vector<uint8_t> source(size_t(kVertexCount) * layout.stride);
+      for (auto& byte : source) {
+        byte = (uint8_t) rng();
+      }
+
+      std::vector<uint8_t> copy(source.size());
+      std::vector<uint8_t> reference(size_t(kVertexCount) * layout.packedStride);
+      std::vector<uint8_t> packed(reference.size());
+
+      std::cout << std::endl << layout.name << std::endl;
+      std::cout << "Staged bytes per vertex: " << layout.stride << " --> " << layout.packedStride << ", vertices: " << kVertexCount << ", repeats: " << kRepeats << std::endl;
+
+      {
+        // What the staging path did before, copy the whole stride
+        std::cout << "Running: memcpy --> ";
+        Timer time;
+        for (uint32_t r = 0; r < kRepeats; r++)
+          memcpy(copy.data(), source.data(), source.size());
+      }
+
+      fast::packVertexStream_slow(reference.data(), layout.packedStride, source.data(), layout.stride, kVertexCount, layout.elements.data(), (uint32_t) layout.elements.size());
+
+      TEST(slow);
+      TEST_CHECK(SSE, SSE2);
+      TEST_CHECK(AVX2, AVX2);
+    }
+
+    std::cout << "Pack vertex fast ops successfully smoke tested" << std::endl;
+  }
+};
+}
+
+int main() {
+  try {
+    fast::PackVertexTestApp::run();
+  }
+  catch (const dxvk::DxvkError& e) {
+    std::cerr << e.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
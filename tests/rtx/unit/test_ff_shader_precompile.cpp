@@ -0,0 +1,186 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+// Compiles a recorded set of fixed-function shader keys to SPIR-V on the CPU
+// and reports the time spent per variant. Pass the D3D9 runtime and optionally
+// a key file recorded by a game (<exe>.ff-keys), otherwise a synthetic set of
+// typical DX7/DX8-era variants is compiled.
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../../test_utils.h"
+#include "../../../src/d3d9/d3d9_fixed_function.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_ff_shader_precompile.log");
+
+  using pfnCompileFixedFunctionShaderKeys = uint32_t (*)(const char*, pfnFFShaderCompileReport);
+}
+
+namespace test_ff_shader_precompile_app {
+  using namespace dxvk;
+
+  struct CompileStats {
+    uint32_t count = 0;
+    double   totalMs = 0.0;
+    double   maxMs = 0.0;
+  };
+
+  CompileStats g_stats;
+
+  void reportCompile(const char* name, uint32_t codeSize, double milliseconds) {
+    std::cout << "  " << name << " --> " << std::fixed << std::setprecision(3)
+              << milliseconds << " ms, " << codeSize << " bytes" << std::endl;
+
+    g_stats.count++;
+    g_stats.totalMs += milliseconds;
+    g_stats.maxMs = std::max(g_stats.maxMs, milliseconds);
+  }
+
+  template<typename Key>
+  void writeKey(std::ofstream& file, D3D9FFShaderKeyType type, const Key& key) {
+    file.write(reinterpret_cast<const char*>(&type), sizeof(type));
+    file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+  }
+
+  // Unlit pre-transformed HUD geometry, lit meshes with up to four
+  // lights, one or two texture coordinate sets, with and without fog
+  uint32_t writeSyntheticKeys(const std::string& fileName) {
+    std::ofstream file(fileName, std::ios_base::binary | std::ios_base::trunc);
+
+    const D3D9FFShaderKeyFileHeader header;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    uint32_t count = 0;
+
+    for (uint32_t positionT = 0; positionT < 2; positionT++) {
+      for (uint32_t lightCount = 0; lightCount <= (positionT ? 0u : 4u); lightCount++) {
+        for (uint32_t color = 0; color < 2; color++) {
+          for (uint32_t texcoords = 0; texcoords <= 2; texcoords++) {
+            for (uint32_t fog = 0; fog < 2; fog++) {
+              D3D9FFShaderKeyVS key;
+              key.Data.Contents.HasPositionT = positionT;
+              key.Data.Contents.HasColor0 = color;
+              key.Data.Contents.UseLighting = lightCount != 0;
+              key.Data.Contents.LightCount = lightCount;
+              key.Data.Contents.NormalizeNormals = lightCount != 0;
+              key.Data.Contents.HasFog = fog;
+
+              for (uint32_t i = 0; i < texcoords; i++) {
+                key.Data.Contents.TexcoordIndices |= i << (i * 3);
+                key.Data.Contents.TexcoordDeclMask |= 2u << (i * 3);
+              }
+
+              writeKey(file, D3D9FFShaderKeyType::Vertex, key);
+              count++;
+            }
+          }
+        }
+      }
+    }
+
+    // Modulate, add and select blends over one to three stages
+    const uint32_t colorOps[] = { D3DTOP_MODULATE, D3DTOP_MODULATE2X, D3DTOP_ADD, D3DTOP_SELECTARG1, D3DTOP_BLENDTEXTUREALPHA };
+
+    for (uint32_t stageCount = 1; stageCount <= 3; stageCount++) {
+      for (uint32_t op : colorOps) {
+        for (uint32_t specular = 0; specular < 2; specular++) {
+          D3D9FFShaderKeyFS key;
+
+          for (uint32_t i = 0; i < stageCount; i++) {
+            auto& stage = key.Stages[i].Contents;
+            stage.ColorOp = i == 0 ? D3DTOP_MODULATE : op;
+            stage.ColorArg1 = D3DTA_TEXTURE;
+            stage.ColorArg2 = i == 0 ? D3DTA_DIFFUSE : D3DTA_CURRENT;
+            stage.AlphaOp = D3DTOP_SELECTARG1;
+            stage.AlphaArg1 = D3DTA_TEXTURE;
+          }
+
+          key.Stages[0].Contents.GlobalSpecularEnable = specular;
+
+          writeKey(file, D3D9FFShaderKeyType::Fragment, key);
+          count++;
+        }
+      }
+    }
+
+    return count;
+  }
+
+  void run_test(const char* d3d9Path, const char* keyFilePath) {
+    HMODULE hD3D9 = LoadLibrary(d3d9Path);
+    if (hD3D9 == NULL) {
+      throw DxvkError("Unable to load D3D9");
+    }
+
+    pfnCompileFixedFunctionShaderKeys fnCompile = (pfnCompileFixedFunctionShaderKeys) GetProcAddress(hD3D9, "compileFixedFunctionShaderKeys");
+    if (fnCompile == NULL) {
+      throw DxvkError("Couldn't load compileFixedFunctionShaderKeys");
+    }
+
+    std::string keyFile;
+    uint32_t expectedCount = 0;
+
+    if (keyFilePath != nullptr) {
+      keyFile = keyFilePath;
+    } else {
+      keyFile = (std::filesystem::temp_directory_path() / "test_ff_shader_precompile.ff-keys").string();
+      expectedCount = writeSyntheticKeys(keyFile);
+    }
+
+    std::cout << "Compiling fixed-function shaders from: " << keyFile << std::endl;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const uint32_t count = fnCompile(keyFile.c_str(), &reportCompile);
+    const auto t1 = std::chrono::steady_clock::now();
+
+    if (count == 0 || count != g_stats.count || (expectedCount != 0 && count != expectedCount)) {
+      throw DxvkError(str::format("Compiled ", count, " shaders, reported ", g_stats.count, ", expected ", expectedCount));
+    }
+
+    std::cout << count << " variants in " << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms, "
+              << g_stats.totalMs << " ms compiling, "
+              << (g_stats.totalMs / count) << " ms average, " << g_stats.maxMs << " ms slowest" << std::endl;
+  }
+}
+
+int main(int n, const char* args[]) {
+  try {
+    if (n < 2) {
+      throw dxvk::DxvkError("Expected D3D9 runtime path as argument, optionally followed by a key file.");
+    }
+
+    test_ff_shader_precompile_app::run_test(args[1], n > 2 ? args[2] : nullptr);
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
@@ -0,0 +1,250 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include "../../test_utils.h"
+#include "../../../src/util/util_fast_cache.h"
+#include "../../../src/util/util_timer.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_flat_cache.log");
+}
+
+namespace dxvk {
+  class TestApp {
+  public:
+    static std::vector<XXH64_hash_t> makeKeys(size_t count, uint64_t seed) {
+      std::vector<XXH64_hash_t> keys(count);
+      for (size_t i = 0; i < count; i++) {
+        const uint64_t v = seed * 0x9E3779B97F4A7C15ull + i;
+        keys[i] = XXH3_64bits(&v, sizeof(v));
+      }
+      return keys;
+    }
+
+    template<typename Map>
+    void checkAgainst(const Map& map, const std::unordered_map<XXH64_hash_t, uint64_t>& reference, const char* name) {
+      if (map.size() != reference.size()) {
+        throw DxvkError(str::format(name, ": size mismatch, ", map.size(), " vs ", reference.size()));
+      }
+
+      size_t iterated = 0;
+      for (const auto& [key, value] : map) {
+        auto it = reference.find(key);
+        if (it == reference.end() || it->second != value) {
+          throw DxvkError(str::format(name, ": iterated an unexpected element ", key));
+        }
+        iterated++;
+      }
+      if (iterated != reference.size()) {
+        throw DxvkError(str::format(name, ": iteration visited ", iterated, " elements"));
+      }
+
+      for (const auto& [key, value] : reference) {
+        auto it = map.find(key);
+        if (it == map.end() || it->second != value) {
+          throw DxvkError(str::format(name, ": lookup of ", key, " failed"));
+        }
+      }
+    }
+
+    template<typename Map>
+    void testRandomized(const char* name) {
+      Map map;
+      std::unordered_map<XXH64_hash_t, uint64_t> reference;
+      std::mt19937_64 rng(7);
+
+      // A small key space, so inserts, erases and tombstone reuse all collide often
+      const auto keys = makeKeys(3000, 1);
+
+      for (uint32_t op = 0; op < 200000; op++) {
+        const XXH64_hash_t key = keys[rng() % keys.size()];
+        switch (rng() % 5) {
+        case 0:
+        case 1: {
+          const bool inserted = map.insert({ key, op }).second;
+          if (inserted != reference.insert({ key, op }).second) {
+            throw DxvkError(str::format(name, ": insert result mismatch"));
+          }
+          break;
+        }
+        case 2:
+          map[key] = op;
+          reference[key] = op;
+          break;
+        case 3:
+          if (map.erase(key) != reference.erase(key)) {
+            throw DxvkError(str::format(name, ": erase result mismatch"));
+          }
+          break;
+        case 4:
+          if (map.count(key) != reference.count(key)) {
+            throw DxvkError(str::format(name, ": count mismatch"));
+          }
+          break;
+        }
+      }
+
+      checkAgainst(map, reference, name);
+
+      // Iterator erase and erase_if
+      map.erase_if([](const auto& it) { return (it->second & 1) != 0; });
+      for (auto it = reference.begin(); it != reference.end();) {
+        it = (it->second & 1) ? reference.erase(it) : std::next(it);
+      }
+      checkAgainst(map, reference, name);
+
+      // Copy and move keep contents
+      Map copy = map;
+      Map moved = std::move(copy);
+      checkAgainst(moved, reference, name);
+      if (!(moved == map)) {
+        throw DxvkError(str::format(name, ": copy does not compare equal"));
+      }
+
+      map.clear();
+      if (!map.empty() || map.begin() != map.end() || map.find(keys[0]) != map.end()) {
+        throw DxvkError(str::format(name, ": clear left elements behind"));
+      }
+    }
+
+    void testStableReferences() {
+      fast_stable_cache<std::unique_ptr<int>> cache;
+      const auto keys = makeKeys(10000, 2);
+
+      cache.try_emplace(keys[0], std::make_unique<int>(42));
+      const std::unique_ptr<int>* first = &cache.at(keys[0]);
+
+      // Many rehashes later the node is still where it was
+      for (size_t i = 1; i < keys.size(); i++) {
+        cache.emplace(keys[i], std::make_unique<int>(int(i)));
+      }
+      if (&cache.at(keys[0]) != first || **first != 42) {
+        throw DxvkError("fast_stable_cache: reference invalidated by growth");
+      }
+
+      auto [it, inserted] = cache.insert_or_assign(keys[0], std::make_unique<int>(7));
+      if (inserted || &it->second != first || *it->second != 7) {
+        throw DxvkError("fast_stable_cache: insert_or_assign must update in place");
+      }
+    }
+
+    void testSet() {
+      fast_flat_set set;
+      const auto keys = makeKeys(1000, 3);
+      for (const XXH64_hash_t key : keys) {
+        set.insert(key);
+      }
+      set.insert(keys[5]);
+      if (set.size() != keys.size() || !set.contains(keys[999]) || set.contains(makeKeys(1, 4)[0])) {
+        throw DxvkError("fast_flat_set: membership mismatch");
+      }
+
+      fast_flat_set copy = set;
+      copy.erase(keys[0]);
+      if (copy == set || copy.size() + 1 != set.size()) {
+        throw DxvkError("fast_flat_set: erase / compare mismatch");
+      }
+    }
+
+    // Insert, hit lookups, miss lookups and erase for the std based cache vs the flat ones
+    template<typename Map>
+    void benchmark(const char* name, const std::vector<XXH64_hash_t>& keys, const std::vector<XXH64_hash_t>& missingKeys) {
+      Map map;
+      uint64_t checksum = 0;
+
+      std::cout << "  " << name << " insert --> ";
+      {
+        Timer time;
+        for (size_t i = 0; i < keys.size(); i++) {
+          map[keys[i]] = i;
+        }
+      }
+
+      std::cout << "  " << name << " lookup (hit) --> ";
+      {
+        Timer time;
+        for (const XXH64_hash_t key : keys) {
+          checksum += map.find(key)->second;
+        }
+      }
+
+      std::cout << "  " << name << " lookup (miss) --> ";
+      {
+        Timer time;
+        for (const XXH64_hash_t key : missingKeys) {
+          checksum += map.find(key) == map.end() ? 1 : 0;
+        }
+      }
+
+      std::cout << "  " << name << " erase --> ";
+      {
+        Timer time;
+        for (const XXH64_hash_t key : keys) {
+          checksum += map.erase(key);
+        }
+      }
+
+      const uint64_t expected = keys.size() * (keys.size() - 1) / 2 + missingKeys.size() + keys.size();
+      if (checksum != expected || !map.empty()) {
+        throw DxvkError(str::format(name, ": benchmark produced wrong results"));
+      }
+    }
+
+    void runBenchmarks() {
+      for (const size_t count : { 10000u, 100000u, 1000000u }) {
+        const auto keys = makeKeys(count, 5);
+        const auto missingKeys = makeKeys(count, 6);
+
+        std::cout << count << " keys" << std::endl;
+        benchmark<std::unordered_map<XXH64_hash_t, uint64_t, XXH64_hash_passthrough>>("std::unordered_map", keys, missingKeys);
+        benchmark<fast_flat_cache<uint64_t>>("fast_flat_cache", keys, missingKeys);
+        benchmark<fast_stable_cache<uint64_t>>("fast_stable_cache", keys, missingKeys);
+      }
+    }
+
+    void run() {
+      testRandomized<fast_flat_cache<uint64_t>>("fast_flat_cache");
+      testRandomized<fast_stable_cache<uint64_t>>("fast_stable_cache");
+      testStableReferences();
+      testSet();
+      runBenchmarks();
+      std::cout << "All passed\n";
+    }
+  };
+}
+
+
+int main() {
+  try {
+    dxvk::TestApp testApp;
+    testApp.run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
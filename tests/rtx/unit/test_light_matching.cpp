@@ -0,0 +1,290 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+// Streams synthetic frames of game lights through the similar light matching
+// of LightManager::addLight, once through LightManager::findSimilarLight and
+// once comparing against every light as before.  Checks both pick the same lights
+// and reports the time per frame at increasing light counts.  Runs on the CPU
+// only, no device is created.
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/dxvk/rtx_render/rtx_light_manager.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_light_matching.log");
+}
+
+namespace test_light_matching_app {
+  using namespace dxvk;
+
+  // World units are centimeters, lights closer than 2 cm are merged like addLight does
+  constexpr float MeterToWorldUnits = 100.f;
+  constexpr float DistanceThreshold = 0.02f * MeterToWorldUnits;
+  constexpr float UniqueObjectDistance = 300.f;
+  constexpr uint32_t FrameCount = 4;
+  constexpr uint32_t DistantLightCount = 4;
+  // Brute force matching is quadratic, don't wait on it past this
+  constexpr uint32_t MaxBruteForceLights = 8192;
+
+  struct LightTable {
+    std::unordered_map<XXH64_hash_t, RtLight> lights;
+    LightSpatialIndex index { MeterToWorldUnits, UniqueObjectDistance };
+  };
+
+  struct StreamResult {
+    std::vector<XXH64_hash_t> matches;
+    uint32_t numMatched = 0;
+    double matchMs = 0.0;
+  };
+
+  RtLight makeSphereLight(const Vector3& position, bool shaped) {
+    const RtLightShaping shaping(shaped, Vector3(0.f, 0.f, -1.f), 0.7f, 0.1f, 0.f);
+    return RtLight(RtSphereLight(position, Vector3(1.f, 1.f, 1.f), 1.f, shaping));
+  }
+
+  RtLight makeDistantLight(const Vector3& direction) {
+    return RtLight(RtDistantLight(normalize(direction), 0.01f, Vector3(1.f, 1.f, 1.f)));
+  }
+
+  // Every frame resubmits the lights of the previous one, most of them nudged by less than the
+  // merge threshold (which changes their hash), and one in sixteen respawned somewhere else.
+  std::vector<std::vector<RtLight>> makeStream(uint32_t lightCount) {
+    std::mt19937 rng(lightCount);
+
+    // Keep the density constant, roughly one light per cubic meter
+    const float extent = std::cbrt(float(lightCount)) * MeterToWorldUnits;
+    std::uniform_real_distribution<float> position(0.f, extent);
+    std::uniform_real_distribution<float> nudge(-0.2f * DistanceThreshold, 0.2f * DistanceThreshold);
+    std::uniform_real_distribution<float> direction(-1.f, 1.f);
+
+    std::vector<std::vector<RtLight>> frames(FrameCount);
+
+    for (uint32_t i = 0; i < lightCount; i++) {
+      if (i < DistantLightCount) {
+        frames[0].push_back(makeDistantLight(Vector3(direction(rng), direction(rng), -1.f)));
+      } else {
+        frames[0].push_back(makeSphereLight(Vector3(position(rng), position(rng), position(rng)), i % 4 == 0));
+      }
+    }
+
+    for (uint32_t f = 1; f < FrameCount; f++) {
+      for (uint32_t i = 0; i < lightCount; i++) {
+        const RtLight& previous = frames[f - 1][i];
+
+        if (previous.getType() == RtLightType::Distant) {
+          const Vector3 offset(nudge(rng), nudge(rng), nudge(rng));
+          frames[f].push_back(makeDistantLight(previous.getDirection() + offset * 0.001f));
+        } else if ((i + f) % 16 == 0) {
+          frames[f].push_back(makeSphereLight(Vector3(position(rng), position(rng), position(rng)), i % 4 == 0));
+        } else {
+          const Vector3 offset(nudge(rng), nudge(rng), nudge(rng));
+          frames[f].push_back(makeSphereLight(previous.getPosition() + offset, i % 4 == 0));
+        }
+      }
+    }
+
+    return frames;
+  }
+
+  // The search LightManager::addLight did before it had an index, comparing against every light
+  XXH64_hash_t findSimilarLightLinear(const LightTable& table, const RtLight& rtLight) {
+    XXH64_hash_t similarLightHash = kEmptyHash;
+    float bestSimilarity = -1.f;
+
+    for (const auto& [hash, light] : table.lights) {
+      const float similarity = LightManager::isSimilar(light, rtLight, DistanceThreshold);
+
+      if (similarity >= 0.f && similarity > bestSimilarity) {
+        similarLightHash = hash;
+        bestSimilarity = similarity;
+      }
+    }
+
+    return similarLightHash;
+  }
+
+  void addLight(LightTable& table, const RtLight& rtLight, bool useIndex, StreamResult& result) {
+    const XXH64_hash_t hash = rtLight.getInstanceHash();
+    auto found = table.lights.find(hash);
+
+    if (found != table.lights.end()) {
+      table.index.move(hash, found->second, rtLight);
+      found->second = rtLight;
+      result.matches.push_back(hash);
+      return;
+    }
+
+    const XXH64_hash_t similarLightHash = useIndex ?
+      LightManager::findSimilarLight(table.lights, table.index, rtLight, DistanceThreshold) :
+      findSimilarLightLinear(table, rtLight);
+
+    if (similarLightHash != kEmptyHash) {
+      table.index.erase(similarLightHash, table.lights.at(similarLightHash));
+      table.lights.erase(similarLightHash);
+      result.numMatched++;
+    }
+
+    table.lights.emplace(hash, rtLight);
+    table.index.insert(hash, rtLight);
+    result.matches.push_back(similarLightHash);
+  }
+
+  StreamResult runStream(const std::vector<std::vector<RtLight>>& frames, bool useIndex) {
+    LightTable table;
+    StreamResult result;
+
+    for (uint32_t f = 0; f < frames.size(); f++) {
+      const auto t0 = std::chrono::steady_clock::now();
+
+      for (const RtLight& light : frames[f]) {
+        addLight(table, light, useIndex, result);
+      }
+
+      // The first frame only fills the table
+      if (f > 0) {
+        result.matchMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+      }
+
+      // Lights that weren't resubmitted this frame go away, like garbage collection would
+      std::unordered_set<XXH64_hash_t> touched;
+      for (const RtLight& light : frames[f]) {
+        touched.insert(light.getInstanceHash());
+      }
+
+      for (auto it = table.lights.begin(); it != table.lights.end();) {
+        if (touched.count(it->first) == 0) {
+          table.index.erase(it->first, it->second);
+          it = table.lights.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+
+    if (table.index.size() != table.lights.size()) {
+      throw DxvkError(str::format("Index holds ", table.index.size(), " lights, table holds ", table.lights.size()));
+    }
+
+    return result;
+  }
+
+  void runCount(uint32_t lightCount) {
+    const auto frames = makeStream(lightCount);
+    const uint32_t matchFrames = FrameCount - 1;
+
+    const StreamResult indexed = runStream(frames, true);
+
+    // Everything but the respawned lights should find its previous frame's light
+    const uint32_t respawned = (lightCount - DistantLightCount) / 16;
+    if (indexed.numMatched + respawned * matchFrames < (lightCount - 1) * matchFrames) {
+      throw DxvkError(str::format("Only ", indexed.numMatched, " lights matched with ", lightCount, " lights per frame"));
+    }
+
+    std::cout << "  " << std::setw(6) << lightCount << " lights --> index " << std::setw(9) << indexed.matchMs / matchFrames << " ms/frame";
+
+    if (lightCount <= MaxBruteForceLights) {
+      const StreamResult bruteForce = runStream(frames, false);
+
+      if (bruteForce.matches != indexed.matches) {
+        throw DxvkError(str::format("Index and brute force picked different lights with ", lightCount, " lights per frame"));
+      }
+
+      std::cout << ", all lights " << std::setw(9) << bruteForce.matchMs / matchFrames << " ms/frame ("
+                << bruteForce.matchMs / indexed.matchMs << "x)";
+    }
+
+    std::cout << std::endl;
+  }
+
+  void testIndexUpdates() {
+    LightSpatialIndex index(MeterToWorldUnits, UniqueObjectDistance);
+
+    const RtLight a = makeSphereLight(Vector3(0.f, 0.f, 0.f), false);
+    const RtLight b = makeSphereLight(Vector3(1000.f, 0.f, 0.f), false);
+    const RtLight distant = makeDistantLight(Vector3(0.f, 0.f, -1.f));
+
+    index.insert(1, a);
+    index.insert(2, distant);
+
+    auto countCandidates = [&](const RtLight& light, float threshold) {
+      uint32_t count = 0;
+      index.forEachCandidate(light, threshold, [&](XXH64_hash_t) { count++; });
+      return count;
+    };
+
+    // Types are kept apart, and distant lights match by direction only
+    if (countCandidates(a, DistanceThreshold) != 1 || countCandidates(makeDistantLight(Vector3(0.01f, 0.f, -1.f)), 0.f) != 1) {
+      throw DxvkError("Expected exactly one candidate of the same type");
+    }
+
+    // Moving a light takes its entry along, in both the fine and the coarse maps
+    index.move(1, a, b);
+    if (countCandidates(a, DistanceThreshold) != 0 || countCandidates(b, DistanceThreshold) != 1 || countCandidates(b, UniqueObjectDistance) != 1) {
+      throw DxvkError("Moved light was not found at its new position");
+    }
+
+    // Changing the cell sizes keeps every entry
+    index.setCellSizes(MeterToWorldUnits * 2.f, UniqueObjectDistance * 0.5f);
+    if (countCandidates(b, DistanceThreshold) != 1 || countCandidates(b, UniqueObjectDistance) != 1) {
+      throw DxvkError("Light lost while re-bucketing the index");
+    }
+
+    index.erase(1, b);
+    index.erase(2, distant);
+    if (index.size() != 0) {
+      throw DxvkError("Index should be empty");
+    }
+  }
+
+  void run_test() {
+    std::cout << "Checking light index updates" << std::endl;
+    testIndexUpdates();
+
+    std::cout << "Matching " << FrameCount - 1 << " frames of moving lights" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (uint32_t lightCount = 256; lightCount <= 65536; lightCount *= 4) {
+      runCount(lightCount);
+    }
+  }
+}
+
+int main() {
+  try {
+    test_light_matching_app::run_test();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
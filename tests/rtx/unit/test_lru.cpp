@@ -0,0 +1,301 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <list>
+#include <random>
+#include <unordered_map>
+#include "../../test_utils.h"
+#include "../../../src/util/util_fast_cache.h"
+#include "../../../src/util/util_lru.h"
+#include "../../../src/util/util_timer.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_lru.log");
+}
+
+namespace dxvk {
+  class TestApp {
+  public:
+    // The previous std::list based implementation, as a reference and a baseline
+    class ListLru {
+    public:
+      void insert(uint64_t value) {
+        auto cacheIter = m_cache.find(value);
+        if (cacheIter != m_cache.end())
+          m_list.erase(cacheIter->second);
+        m_list.push_back(value);
+        m_cache[value] = std::prev(m_list.end());
+      }
+
+      void remove(uint64_t value) {
+        auto cacheIter = m_cache.find(value);
+        if (cacheIter == m_cache.end())
+          return;
+        m_list.erase(cacheIter->second);
+        m_cache.erase(cacheIter);
+      }
+
+      void touch(uint64_t value) {
+        auto cacheIter = m_cache.find(value);
+        if (cacheIter == m_cache.end())
+          return;
+        m_list.erase(cacheIter->second);
+        m_list.push_back(value);
+        cacheIter->second = std::prev(m_list.end());
+      }
+
+      const std::list<uint64_t>& order() const { return m_list; }
+
+    private:
+      std::list<uint64_t> m_list;
+      std::unordered_map<uint64_t, std::list<uint64_t>::iterator> m_cache;
+    };
+
+    template<typename Lru>
+    static std::vector<uint64_t> order(const Lru& lru) {
+      return std::vector<uint64_t>(lru.leastRecentlyUsedIter(), lru.leastRecentlyUsedEndIter());
+    }
+
+    static std::vector<uint64_t> order(const lru_index_list& lru) {
+      std::vector<uint64_t> ids;
+      for (uint32_t id = lru.leastRecentlyUsed(); id != lru_index_list::kInvalid; id = lru.next(id)) {
+        ids.push_back(id);
+      }
+      return ids;
+    }
+
+    void testIndexList() {
+      lru_index_list lru;
+      const uint32_t ids[] = { 4, 1, 7, 1, 0 };
+      lru.touch(ids, std::size(ids));
+
+      if (order(lru) != std::vector<uint64_t> { 4, 7, 1, 0 } || lru.size() != 4) {
+        throw DxvkError("lru_index_list: batched touch order mismatch");
+      }
+
+      lru.touch(4);
+      lru.remove(7);
+      if (order(lru) != std::vector<uint64_t> { 1, 0, 4 } || lru.contains(7) || lru.remove(7)) {
+        throw DxvkError("lru_index_list: touch / remove mismatch");
+      }
+
+      std::vector<uint64_t> reversed;
+      for (uint32_t id = lru.mostRecentlyUsed(); id != lru_index_list::kInvalid; id = lru.prev(id)) {
+        reversed.push_back(id);
+      }
+      if (reversed != std::vector<uint64_t> { 4, 0, 1 }) {
+        throw DxvkError("lru_index_list: prev must walk back from the most recently used id");
+      }
+
+      // Evict until "under budget": each id costs 1, the budget is 1
+      uint32_t used = lru.size();
+      const size_t numEvicted = lru.evictWhile([&](uint32_t) {
+        if (used <= 1) {
+          return false;
+        }
+        used--;
+        return true;
+      });
+      if (numEvicted != 2 || order(lru) != std::vector<uint64_t> { 4 }) {
+        throw DxvkError("lru_index_list: evictWhile must stop once under budget");
+      }
+
+      // The callback may remove the id itself
+      lru.touch(9);
+      lru.evictWhile([&](uint32_t id) { return lru.remove(id); });
+      if (!lru.empty() || lru.leastRecentlyUsed() != lru_index_list::kInvalid) {
+        throw DxvkError("lru_index_list: evictWhile with self removal left ids behind");
+      }
+    }
+
+    void testClock() {
+      clock_index_list clock;
+      for (uint32_t id = 0; id < 8; id++) {
+        clock.touch(id);
+      }
+
+      // First sweep clears references, the second one evicts. Ids 2 and 5 are
+      // re-referenced after the first sweep and must survive the second
+      clock.evictWhile([](uint32_t) { return false; });
+      clock.touch(2);
+      clock.touch(5);
+
+      std::vector<uint32_t> evicted;
+      clock.evictWhile([&](uint32_t id) {
+        evicted.push_back(id);
+        return evicted.size() < 7;
+      });
+      evicted.pop_back(); // The candidate that stopped eviction is kept
+
+      if (evicted != std::vector<uint32_t> { 0, 1, 3, 4, 6, 7 } || !clock.contains(2) || !clock.contains(5) || clock.size() != 2) {
+        throw DxvkError("clock_index_list: second chance order mismatch");
+      }
+    }
+
+    void testRandomized() {
+      ListLru reference;
+      lru_list<uint64_t> lru;
+      lru_list<XXH64_hash_t, fast_flat_cache<uint32_t>> hashLru;
+      std::mt19937 rng(3);
+
+      for (uint32_t op = 0; op < 100000; op++) {
+        const uint64_t value = rng() % 500;
+        switch (rng() % 4) {
+        case 0:
+          reference.insert(value);
+          lru.insert(value);
+          hashLru.insert(value);
+          break;
+        case 1:
+          reference.remove(value);
+          lru.remove(value);
+          hashLru.remove(value);
+          break;
+        default:
+          reference.touch(value);
+          lru.touch(value);
+          hashLru.touchHandle(hashLru.find(value));
+          break;
+        }
+      }
+
+      const std::vector<uint64_t> expected(reference.order().begin(), reference.order().end());
+      if (order(lru) != expected || order(hashLru) != expected || lru.size() != expected.size()) {
+        throw DxvkError("lru_list: order differs from the std::list implementation");
+      }
+
+      // Removing through iterators while walking
+      for (auto it = lru.leastRecentlyUsedIter(); it != lru.leastRecentlyUsedEndIter();) {
+        it = (*it & 1) ? lru.remove(it) : std::next(it);
+      }
+      for (uint64_t v : order(lru)) {
+        if (v & 1) {
+          throw DxvkError("lru_list: iterator removal missed an element");
+        }
+      }
+
+      const size_t sizeBefore = hashLru.size();
+      if (hashLru.evictWhile([](XXH64_hash_t) { return true; }) != sizeBefore || !hashLru.empty()) {
+        throw DxvkError("lru_list: evictWhile did not empty the list");
+      }
+    }
+
+    // Residency style workload: every frame a random subset is touched, then the oldest get evicted
+    void runBenchmarks() {
+      constexpr uint32_t kNumEntries = 100000;
+      constexpr uint32_t kNumTouches = 1000000;
+
+      std::mt19937 rng(11);
+      std::vector<uint32_t> touches(kNumTouches);
+      for (uint32_t& t : touches) {
+        // Skewed, a hot working set plus a long tail
+        t = (rng() % 4) ? rng() % (kNumEntries / 10) : rng() % kNumEntries;
+      }
+
+      std::cout << kNumEntries << " entries, " << kNumTouches << " touches" << std::endl;
+
+      {
+        ListLru lru;
+        for (uint32_t i = 0; i < kNumEntries; i++) {
+          lru.insert(i);
+        }
+        std::cout << "  std::list lru touch --> ";
+        {
+          Timer time;
+          for (uint32_t t : touches) {
+            lru.touch(t);
+          }
+        }
+      }
+
+      {
+        lru_list<uint64_t> lru;
+        for (uint32_t i = 0; i < kNumEntries; i++) {
+          lru.insert(i);
+        }
+        std::cout << "  lru_list touch --> ";
+        {
+          Timer time;
+          for (uint32_t t : touches) {
+            lru.touch(t);
+          }
+        }
+      }
+
+      uint64_t checksum = 0;
+      {
+        lru_index_list lru;
+        lru.reserve(kNumEntries);
+        std::cout << "  lru_index_list batched touch --> ";
+        {
+          Timer time;
+          lru.touch(touches.data(), touches.size());
+        }
+        std::cout << "  lru_index_list evict half --> ";
+        {
+          Timer time;
+          checksum += lru.evictWhile([&](uint32_t) { return lru.size() > kNumEntries / 2; });
+        }
+      }
+
+      {
+        clock_index_list clock;
+        std::cout << "  clock_index_list batched touch --> ";
+        {
+          Timer time;
+          clock.touch(touches.data(), touches.size());
+        }
+        std::cout << "  clock_index_list evict half --> ";
+        {
+          Timer time;
+          checksum += clock.evictWhile([&](uint32_t) { return clock.size() > kNumEntries / 2; });
+        }
+      }
+
+      if (checksum == 0) {
+        throw DxvkError("benchmark: nothing was evicted");
+      }
+    }
+
+    void run() {
+      testIndexList();
+      testClock();
+      testRandomized();
+      runBenchmarks();
+      std::cout << "All passed\n";
+    }
+  };
+}
+
+
+int main() {
+  try {
+    dxvk::TestApp testApp;
+    testApp.run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
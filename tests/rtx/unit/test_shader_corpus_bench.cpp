@@ -0,0 +1,295 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+// Runs a directory of captured shader blobs through the DXSO and DXBC
+// front-ends (reader, analyzer, compiler) without a Vulkan device and
+// reports throughput, per-phase timing, emitted SPIR-V size and peak
+// memory. Corpora can be captured from any title by setting
+// DXVK_SHADER_BYTECODE_DUMP_PATH, which writes every created shader as
+// <key>.dxso or <key>.dxbc.
+//
+// Usage: test_shader_corpus_bench <d3d9 runtime> [corpus dir] [iterations]
+// The corpus dir defaults to DXVK_SHADER_CORPUS_PATH, the benchmark is
+// skipped if neither is set.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/d3d9/d3d9_shader.h"
+#ifdef DXVK_SHADER_BENCH_DXBC
+#include "../../../src/dxbc/dxbc_module.h"
+#endif
+
+#include <psapi.h>
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_shader_corpus_bench.log");
+
+  using pfnBenchmarkDxsoShader = bool (*)(const void*, size_t, D3D9ShaderCompileStats*);
+}
+
+namespace test_shader_corpus_bench_app {
+  using namespace dxvk;
+
+  // Exit code that makes meson report the benchmark as skipped
+  constexpr int SkipExitCode = 77;
+
+  struct ShaderBlob {
+    std::string       name;
+    std::vector<char> data;
+  };
+
+  struct FrontEndStats {
+    uint32_t count = 0;
+    uint32_t failed = 0;
+    uint64_t bytecodeBytes = 0;
+    uint64_t spirvDwords = 0;
+    double   readMs = 0.0;
+    double   analyzeMs = 0.0;
+    double   compileMs = 0.0;
+    double   wallMs = 0.0;
+  };
+
+  double elapsedMs(std::chrono::steady_clock::time_point t0, std::chrono::steady_clock::time_point t1) {
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+  }
+
+  std::vector<ShaderBlob> loadBlobs(const std::filesystem::path& dir, const char* extension) {
+    std::vector<ShaderBlob> blobs;
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(dir)) {
+      if (!entry.is_regular_file() || entry.path().extension() != extension)
+        continue;
+
+      std::ifstream file(entry.path(), std::ios_base::binary);
+
+      ShaderBlob blob;
+      blob.name = entry.path().filename().string();
+      blob.data.resize(size_t(entry.file_size()));
+      file.read(blob.data.data(), blob.data.size());
+
+      if (file)
+        blobs.push_back(std::move(blob));
+    }
+
+    return blobs;
+  }
+
+  size_t peakWorkingSet() {
+    PROCESS_MEMORY_COUNTERS counters = { };
+    counters.cb = sizeof(counters);
+
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+      return 0;
+
+    return counters.PeakWorkingSetSize;
+  }
+
+  FrontEndStats runDxso(pfnBenchmarkDxsoShader fnBenchmark, const std::vector<ShaderBlob>& blobs, uint32_t iterations) {
+    FrontEndStats stats;
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < iterations; i++) {
+      for (const auto& blob : blobs) {
+        D3D9ShaderCompileStats result = { };
+
+        if (!fnBenchmark(blob.data.data(), blob.data.size(), &result)) {
+          if (i == 0)
+            std::cerr << "  Failed to compile " << blob.name << std::endl;
+
+          stats.failed++;
+          continue;
+        }
+
+        stats.count++;
+        stats.bytecodeBytes += result.bytecodeLength;
+        stats.spirvDwords += result.spirvDwords;
+        stats.readMs += result.readMs;
+        stats.analyzeMs += result.analyzeMs;
+        stats.compileMs += result.compileMs;
+      }
+    }
+
+    stats.wallMs = elapsedMs(t0, std::chrono::steady_clock::now());
+    return stats;
+  }
+
+#ifdef DXVK_SHADER_BENCH_DXBC
+  FrontEndStats runDxbc(const std::vector<ShaderBlob>& blobs, uint32_t iterations) {
+    FrontEndStats stats;
+
+    // Same options as the standalone dxbc-compiler tool
+    DxbcModuleInfo moduleInfo;
+    moduleInfo.options.useSubgroupOpsForAtomicCounters = true;
+    moduleInfo.options.useDemoteToHelperInvocation = true;
+    moduleInfo.options.minSsboAlignment = 4;
+    moduleInfo.tess = nullptr;
+    moduleInfo.xfb = nullptr;
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < iterations; i++) {
+      for (const auto& blob : blobs) {
+        try {
+          const auto t1 = std::chrono::steady_clock::now();
+
+          DxbcReader reader(blob.data.data(), blob.data.size());
+          DxbcModule module(reader);
+
+          const auto t2 = std::chrono::steady_clock::now();
+
+          DxbcAnalysisInfo analysisInfo = module.analyze(moduleInfo);
+
+          const auto t3 = std::chrono::steady_clock::now();
+
+          Rc<DxvkShader> shader = module.compile(moduleInfo, blob.name, analysisInfo);
+
+          const auto t4 = std::chrono::steady_clock::now();
+
+          stats.count++;
+          stats.bytecodeBytes += blob.data.size();
+          stats.spirvDwords += shader->getCode().dwords();
+          stats.readMs += elapsedMs(t1, t2);
+          stats.analyzeMs += elapsedMs(t2, t3);
+          stats.compileMs += elapsedMs(t3, t4);
+        } catch (const DxvkError& error) {
+          if (i == 0)
+            std::cerr << "  Failed to compile " << blob.name << ": " << error.message() << std::endl;
+
+          stats.failed++;
+        }
+      }
+    }
+
+    stats.wallMs = elapsedMs(t0, std::chrono::steady_clock::now());
+    return stats;
+  }
+#endif
+
+  void printStats(const char* frontEnd, const FrontEndStats& stats) {
+    std::cout << frontEnd << ": " << stats.count << " shaders";
+
+    if (stats.failed)
+      std::cout << " (" << stats.failed << " failed)";
+
+    if (!stats.count) {
+      std::cout << std::endl;
+      return;
+    }
+
+    std::cout << " in " << stats.wallMs << " ms, "
+              << (stats.count * 1000.0 / stats.wallMs) << " shaders/s" << std::endl;
+    std::cout << "  read    --> " << stats.readMs << " ms, " << (stats.readMs / stats.count) << " ms average" << std::endl;
+    std::cout << "  analyze --> " << stats.analyzeMs << " ms, " << (stats.analyzeMs / stats.count) << " ms average" << std::endl;
+    std::cout << "  compile --> " << stats.compileMs << " ms, " << (stats.compileMs / stats.count) << " ms average" << std::endl;
+    std::cout << "  " << stats.bytecodeBytes << " bytecode bytes --> " << stats.spirvDwords << " SPIR-V words, "
+              << (stats.spirvDwords / stats.count) << " words average" << std::endl;
+  }
+
+  int run_test(const char* d3d9Path, const char* corpusPath, uint32_t iterations) {
+    const std::string corpus = corpusPath != nullptr
+      ? std::string(corpusPath)
+      : env::getEnvVar("DXVK_SHADER_CORPUS_PATH");
+
+    if (corpus.empty()) {
+      std::cout << "No shader corpus given, skipping. Pass a directory or set DXVK_SHADER_CORPUS_PATH." << std::endl;
+      return SkipExitCode;
+    }
+
+    if (!std::filesystem::is_directory(corpus)) {
+      throw DxvkError(str::format("Shader corpus not found: ", corpus));
+    }
+
+    HMODULE hD3D9 = LoadLibrary(d3d9Path);
+    if (hD3D9 == NULL) {
+      throw DxvkError("Unable to load D3D9");
+    }
+
+    pfnBenchmarkDxsoShader fnBenchmark = (pfnBenchmarkDxsoShader) GetProcAddress(hD3D9, "benchmarkDxsoShader");
+    if (fnBenchmark == NULL) {
+      throw DxvkError("Couldn't load benchmarkDxsoShader");
+    }
+
+    const std::vector<ShaderBlob> dxsoBlobs = loadBlobs(corpus, ".dxso");
+    const std::vector<ShaderBlob> dxbcBlobs = loadBlobs(corpus, ".dxbc");
+
+    std::cout << "Shader corpus: " << corpus << ", " << dxsoBlobs.size() << " DXSO and "
+              << dxbcBlobs.size() << " DXBC shaders, " << iterations << " iteration(s)" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+
+    const size_t baseWorkingSet = peakWorkingSet();
+
+    const FrontEndStats dxsoStats = runDxso(fnBenchmark, dxsoBlobs, iterations);
+    printStats("DXSO", dxsoStats);
+
+#ifdef DXVK_SHADER_BENCH_DXBC
+    const FrontEndStats dxbcStats = runDxbc(dxbcBlobs, iterations);
+    printStats("DXBC", dxbcStats);
+#else
+    if (!dxbcBlobs.empty())
+      std::cout << "DXBC: front-end not built, skipping " << dxbcBlobs.size() << " shaders" << std::endl;
+#endif
+
+    const size_t peak = peakWorkingSet();
+
+    std::cout << "Peak working set: " << (peak >> 20) << " MB ("
+              << (baseWorkingSet >> 20) << " MB after loading the corpus)" << std::endl;
+
+    if (dxsoStats.failed
+#ifdef DXVK_SHADER_BENCH_DXBC
+     || dxbcStats.failed
+#endif
+    ) {
+      throw DxvkError("Some shaders failed to compile");
+    }
+
+    return 0;
+  }
+}
+
+int main(int n, const char* args[]) {
+  try {
+    if (n < 2) {
+      throw dxvk::DxvkError("Expected D3D9 runtime path as argument, optionally followed by a corpus directory and iteration count.");
+    }
+
+    const uint32_t iterations = n > 3 ? std::max(std::atoi(args[3]), 1) : 1;
+
+    return test_shader_corpus_bench_app::run_test(args[1], n > 2 ? args[2] : nullptr, iterations);
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
@@ -0,0 +1,168 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <random>
+#include <unordered_map>
+#include "../../test_utils.h"
+#include "../../../src/dxvk/rtx_render/rtx_sparse_unique_cache.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_sparse_unique_cache.log");
+}
+
+namespace dxvk {
+  class TestApp {
+  public:
+    struct IntHashFn {
+      size_t operator()(const int& v) const {
+        // Deliberately weak, so probe chains and tombstones get exercised
+        return size_t(v) & 0xff;
+      }
+    };
+
+    using Cache = SparseUniqueCache<int, IntHashFn>;
+
+    std::vector<std::pair<uint32_t, uint32_t>> getDirtyRanges(const Cache& cache) {
+      std::vector<std::pair<uint32_t, uint32_t>> ranges;
+      cache.forEachDirtyRange([&](uint32_t begin, uint32_t end) {
+        ranges.emplace_back(begin, end);
+      });
+      return ranges;
+    }
+
+    void testHandlesAndDirtyRanges() {
+      Cache cache;
+
+      for (int i = 1; i <= 8; i++) {
+        if (cache.track(i) != uint32_t(i - 1)) {
+          throw DxvkError("track: indices should be handed out in order");
+        }
+      }
+
+      if (getDirtyRanges(cache) != std::vector<std::pair<uint32_t, uint32_t>> { { 0, 8 } }) {
+        throw DxvkError("dirty ranges: expected a single run over all new slots");
+      }
+      cache.clearDirty();
+
+      uint32_t idx;
+      const Cache::Handle handle3 = cache.trackHandle(3);
+      if (handle3.index != 2 || !cache.isCurrent(handle3) || cache.hasDirtySlots()) {
+        throw DxvkError("trackHandle: retracking must return the existing slot without dirtying it");
+      }
+
+      cache.free(3);
+      cache.free(6);
+      if (cache.isCurrent(handle3) || cache.find(3, idx) || cache.getActiveCount() != 6 || cache.getTotalCount() != 8) {
+        throw DxvkError("free: handle must be invalidated, entry gone and counts updated");
+      }
+
+      // Freed slots are reused in FIFO order, the old handle must not match the new occupant
+      const Cache::Handle handle9 = cache.trackHandle(9);
+      if (handle9.index != 2 || cache.track(10) != 5 || cache.getActiveCount() != 8) {
+        throw DxvkError("free list: slots must be reused in the order they were freed");
+      }
+      if (!cache.isCurrent(handle9) || cache.isCurrent(handle3) || handle9.generation == handle3.generation ||
+          cache.getHandle(2).generation != handle9.generation) {
+        throw DxvkError("free list: a reused slot must reject the handle issued before it was freed");
+      }
+
+      cache.markDirty(7);
+      if (getDirtyRanges(cache) != std::vector<std::pair<uint32_t, uint32_t>> { { 2, 3 }, { 5, 6 }, { 7, 8 } }) {
+        throw DxvkError("dirty ranges: expected freed/reused and marked slots only");
+      }
+
+      if (cache.find(3, idx) || !cache.find(9, idx) || idx != 2) {
+        throw DxvkError("find: stale or missing entry");
+      }
+
+      cache.clear();
+      if (cache.isCurrent(handle9) || cache.getTotalCount() != 0 || cache.getActiveCount() != 0 || cache.hasDirtySlots() || cache.find(9, idx)) {
+        throw DxvkError("clear: expected an empty cache with no live handles");
+      }
+
+      // Indices restart at 0 after a clear, handles from before must still be rejected
+      const Cache::Handle handle11 = cache.trackHandle(11);
+      if (handle11.index != 0 || !cache.isCurrent(handle11) || cache.isCurrent(Cache::Handle { 0, 0 })) {
+        throw DxvkError("clear: handles issued before the clear must stay stale");
+      }
+      cache.clear();
+
+      if (cache.track(42, [](const int& v) { return v + 1; }) != 0 || !cache.find(43, idx) || cache.find(42, idx)) {
+        throw DxvkError("track: first-cache callback result must be what gets stored");
+      }
+    }
+
+    // Random track/free against a reference map, to cover table growth and tombstone reuse
+    void testRandomized() {
+      Cache cache;
+      std::unordered_map<int, uint32_t> reference;
+      std::mt19937 rng(1234);
+      std::uniform_int_distribution<int> valueDist(1, 5000);
+
+      for (int i = 0; i < 200000; i++) {
+        const int value = valueDist(rng);
+        if (rng() % 3 == 0) {
+          cache.free(value);
+          reference.erase(value);
+        } else {
+          const uint32_t idx = cache.track(value);
+          auto it = reference.find(value);
+          if (it != reference.end() && it->second != idx) {
+            throw DxvkError(str::format("randomized: ", value, " moved from slot ", it->second, " to ", idx));
+          }
+          reference[value] = idx;
+        }
+      }
+
+      if (cache.getActiveCount() != reference.size()) {
+        throw DxvkError(str::format("randomized: active count ", cache.getActiveCount(), " expected ", reference.size()));
+      }
+
+      for (auto& [value, expectedIdx] : reference) {
+        uint32_t idx;
+        if (!cache.find(value, idx) || idx != expectedIdx || cache.at(idx) != value) {
+          throw DxvkError(str::format("randomized: lookup of ", value, " failed"));
+        }
+      }
+    }
+
+    void run() {
+      testHandlesAndDirtyRanges();
+      testRandomized();
+      std::cout << "All passed\n";
+    }
+  };
+}
+
+
+int main() {
+  try {
+    dxvk::TestApp testApp;
+    testApp.run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
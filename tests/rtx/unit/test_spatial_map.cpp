@@ -19,9 +19,14 @@
 * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 * DEALINGS IN THE SOFTWARE.
 */
+#include <algorithm>
+#include <cfloat>
+#include <random>
 #include <set>
+#include <unordered_map>
 #include "../../test_utils.h"
 #include "../../../src/util/util_spatial_map.h"
+#include "../../../src/util/util_timer.h"
 
 namespace dxvk {
   // Note: Logger needed by some shared code used in this Unit Test.
@@ -41,20 +46,187 @@ namespace dxvk {
     }
 
     void testPoint(const SpatialMap<int>& map, const Vector3& pos, const std::set<int>& expectedResult) {
-      auto candidates = map.getDataNearPos(pos);
       std::set<int> candidatesSet;
-      int count = 0;
-      for (auto vec : candidates) {
-        for (int value : *vec) {
-          count++;
-          candidatesSet.emplace(value);
-        }
-      }
+      map.forEachNearPos(pos, [&](const int& value) {
+        candidatesSet.emplace(value);
+        return true;
+      });
       if (candidatesSet != expectedResult) {
         throw DxvkError(str::format("incorrect result: for pos ", ToString(pos), " expected [", ToString(expectedResult), "] but got [", ToString(candidatesSet), "]."));
       }
     }
 
+    // Compares radius and k-nearest queries against brute force, over a map that has seen inserts, erases, moves and a rebuild
+    void testQueries() {
+      std::mt19937 rng(7);
+      std::uniform_real_distribution<float> uni(-100.f, 100.f);
+
+      const int kCount = 20000;
+      SpatialMap<int> map(4.f);
+      std::unordered_map<int, Vector3> reference;
+      for (int i = 0; i < kCount; i++) {
+        const Vector3 pos(uni(rng), uni(rng), uni(rng));
+        map.insert(pos, i);
+        reference[i] = pos;
+      }
+      for (int i = 0; i < kCount; i += 3) {
+        map.erase(reference[i], i);
+        reference.erase(i);
+      }
+      for (int i = 1; i < kCount; i += 3) {
+        const Vector3 newPos = reference[i] + Vector3(uni(rng), uni(rng), uni(rng)) * 0.05f;
+        map.move(reference[i], newPos, i);
+        reference[i] = newPos;
+      }
+
+      for (int pass = 0; pass < 2; pass++) {
+        if (map.size() != reference.size()) {
+          throw DxvkError(str::format("incorrect size: expected ", reference.size(), " but got ", map.size()));
+        }
+
+        for (int q = 0; q < 100; q++) {
+          const Vector3 center(uni(rng), uni(rng), uni(rng));
+          const float radius = 12.f;
+
+          std::set<int> found, expected;
+          map.forEachInRadius(center, radius, [&](const int& value, float) {
+            found.emplace(value);
+            return true;
+          });
+          std::vector<float> distances;
+          for (const auto& [value, pos] : reference) {
+            const float distSqr = lengthSqr(pos - center);
+            if (distSqr <= radius * radius) {
+              expected.emplace(value);
+            }
+            distances.push_back(distSqr);
+          }
+          if (found != expected) {
+            throw DxvkError(str::format("incorrect radius query result around ", ToString(center)));
+          }
+
+          std::sort(distances.begin(), distances.end());
+          SpatialMap<int>::Neighbour nearest[8];
+          const uint32_t numNearest = map.findNearest(center, 8, FLT_MAX, nearest);
+          if (numNearest != 8) {
+            throw DxvkError(str::format("incorrect k-nearest count around ", ToString(center), ": ", numNearest));
+          }
+          for (uint32_t k = 0; k < numNearest; k++) {
+            if (nearest[k].distanceSqr != distances[k] || lengthSqr(reference[nearest[k].data] - center) != distances[k]) {
+              throw DxvkError(str::format("incorrect k-nearest result around ", ToString(center)));
+            }
+          }
+        }
+
+        // Second pass runs against a re-bucketed map
+        map.rebuild(6.f);
+      }
+
+      SpatialMap<int> sparse(1.f);
+      sparse.insert(Vector3(0.f, 0.f, 0.f), 0);
+      SpatialMap<int>::Neighbour nearest[4];
+      if (sparse.findNearest(Vector3(500.f, 0.f, 0.f), 4, FLT_MAX, nearest) != 1 || nearest[0].data != 0 ||
+          sparse.findNearest(Vector3(500.f, 0.f, 0.f), 4, 10.f, nearest) != 0) {
+        throw DxvkError("incorrect k-nearest result on a sparse map");
+      }
+    }
+
+    // Entries that keep moving across cells must not grow the cell table, and erases must not break probing of the cells left behind
+    void testChurn() {
+      std::mt19937 rng(13);
+      std::uniform_real_distribution<float> uni(-50.f, 50.f);
+
+      const int kCount = 500;
+      SpatialMap<int> map(1.f);
+      std::vector<Vector3> positions(kCount);
+      for (int i = 0; i < kCount; i++) {
+        positions[i] = Vector3(uni(rng), uni(rng), uni(rng));
+        map.insert(positions[i], i);
+      }
+
+      const size_t initialTableSize = map.tableSize();
+
+      for (int frame = 0; frame < 200; frame++) {
+        for (int i = 0; i < kCount; i++) {
+          const Vector3 newPos = positions[i] + Vector3(uni(rng), uni(rng), uni(rng)) * 0.1f;
+          map.move(positions[i], newPos, i);
+          positions[i] = newPos;
+        }
+      }
+
+      if (map.tableSize() > initialTableSize) {
+        throw DxvkError(str::format("cell table grew from ", initialTableSize, " to ", map.tableSize(), " slots with ", kCount, " entries"));
+      }
+
+      for (int i = 0; i < kCount; i++) {
+        bool found = false;
+        map.forEachInRadius(positions[i], 0.f, [&](const int& value, float) {
+          found |= value == i;
+          return true;
+        });
+        if (!found) {
+          throw DxvkError(str::format("entry ", i, " lost after churn"));
+        }
+      }
+
+      for (int i = 0; i < kCount; i++) {
+        map.erase(positions[i], i);
+      }
+      if (map.size() != 0) {
+        throw DxvkError("map should be empty");
+      }
+    }
+
+    void benchmark() {
+      std::mt19937 rng(11);
+      std::uniform_real_distribution<float> uni(-2000.f, 2000.f);
+
+      const int kCount = 200000;
+      const int kQueries = 200000;
+      std::vector<Vector3> positions(kCount);
+      for (Vector3& pos : positions) {
+        pos = Vector3(uni(rng), uni(rng), uni(rng));
+      }
+
+      SpatialMap<int> map(20.f);
+      std::cout << "Inserting " << kCount << " entries --> ";
+      {
+        Timer time;
+        for (int i = 0; i < kCount; i++) {
+          map.insert(positions[i], i);
+        }
+      }
+
+      std::cout << "Rebuilding --> ";
+      {
+        Timer time;
+        map.rebuild(20.f);
+      }
+
+      size_t visited = 0;
+      std::cout << "Running " << kQueries << " neighbourhood queries --> ";
+      {
+        Timer time;
+        for (int q = 0; q < kQueries; q++) {
+          map.forEachNearPos(positions[q % kCount], [&](const int&) {
+            ++visited;
+            return true;
+          });
+        }
+      }
+
+      SpatialMap<int>::Neighbour nearest[4];
+      std::cout << "Running " << kQueries << " k-nearest queries --> ";
+      {
+        Timer time;
+        for (int q = 0; q < kQueries; q++) {
+          visited += map.findNearest(positions[q % kCount], 4, 40.f, nearest);
+        }
+      }
+
+      std::cout << "Visited " << visited << " entries" << std::endl;
+    }
+
     void run() {
       SpatialMap<int> map(2.0f);
 
@@ -74,6 +246,10 @@ namespace dxvk {
       testPoint(map, Vector3(2.5f, 2.5f, 2.5f), { 0, 1, 2, 3});
       // far section of next cell
       testPoint(map, Vector3(3.5f, 3.5f, 3.5f), { 2, 3});
+
+      testQueries();
+      testChurn();
+      benchmark();
       std::cout << "All passed\n";
     }
   };
@@ -0,0 +1,219 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+// Writes a synthetic 50k entry state cache with usage records, checks that
+// parsing it on one and on many threads yields the same entries and merged
+// usage, that corrupted records are skipped, and reports parse and validate
+// time for both. Runs on the CPU only, no device is created.
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "../../test_utils.h"
+#include "../../../src/dxvk/dxvk_state_cache.h"
+#include "../../../src/util/util_mapped_file.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_state_cache_parse.log");
+}
+
+namespace test_state_cache_parse_app {
+  using namespace dxvk;
+
+  constexpr uint32_t EntryCount = 50000;
+  constexpr uint32_t SessionCount = 3;
+
+  DxvkShaderKey makeKey(VkShaderStageFlagBits stage, uint32_t id) {
+    const uint32_t data[2] = { uint32_t(stage), id };
+    return DxvkShaderKey(stage, Sha1Hash::compute(data, sizeof(data)));
+  }
+
+  DxvkStateCacheEntry makeEntry(uint32_t i) {
+    DxvkStateCacheEntry entry = { };
+
+    // One in eight is a compute pipeline, graphics pipelines
+    // share vertex shaders the way real titles do
+    if (i % 8 == 7) {
+      entry.shaders.cs = makeKey(VK_SHADER_STAGE_COMPUTE_BIT, i);
+      entry.cpState.sc.specConstants[0] = i;
+    } else {
+      entry.shaders.vs = makeKey(VK_SHADER_STAGE_VERTEX_BIT, i / 16);
+      entry.shaders.fs = makeKey(VK_SHADER_STAGE_FRAGMENT_BIT, i);
+      entry.format.sampleCount = VK_SAMPLE_COUNT_1_BIT;
+      entry.format.color[0].format = VK_FORMAT_B8G8R8A8_UNORM;
+      entry.format.color[0].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+      entry.gpState.sc.specConstants[i % MaxNumSpecConstants] = i;
+    }
+
+    return entry;
+  }
+
+  // Sessions use a growing prefix of the entries, the first few
+  // thousand are used in every session and needed right away
+  DxvkStateCacheUsage expectedUsage(uint32_t i) {
+    DxvkStateCacheUsage usage;
+
+    for (uint32_t s = 0; s < SessionCount; s++) {
+      if (i < (s + 1) * EntryCount / (SessionCount + 1))
+        usage.merge(DxvkStateCacheUsage { 1u, i / 64 + s });
+    }
+
+    return usage;
+  }
+
+  std::string writeCacheFile(const std::filesystem::path& path, uint32_t corruptEntry) {
+    std::ostringstream stream(std::ios_base::binary);
+
+    DxvkStateCacheHeader header;
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<Sha1Hash> hashes(EntryCount);
+    size_t corruptOffset = 0;
+
+    for (uint32_t i = 0; i < EntryCount; i++) {
+      if (i == corruptEntry)
+        corruptOffset = size_t(stream.tellp());
+
+      DxvkStateCacheEntry entry = makeEntry(i);
+      DxvkStateCache::writeCacheEntry(stream, entry);
+      hashes[i] = entry.hash;
+    }
+
+    for (uint32_t s = 0; s < SessionCount; s++) {
+      for (uint32_t i = 0; i < (s + 1) * EntryCount / (SessionCount + 1); i++)
+        DxvkStateCache::writeUsageRecord(stream, hashes[i], DxvkStateCacheUsage { 1u, i / 64 + s });
+    }
+
+    std::string data = stream.str();
+
+    // Flip a byte of the entry payload, past the record header and check sum
+    if (corruptEntry < EntryCount)
+      data[corruptOffset + 4 + sizeof(Sha1Hash)] ^= 0x5a;
+
+    std::ofstream file(path, std::ios_base::binary | std::ios_base::trunc);
+    file.write(data.data(), data.size());
+    return data;
+  }
+
+  double parse(const MappedFile& file, uint32_t numThreads, DxvkStateCacheContents& contents) {
+    const auto t0 = std::chrono::steady_clock::now();
+
+    DxvkStateCacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    DxvkStateCache::parseCacheEntries(header.version,
+      reinterpret_cast<const char*>(file.data()) + sizeof(header),
+      file.size() - sizeof(header), numThreads, contents);
+
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+  }
+
+  void checkContents(const DxvkStateCacheContents& contents, uint32_t corruptEntry) {
+    const uint32_t expectedEntries = corruptEntry < EntryCount ? EntryCount - 1 : EntryCount;
+
+    if (contents.entries.size() != expectedEntries || contents.usage.size() != expectedEntries)
+      throw DxvkError(str::format("Parsed ", contents.entries.size(), " entries, expected ", expectedEntries));
+
+    if (contents.numInvalidEntries != EntryCount - expectedEntries)
+      throw DxvkError(str::format("Found ", contents.numInvalidEntries, " invalid entries"));
+
+    for (uint32_t i = 0, n = 0; i < EntryCount; i++) {
+      if (i == corruptEntry)
+        continue;
+
+      DxvkStateCacheEntry expected = makeEntry(i);
+      const DxvkStateCacheEntry& entry = contents.entries[n];
+      const DxvkStateCacheUsage& usage = contents.usage[n++];
+
+      const bool match = entry.shaders.eq(expected.shaders)
+        && entry.format.eq(expected.format)
+        && entry.gpState == expected.gpState
+        && entry.cpState == expected.cpState;
+
+      if (!match)
+        throw DxvkError(str::format("Entry ", i, " does not match what was written"));
+
+      const DxvkStateCacheUsage expectedUse = expectedUsage(i);
+
+      if (usage.useCount != expectedUse.useCount || usage.firstUseFrame != expectedUse.firstUseFrame)
+        throw DxvkError(str::format("Entry ", i, " has usage ", usage.useCount, "/", usage.firstUseFrame,
+                                    ", expected ", expectedUse.useCount, "/", expectedUse.firstUseFrame));
+    }
+  }
+
+  void runCase(const std::filesystem::path& path, uint32_t corruptEntry, bool report) {
+    const std::string data = writeCacheFile(path, corruptEntry);
+
+    MappedFile file;
+    if (!file.open(path.string()))
+      throw DxvkError("Failed to map the state cache file");
+
+    const uint32_t numThreads = std::max(dxvk::thread::hardware_concurrency(), 1u);
+
+    DxvkStateCacheContents serial;
+    const double serialMs = parse(file, 1, serial);
+    checkContents(serial, corruptEntry);
+
+    DxvkStateCacheContents parallel;
+    const double parallelMs = parse(file, numThreads, parallel);
+    checkContents(parallel, corruptEntry);
+
+    if (report) {
+      std::cout << EntryCount << " entries, " << parallel.numUsageRecords << " usage records, "
+                << (data.size() >> 10) << " KB" << std::endl;
+      std::cout << "  1 thread --> " << serialMs << " ms" << std::endl;
+      std::cout << "  " << numThreads << " threads --> " << parallelMs << " ms" << std::endl;
+    }
+  }
+
+  void run_test() {
+    const auto path = std::filesystem::temp_directory_path() / "test_state_cache_parse.dxvk-cache";
+
+    std::cout << std::fixed << std::setprecision(2);
+
+    std::cout << "Checking that a corrupted entry is skipped" << std::endl;
+    runCase(path, EntryCount / 3, false);
+
+    std::cout << "Parsing a clean cache" << std::endl;
+    runCase(path, ~0u, true);
+
+    std::filesystem::remove(path);
+  }
+}
+
+int main() {
+  try {
+    test_state_cache_parse_app::run_test();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
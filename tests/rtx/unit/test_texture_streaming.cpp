@@ -0,0 +1,318 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+// Checks the texture streaming scores and the order RtxTextureManager takes
+// streaming requests in.  Simulates frames of requests being queued, their
+// hints changing and textures going out of view, and compares every request
+// TextureStreamingQueue hands out against rescoring the whole queue, which is
+// what the texture manager did before.  Also reports the time to drain a large
+// queue both ways.  Runs on the CPU only, no device is created.
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/dxvk/rtx_render/rtx_texture_streaming.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_texture_streaming.log");
+}
+
+namespace test_texture_streaming_app {
+  using namespace dxvk;
+
+  constexpr TextureStreamingWeights Weights { 1.f, 0.25f, 0.01f, 0.05f, 100.f };
+  constexpr uint32_t FrameCount = 200;
+
+  struct Request {
+    uint32_t id;
+    TextureStreamingRequest info;
+    uint32_t version = 0;
+    // Push order of the latest version, ties are taken in this order
+    uint64_t sequence = 0;
+    bool inQueue = false;
+  };
+
+  using Queue = TextureStreamingQueue<Request*>;
+
+  class Simulation {
+  public:
+    Simulation(bool holdBack, uint32_t seed)
+      : m_holdBack(holdBack), m_rng(seed) { }
+
+    void run() {
+      std::uniform_int_distribution<uint32_t> count(0, 24);
+      std::uniform_int_distribution<uint32_t> percent(0, 99);
+
+      for (uint32_t frame = 1; frame <= FrameCount; frame++) {
+        const uint32_t numNew = count(m_rng);
+        for (uint32_t i = 0; i < numNew; i++) {
+          push(frame);
+        }
+
+        // Some queued textures are drawn again with different hints, the rest go out of view over time
+        for (Request* request : m_queued) {
+          if (percent(m_rng) < 20) {
+            setHints(request->info, frame);
+            repush(*request, frame);
+          }
+        }
+
+        const uint32_t numPops = count(m_rng);
+        for (uint32_t i = 0; i < numPops && !m_queued.empty(); i++) {
+          pop(frame);
+        }
+      }
+
+      while (!m_queued.empty()) {
+        pop(FrameCount + 1);
+      }
+
+      // Only superseded versions are left, which must not come out again
+      Request* leftover;
+      if (m_queue.pop(leftover, FrameCount + 1, m_holdBack, [&](Request* r, uint32_t v, double& p) { return getPriority(r, v, p, FrameCount + 1); })) {
+        throw DxvkError(str::format("Queue handed out request ", leftover->id, " after all were taken"));
+      }
+    }
+
+  private:
+    bool m_holdBack;
+    std::mt19937 m_rng;
+    Queue m_queue;
+    std::vector<std::unique_ptr<Request>> m_requests;
+    std::vector<Request*> m_queued;
+    uint64_t m_sequence = 0;
+
+    void setHints(TextureStreamingRequest& info, uint32_t frame) {
+      std::uniform_real_distribution<float> coverage(0.f, 1.f);
+      std::uniform_real_distribution<float> distance(0.f, 10000.f);
+
+      info.coverage = coverage(m_rng);
+      info.distance = distance(m_rng);
+      info.frameLastRequested = frame;
+    }
+
+    void push(uint32_t frame) {
+      std::uniform_int_distribution<int> mip(0, 12);
+
+      m_requests.push_back(std::make_unique<Request>());
+      Request& request = *m_requests.back();
+      request.id = uint32_t(m_requests.size() - 1);
+      setHints(request.info, frame);
+      request.info.frameQueued = frame;
+      request.info.currentMip = mip(m_rng);
+      // A third are mip changes of resident textures, the rest load the full chain
+      request.info.targetMip = request.id % 3 == 0 ? std::max(request.info.currentMip - 1, 0) : 0;
+      request.inQueue = true;
+      request.sequence = m_sequence++;
+
+      m_queue.push(&request, calcTextureStreamingPriority(request.info, frame, Weights), request.version, frame);
+      m_queued.push_back(&request);
+    }
+
+    void repush(Request& request, uint32_t frame) {
+      request.sequence = m_sequence++;
+      m_queue.push(&request, calcTextureStreamingPriority(request.info, frame, Weights), ++request.version, request.info.frameQueued);
+    }
+
+    static bool getPriority(Request* request, uint32_t version, double& priority, uint32_t frame) {
+      if (version != request->version) {
+        return false;
+      }
+      priority = calcTextureStreamingPriority(request->info, frame, Weights);
+      return true;
+    }
+
+    // Rescores every queued request, ready ones first
+    size_t findBest(uint32_t frame) const {
+      size_t best = 0;
+      bool bestIsReady = false;
+      double bestScore = 0.0;
+
+      for (size_t i = 0; i < m_queued.size(); i++) {
+        const Request& request = *m_queued[i];
+        const bool isReady = !m_holdBack || request.info.frameQueued < frame;
+        const double score = calcTextureStreamingScore(request.info, frame, Weights);
+
+        const bool isBetter = i == 0 ||
+          (isReady && !bestIsReady) ||
+          (isReady == bestIsReady && (score > bestScore || (score == bestScore && request.sequence < m_queued[best]->sequence)));
+
+        if (isBetter) {
+          best = i;
+          bestIsReady = isReady;
+          bestScore = score;
+        }
+      }
+
+      return best;
+    }
+
+    void pop(uint32_t frame) {
+      const size_t expected = findBest(frame);
+
+      Request* request = nullptr;
+      if (!m_queue.pop(request, frame, m_holdBack, [&](Request* r, uint32_t v, double& p) { return getPriority(r, v, p, frame); })) {
+        throw DxvkError(str::format("Queue ran dry with ", m_queued.size(), " requests left in frame ", frame));
+      }
+
+      if (request != m_queued[expected]) {
+        throw DxvkError(str::format("Frame ", frame, ": queue took request ", request->id, " (score ",
+                                    calcTextureStreamingScore(request->info, frame, Weights), "), expected ", m_queued[expected]->id,
+                                    " (score ", calcTextureStreamingScore(m_queued[expected]->info, frame, Weights), ")",
+                                    m_holdBack ? " holding back new requests" : ""));
+      }
+
+      request->inQueue = false;
+      m_queued[expected] = m_queued.back();
+      m_queued.pop_back();
+    }
+  };
+
+  void testScores() {
+    TextureStreamingRequest near { 0.5f, 100.f, 10, 10, 8, 0 };
+    TextureStreamingRequest far = near;
+    far.distance = 10000.f;
+
+    // Closer, larger and older requests and ones missing more mips go first
+    if (calcTextureStreamingScore(near, 10, Weights) <= calcTextureStreamingScore(far, 10, Weights)) {
+      throw DxvkError("Closer request should score higher");
+    }
+
+    TextureStreamingRequest older = far;
+    older.frameQueued = 0;
+    if (calcTextureStreamingScore(older, 10, Weights) <= calcTextureStreamingScore(far, 10, Weights)) {
+      throw DxvkError("Older request should score higher");
+    }
+
+    TextureStreamingRequest fewerMips = near;
+    fewerMips.currentMip = 2;
+    if (calcTextureStreamingScore(fewerMips, 10, Weights) >= calcTextureStreamingScore(near, 10, Weights)) {
+      throw DxvkError("Request missing fewer mips should score lower");
+    }
+
+    // Out of view for longer than kStreamingVisibleFrames, only age and missing mips count
+    const uint32_t hiddenFrames = kStreamingVisibleFrames + 10;
+    const double expected = double(Weights.age) * hiddenFrames + double(Weights.mipDeficit) * 8.0;
+    const double hidden = calcTextureStreamingScore(near, 10 + hiddenFrames, Weights);
+    if (std::abs(hidden - expected) > 1e-4) {
+      throw DxvkError(str::format("Hidden request scored ", hidden, ", expected ", expected));
+    }
+
+    // Priority and score differ by the same amount for every request queued by that frame
+    const uint32_t frame = 12;
+    const double offsetNear = calcTextureStreamingScore(near, frame, Weights) - calcTextureStreamingPriority(near, frame, Weights);
+    const double offsetOlder = calcTextureStreamingScore(older, frame, Weights) - calcTextureStreamingPriority(older, frame, Weights);
+    if (std::abs(offsetNear - offsetOlder) > 1e-6) {
+      throw DxvkError("Priority does not rank requests like the score does");
+    }
+  }
+
+  void benchmark(uint32_t requestCount) {
+    std::mt19937 rng(requestCount);
+    std::uniform_real_distribution<float> coverage(0.f, 1.f);
+    std::uniform_real_distribution<float> distance(0.f, 10000.f);
+
+    std::vector<Request> requests(requestCount);
+    for (uint32_t i = 0; i < requestCount; i++) {
+      requests[i].id = i;
+      requests[i].info = TextureStreamingRequest { coverage(rng), distance(rng), 1, i % 4, 8, 0 };
+    }
+
+    const uint32_t frame = 2;
+    Queue queue;
+    const auto t0 = std::chrono::steady_clock::now();
+
+    for (Request& request : requests) {
+      queue.push(&request, calcTextureStreamingPriority(request.info, frame, Weights), 0, request.info.frameQueued);
+    }
+
+    Request* request;
+    while (queue.pop(request, frame, true, [&](Request* r, uint32_t, double& p) { p = calcTextureStreamingPriority(r->info, frame, Weights); return true; })) {
+    }
+
+    const auto t1 = std::chrono::steady_clock::now();
+
+    std::vector<Request*> queued;
+    for (Request& request : requests) {
+      queued.push_back(&request);
+    }
+
+    while (!queued.empty()) {
+      size_t best = 0;
+      double bestScore = -1e30;
+      for (size_t i = 0; i < queued.size(); i++) {
+        const double score = calcTextureStreamingScore(queued[i]->info, frame, Weights);
+        if (score > bestScore) {
+          best = i;
+          bestScore = score;
+        }
+      }
+      queued[best] = queued.back();
+      queued.pop_back();
+    }
+
+    const auto t2 = std::chrono::steady_clock::now();
+    const double queueMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    const double rescanMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+    std::cout << "  " << std::setw(6) << requestCount << " requests --> queue " << std::setw(9) << queueMs << " ms, rescoring every pop "
+              << std::setw(9) << rescanMs << " ms (" << rescanMs / queueMs << "x)" << std::endl;
+  }
+
+  void run_test() {
+    std::cout << "Checking streaming scores" << std::endl;
+    testScores();
+
+    std::cout << "Simulating " << FrameCount << " frames of streaming requests" << std::endl;
+    for (bool holdBack : { true, false }) {
+      for (uint32_t seed = 1; seed <= 8; seed++) {
+        Simulation simulation(holdBack, seed);
+        simulation.run();
+      }
+    }
+
+    std::cout << "Draining the streaming queue" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    for (uint32_t requestCount : { 1000u, 4000u, 16000u }) {
+      benchmark(requestCount);
+    }
+  }
+}
+
+int main() {
+  try {
+    test_texture_streaming_app::run_test();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
@@ -0,0 +1,209 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+// Generates the static BLAS TLAS records and billboard records the AccelManager
+// uploads each frame for synthetic scenes of 1k, 10k and 50k instances, once on
+// the calling thread and once split across a worker pool.  Checks both produce
+// byte identical records in the same order and reports the time per frame.
+// Runs on the CPU only, no device is created.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "../../test_utils.h"
+#include "../../../src/dxvk/rtx_render/rtx_accel_records.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_tlas_instance_records.log");
+}
+
+namespace test_tlas_instance_records_app {
+  using namespace dxvk;
+
+  constexpr uint32_t FrameCount = 16;
+  constexpr uint64_t IntersectionBlasReference = 0x1000;
+
+  struct Scene {
+    std::vector<std::unique_ptr<RtInstance>> instances;
+    std::vector<StaticBlasInstanceSource> sources;
+    std::vector<IntersectionBillboard> billboards;
+  };
+
+  struct Records {
+    std::vector<VkAccelerationStructureInstanceKHR> instances;
+    std::vector<MemoryBillboard> billboards;
+    uint32_t numActiveBillboards = 0;
+  };
+
+  // Every instance gets a static BLAS and, like a particle system would, two billboards,
+  // one in eight of which can't be used as an intersection primitive
+  Scene makeScene(uint32_t instanceCount) {
+    std::mt19937 rng(instanceCount);
+    std::uniform_real_distribution<float> position(-1000.f, 1000.f);
+    std::uniform_real_distribution<float> size(1.f, 50.f);
+
+    Scene scene;
+
+    for (uint32_t i = 0; i < instanceCount; i++) {
+      scene.instances.push_back(std::make_unique<RtInstance>(i, i));
+      RtInstance& instance = *scene.instances.back();
+
+      Matrix4 objectToWorld;
+      objectToWorld[3] = Vector4(position(rng), position(rng), position(rng), 1.f);
+      const Matrix4 transform = transpose(objectToWorld);
+
+      VkAccelerationStructureInstanceKHR& vkInstance = instance.getVkInstance();
+      memcpy(&vkInstance.transform, &transform, sizeof(VkTransformMatrixKHR));
+      vkInstance.mask = 0xff;
+      vkInstance.flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
+      vkInstance.instanceCustomIndex = (i & 1) ? CUSTOM_INDEX_IS_VIEW_MODEL : 0;
+      instance.setSurfaceIndex(i);
+
+      scene.sources.push_back(StaticBlasInstanceSource { &instance, 0x100000ull + i * 0x100ull, i });
+
+      for (uint32_t b = 0; b < 2; b++) {
+        IntersectionBillboard billboard {};
+        billboard.center = Vector3(position(rng), position(rng), position(rng));
+        billboard.xAxis = Vector3(1.f, 0.f, 0.f);
+        billboard.yAxis = Vector3(0.f, 0.f, 1.f);
+        billboard.width = size(rng);
+        billboard.height = size(rng);
+        billboard.xAxisUV = Vector2(1.f, 0.f);
+        billboard.yAxisUV = Vector2(0.f, 1.f);
+        billboard.centerUV = Vector2(0.5f, 0.5f);
+        billboard.vertexColor = 0xffffffff;
+        billboard.instanceMask = 0x10;
+        billboard.instance = &instance;
+        billboard.allowAsIntersectionPrimitive = (i * 2 + b) % 8 != 0;
+        billboard.isBeam = b == 1;
+        scene.billboards.push_back(billboard);
+      }
+    }
+
+    return scene;
+  }
+
+  double generate(const Scene& scene, AccelRecordWorkers* workers, Records& records) {
+    const auto t0 = std::chrono::steady_clock::now();
+
+    for (uint32_t f = 0; f < FrameCount; f++) {
+      records.instances.clear();
+      appendStaticBlasInstanceRecords(workers, scene.sources, records.instances);
+      records.numActiveBillboards = appendBillboardRecords(workers, scene.billboards, IntersectionBlasReference,
+                                                           records.billboards, records.instances);
+    }
+
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() / FrameCount;
+  }
+
+  void checkRecords(const Scene& scene, const Records& records) {
+    const uint32_t instanceCount = uint32_t(scene.sources.size());
+    const uint32_t expectedBillboards = uint32_t(scene.billboards.size()) - divCeil(uint32_t(scene.billboards.size()), 8u);
+
+    if (records.numActiveBillboards != expectedBillboards || records.instances.size() != instanceCount + expectedBillboards)
+      throw DxvkError(str::format("Generated ", records.numActiveBillboards, " billboards, expected ", expectedBillboards));
+
+    for (uint32_t i = 0; i < instanceCount; i++) {
+      const VkAccelerationStructureInstanceKHR& record = records.instances[i];
+
+      if (record.accelerationStructureReference != scene.sources[i].blasReference ||
+          (record.instanceCustomIndex & CUSTOM_INDEX_SURFACE_MASK) != i ||
+          (record.instanceCustomIndex & CUSTOM_INDEX_IS_VIEW_MODEL) != ((i & 1) ? CUSTOM_INDEX_IS_VIEW_MODEL : 0u))
+        throw DxvkError(str::format("Static BLAS record ", i, " does not match its instance"));
+    }
+
+    // Billboard records keep the order of the active billboards
+    for (uint32_t i = 0, index = 0; i < scene.billboards.size(); i++) {
+      const IntersectionBillboard& billboard = scene.billboards[i];
+
+      if (!billboard.allowAsIntersectionPrimitive)
+        continue;
+
+      const VkAccelerationStructureInstanceKHR& record = records.instances[instanceCount + index];
+      const MemoryBillboard& memory = records.billboards[index];
+
+      if (record.instanceCustomIndex != index || record.accelerationStructureReference != IntersectionBlasReference ||
+          memory.surfaceIndex != billboard.instance->getSurfaceIndex() || memory.center != billboard.center)
+        throw DxvkError(str::format("Billboard record ", index, " does not match billboard ", i));
+
+      index++;
+    }
+  }
+
+  void compareRecords(const Records& serial, const Records& parallel, uint32_t instanceCount) {
+    if (serial.instances.size() != parallel.instances.size() ||
+        memcmp(serial.instances.data(), parallel.instances.data(), serial.instances.size() * sizeof(VkAccelerationStructureInstanceKHR)) != 0)
+      throw DxvkError(str::format("Serial and parallel TLAS records differ with ", instanceCount, " instances"));
+
+    if (serial.billboards.size() != parallel.billboards.size() ||
+        memcmp(serial.billboards.data(), parallel.billboards.data(), serial.billboards.size() * sizeof(MemoryBillboard)) != 0)
+      throw DxvkError(str::format("Serial and parallel billboard records differ with ", instanceCount, " instances"));
+  }
+
+  void runCount(AccelRecordWorkers& workers, uint32_t instanceCount) {
+    const Scene scene = makeScene(instanceCount);
+
+    Records serial;
+    const double serialMs = generate(scene, nullptr, serial);
+    checkRecords(scene, serial);
+
+    Records parallel;
+    const double parallelMs = generate(scene, &workers, parallel);
+    compareRecords(serial, parallel, instanceCount);
+
+    std::cout << "  " << std::setw(6) << instanceCount << " instances, " << std::setw(6) << serial.instances.size() << " records --> "
+              << "1 thread " << std::setw(7) << serialMs << " ms/frame, "
+              << uint32_t(workers.numThreads()) + 1 << " threads " << std::setw(7) << parallelMs << " ms/frame ("
+              << serialMs / parallelMs << "x)" << std::endl;
+  }
+
+  void run_test() {
+    const uint32_t numWorkers = std::clamp(dxvk::thread::hardware_concurrency() / 4, 1u, 4u);
+    AccelRecordWorkers workers(uint8_t(numWorkers), "test-accel-records");
+
+    std::cout << "Generating TLAS instance and billboard records, " << FrameCount << " frames" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (uint32_t instanceCount : { 1000u, 10000u, 50000u }) {
+      runCount(workers, instanceCount);
+    }
+  }
+}
+
+int main() {
+  try {
+    test_tlas_instance_records_app::run_test();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
@@ -0,0 +1,343 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <map>
+#include <random>
+#include <type_traits>
+#include <vector>
+#include "../../test_utils.h"
+#include "../../../src/util/util_tlsf_allocator.h"
+#include "../../../src/util/util_timer.h"
+
+namespace dxvk {
+  // Note: Logger needed by some shared code used in this Unit Test.
+  Logger Logger::s_instance("test_tlsf_allocator.log");
+}
+
+namespace dxvk {
+  class TestApp {
+  public:
+    // The worst-fit free list DxvkMemoryChunk used before the TLSF allocator, kept as the benchmark baseline
+    class FreeListAllocator {
+    public:
+      struct Allocation {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+
+        explicit operator bool () const {
+          return size != 0;
+        }
+      };
+
+      explicit FreeListAllocator(uint64_t size) {
+        m_freeList.push_back({ 0, size });
+      }
+
+      Allocation alloc(uint64_t size, uint64_t align) {
+        if (m_freeList.size() == 0)
+          return Allocation();
+
+        auto bestSlice = m_freeList.begin();
+
+        for (auto slice = m_freeList.begin(); slice != m_freeList.end(); slice++) {
+          if (slice->length == size) {
+            bestSlice = slice;
+            break;
+          } else if (slice->length > bestSlice->length) {
+            bestSlice = slice;
+          }
+        }
+
+        const uint64_t sliceStart = bestSlice->offset;
+        const uint64_t sliceEnd = bestSlice->offset + bestSlice->length;
+        const uint64_t allocStart = alignUp(sliceStart, align);
+        const uint64_t allocEnd = alignUp(allocStart + size, align);
+
+        if (allocEnd > sliceEnd)
+          return Allocation();
+
+        m_freeList.erase(bestSlice);
+
+        if (allocStart != sliceStart)
+          m_freeList.push_back({ sliceStart, allocStart - sliceStart });
+
+        if (allocEnd != sliceEnd)
+          m_freeList.push_back({ allocEnd, sliceEnd - allocEnd });
+
+        return Allocation { allocStart, allocEnd - allocStart };
+      }
+
+      void free(uint64_t offset, uint64_t length) {
+        auto curr = m_freeList.begin();
+
+        while (curr != m_freeList.end()) {
+          if (curr->offset == offset + length) {
+            length += curr->length;
+            curr = m_freeList.erase(curr);
+          } else if (curr->offset + curr->length == offset) {
+            offset -= curr->length;
+            length += curr->length;
+            curr = m_freeList.erase(curr);
+          } else {
+            curr++;
+          }
+        }
+
+        m_freeList.push_back({ offset, length });
+      }
+
+      uint64_t largestFreeBlock() const {
+        uint64_t largest = 0;
+        for (const FreeSlice& slice : m_freeList) {
+          largest = std::max(largest, slice.length);
+        }
+        return largest;
+      }
+
+      uint32_t freeBlockCount() const {
+        return uint32_t(m_freeList.size());
+      }
+
+    private:
+      struct FreeSlice {
+        uint64_t offset;
+        uint64_t length;
+      };
+
+      std::vector<FreeSlice> m_freeList;
+
+      static uint64_t alignUp(uint64_t value, uint64_t align) {
+        return (value + align - 1) & ~(align - 1);
+      }
+    };
+
+    struct LiveAllocation {
+      uint64_t offset;
+      uint64_t size;
+      TlsfAllocator::Node node;
+    };
+
+    static uint64_t randomAlignment(std::mt19937& rng) {
+      // Mostly the alignments buffers and images ask for, sometimes larger
+      static const uint64_t alignments[] = { 1, 4, 16, 256, 256, 4096, 65536 };
+      return alignments[rng() % (sizeof(alignments) / sizeof(alignments[0]))];
+    }
+
+    static void validate(const TlsfAllocator& allocator, const std::map<uint64_t, LiveAllocation>& live) {
+      uint64_t usedBytes = 0;
+      uint64_t end = 0;
+      for (const auto& entry : live) {
+        const LiveAllocation& allocation = entry.second;
+        if (allocation.offset < end) {
+          throw DxvkError(str::format("TlsfAllocator: allocation at ", allocation.offset, " overlaps the previous one"));
+        }
+        end = allocation.offset + allocation.size;
+        usedBytes += allocation.size;
+      }
+
+      if (end > allocator.size()) {
+        throw DxvkError("TlsfAllocator: allocation past the end of the range");
+      }
+      if (allocator.freeBytes() + usedBytes != allocator.size()) {
+        throw DxvkError("TlsfAllocator: free bytes do not add up");
+      }
+      if (allocator.allocationCount() != live.size()) {
+        throw DxvkError("TlsfAllocator: wrong allocation count");
+      }
+      if (allocator.largestFreeBlock() > allocator.freeBytes()) {
+        throw DxvkError("TlsfAllocator: largest free block exceeds free bytes");
+      }
+    }
+
+    void testBasics() {
+      TlsfAllocator allocator(1024);
+
+      if (!allocator.isEmpty() || allocator.freeBlockCount() != 1 || allocator.largestFreeBlock() != 1024) {
+        throw DxvkError("TlsfAllocator: a new allocator must be one free block");
+      }
+
+      const TlsfAllocator::Allocation a = allocator.alloc(100, 64);
+      const TlsfAllocator::Allocation b = allocator.alloc(100, 64);
+      const TlsfAllocator::Allocation c = allocator.alloc(100, 64);
+
+      if (!a || !b || !c || a.size != 128 || (b.offset % 64) != 0 || (c.offset % 64) != 0) {
+        throw DxvkError("TlsfAllocator: sizes must be rounded up to the alignment");
+      }
+
+      if (allocator.alloc(2048, 1)) {
+        throw DxvkError("TlsfAllocator: allocation larger than the range must fail");
+      }
+
+      // Free the middle one first so both neighbours merge into it afterwards
+      allocator.free(b.node);
+      allocator.free(a.node);
+      allocator.free(c.node);
+
+      if (!allocator.isEmpty() || allocator.freeBlockCount() != 1 || allocator.largestFreeBlock() != 1024) {
+        throw DxvkError("TlsfAllocator: free blocks not coalesced");
+      }
+
+      const TlsfAllocator::Allocation all = allocator.alloc(1024, 1);
+      if (!all || all.offset != 0 || allocator.freeBlockCount() != 0 || allocator.alloc(1, 1)) {
+        throw DxvkError("TlsfAllocator: the whole range must be allocatable after coalescing");
+      }
+    }
+
+    void testRandomized() {
+      const uint64_t size = 64ull << 20;
+      std::mt19937 rng(1234);
+      TlsfAllocator allocator(size);
+      std::map<uint64_t, LiveAllocation> live;
+
+      for (uint32_t i = 0; i < 200000; i++) {
+        if (live.empty() || (rng() % 100) < 55) {
+          const uint64_t allocSize = 1 + ((rng() % 4) == 0 ? (rng() % (1 << 20)) : (rng() % 8192));
+          const uint64_t align = randomAlignment(rng);
+          const TlsfAllocator::Allocation allocation = allocator.alloc(allocSize, align);
+          if (!allocation) {
+            continue;
+          }
+          if ((allocation.offset % align) != 0 || allocation.size < allocSize) {
+            throw DxvkError("TlsfAllocator: misaligned or short allocation");
+          }
+          live[allocation.offset] = { allocation.offset, allocation.size, allocation.node };
+        } else {
+          auto entry = live.begin();
+          std::advance(entry, rng() % std::min<size_t>(live.size(), 64));
+          allocator.free(entry->second.node);
+          live.erase(entry);
+        }
+
+        if ((i % 1000) == 0) {
+          validate(allocator, live);
+        }
+      }
+
+      validate(allocator, live);
+
+      for (const auto& entry : live) {
+        allocator.free(entry.second.node);
+      }
+
+      if (!allocator.isEmpty() || allocator.freeBlockCount() != 1 || allocator.freeBytes() != size) {
+        throw DxvkError("TlsfAllocator: not a single free block after freeing everything");
+      }
+    }
+
+    // Keeps a few thousand allocations live in a 256 MB chunk and replaces random ones
+    template<typename Allocator>
+    static void churn(const char* name, uint32_t numLive) {
+      const uint64_t size = 256ull << 20;
+      const uint32_t numOperations = 200000;
+      std::mt19937 rng(42);
+      Allocator allocator(size);
+
+      struct Entry {
+        uint64_t offset;
+        uint64_t size;
+        TlsfAllocator::Node node;
+      };
+      std::vector<Entry> live;
+      uint32_t numFailed = 0;
+
+      auto allocOne = [&]() {
+        const uint64_t allocSize = 256 + (rng() % (48 << 10));
+        const auto allocation = allocator.alloc(allocSize, randomAlignment(rng));
+        if (!allocation) {
+          numFailed++;
+          return;
+        }
+        if constexpr (std::is_same_v<Allocator, TlsfAllocator>) {
+          live.push_back({ allocation.offset, allocation.size, allocation.node });
+        } else {
+          live.push_back({ allocation.offset, allocation.size, TlsfAllocator::kInvalidNode });
+        }
+      };
+
+      auto freeOne = [&](size_t index) {
+        if constexpr (std::is_same_v<Allocator, TlsfAllocator>) {
+          allocator.free(live[index].node);
+        } else {
+          allocator.free(live[index].offset, live[index].size);
+        }
+        live[index] = live.back();
+        live.pop_back();
+      };
+
+      std::cout << "  " << name << ", " << numLive << " live --> ";
+      {
+        Timer time;
+        for (uint32_t i = 0; i < numLive; i++) {
+          allocOne();
+        }
+        for (uint32_t i = 0; i < numOperations; i++) {
+          if (!live.empty()) {
+            freeOne(rng() % live.size());
+          }
+          allocOne();
+        }
+      }
+
+      uint64_t usedBytes = 0;
+      for (const Entry& entry : live) {
+        usedBytes += entry.size;
+      }
+      const uint64_t freeBytes = size - usedBytes;
+      const double fragmentation = freeBytes ? 1.0 - double(allocator.largestFreeBlock()) / double(freeBytes) : 0.0;
+
+      std::cout << "    " << allocator.freeBlockCount() << " free blocks, largest "
+                << (allocator.largestFreeBlock() >> 10) << " KB of " << (freeBytes >> 10) << " KB free, fragmentation "
+                << fragmentation << ", " << numFailed << " failed allocations" << std::endl;
+
+      while (!live.empty()) {
+        freeOne(live.size() - 1);
+      }
+    }
+
+    void runBenchmarks() {
+      for (const uint32_t numLive : { 1000u, 4000u }) {
+        churn<FreeListAllocator>("worst-fit free list", numLive);
+        churn<TlsfAllocator>("TlsfAllocator", numLive);
+      }
+    }
+
+    void run() {
+      testBasics();
+      testRandomized();
+      runBenchmarks();
+      std::cout << "All passed\n";
+    }
+  };
+}
+
+
+int main() {
+  try {
+    dxvk::TestApp testApp;
+    testApp.run();
+  }
+  catch (const dxvk::DxvkError& error) {
+    std::cerr << error.message() << std::endl;
+    throw;
+  }
+
+  return 0;
+}
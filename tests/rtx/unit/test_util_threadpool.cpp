@@ -47,6 +47,14 @@ public:
     test_smoke<4>();
     cout << "Begin misc tests" << endl;
     test_misc();
+    cout << "Begin multi-producer contention test" << endl;
+    test_contention();
+    cout << "Begin back-pressure test" << endl;
+    test_backpressure();
+    cout << "Begin parallel for/reduce tests" << endl;
+    test_parallel();
+    cout << "Begin throughput test" << endl;
+    test_throughput();
     cout << "WorkerThreadPool successfully smoke tested" << endl;
   }
   
@@ -186,6 +194,193 @@ private:
       throw DxvkError("Result didnt match");
     }
   }
+
+  static void test_contention() {
+    const uint32_t numThreads = 4;
+    const uint32_t numProducers = 6;
+    const uint32_t numTasksPerProducer = 5000;
+
+    WorkerThreadPool<2048> threadPool(numThreads);
+    cout << "Created thread pool with " << numThreads << " threads, " << numProducers << " producers" << endl;
+
+    std::atomic<uint32_t> executed = 0;
+    std::atomic<uint32_t> invalidFutures = 0;
+    std::atomic<uint64_t> resultSum = 0;
+
+    vector<std::thread> producers;
+    {
+      Timer t;
+      for (uint32_t p = 0; p < numProducers; p++) {
+        producers.emplace_back([&, p]() {
+          // Consume futures in a sliding window so task slots are never recycled while still referenced
+          const uint32_t window = 64;
+          vector<Future<uint32_t>> inFlight(window);
+
+          for (uint32_t i = 0; i < numTasksPerProducer; i++) {
+            Future<uint32_t>& slot = inFlight[i % window];
+            if (slot.valid()) {
+              resultSum += slot.get();
+            }
+
+            slot = threadPool.Schedule([&executed, value = p * numTasksPerProducer + i]() -> uint32_t {
+              ++executed;
+              return value;
+            });
+
+            if (!slot.valid()) {
+              ++invalidFutures;
+            }
+          }
+
+          for (auto& future : inFlight) {
+            if (future.valid()) {
+              resultSum += future.get();
+            }
+          }
+        });
+      }
+
+      for (auto& producer : producers) {
+        producer.join();
+      }
+
+      cout << "Scheduled and completed " << numProducers * numTasksPerProducer << " tasks from " << numProducers << " threads in ";
+    }
+
+    const uint32_t total = numProducers * numTasksPerProducer;
+    const uint64_t expectedSum = (uint64_t) total * (total - 1) / 2;
+
+    if (invalidFutures != 0) {
+      throw DxvkError("Concurrent schedule returned invalid futures");
+    }
+
+    if (executed != total || resultSum != expectedSum) {
+      throw DxvkError(str::format("Results didnt match under contention, executed: ", executed.load(), "/", total));
+    }
+  }
+
+  static void test_backpressure() {
+    // Deliberately tiny queues, so producers will routinely find them all full
+    const uint32_t numThreads = 2;
+    const uint32_t numTasks = 10000;
+
+    WorkerThreadPool<4> threadPool(numThreads);
+
+    std::atomic<uint32_t> executed = 0;
+    for (uint32_t i = 0; i < numTasks; i++) {
+      auto future = threadPool.Schedule([&executed]() {
+        auto start = high_resolution_clock::now();
+        while (duration_cast<microseconds>(high_resolution_clock::now() - start).count() < 5);
+        ++executed;
+      });
+
+      if (!future.valid()) {
+        throw DxvkError("Schedule dropped a task when the queues were full");
+      }
+    }
+
+    // Wait for the tail to complete
+    while (executed < numTasks) {
+      std::this_thread::yield();
+    }
+
+    cout << "Back-pressure executed all " << numTasks << " tasks" << endl;
+  }
+
+  static void test_parallel() {
+    const uint32_t numThreads = 4;
+    WorkerThreadPool<64> threadPool(numThreads);
+
+    // Every element visited exactly once, across a range of chunk sizes (incl. uneven tails)
+    const uint32_t count = 100003;
+    vector<std::atomic<uint32_t>> visits(count);
+    for (uint32_t chunkSize : { 1u, 7u, 1024u, count, count * 2 }) {
+      for (auto& v : visits) {
+        v = 0;
+      }
+
+      threadPool.ParallelFor(0, count, chunkSize, [&visits](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+          ++visits[i];
+        }
+      });
+
+      for (uint32_t i = 0; i < count; i++) {
+        if (visits[i] != 1) {
+          throw DxvkError(str::format("ParallelFor visited element ", i, " ", visits[i].load(), " times with chunk size ", chunkSize));
+        }
+      }
+    }
+
+    // Empty range is a no-op
+    threadPool.ParallelFor(10, 10, 16, [](uint32_t, uint32_t) {
+      throw DxvkError("ParallelFor invoked on empty range");
+    });
+
+    // Sum of [0, N)
+    const uint64_t sum = threadPool.ParallelReduce<uint64_t>(0, count, 4096, 0ull,
+      [](uint32_t begin, uint32_t end) {
+        uint64_t partial = 0;
+        for (uint32_t i = begin; i < end; i++) {
+          partial += i;
+        }
+        return partial;
+      },
+      [](uint64_t a, uint64_t b) { return a + b; });
+
+    if (sum != (uint64_t) count * (count - 1) / 2) {
+      throw DxvkError("ParallelReduce result didnt match");
+    }
+
+    // Nested fork-join from within a task running on the same pool must not deadlock
+    std::atomic<uint32_t> nested = 0;
+    auto future = threadPool.Schedule([&threadPool, &nested]() {
+      threadPool.ParallelFor(0, 1000, 10, [&nested](uint32_t begin, uint32_t end) {
+        nested += end - begin;
+      });
+    });
+    future.get();
+
+    if (nested != 1000) {
+      throw DxvkError("Nested ParallelFor result didnt match");
+    }
+
+    cout << "ParallelFor/ParallelReduce successfully tested" << endl;
+  }
+
+  static void test_throughput() {
+    const uint32_t numThreads = 4;
+    const uint32_t numTasks = 200000;
+
+    WorkerThreadPool<1024> threadPool(numThreads);
+
+    for (uint32_t numProducers : { 1u, 2u, 4u }) {
+      std::atomic<uint32_t> executed = 0;
+
+      const auto start = high_resolution_clock::now();
+
+      vector<std::thread> producers;
+      for (uint32_t p = 0; p < numProducers; p++) {
+        producers.emplace_back([&]() {
+          for (uint32_t i = 0; i < numTasks / numProducers; i++) {
+            threadPool.Schedule([&executed]() { ++executed; });
+          }
+        });
+      }
+
+      for (auto& producer : producers) {
+        producer.join();
+      }
+
+      const uint32_t expected = (numTasks / numProducers) * numProducers;
+      while (executed < expected) {
+        std::this_thread::yield();
+      }
+
+      const double seconds = duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+      cout << "Throughput with " << numProducers << " producer(s): " << (uint64_t) (expected / seconds) << " tasks/s" << endl;
+    }
+  }
 };
 
 int main() {